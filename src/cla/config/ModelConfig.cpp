@@ -30,9 +30,9 @@ void JsonConfig::align() {
 	config_.at(aligner_.getType()) = aligner_.getConfig();
 }
 
-PCLA JsonConfig::buildModel() {
+PCLA JsonConfig::buildModel(const std::size_t nbThreads) {
 	align();
-	return ModelJsonBuilder::buildModel(config_);
+	return ModelJsonBuilder::buildModel(config_, nbThreads);
 }
 
 
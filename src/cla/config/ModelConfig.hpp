@@ -84,9 +84,11 @@ public:
 	/**
 	 * Build the cla model instance.
 	 *
+	 * @param nbThreads The number of the threads that build the layers.
+	 * If the number is 1, the layers are built one by one.
 	 * @return PCLA The pointer of the cla model instance.
 	 */
-	PCLA buildModel();
+	PCLA buildModel(const std::size_t nbThreads = 1u);
 
 
 	friend std::ostream& operator<<(std::ostream& os, const JsonConfig& config);
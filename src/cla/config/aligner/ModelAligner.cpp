@@ -142,5 +142,15 @@ void ModelJsonAligner::setSeed(const int seed) {
 	io_.setSeed(seed);
 }
 
+void ModelJsonAligner::setNbThreads(const htm::UInt nbThreads) {
+	for(auto&& layer : layers_)
+		layer.setNbThreads(nbThreads);
+}
+
+void ModelJsonAligner::setRecordedEvents(const std::vector<std::string>& recordedEvents) {
+	for(auto&& layer : layers_)
+		layer.setRecordedEvents(recordedEvents);
+}
+
 
 } // namespace cla
\ No newline at end of file
@@ -147,6 +147,24 @@ public:
 	 */
 	void setSeed(const int seed);
 
+	/**
+	 * Set the number of the threads which compute the regions of each
+	 * layer.
+	 * 
+	 * @param nbThreads The number of the threads.
+	 */
+	void setNbThreads(const htm::UInt nbThreads);
+
+	/**
+	 * Set the connections events that the temporal memory modules of all
+	 * layers record. The callbacks which read the synapses need the
+	 * "synapses" and "permanences" events.
+	 * 
+	 * @param recordedEvents The names of the event classes ("segments",
+	 * "synapses", "permanences" and "all").
+	 */
+	void setRecordedEvents(const std::vector<std::string>& recordedEvents);
+
 };
 
 } // namespace cla
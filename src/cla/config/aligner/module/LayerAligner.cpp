@@ -8,6 +8,7 @@
 #include "cla/config/aligner/module/LayerAligner.hpp"
 #include "cla/config/utils/ConfigHelpers.hpp"
 #include "cla/config/utils/JsonParamDefinition.hpp"
+#include "cla/extension/types/Psdr.hpp"
 #include "cla/utils/Checker.hpp"
 
 namespace cla {
@@ -51,7 +52,20 @@ void LayerJsonAligner::alignHtmLayerConfig_() {
 	if(isInputDimensionsUpdated_)
 		ConfigHelper::assign(config_, LJLabel::PARAM_INPUT_DIMENSION_LABEL, inputDimensions_);
 
-	sp_.setColumnDimensions(config_.at(LJLabel::PARAM_COLUMN_DIMENSION_LABEL));
+	// Each spatial pooler computes one region of the layer, so it takes
+	// the split input and column dimensions.
+	const htm::UInt nbRegions = config_.at(LJLabel::PARAM_NB_REGIONS_LABEL);
+
+	sp_.setInputDimensions(
+		htm::PartialDenseFuncs::splitDimensions(
+			config_.at(LJLabel::PARAM_INPUT_DIMENSION_LABEL), nbRegions
+		)
+	);
+	sp_.setColumnDimensions(
+		htm::PartialDenseFuncs::splitDimensions(
+			config_.at(LJLabel::PARAM_COLUMN_DIMENSION_LABEL), nbRegions
+		)
+	);
 	tm_.setColumnDimensions(config_.at(LJLabel::PARAM_COLUMN_DIMENSION_LABEL));
 	tm_.setNumRegions(config_.at(LJLabel::PARAM_NB_REGIONS_LABEL));
 	tm_.setCellsPerColumn(config_.at(LJLabel::PARAM_NB_CELLS_FOR_COLUMNS_LABEL));
@@ -142,6 +156,14 @@ void LayerJsonAligner::setSeed(const int seed) {
 	tm_.setSeed(seed);
 }
 
+void LayerJsonAligner::setNbThreads(const htm::UInt nbThreads) {
+	ConfigHelper::assign(config_, LJLabel::PARAM_NB_THREADS_LABEL, nbThreads);
+}
+
+void LayerJsonAligner::setRecordedEvents(const std::vector<std::string>& recordedEvents) {
+	tm_.setRecordedEvents(recordedEvents);
+}
+
 void LayerJsonAligner::setInputDimensions(const std::vector<htm::UInt>& dimensions) {
 	sp_.setInputDimensions(dimensions);
 
@@ -160,6 +160,22 @@ public:
 	 */
 	void setSeed(const int seed);
 
+	/**
+	 * Set the number of the threads which compute the regions of the
+	 * layer.
+	 * 
+	 * @param nbThreads The number of the threads.
+	 */
+	void setNbThreads(const htm::UInt nbThreads);
+
+	/**
+	 * Set the connections events that the temporal memory module of the
+	 * layer records for the callbacks.
+	 * 
+	 * @param recordedEvents The names of the event classes.
+	 */
+	void setRecordedEvents(const std::vector<std::string>& recordedEvents);
+
 	/**
 	 * Set the input dimensions of the layer module. The input dimensions for all 
 	 * modules on the layer are unified to this value.
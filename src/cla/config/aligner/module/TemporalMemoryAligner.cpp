@@ -31,6 +31,7 @@ void TemporalMemoryJsonAligner::initializeByHtmTemporalMemory_(
 	isColumnDimensionsUpdated_ = false;
 	isCellsPerColumnUpdated_ = false;
 	isExternalPredictiveInputsUpdated_ = false;
+	isRecordedEventsUpdated_ = false;
 }
 
 void TemporalMemoryJsonAligner::alignHtmTemporalMemoryConfig_() {
@@ -48,6 +49,9 @@ void TemporalMemoryJsonAligner::alignHtmTemporalMemoryConfig_() {
 
 	if(isExternalPredictiveInputsUpdated_)
 		ConfigHelper::assign(config_, TMJLabel::PARAM_EXTERNAL_PREDICTIVE_INPUTS, externalPredictiveInputs_);
+
+	if(isRecordedEventsUpdated_)
+		ConfigHelper::assign(config_, TMJLabel::PARAM_RECORDED_EVENTS, recordedEvents_);
 }
 
 
@@ -60,7 +64,8 @@ TemporalMemoryJsonAligner::TemporalMemoryJsonAligner():
 	isNumRegionsUpdated_(false),
 	isColumnDimensionsUpdated_(false),
 	isCellsPerColumnUpdated_(false),
-	isExternalPredictiveInputsUpdated_(false)
+	isExternalPredictiveInputsUpdated_(false),
+	isRecordedEventsUpdated_(false)
 {
 
 }
@@ -147,4 +152,9 @@ void TemporalMemoryJsonAligner::setExternalPredictiveInputs(const htm::UInt exte
 	isExternalPredictiveInputsUpdated_ = true;
 }
 
+void TemporalMemoryJsonAligner::setRecordedEvents(const std::vector<std::string>& recordedEvents) {
+	recordedEvents_ = recordedEvents;
+	isRecordedEventsUpdated_ = true;
+}
+
 } // namespace cla
\ No newline at end of file
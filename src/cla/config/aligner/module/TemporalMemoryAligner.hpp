@@ -38,12 +38,14 @@ private:
 	std::vector<htm::UInt> columnDimensions_;
 	htm::UInt cellsPerColumn_;
 	htm::UInt externalPredictiveInputs_;
+	std::vector<std::string> recordedEvents_;
 
 	bool isSeedUpdated_;
 	bool isNumRegionsUpdated_;
 	bool isColumnDimensionsUpdated_;
 	bool isCellsPerColumnUpdated_;
 	bool isExternalPredictiveInputsUpdated_;
+	bool isRecordedEventsUpdated_;
 
 private:
 
@@ -170,6 +172,15 @@ public:
 	 */
 	void setExternalPredictiveInputs(const htm::UInt externalPredictiveInputs);
 
+	/**
+	 * Set the connections events that the temporal memory module records
+	 * for the callbacks.
+	 * 
+	 * @param recordedEvents The names of the event classes ("segments",
+	 * "synapses", "permanences" and "all").
+	 */
+	void setRecordedEvents(const std::vector<std::string>& recordedEvents);
+
 };
 
 } // namespace cla
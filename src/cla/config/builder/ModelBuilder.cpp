@@ -5,6 +5,9 @@
  * Implementation of ModelBuilder.cpp
  */
 
+#include <algorithm>
+#include <utility>
+
 #include "cla/model/generator/ClaGenerator.hpp"
 #include "cla/config/builder/ModelBuilder.hpp"
 #include "cla/config/builder/module/IoBuilder.hpp"
@@ -12,6 +15,7 @@
 #include "cla/config/utils/ConfigHelpers.hpp"
 #include "cla/config/utils/JsonParamDefinition.hpp"
 #include "cla/utils/Checker.hpp"
+#include "cla/utils/ThreadPool.hpp"
 
 namespace cla {
 
@@ -22,14 +26,17 @@ using MJLabel = ModelJsonLabels;
  * ModelJsonBuilder private functions.
  ***********************************************/
 
-PCLA ModelJsonBuilder::buildMlclaModel_(const json& config) {
+PCLA ModelJsonBuilder::buildMlclaModel_(
+	const json& config,
+	const std::size_t nbThreads
+) {
 
-	std::vector<PLayer> layers;
+	std::vector<std::pair<std::string, const json*>> layerConfigs;
 	PIO io = nullptr;
 
 	for(const auto& [key, value] : config.items()) {
 		if(KeyHelper::contain(key, MJLabel::LAYER_KEYWORD)) {
-			layers.emplace_back(std::move(LayerJsonBuilder::buildLayer(key, value)));
+			layerConfigs.emplace_back(key, &value);
 			continue;
 		} 
 		
@@ -41,6 +48,23 @@ PCLA ModelJsonBuilder::buildMlclaModel_(const json& config) {
 		CLA_ALERT("Error: There are parameters that are not assumed.");
 	}
 
+	// The layers do not share any state while they are built, so they are
+	// built concurrently and kept in the order of the config.
+	std::vector<PLayer> layers(layerConfigs.size());
+	const auto& buildLayer = [&](const std::size_t index) {
+		const auto& [key, value] = layerConfigs.at(index);
+		layers.at(index) = LayerJsonBuilder::buildLayer(key, *value);
+	};
+
+	const std::size_t nbWorkers = std::min(nbThreads, layers.size());
+	if(nbWorkers > 1u) {
+		// The caller runs the tasks as well, so one worker less is enough.
+		ThreadPool pool(nbWorkers - 1u);
+		pool.parallelFor(layers.size(), buildLayer);
+	} else {
+		for(std::size_t i = 0u; i < layers.size(); ++i) buildLayer(i);
+	}
+
 	CLA_CHECK(!layers.empty(), "Error: Not a single layer instance is generated.");
 	for(const auto& layer : layers)
 		CLA_CHECK(layer, "Error: A layer instance is not generated correctly.");
@@ -55,9 +79,12 @@ PCLA ModelJsonBuilder::buildMlclaModel_(const json& config) {
  * ModelJsonBuilder public functions.
  ***********************************************/
 
-PCLA ModelJsonBuilder::buildModel(const json& config) {
+PCLA ModelJsonBuilder::buildModel(
+	const json& config,
+	const std::size_t nbThreads
+) {
 	if(KeyHelper::contain(config, MJLabel::MLCLA_MODEL_LABEL)) {
-		return buildMlclaModel_(config.at(MJLabel::MLCLA_MODEL_LABEL));
+		return buildMlclaModel_(config.at(MJLabel::MLCLA_MODEL_LABEL), nbThreads);
 	}
 
 	CLA_ALERT("Error: There is no model that can be built.");
@@ -65,10 +92,11 @@ PCLA ModelJsonBuilder::buildModel(const json& config) {
 
 PCLA ModelJsonBuilder::buildModel(
 	const std::string& type, 
-	const json& config
+	const json& config,
+	const std::size_t nbThreads
 ) {
 	if(KeyHelper::contain(type, MJLabel::MLCLA_MODEL_LABEL)) {
-		return buildMlclaModel_(config);
+		return buildMlclaModel_(config, nbThreads);
 	}
 
 	CLA_ALERT("Error: There is no model that can be built.");
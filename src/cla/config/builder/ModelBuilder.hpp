@@ -35,9 +35,13 @@ private:
 	 * Build the mlcla model instance.
 	 * 
 	 * @param config The config of the mlcla model on the JSON.
+	 * @param nbThreads The number of the threads that build the layers.
 	 * @return PCLA The pointer of the mlcla model instance.
 	 */
-	static PCLA buildMlclaModel_(const json& config);
+	static PCLA buildMlclaModel_(
+		const json& config,
+		const std::size_t nbThreads
+	);
 
 
 public:
@@ -56,20 +60,28 @@ public:
 	 * Build the cla model instance.
 	 * 
 	 * @param config The config of the cla model on the JSON.
+	 * @param nbThreads The number of the threads that build the layers.
+	 * If the number is 1, the layers are built one by one.
 	 * @return PCLA The pointer of the cla model instance.
 	 */
-	static PCLA buildModel(const json& config);
+	static PCLA buildModel(
+		const json& config,
+		const std::size_t nbThreads = 1u
+	);
 
 	/**
 	 * Build the cla model instance.
 	 * 
 	 * @param type The name of the model type.
 	 * @param config The config of the cla model on the JSON.
+	 * @param nbThreads The number of the threads that build the layers.
+	 * If the number is 1, the layers are built one by one.
 	 * @return PCLA The pointer of the cla model instance.
 	 */
 	static PCLA buildModel(
 		const std::string& type, 
-		const json& config
+		const json& config,
+		const std::size_t nbThreads = 1u
 	);
 
 };
@@ -31,6 +31,7 @@ PLayer LayerJsonBuilder::buildHtmLayer_(const json& config) {
 	std::vector<htm::UInt> columnDimensions = {};
 	htm::UInt nbCellsForColumn = 0u;
 	htm::UInt nbRegions = 0u;
+	htm::UInt nbThreads = 1u;
 
 	// The values to initialize sps later.
 	std::string tmpSPType;
@@ -64,6 +65,11 @@ PLayer LayerJsonBuilder::buildHtmLayer_(const json& config) {
 			continue;
 		}
 
+		if(KeyHelper::contain(key, LJLabel::PARAM_NB_THREADS_LABEL)) {
+			value.get_to(nbThreads);
+			continue;
+		}
+
 		if(KeyHelper::contain(key, LJLabel::ACCEPTER_KEYWORD)) {
 			accepter = std::move(AccepterJsonBuilder::buildAccepter(key, value));
 			continue;
@@ -108,6 +114,7 @@ PLayer LayerJsonBuilder::buildHtmLayer_(const json& config) {
 
 	CLA_CHECK(nbCellsForColumn > 0, "Error: A nbCellsForColumn value is not allowed.");
 	CLA_CHECK(nbRegions, "Error: A nbRegions value is not allowed.");
+	CLA_CHECK(nbThreads, "Error: A nbThreads value is not allowed.");
 
 	// Late initializing.
 	for(htm::UInt i = 0u; i < nbRegions; ++i) {
@@ -133,7 +140,8 @@ PLayer LayerJsonBuilder::buildHtmLayer_(const json& config) {
 		std::move(adapter), 
 		std::move(sender),
 		std::move(receiver),
-		std::move(sps), std::move(tm)
+		std::move(sps), std::move(tm),
+		nbThreads
 	);
 };
 
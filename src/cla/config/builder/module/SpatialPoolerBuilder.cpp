@@ -41,6 +41,8 @@ PSpatialPooler SpatialPoolerJsonBuilder::buildHtmSpatialPooler_(
 	htm::UInt spVerbosity;
 	bool wrapAround;
 	bool constSynInitPermanence;
+	htm::UInt connectedBitsRefreshPeriod = 0u;
+	htm::UInt initThreads = 0u;
 
 	for(const auto& [key, value] : config.items()) {
 		if(KeyHelper::contain(key, SPJLabel::PARAM_INPUT_DIMENSIONS)) {
@@ -133,6 +135,16 @@ PSpatialPooler SpatialPoolerJsonBuilder::buildHtmSpatialPooler_(
 			continue;
 		}
 
+		if(KeyHelper::contain(key, SPJLabel::PARAM_CONNECTED_BITS_REFRESH_PERIOD)) {
+			value.get_to(connectedBitsRefreshPeriod);
+			continue;
+		}
+
+		if(KeyHelper::contain(key, SPJLabel::PARAM_INIT_THREADS)) {
+			value.get_to(initThreads);
+			continue;
+		}
+
 		CLA_ALERT("Error: There are parameters that are not assumed.");
 	}
 
@@ -143,7 +155,7 @@ PSpatialPooler SpatialPoolerJsonBuilder::buildHtmSpatialPooler_(
 		synPermInactiveDec, synPermActiveInc, synPermConnected,
 		synInitPermanence, minPctOverlapDutyCycles, dutyCyclePeriod,
 		boostStrength, seed, spVerbosity, wrapAround,
-		constSynInitPermanence
+		constSynInitPermanence, connectedBitsRefreshPeriod, initThreads
 	);
 }
 
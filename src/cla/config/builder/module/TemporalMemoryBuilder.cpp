@@ -51,6 +51,7 @@ PTemporalMemory TemporalMemoryJsonBuilder::buildHtmTemporalMemory_(const json& c
 	std::string innerSegmentSelectorModeStr;
 	std::string outerSegmentSelectorModeStr;
 	int anomalyIntMode;
+	std::vector<std::string> recordedEventsStr;
 
 	for(const auto& [key, value] : config.items()) {
 		if(KeyHelper::contain(key, TMJLabel::PARAM_NUM_REGIONS)) {
@@ -182,12 +183,17 @@ PTemporalMemory TemporalMemoryJsonBuilder::buildHtmTemporalMemory_(const json& c
 			value.get_to(anomalyIntMode);
 			continue;
 		}
+
+		if(KeyHelper::contain(key, TMJLabel::PARAM_RECORDED_EVENTS)) {
+			value.get_to(recordedEventsStr);
+			continue;
+		}
 		
 		CLA_ALERT("Error: There are parameters that are not assumed.");
 	}
 
 
-	return TemporalMemoryGenerator<HtmTemporalMemory>::generate(
+	auto tm = TemporalMemoryGenerator<HtmTemporalMemory>::generate(
 		numRegions, columnDimensions, cellsPerColumn, activationThreshold,
 		initialPermanence, connectedPermanence, minThreshold,
 		maxNewSynapseCount, permanenceIncrement, permanenceDecrement,
@@ -200,6 +206,11 @@ PTemporalMemory TemporalMemoryJsonBuilder::buildHtmTemporalMemory_(const json& c
 		htm::SegmentSelectors::getMode(outerSegmentSelectorModeStr),
 		static_cast<htm::TemporalMemoryExtension::ANMode>(anomalyIntMode)
 	);
+
+	// The callbacks which read the events need them recorded here.
+	tm->setRecordedEvents(htm::ConnectionsEvent::getEvents(recordedEventsStr));
+
+	return tm;
 }
 
 
@@ -78,6 +78,8 @@ struct SpatialPoolerJsonLabels {
 	inline static Label PARAM_SP_VERBOSITY = "spVerbosity";	
 	inline static Label PARAM_WRAP_AROUND = "wrapAround";
 	inline static Label PARAM_CONST_SYN_INIT_PERMANENCE = "constSynInitPermanence";
+	inline static Label PARAM_CONNECTED_BITS_REFRESH_PERIOD = "connectedBitsRefreshPeriod";
+	inline static Label PARAM_INIT_THREADS = "initThreads";
 };
 
 
@@ -119,6 +121,7 @@ struct TemporalMemoryJsonLabels {
 	inline static Label PARAM_INNER_SEGMENT_SELECTOR_MODE = "innerSegmentSelectorMode";
 	inline static Label PARAM_OUTER_SEGMENT_SELECTOR_MODE = "outerSegmentSelectorMode";
 	inline static Label PARAM_ANOMALY_MODE = "anomalyMode";
+	inline static Label PARAM_RECORDED_EVENTS = "recordedEvents";
 };
 
 
@@ -169,6 +172,7 @@ struct LayerJsonLabels {
 	inline static Label PARAM_COLUMN_DIMENSION_LABEL = "columnDimensions";
 	inline static Label PARAM_NB_CELLS_FOR_COLUMNS_LABEL = "nbCellsForColumns";
 	inline static Label PARAM_NB_REGIONS_LABEL = "nbRegions";
+	inline static Label PARAM_NB_THREADS_LABEL = "nbThreads";
 
 	inline static Label ACCEPTER_KEYWORD = "Accepter";
 	inline static Label ADAPTER_KEYWORD = "Adapter";
@@ -0,0 +1,111 @@
+// DataSource.cpp
+
+/**
+ * @file
+ * Implementation of DataSource.cpp
+ */
+
+#include <exception>
+#include <sstream>
+
+#include "cla/environment/DataSource.hpp"
+#include "cla/utils/Checker.hpp"
+
+namespace cla {
+
+/************************************************
+ * DataSource public functions
+ ***********************************************/
+
+Step DataSource::skip(const Step nbSteps) {
+	Values values;
+	Step nbSkipped = 0u;
+
+	while(nbSkipped < nbSteps && next(values)) ++nbSkipped;
+
+	return nbSkipped;
+}
+
+
+/************************************************
+ * CsvSource private functions
+ ***********************************************/
+
+bool CsvSource::parse_(const std::string& line, Values& values) {
+	values.clear();
+
+	std::istringstream iss(line);
+	std::string cell;
+
+	while(std::getline(iss, cell, ',')) {
+		std::size_t end = 0u;
+		try {
+			values.push_back(std::stod(cell, &end));
+		} catch(const std::exception&) {
+			return false;
+		}
+		if(cell.find_first_not_of(" \t", end) != std::string::npos)
+			return false;
+	}
+
+	return !values.empty();
+}
+
+
+/************************************************
+ * CsvSource public functions
+ ***********************************************/
+
+CsvSource::CsvSource(std::istream& is, const std::string& name)
+	: is_(is), name_(name), nbLines_(0u), nbValues_(0u), hasHeader_(false) {}
+
+bool CsvSource::next(Values& values) {
+	std::string line;
+
+	while(std::getline(is_, line)) {
+		++nbLines_;
+
+		if(!line.empty() && line.back() == '\r') line.pop_back();
+		if(line.find_first_not_of(" \t") == std::string::npos || line.front() == '#')
+			continue;
+
+		// A header row can come only before the first values.
+		if(!parse_(line, values)) {
+			CLA_CHECK_THROW(
+				nbValues_ == 0u && !hasHeader_,
+				"Cannot read the values at " << name_ << ":" << nbLines_
+			)
+			hasHeader_ = true;
+			continue;
+		}
+
+		if(nbValues_ == 0u) nbValues_ = values.size();
+		CLA_CHECK_THROW(
+			values.size() == nbValues_,
+			"The number of the values is changed at " << name_ << ":" << nbLines_
+		)
+		return true;
+	}
+
+	return false;
+}
+
+
+/************************************************
+ * EnvSource public functions
+ ***********************************************/
+
+EnvSource::EnvSource(PEnv env) : env_(env), started_(false) {
+	env_->reset();
+}
+
+bool EnvSource::next(Values& values) {
+	if(started_) env_->increment();
+	started_ = true;
+
+	values = env_->getValues();
+	return true;
+}
+
+
+} // namespace cla
@@ -0,0 +1,154 @@
+// DataSource.hpp
+
+/**
+ * @file
+ * Definitions for the DataSource classes in C++
+ */
+
+#ifndef DATA_SOURCE_HPP
+#define DATA_SOURCE_HPP
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "cla/environment/core/CoreEnv.hpp"
+
+namespace cla {
+
+/**
+ * DataSource implementation in C++
+ *
+ * @b Description
+ * The DataSource is an abstract class for the stream of the input values
+ * of a model. The source gives the values of the steps one by one, so only
+ * the current values are held however long the stream is.
+ */
+class DataSource {
+
+public:
+
+	/**
+	 * DataSource constructor
+	 */
+	DataSource() = default;
+
+	/**
+	 * DataSource destructor
+	 */
+	virtual ~DataSource() = default;
+
+	/**
+	 * Get the values of the next step.
+	 *
+	 * @param values The values. (This param has a return value.)
+	 * @return bool Whether the values are given, false at the end.
+	 */
+	virtual bool next(Values& values) = 0;
+
+	/**
+	 * Skip the values of the steps.
+	 *
+	 * @param nbSteps The number of the steps to skip.
+	 * @return Step The number of the skipped steps, which is less than
+	 * nbSteps only at the end of the source.
+	 */
+	Step skip(const Step nbSteps);
+};
+
+using PDataSource = std::unique_ptr<DataSource>;
+
+
+/**
+ * CsvSource implementation in C++
+ *
+ * @b Description
+ * The CsvSource is the source of the csv rows of a stream. A row is the
+ * comma separated input values of one step. The blank lines, the lines
+ * which start with '#' and one header row before the first values are
+ * skipped, and a carriage return at the end of a line is dropped. All the
+ * rows must have the same number of the values.
+ *
+ * A row which cannot be read throws std::runtime_error with the name and
+ * the line of the stream.
+ */
+class CsvSource : public DataSource {
+
+private:
+
+	std::istream& is_;
+	std::string name_;
+	std::size_t nbLines_;
+	std::size_t nbValues_;
+	bool hasHeader_;
+
+private:
+
+	static bool parse_(const std::string& line, Values& values);
+
+public:
+
+	/**
+	 * CsvSource constructor
+	 *
+	 * @param is The stream of the csv rows. It must outlive the source.
+	 * @param name The name of the stream in the error messages.
+	 */
+	CsvSource(std::istream& is, const std::string& name);
+
+	/**
+	 * CsvSource destructor
+	 */
+	~CsvSource() = default;
+
+	/**
+	 * Get the values of the next row.
+	 *
+	 * @param values The values. (This param has a return value.)
+	 * @return bool Whether the values are given, false at the end.
+	 */
+	bool next(Values& values) override;
+};
+
+
+/**
+ * EnvSource implementation in C++
+ *
+ * @b Description
+ * The EnvSource is the endless source of the values of an environment.
+ * The environment is reset at the construction.
+ */
+class EnvSource : public DataSource {
+
+private:
+
+	PEnv env_;
+	bool started_;
+
+public:
+
+	/**
+	 * EnvSource constructor
+	 *
+	 * @param env The environment.
+	 */
+	explicit EnvSource(PEnv env);
+
+	/**
+	 * EnvSource destructor
+	 */
+	~EnvSource() = default;
+
+	/**
+	 * Get the values of the next step of the environment.
+	 *
+	 * @param values The values. (This param has a return value.)
+	 * @return bool Always true.
+	 */
+	bool next(Values& values) override;
+};
+
+
+} // namespace cla
+
+#endif // DATA_SOURCE_HPP
@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 #include <type_traits>
 
 #include <htm/types/Types.hpp>
@@ -0,0 +1,294 @@
+// ConnectedBitMatrix.cpp
+
+/**
+ * @file
+ * Implementation of ConnectedBitMatrix
+ */
+
+#include <bitset>
+
+#include <cla/extension/algorithms/ConnectedBitMatrix.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CLA_BIT_MATRIX_X86
+#include <immintrin.h>
+#endif
+
+namespace htm {
+
+namespace {
+
+using OverlapKernel = void (*)(
+	const UInt64* rows,
+	const UInt numRows,
+	const UInt wordsPerRow,
+	const UInt64* input,
+	SynapseIdx* overlaps
+);
+
+void overlapsScalar(
+	const UInt64* rows,
+	const UInt numRows,
+	const UInt wordsPerRow,
+	const UInt64* input,
+	SynapseIdx* overlaps
+) {
+	for(UInt r = 0u; r < numRows; ++r, rows += wordsPerRow) {
+		UInt64 count = 0u;
+		for(UInt w = 0u; w < wordsPerRow; ++w) {
+#ifdef __GNUC__
+			count += __builtin_popcountll(rows[w] & input[w]);
+#else
+			count += std::bitset<64>(rows[w] & input[w]).count();
+#endif
+		}
+		overlaps[r] = static_cast<SynapseIdx>(count);
+	}
+}
+
+#ifdef CLA_BIT_MATRIX_X86
+
+// The popcount of the bytes by the lookup of the nibbles (W. Mula).
+__attribute__((target("avx2")))
+void overlapsAvx2(
+	const UInt64* rows,
+	const UInt numRows,
+	const UInt wordsPerRow,
+	const UInt64* input,
+	SynapseIdx* overlaps
+) {
+	const __m256i lookup = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+	);
+	const __m256i lowMask = _mm256_set1_epi8(0x0f);
+	const __m256i zero = _mm256_setzero_si256();
+
+	for(UInt r = 0u; r < numRows; ++r, rows += wordsPerRow) {
+		__m256i sums = zero;
+
+		for(UInt w = 0u; w < wordsPerRow; w += 4u) {
+			const __m256i bits = _mm256_and_si256(
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + w)),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + w))
+			);
+			const __m256i low = _mm256_and_si256(bits, lowMask);
+			const __m256i high = _mm256_and_si256(_mm256_srli_epi16(bits, 4), lowMask);
+			const __m256i counts = _mm256_add_epi8(
+				_mm256_shuffle_epi8(lookup, low),
+				_mm256_shuffle_epi8(lookup, high)
+			);
+			sums = _mm256_add_epi64(sums, _mm256_sad_epu8(counts, zero));
+		}
+
+		const __m128i half = _mm_add_epi64(
+			_mm256_castsi256_si128(sums),
+			_mm256_extracti128_si256(sums, 1)
+		);
+		const UInt64 count = static_cast<UInt64>(_mm_cvtsi128_si64(half))
+			+ static_cast<UInt64>(_mm_extract_epi64(half, 1));
+		overlaps[r] = static_cast<SynapseIdx>(count);
+	}
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+void overlapsAvx512(
+	const UInt64* rows,
+	const UInt numRows,
+	const UInt wordsPerRow,
+	const UInt64* input,
+	SynapseIdx* overlaps
+) {
+	for(UInt r = 0u; r < numRows; ++r, rows += wordsPerRow) {
+		__m512i sums = _mm512_setzero_si512();
+
+		for(UInt w = 0u; w < wordsPerRow; w += 8u) {
+			const __m512i bits = _mm512_and_si512(
+				_mm512_loadu_si512(rows + w),
+				_mm512_loadu_si512(input + w)
+			);
+			sums = _mm512_add_epi64(sums, _mm512_popcnt_epi64(bits));
+		}
+
+		overlaps[r] = static_cast<SynapseIdx>(_mm512_reduce_add_epi64(sums));
+	}
+}
+
+#endif // CLA_BIT_MATRIX_X86
+
+struct SelectedKernel {
+	OverlapKernel kernel = overlapsScalar;
+	const char* name = "scalar";
+
+	SelectedKernel() {
+#ifdef CLA_BIT_MATRIX_X86
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx512f")
+			&& __builtin_cpu_supports("avx512vpopcntdq")) {
+			kernel = overlapsAvx512;
+			name = "avx512";
+		} else if(__builtin_cpu_supports("avx2")) {
+			kernel = overlapsAvx2;
+			name = "avx2";
+		}
+#endif
+	}
+};
+
+const SelectedKernel& selectedKernel() {
+	static const SelectedKernel selected;
+	return selected;
+}
+
+} // namespace
+
+
+/**
+ * ConnectedBitMatrix methods
+ */
+void ConnectedBitMatrix::rebuild_() const {
+	fillRows(*connections_, numColumns_, wordsPerRow_, rows_.data());
+}
+
+void ConnectedBitMatrix::initialize(
+	const Connections* connections,
+	const UInt numColumns,
+	const UInt numInputs
+) {
+	connections_ = connections;
+	numColumns_ = numColumns;
+	numInputs_ = numInputs;
+	wordsPerRow_ = wordsPerRow(numInputs);
+
+	rows_.assign(static_cast<size_t>(numColumns_) * wordsPerRow_, 0u);
+	invalidate();
+}
+
+void ConnectedBitMatrix::invalidate() {
+	stale_.store(true);
+}
+
+void ConnectedBitMatrix::computeOverlaps(
+	const std::vector<CellIdx>& activeInputs,
+	std::vector<SynapseIdx>& overlaps
+) const {
+	std::vector<UInt64> inputWords;
+	computeOverlaps(activeInputs, overlaps, inputWords);
+}
+
+void ConnectedBitMatrix::computeOverlaps(
+	const std::vector<CellIdx>& activeInputs,
+	std::vector<SynapseIdx>& overlaps,
+	std::vector<UInt64>& inputWords
+) const {
+	NTA_ASSERT(connections_ != nullptr);
+
+	if(stale_.load(std::memory_order_acquire)) {
+		const std::lock_guard<std::mutex> lock(rebuildMutex_);
+
+		if(stale_.load(std::memory_order_relaxed)) {
+			rebuild_();
+			stale_.store(false, std::memory_order_release);
+		}
+	}
+
+	computeOverlaps(
+		rows_.data(), numColumns_, wordsPerRow_, numInputs_,
+		activeInputs, overlaps, inputWords
+	);
+}
+
+UInt ConnectedBitMatrix::wordsPerRow(const UInt numInputs) {
+	const UInt words = (numInputs + WORD_BITS - 1u) / WORD_BITS;
+	return (words + ROW_ALIGNMENT - 1u) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+}
+
+void ConnectedBitMatrix::fillRows(
+	const Connections& connections,
+	const UInt numColumns,
+	const UInt wordsPerRow,
+	UInt64* rows
+) {
+	std::fill(rows, rows + static_cast<size_t>(numColumns) * wordsPerRow, UInt64(0u));
+
+	const Permanence threshold = connections.getConnectedThreshold();
+
+	// Each column has a single segment, so the segment is the column.
+	for(CellIdx column = 0u; column < numColumns; ++column) {
+		UInt64* row = rows + static_cast<size_t>(column) * wordsPerRow;
+
+		for(const Synapse synapse : connections.synapsesForSegment(column)) {
+			const auto& synData = connections.dataForSynapse(synapse);
+
+			if(synData.permanence >= threshold) {
+				const CellIdx input = synData.presynapticCell;
+				row[input / WORD_BITS] |= UInt64(1u) << (input % WORD_BITS);
+			}
+		}
+	}
+}
+
+void ConnectedBitMatrix::computeOverlaps(
+	const UInt64* rows,
+	const UInt numRows,
+	const UInt wordsPerRow,
+	const UInt numInputs,
+	const std::vector<CellIdx>& activeInputs,
+	std::vector<SynapseIdx>& overlaps
+) {
+	std::vector<UInt64> inputWords;
+	computeOverlaps(
+		rows, numRows, wordsPerRow, numInputs, activeInputs, overlaps, inputWords
+	);
+}
+
+void ConnectedBitMatrix::computeOverlaps(
+	const UInt64* rows,
+	const UInt numRows,
+	const UInt wordsPerRow,
+	const UInt numInputs,
+	const std::vector<CellIdx>& activeInputs,
+	std::vector<SynapseIdx>& overlaps,
+	std::vector<UInt64>& inputWords
+) {
+	inputWords.assign(wordsPerRow, 0u);
+	for(const CellIdx bit : activeInputs) {
+		NTA_ASSERT(bit < numInputs);
+		inputWords[bit / WORD_BITS] |= UInt64(1u) << (bit % WORD_BITS);
+	}
+
+	overlaps.resize(numRows);
+	selectedKernel().kernel(
+		rows, numRows, wordsPerRow, inputWords.data(), overlaps.data()
+	);
+}
+
+const char* ConnectedBitMatrix::kernelName() {
+	return selectedKernel().name;
+}
+
+void ConnectedBitMatrix::onCreateSynapse(Synapse synapse) {
+	invalidate();
+}
+
+void ConnectedBitMatrix::onCreateSynapses(const std::vector<Synapse>& synapses) {
+	invalidate();
+}
+
+void ConnectedBitMatrix::onDestroySynapse(Synapse synapse) {
+	invalidate();
+}
+
+void ConnectedBitMatrix::onUpdateSynapsePermanence(
+	Synapse synapse,
+	Permanence permanence
+) {
+	invalidate();
+}
+
+void ConnectedBitMatrix::onCompact(const ConnectionsRemap& remap) {
+	invalidate();
+}
+
+
+} // namespace htm
@@ -0,0 +1,232 @@
+// ConnectedBitMatrix.hpp
+
+/**
+ * @file
+ * Definitions for the ConnectedBitMatrix in C++
+ */
+
+#ifndef CONNECTED_BIT_MATRIX_HPP
+#define CONNECTED_BIT_MATRIX_HPP
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Types.hpp>
+
+
+namespace htm {
+
+/**
+ * ConnectedBitMatrix implementation in C++.
+ *
+ * @b Description
+ * The ConnectedBitMatrix is the frozen view of the column-synapses of the
+ * spatial pooler for the inference. Each column has a row of packed bits,
+ * one bit for each input, which is set when the column has a connected
+ * synapse to the input. The overlap of a column is then the popcount of
+ * its row AND the packed input, computed with AVX-512 or AVX2 when the cpu
+ * supports them and with the scalar popcount otherwise.
+ *
+ * The matrix is marked stale by the synapse events and is rebuilt on the
+ * next lookup, so it is built when learning is switched off. Lookups may
+ * run concurrently as long as the connections are not modified at the
+ * same time.
+ */
+class ConnectedBitMatrix : public ConnectionsEventHandler {
+
+public:
+
+	// The rows are padded to the width of one AVX-512 register.
+	static constexpr UInt WORD_BITS = 64u;
+	static constexpr UInt ROW_ALIGNMENT = 8u;
+
+private:
+
+	const Connections* connections_ = nullptr;
+
+	UInt numColumns_ = 0u;
+	UInt numInputs_ = 0u;
+	UInt wordsPerRow_ = 0u;
+
+	mutable std::vector<UInt64> rows_;
+	mutable std::atomic<bool> stale_{true};
+	mutable std::mutex rebuildMutex_;
+
+private:
+
+	void rebuild_() const;
+
+public:
+
+	/**
+	 * ConnectedBitMatrix constructor.
+	 */
+	ConnectedBitMatrix() = default;
+
+	/**
+	 * ConnectedBitMatrix destructor.
+	 */
+	~ConnectedBitMatrix() = default;
+
+	/**
+	 * Initialize ConnectedBitMatrix. The matrix is marked stale.
+	 *
+	 * @param connections The column-synapses of the spatial pooler.
+	 * @param numColumns The number of columns.
+	 * @param numInputs The number of inputs.
+	 */
+	void initialize(
+		const Connections* connections,
+		const UInt numColumns,
+		const UInt numInputs
+	);
+
+	/**
+	 * Mark the matrix stale.
+	 */
+	void invalidate();
+
+	/**
+	 * Compute the number of the connected synapses to the active inputs
+	 * for each column. The result is the same as
+	 * Connections::computeActivity.
+	 *
+	 * @param activeInputs The sorted or unsorted indexes of active inputs.
+	 * @param overlaps The overlaps of the columns. (This param has a
+	 * return value.)
+	 */
+	void computeOverlaps(
+		const std::vector<CellIdx>& activeInputs,
+		std::vector<SynapseIdx>& overlaps
+	) const;
+
+	/**
+	 * Compute the overlaps with the caller-owned buffer of the input
+	 * words, so the repeated calls of a stream do not allocate.
+	 *
+	 * @param activeInputs The sorted or unsorted indexes of active inputs.
+	 * @param overlaps The overlaps of the columns. (This param has a
+	 * return value.)
+	 * @param inputWords The buffer of the input words. (This param has a
+	 * return value.)
+	 */
+	void computeOverlaps(
+		const std::vector<CellIdx>& activeInputs,
+		std::vector<SynapseIdx>& overlaps,
+		std::vector<UInt64>& inputWords
+	) const;
+
+	/**
+	 * Get the number of the words of a row, padded to ROW_ALIGNMENT.
+	 *
+	 * @param numInputs The number of inputs.
+	 */
+	static UInt wordsPerRow(const UInt numInputs);
+
+	/**
+	 * Fill the rows with the connected synapses of the columns. This is
+	 * the layout of the matrix, also used by the frozen model image.
+	 *
+	 * @param connections The column-synapses of the spatial pooler.
+	 * @param numColumns The number of columns.
+	 * @param wordsPerRow The number of the words of a row.
+	 * @param rows The rows, numColumns * wordsPerRow words. (This param
+	 * has a return value.)
+	 */
+	static void fillRows(
+		const Connections& connections,
+		const UInt numColumns,
+		const UInt wordsPerRow,
+		UInt64* rows
+	);
+
+	/**
+	 * Compute the overlaps of the rows which are not owned by a matrix,
+	 * e.g. the rows of a memory-mapped model image.
+	 *
+	 * @param rows The rows, numRows * wordsPerRow words.
+	 * @param numRows The number of the rows (columns).
+	 * @param wordsPerRow The number of the words of a row.
+	 * @param numInputs The number of inputs.
+	 * @param activeInputs The sorted or unsorted indexes of active inputs.
+	 * @param overlaps The overlaps of the columns. (This param has a
+	 * return value.)
+	 */
+	static void computeOverlaps(
+		const UInt64* rows,
+		const UInt numRows,
+		const UInt wordsPerRow,
+		const UInt numInputs,
+		const std::vector<CellIdx>& activeInputs,
+		std::vector<SynapseIdx>& overlaps
+	);
+
+	/**
+	 * Compute the overlaps of the rows which are not owned by a matrix
+	 * with the caller-owned buffer of the input words.
+	 *
+	 * @param rows The rows, numRows * wordsPerRow words.
+	 * @param numRows The number of the rows (columns).
+	 * @param wordsPerRow The number of the words of a row.
+	 * @param numInputs The number of inputs.
+	 * @param activeInputs The sorted or unsorted indexes of active inputs.
+	 * @param overlaps The overlaps of the columns. (This param has a
+	 * return value.)
+	 * @param inputWords The buffer of the input words. (This param has a
+	 * return value.)
+	 */
+	static void computeOverlaps(
+		const UInt64* rows,
+		const UInt numRows,
+		const UInt wordsPerRow,
+		const UInt numInputs,
+		const std::vector<CellIdx>& activeInputs,
+		std::vector<SynapseIdx>& overlaps,
+		std::vector<UInt64>& inputWords
+	);
+
+	/**
+	 * Get the name of the popcount kernel selected for this cpu.
+	 *
+	 * @return const char* "avx512", "avx2" or "scalar".
+	 */
+	static const char* kernelName();
+
+	void onCreateSegment(Segment segment) override {}
+	void onDestroySegment(Segment segment) override {}
+
+	/**
+	 * Called after a synapse is created.
+	 */
+	void onCreateSynapse(Synapse synapse) override;
+
+	/**
+	 * Called after the synapses of a segment are created.
+	 */
+	void onCreateSynapses(const std::vector<Synapse>& synapses) override;
+
+	/**
+	 * Called before a synapse is destroyed.
+	 */
+	void onDestroySynapse(Synapse synapse) override;
+
+	/**
+	 * Called after a synapse crosses the connected threshold.
+	 */
+	void onUpdateSynapsePermanence(
+		Synapse synapse,
+		Permanence permanence
+	) override;
+
+	/**
+	 * Called after the connections are compacted.
+	 */
+	void onCompact(const ConnectionsRemap& remap) override;
+};
+
+
+} // namespace htm
+
+#endif // CONNECTED_BIT_MATRIX_HPP
@@ -0,0 +1,414 @@
+// FrozenConnections.cpp
+
+/**
+ * @file
+ * Implementation of FrozenConnections
+ */
+
+#include <cstdint>
+
+#include <cla/extension/algorithms/FrozenConnections.hpp>
+
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+namespace {
+
+constexpr UInt32 FNV_OFFSET_BASIS = 2166136261u;
+constexpr UInt32 FNV_PRIME = 16777619u;
+
+// The FNV-1a hash over the 4 byte words instead of the bytes.
+UInt32 updateChecksum(UInt32 checksum, const UInt32* first, const UInt32* last) {
+	for(const UInt32* it = first; it != last; ++it) {
+		checksum ^= *it;
+		checksum *= FNV_PRIME;
+	}
+	return checksum;
+}
+
+template<typename T>
+UInt32 updateChecksum(const UInt32 checksum, const std::vector<T>& values) {
+	static_assert(sizeof(T) == 4u, "The arrays of the image are 4 bytes wide.");
+	const UInt32* first = reinterpret_cast<const UInt32*>(values.data());
+	return updateChecksum(checksum, first, first + values.size());
+}
+
+// The offsets start at zero and never decrease.
+bool isMonotonic(const UInt32* offsets, const size_t count) {
+	if(offsets[0] != 0u) return false;
+	for(size_t i = 1u; i < count; ++i)
+		if(offsets[i] < offsets[i - 1u]) return false;
+	return true;
+}
+
+template<typename T>
+bool isInRange(const T* values, const size_t count, const size_t size) {
+	for(size_t i = 0u; i < count; ++i)
+		if(static_cast<size_t>(values[i]) >= size) return false;
+	return true;
+}
+
+template<typename T>
+void writeArray(std::ostream& os, const std::vector<T>& values, size_t& bytes) {
+	static_assert(sizeof(T) == 4u, "The arrays of the image are 4 bytes wide.");
+	os.write(
+		reinterpret_cast<const char*>(values.data()),
+		static_cast<std::streamsize>(values.size() * sizeof(T))
+	);
+	bytes += values.size() * sizeof(T);
+}
+
+template<typename T>
+const T* readArray(const char*& cursor, const char* last, const size_t count) {
+	static_assert(sizeof(T) == 4u, "The arrays of the image are 4 bytes wide.");
+	NTA_CHECK(static_cast<size_t>(last - cursor) >= count * sizeof(T))
+		<< "The frozen connections image is truncated.";
+	const T* values = reinterpret_cast<const T*>(cursor);
+	cursor += count * sizeof(T);
+	return values;
+}
+
+// The CSR form of the presynaptic table, in the order of the Connections.
+template<typename Table>
+void flattenTable(
+	const size_t numRows,
+	const Table& table,
+	std::vector<UInt32>& offsets,
+	std::vector<Segment>& segments
+) {
+	offsets.assign(1u, 0u);
+	segments.clear();
+	for(size_t cell = 0u; cell < numRows; ++cell) {
+		const auto& row = table(static_cast<CellIdx>(cell));
+		segments.insert(segments.end(), row.begin(), row.end());
+		offsets.push_back(static_cast<UInt32>(segments.size()));
+	}
+}
+
+} // namespace
+
+
+/**
+ * FrozenConnections private methods
+ */
+void FrozenConnections::validate_(
+	const Header& header,
+	const char* first,
+	const char* last
+) const {
+	const UInt32 checksum = updateChecksum(
+		FNV_OFFSET_BASIS,
+		reinterpret_cast<const UInt32*>(first),
+		reinterpret_cast<const UInt32*>(last)
+	);
+	NTA_CHECK(checksum == header.checksum)
+		<< "The checksum of the frozen connections image does not match.";
+
+	const size_t numCells = header.numCells;
+	const size_t numSegments = header.numSegments;
+	const size_t numPresynapticCells = header.numPresynapticCells;
+
+	NTA_CHECK(isMonotonic(cellSegmentOffsets_, numCells + 1u))
+		<< "The segment offsets of the cells are not monotonic.";
+	NTA_CHECK(cellSegmentOffsets_[numCells] <= numSegments)
+		<< "The cells have more segments than the image.";
+	NTA_CHECK(isInRange(cellSegments_, cellSegmentOffsets_[numCells], numSegments))
+		<< "A segment of the cells is out of range.";
+	for(size_t cell = 0u; cell < numCells; ++cell) {
+		for(UInt32 i = cellSegmentOffsets_[cell]; i < cellSegmentOffsets_[cell + 1u]; ++i) {
+			NTA_CHECK(segmentCells_[cellSegments_[i]] == cell)
+				<< "The segment " << cellSegments_[i] << " is not on the cell " << cell;
+		}
+	}
+	NTA_CHECK(isInRange(segmentCells_, numSegments, numCells))
+		<< "The cell of a segment is out of range.";
+
+	NTA_CHECK(isMonotonic(segmentSynapseOffsets_, numSegments + 1u))
+		<< "The synapse offsets of the segments are not monotonic.";
+	for(size_t segment = 0u; segment < numSegments; ++segment) {
+		const UInt32 end = segmentSynapseOffsets_[segment + 1u];
+		for(UInt32 i = segmentSynapseOffsets_[segment]; i < end; ++i) {
+			NTA_CHECK(synapseSegments_[i] == segment)
+				<< "The synapse " << i << " is not on the segment " << segment;
+		}
+	}
+	NTA_CHECK(isInRange(
+		synapsePresynapticCells_, header.numSynapses, numPresynapticCells
+	)) << "The presynaptic cell of a synapse is out of range.";
+
+	NTA_CHECK(isMonotonic(potentialOffsets_, numPresynapticCells + 1u))
+		<< "The potential offsets are not monotonic.";
+	NTA_CHECK(isInRange(potentialSegments_, header.numPotential, numSegments))
+		<< "A potential segment is out of range.";
+	NTA_CHECK(isMonotonic(connectedOffsets_, numPresynapticCells + 1u))
+		<< "The connected offsets are not monotonic.";
+	NTA_CHECK(isInRange(connectedSegments_, header.numConnected, numSegments))
+		<< "A connected segment is out of range.";
+}
+
+
+/**
+ * FrozenConnections methods
+ */
+FrozenConnections::FrozenConnections(
+	const void* image,
+	const size_t bytes,
+	const bool validate
+) {
+	attach(image, bytes, validate);
+}
+
+void FrozenConnections::attach(
+	const void* image,
+	const size_t bytes,
+	const bool validate
+) {
+	// The view stays empty when the image is rejected.
+	header_ = nullptr;
+
+	NTA_CHECK(image != nullptr);
+	NTA_CHECK(reinterpret_cast<uintptr_t>(image) % alignof(Header) == 0u)
+		<< "The frozen connections image is not aligned.";
+
+	const char* cursor = static_cast<const char*>(image);
+	const char* last = cursor + bytes;
+
+	NTA_CHECK(bytes >= sizeof(Header))
+		<< "The frozen connections image is truncated.";
+	const Header* header = reinterpret_cast<const Header*>(cursor);
+	NTA_CHECK(header->magic == MAGIC && header->version == VERSION)
+		<< "The image is not a frozen connections image of version " << VERSION;
+	cursor += sizeof(Header);
+
+	cellSegmentOffsets_ = readArray<UInt32>(
+		cursor, last, size_t{header->numCells} + 1u
+	);
+	cellSegments_ = readArray<Segment>(
+		cursor, last, cellSegmentOffsets_[header->numCells]
+	);
+	segmentCells_ = readArray<CellIdx>(cursor, last, header->numSegments);
+	segmentOrdinals_ = readArray<Segment>(cursor, last, header->numSegments);
+	segmentSynapseOffsets_ = readArray<UInt32>(
+		cursor, last, size_t{header->numSegments} + 1u
+	);
+	NTA_CHECK(segmentSynapseOffsets_[header->numSegments] == header->numSynapses)
+		<< "The frozen connections image is corrupted.";
+	synapsePresynapticCells_ = readArray<CellIdx>(cursor, last, header->numSynapses);
+	synapsePermanences_ = readArray<Permanence>(cursor, last, header->numSynapses);
+	synapseSegments_ = readArray<Segment>(cursor, last, header->numSynapses);
+
+	potentialOffsets_ = readArray<UInt32>(
+		cursor, last, size_t{header->numPresynapticCells} + 1u
+	);
+	NTA_CHECK(potentialOffsets_[header->numPresynapticCells] == header->numPotential)
+		<< "The frozen connections image is corrupted.";
+	potentialSegments_ = readArray<Segment>(cursor, last, header->numPotential);
+
+	connectedOffsets_ = readArray<UInt32>(
+		cursor, last, size_t{header->numPresynapticCells} + 1u
+	);
+	NTA_CHECK(connectedOffsets_[header->numPresynapticCells] == header->numConnected)
+		<< "The frozen connections image is corrupted.";
+	connectedSegments_ = readArray<Segment>(cursor, last, header->numConnected);
+
+	if(validate) {
+		validate_(*header, static_cast<const char*>(image) + sizeof(Header), cursor);
+	}
+
+	header_ = header;
+}
+
+size_t FrozenConnections::write(std::ostream& os, const Connections& connections) {
+	const size_t numCells = connections.numCells();
+	const size_t numSegments = connections.segmentFlatListLength();
+	const size_t numPresynapticCells = connections.presynapticCellFlatListLength();
+
+	std::vector<UInt32> cellSegmentOffsets(1u, 0u);
+	std::vector<Segment> cellSegments;
+	for(CellIdx cell = 0u; cell < numCells; ++cell) {
+		const auto& segments = connections.segmentsForCell(cell);
+		cellSegments.insert(cellSegments.end(), segments.begin(), segments.end());
+		cellSegmentOffsets.push_back(static_cast<UInt32>(cellSegments.size()));
+	}
+
+	// The destroyed segments have no synapses, so they are never active.
+	std::vector<CellIdx> segmentCells(numSegments);
+	std::vector<Segment> segmentOrdinals(numSegments);
+	std::vector<UInt32> segmentSynapseOffsets(1u, 0u);
+	std::vector<CellIdx> synapsePresynapticCells;
+	std::vector<Permanence> synapsePermanences;
+	std::vector<Segment> synapseSegments;
+	for(Segment segment = 0u; segment < numSegments; ++segment) {
+		segmentCells[segment] = connections.cellForSegment(segment);
+		segmentOrdinals[segment] = connections.dataForSegment(segment).id;
+
+		for(const Synapse synapse : connections.synapsesForSegment(segment)) {
+			const auto& synData = connections.dataForSynapse(synapse);
+			synapsePresynapticCells.push_back(synData.presynapticCell);
+			synapsePermanences.push_back(synData.permanence);
+			synapseSegments.push_back(segment);
+		}
+		segmentSynapseOffsets.push_back(
+			static_cast<UInt32>(synapsePresynapticCells.size())
+		);
+	}
+
+	std::vector<UInt32> potentialOffsets, connectedOffsets;
+	std::vector<Segment> potentialSegments, connectedSegments;
+	flattenTable(
+		numPresynapticCells,
+		[&](const CellIdx cell) -> const std::vector<Segment>& {
+			return connections.potentialSegmentsForPresynapticCell(cell);
+		},
+		potentialOffsets, potentialSegments
+	);
+	flattenTable(
+		numPresynapticCells,
+		[&](const CellIdx cell) -> const std::vector<Segment>& {
+			return connections.connectedSegmentsForPresynapticCell(cell);
+		},
+		connectedOffsets, connectedSegments
+	);
+
+	Header header;
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.numCells = static_cast<UInt32>(numCells);
+	header.numSegments = static_cast<UInt32>(numSegments);
+	header.numSynapses = static_cast<UInt32>(synapsePresynapticCells.size());
+	header.numPresynapticCells = static_cast<UInt32>(numPresynapticCells);
+	header.numPotential = static_cast<UInt32>(potentialSegments.size());
+	header.numConnected = static_cast<UInt32>(connectedSegments.size());
+	header.connectedThreshold = connections.getConnectedThreshold();
+
+	UInt32 checksum = FNV_OFFSET_BASIS;
+	checksum = updateChecksum(checksum, cellSegmentOffsets);
+	checksum = updateChecksum(checksum, cellSegments);
+	checksum = updateChecksum(checksum, segmentCells);
+	checksum = updateChecksum(checksum, segmentOrdinals);
+	checksum = updateChecksum(checksum, segmentSynapseOffsets);
+	checksum = updateChecksum(checksum, synapsePresynapticCells);
+	checksum = updateChecksum(checksum, synapsePermanences);
+	checksum = updateChecksum(checksum, synapseSegments);
+	checksum = updateChecksum(checksum, potentialOffsets);
+	checksum = updateChecksum(checksum, potentialSegments);
+	checksum = updateChecksum(checksum, connectedOffsets);
+	checksum = updateChecksum(checksum, connectedSegments);
+	header.checksum = checksum;
+
+	os.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	size_t bytes = sizeof(Header);
+
+	writeArray(os, cellSegmentOffsets, bytes);
+	writeArray(os, cellSegments, bytes);
+	writeArray(os, segmentCells, bytes);
+	writeArray(os, segmentOrdinals, bytes);
+	writeArray(os, segmentSynapseOffsets, bytes);
+	writeArray(os, synapsePresynapticCells, bytes);
+	writeArray(os, synapsePermanences, bytes);
+	writeArray(os, synapseSegments, bytes);
+	writeArray(os, potentialOffsets, bytes);
+	writeArray(os, potentialSegments, bytes);
+	writeArray(os, connectedOffsets, bytes);
+	writeArray(os, connectedSegments, bytes);
+
+	return bytes;
+}
+
+namespace {
+
+// Count the active synapses of the segments in the presynaptic table. The
+// relations are visited only when the sink records them.
+template<bool recordRelations>
+void accumulateActivity(
+	const std::vector<CellIdx>& activePresynapticCells,
+	const CellIdx numPresynapticCells,
+	const UInt32* offsets,
+	const Segment* segments,
+	std::vector<SynapseIdx>& numActiveSynapsesForSegment,
+	std::vector<Segment>& segmentsTouched,
+	SegmentRelations& relations
+) {
+	for(const CellIdx cell : activePresynapticCells) {
+		if(cell >= numPresynapticCells) continue;
+
+		const Segment* last = segments + offsets[cell + 1u];
+		for(const Segment* it = segments + offsets[cell]; it != last; ++it) {
+			if(numActiveSynapsesForSegment[*it]++ == 0) {
+				segmentsTouched.push_back(*it);
+			}
+			if(recordRelations) relations.record(*it, cell);
+		}
+	}
+}
+
+void accumulateActivity(
+	const std::vector<CellIdx>& activePresynapticCells,
+	const CellIdx numPresynapticCells,
+	const UInt32* offsets,
+	const Segment* segments,
+	std::vector<SynapseIdx>& numActiveSynapsesForSegment,
+	std::vector<Segment>& segmentsTouched,
+	SegmentRelations& relations
+) {
+	if(relations.isEnabled()) {
+		accumulateActivity<true>(
+			activePresynapticCells, numPresynapticCells, offsets, segments,
+			numActiveSynapsesForSegment, segmentsTouched, relations
+		);
+	} else {
+		accumulateActivity<false>(
+			activePresynapticCells, numPresynapticCells, offsets, segments,
+			numActiveSynapsesForSegment, segmentsTouched, relations
+		);
+	}
+}
+
+} // namespace
+
+void FrozenConnections::computeActivity(
+	const std::vector<CellIdx>& activePresynapticCells,
+	std::vector<SynapseIdx>& numActiveConnectedSynapsesForSegment,
+	std::vector<Segment>& activeSegmentsTouched,
+	SegmentRelations& activeRelations
+) const {
+	NTA_ASSERT(header_ != nullptr);
+
+	numActiveConnectedSynapsesForSegment.assign(header_->numSegments, 0);
+	activeSegmentsTouched.clear();
+	activeRelations.clear();
+
+	accumulateActivity(
+		activePresynapticCells, header_->numPresynapticCells,
+		connectedOffsets_, connectedSegments_,
+		numActiveConnectedSynapsesForSegment, activeSegmentsTouched, activeRelations
+	);
+}
+
+void FrozenConnections::computeActivity(
+	const std::vector<CellIdx>& activePresynapticCells,
+	std::vector<SynapseIdx>& numActiveConnectedSynapsesForSegment,
+	std::vector<SynapseIdx>& numActivePotentialSynapsesForSegment,
+	std::vector<Segment>& activeSegmentsTouched,
+	std::vector<Segment>& matchingSegmentsTouched,
+	SegmentRelations& activeRelations,
+	SegmentRelations& matchingRelations
+) const {
+	computeActivity(
+		activePresynapticCells, numActiveConnectedSynapsesForSegment,
+		activeSegmentsTouched, activeRelations
+	);
+
+	numActivePotentialSynapsesForSegment = numActiveConnectedSynapsesForSegment;
+	matchingSegmentsTouched = activeSegmentsTouched;
+	matchingRelations.clear();
+
+	accumulateActivity(
+		activePresynapticCells, header_->numPresynapticCells,
+		potentialOffsets_, potentialSegments_,
+		numActivePotentialSynapsesForSegment, matchingSegmentsTouched, matchingRelations
+	);
+}
+
+} // namespace htm
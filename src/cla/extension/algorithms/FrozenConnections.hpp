@@ -0,0 +1,281 @@
+// FrozenConnections.hpp
+
+/**
+ * @file
+ * Definitions for the FrozenConnections in C++
+ */
+
+#ifndef FROZEN_CONNECTIONS_HPP
+#define FROZEN_CONNECTIONS_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Types.hpp>
+
+
+namespace htm {
+
+/**
+ * FrozenConnections implementation in C++.
+ *
+ * @b Description
+ * The FrozenConnections is the read-only view of Connections for the
+ * inference. The view does not own the data, it reads the flat arrays of
+ * an image written by write, typically from a memory-mapped file, so
+ * attaching the view does not copy or parse the synapses.
+ *
+ * The image keeps the segment indices of the written Connections, so the
+ * vectors indexed by segment can be shared with it. The synapses are
+ * stored segment by segment and the presynaptic tables keep the order of
+ * the Connections, so computeActivity gives the same counts, touched
+ * segments and relations as Connections::computeActivity.
+ *
+ * The image is in the native byte order and all arrays are 4 bytes wide:
+ *
+ * header
+ * cellSegmentOffsets[numCells + 1], cellSegments[...]
+ * segmentCells[numSegments]
+ * segmentOrdinals[numSegments]
+ * segmentSynapseOffsets[numSegments + 1]
+ * synapsePresynapticCells[numSynapses]
+ * synapsePermanences[numSynapses]
+ * synapseSegments[numSynapses]
+ * potentialOffsets[numPresynapticCells + 1], potentialSegments[...]
+ * connectedOffsets[numPresynapticCells + 1], connectedSegments[...]
+ *
+ * The header keeps the FNV-1a checksum of the 4 byte words of the arrays.
+ * The view indexes the arrays by the values read from the image, so an
+ * image from an untrusted source must be attached with the validation,
+ * which checks the checksum, the order of the offsets and the range of
+ * the indices before the first lookup.
+ */
+class FrozenConnections {
+
+public:
+
+	/**
+	 * Read only range of the values in the image.
+	 */
+	template<typename T>
+	class Range {
+	public:
+		Range() : first_(nullptr), last_(nullptr) {}
+		Range(const T* first, const T* last) : first_(first), last_(last) {}
+
+		const T* begin() const { return first_; }
+		const T* end() const { return last_; }
+		size_t size() const { return static_cast<size_t>(last_ - first_); }
+		bool empty() const { return first_ == last_; }
+		const T& operator[](const size_t i) const { return first_[i]; }
+
+	private:
+		const T* first_;
+		const T* last_;
+	};
+
+	static constexpr UInt32 MAGIC = 0x5a464e43u; // "CNFZ"
+	static constexpr UInt32 VERSION = 2u;
+
+private:
+
+	struct Header {
+		UInt32 magic;
+		UInt32 version;
+		UInt32 numCells;
+		UInt32 numSegments;
+		UInt32 numSynapses;
+		UInt32 numPresynapticCells;
+		UInt32 numPotential;
+		UInt32 numConnected;
+		Permanence connectedThreshold;
+		UInt32 checksum;
+	};
+
+	const Header* header_ = nullptr;
+
+	const UInt32* cellSegmentOffsets_ = nullptr;
+	const Segment* cellSegments_ = nullptr;
+	const CellIdx* segmentCells_ = nullptr;
+	const Segment* segmentOrdinals_ = nullptr;
+	const UInt32* segmentSynapseOffsets_ = nullptr;
+	const CellIdx* synapsePresynapticCells_ = nullptr;
+	const Permanence* synapsePermanences_ = nullptr;
+	const Segment* synapseSegments_ = nullptr;
+	const UInt32* potentialOffsets_ = nullptr;
+	const Segment* potentialSegments_ = nullptr;
+	const UInt32* connectedOffsets_ = nullptr;
+	const Segment* connectedSegments_ = nullptr;
+
+private:
+
+	void validate_(const Header& header, const char* first, const char* last) const;
+
+public:
+
+	/**
+	 * FrozenConnections constructor. The view is empty until attach.
+	 */
+	FrozenConnections() = default;
+
+	/**
+	 * FrozenConnections constructor with the image.
+	 * See attach.
+	 */
+	FrozenConnections(
+		const void* image,
+		const size_t bytes,
+		const bool validate = true
+	);
+
+	/**
+	 * Attach the view to the image. The image must be aligned to 4 bytes
+	 * and outlive the view. The header and the sizes of the arrays are
+	 * always checked. The validation reads the whole image once, so it
+	 * can be skipped for a trusted image to keep the attach in place.
+	 *
+	 * @param image The first byte of the image.
+	 * @param bytes The size of the image, at least the size written.
+	 * @param validate Whether to check the checksum, the offsets and the
+	 * indices of the image.
+	 */
+	void attach(const void* image, const size_t bytes, const bool validate = true);
+
+	/**
+	 * Write the image of the connections.
+	 *
+	 * @param os The binary output stream.
+	 * @param connections The connections to freeze.
+	 * @return The number of the written bytes.
+	 */
+	static size_t write(std::ostream& os, const Connections& connections);
+
+	/**
+	 * Get the number of the cells.
+	 */
+	size_t numCells() const { return header_->numCells; }
+
+	/**
+	 * Get the vector length needed to use segments as indices.
+	 */
+	size_t segmentFlatListLength() const { return header_->numSegments; }
+
+	/**
+	 * Get the number of the segments on the cells.
+	 */
+	size_t numSegments() const {
+		return cellSegmentOffsets_[header_->numCells];
+	}
+
+	/**
+	 * Get the number of the synapses.
+	 */
+	size_t numSynapses() const { return header_->numSynapses; }
+
+	/**
+	 * Get the connected threshold of the written connections.
+	 */
+	Permanence getConnectedThreshold() const {
+		return header_->connectedThreshold;
+	}
+
+	/**
+	 * Get the segments on the cell.
+	 *
+	 * @param cell The cell.
+	 */
+	Range<Segment> segmentsForCell(const CellIdx cell) const {
+		return {
+			cellSegments_ + cellSegmentOffsets_[cell],
+			cellSegments_ + cellSegmentOffsets_[cell + 1u]
+		};
+	}
+
+	/**
+	 * Get the cell that the segment is on.
+	 *
+	 * @param segment The segment.
+	 */
+	CellIdx cellForSegment(const Segment segment) const {
+		return segmentCells_[segment];
+	}
+
+	/**
+	 * Compare the segments in the order of Connections::compareSegments,
+	 * by the cell and then by the ordinal of the creation.
+	 *
+	 * @param a The left segment.
+	 * @param b The right segment.
+	 */
+	bool compareSegments(const Segment a, const Segment b) const {
+		if(segmentCells_[a] == segmentCells_[b])
+			return segmentOrdinals_[a] < segmentOrdinals_[b];
+		return segmentCells_[a] < segmentCells_[b];
+	}
+
+	/**
+	 * Get the presynaptic cells of the synapses on the segment.
+	 *
+	 * @param segment The segment.
+	 */
+	Range<CellIdx> presynapticCellsForSegment(const Segment segment) const {
+		return {
+			synapsePresynapticCells_ + segmentSynapseOffsets_[segment],
+			synapsePresynapticCells_ + segmentSynapseOffsets_[segment + 1u]
+		};
+	}
+
+	/**
+	 * Get the permanences of the synapses on the segment, in the order of
+	 * presynapticCellsForSegment.
+	 *
+	 * @param segment The segment.
+	 */
+	Range<Permanence> permanencesForSegment(const Segment segment) const {
+		return {
+			synapsePermanences_ + segmentSynapseOffsets_[segment],
+			synapsePermanences_ + segmentSynapseOffsets_[segment + 1u]
+		};
+	}
+
+	/**
+	 * Get the segment of the synapse. The synapses are numbered segment by
+	 * segment in the image.
+	 *
+	 * @param synapse The synapse.
+	 */
+	Segment segmentForSynapse(const Synapse synapse) const {
+		return synapseSegments_[synapse];
+	}
+
+	/**
+	 * Compute the activity of the segments by the connected synapses.
+	 * See Connections::computeActivity.
+	 */
+	void computeActivity(
+		const std::vector<CellIdx>& activePresynapticCells,
+		std::vector<SynapseIdx>& numActiveConnectedSynapsesForSegment,
+		std::vector<Segment>& activeSegmentsTouched,
+		SegmentRelations& activeRelations
+	) const;
+
+	/**
+	 * Compute the activity of the segments by the connected and the
+	 * potential synapses. See Connections::computeActivity.
+	 */
+	void computeActivity(
+		const std::vector<CellIdx>& activePresynapticCells,
+		std::vector<SynapseIdx>& numActiveConnectedSynapsesForSegment,
+		std::vector<SynapseIdx>& numActivePotentialSynapsesForSegment,
+		std::vector<Segment>& activeSegmentsTouched,
+		std::vector<Segment>& matchingSegmentsTouched,
+		SegmentRelations& activeRelations,
+		SegmentRelations& matchingRelations
+	) const;
+};
+
+} // namespace htm
+
+#endif // FROZEN_CONNECTIONS_HPP
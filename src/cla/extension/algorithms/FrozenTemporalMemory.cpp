@@ -0,0 +1,264 @@
+// FrozenTemporalMemory.cpp
+
+/**
+ * @file
+ * Implementation of FrozenTemporalMemory
+ */
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+#include <cla/extension/algorithms/FrozenTemporalMemory.hpp>
+#include <cla/extension/algorithms/SegmentSelector.hpp>
+
+#include <htm/utils/GroupBy.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/**
+ * FrozenTemporalMemory private methods
+ */
+void FrozenTemporalMemory::selectSegments_(
+	const std::vector<SynapseIdx>& numSynsForSegment,
+	const SynapseIdx threshold,
+	const std::vector<Segment>& touchedSegments,
+	std::vector<Segment>& selectedSegments
+) const {
+	selectedSegments.clear();
+
+	// Untouched segments only qualify for a zero threshold, as in the
+	// SparseThresholdSelector.
+	if(threshold == 0u) {
+		for(Segment segment = 0u; segment < numSynsForSegment.size(); ++segment)
+			selectedSegments.push_back(segment);
+	} else {
+		for(const Segment segment : touchedSegments) {
+			if(numSynsForSegment[segment] >= threshold)
+				selectedSegments.push_back(segment);
+		}
+	}
+
+	std::sort(
+		selectedSegments.begin(), selectedSegments.end(),
+		[&](const Segment a, const Segment b) {
+			return connections.compareSegments(a, b);
+		}
+	);
+}
+
+CellIdx FrozenTemporalMemory::getLeastUsedCell_(
+	const CellIdx column,
+	Random& rng
+) const {
+	const CellIdx begin = column * parameters_.cellsPerColumn;
+	const CellIdx end = begin + parameters_.cellsPerColumn;
+
+	size_t minSegments = std::numeric_limits<size_t>::max();
+	UInt32 numMinCells = 0u;
+	for(CellIdx cell = begin; cell < end; ++cell) {
+		const size_t numSegments = connections.segmentsForCell(cell).size();
+		if(numSegments < minSegments) {
+			minSegments = numSegments;
+			numMinCells = 0u;
+		}
+		if(numSegments == minSegments) ++numMinCells;
+	}
+
+	// The k-th minimal cell in the cell order is the cell chosen by the
+	// LeastUsedCellTracker with the same random generator.
+	UInt32 k = rng.getUInt32(numMinCells);
+	for(CellIdx cell = begin; cell < end; ++cell) {
+		if(connections.segmentsForCell(cell).size() != minSegments) continue;
+		if(k-- == 0u) return cell;
+	}
+
+	NTA_THROW << "The least used cell is not found in the column " << column;
+}
+
+
+/**
+ * FrozenTemporalMemory methods
+ */
+FrozenTemporalMemory::Parameters FrozenTemporalMemory::parametersOf(
+	const TemporalMemoryExtension& tm
+) {
+	Parameters parameters;
+	parameters.numColumns = static_cast<UInt32>(tm.numberOfColumns());
+	parameters.cellsPerColumn = static_cast<UInt32>(tm.getCellsPerColumn());
+	parameters.activationThreshold = tm.getActivationThreshold();
+	parameters.minThreshold = tm.getMinThreshold();
+	parameters.externalPredictiveInputs = tm.getExternalPredictiveInputs();
+	parameters.innerSegmentSelectorMode
+		= static_cast<UInt32>(tm.getInnerSegmentSelectorMode());
+	return parameters;
+}
+
+void FrozenTemporalMemory::attach(
+	const Parameters& parameters,
+	const void* image,
+	const size_t bytes,
+	const bool validate
+) {
+	NTA_CHECK(parameters.cellsPerColumn > 0u);
+
+	connections.attach(image, bytes, validate);
+	NTA_CHECK(
+		connections.numCells()
+			== static_cast<size_t>(parameters.numColumns) * parameters.cellsPerColumn
+	) << "The frozen connections do not match the temporal memory.";
+
+	parameters_ = parameters;
+}
+
+bool FrozenTemporalMemory::isInferable() const {
+	const auto mode = static_cast<SSMode>(parameters_.innerSegmentSelectorMode);
+	return mode == SSMode::THRESHOLD || mode == SSMode::SPARSE_THRESHOLD;
+}
+
+void FrozenTemporalMemory::activateDendrites(
+	TemporalMemoryExtensionState& state,
+	const SDR& externalPredictiveInputsActive,
+	const SDR& externalPredictiveInputsWinners
+) const {
+	NTA_CHECK(isInferable())
+		<< "The frozen temporal memory supports only the threshold selectors.";
+
+	const UInt externalPredictiveInputs = parameters_.externalPredictiveInputs;
+	if( externalPredictiveInputs > 0 ){
+		NTA_CHECK( externalPredictiveInputsActive.size  == externalPredictiveInputs );
+		NTA_CHECK( externalPredictiveInputsWinners.size == externalPredictiveInputs );
+	} else {
+		NTA_CHECK( externalPredictiveInputsActive.getSum() == 0u && externalPredictiveInputsWinners.getSum() == 0u )
+			<< "External predictive inputs must be declared to TM constructor!";
+	}
+
+	if( state.segmentsValid ) return;
+
+	const CellIdx numCells = static_cast<CellIdx>(numberOfCells());
+	for(const auto &active : externalPredictiveInputsActive.getSparse()) {
+		state.activeCells.push_back( static_cast<CellIdx>(active + numCells) );
+	}
+	for(const auto &winner : externalPredictiveInputsWinners.getSparse()) {
+		state.winnerCells.push_back( static_cast<CellIdx>(winner + numCells) );
+	}
+
+	// The threshold selectors do not read the relations.
+	state.activeRelations.setEnabled(false);
+	state.matchingRelations.setEnabled(false);
+	connections.computeActivity(
+		state.activeCells,
+		state.numActiveConnectedSynapsesForSegment,
+		state.numActivePotentialSynapsesForSegment,
+		state.activeSegmentsTouched,
+		state.matchingSegmentsTouched,
+		state.activeRelations,
+		state.matchingRelations
+	);
+
+	selectSegments_(
+		state.numActiveConnectedSynapsesForSegment,
+		static_cast<SynapseIdx>(parameters_.activationThreshold),
+		state.activeSegmentsTouched,
+		state.activeSegmentsForInner
+	);
+	selectSegments_(
+		state.numActivePotentialSynapsesForSegment,
+		static_cast<SynapseIdx>(parameters_.minThreshold),
+		state.matchingSegmentsTouched,
+		state.matchingSegmentsForInner
+	);
+	state.activeSegmentsForOuter.clear();
+
+	state.segmentsValid = true;
+}
+
+void FrozenTemporalMemory::activateDendrites(
+	TemporalMemoryExtensionState& state
+) const {
+	const SDR externalPredictiveInputsActive(std::vector<UInt>{ parameters_.externalPredictiveInputs });
+	const SDR externalPredictiveInputsWinners(std::vector<UInt>{ parameters_.externalPredictiveInputs });
+	activateDendrites(state, externalPredictiveInputsActive, externalPredictiveInputsWinners);
+}
+
+void FrozenTemporalMemory::activateCells(
+	const SDR& activeColumns,
+	TemporalMemoryExtensionState& state
+) const {
+	NTA_CHECK(activeColumns.size == parameters_.numColumns)
+		<< "TM invalid input size: " << activeColumns.size << " vs. " << parameters_.numColumns;
+
+	const auto& sparse = activeColumns.getSparse();
+	const CellIdx cellsPerColumn = parameters_.cellsPerColumn;
+
+	state.activeCells.clear();
+	state.winnerCells.clear();
+
+	const auto toColumns = [&](const Segment segment) {
+		return connections.cellForSegment(segment) / cellsPerColumn;
+	};
+	const auto identity = [](const ElemSparse a) {return a;};
+
+	for (auto &&columnData : groupBy(
+			sparse, identity,
+			state.activeSegmentsForInner,   toColumns,
+			state.matchingSegmentsForInner, toColumns)) {
+
+		Segment column;
+		std::vector<Segment>::const_iterator activeColumnsBegin, activeColumnsEnd,
+									columnActiveSegmentsBegin, columnActiveSegmentsEnd,
+										columnMatchingSegmentsBegin, columnMatchingSegmentsEnd;
+
+		std::tie(column,
+				activeColumnsBegin, activeColumnsEnd,
+				columnActiveSegmentsBegin, columnActiveSegmentsEnd,
+				columnMatchingSegmentsBegin, columnMatchingSegmentsEnd
+		) = columnData;
+
+		// Without learning, predicted but inactive columns have no effect.
+		if (activeColumnsBegin == activeColumnsEnd) continue;
+
+		if (columnActiveSegmentsBegin != columnActiveSegmentsEnd) {
+			// The predicted cells become active and winner.
+			auto activeSegment = columnActiveSegmentsBegin;
+			do {
+				const CellIdx cell = connections.cellForSegment(*activeSegment);
+				state.activeCells.push_back(cell);
+				state.winnerCells.push_back(cell);
+
+				while (++activeSegment != columnActiveSegmentsEnd &&
+						connections.cellForSegment(*activeSegment) == cell) {}
+			} while (activeSegment != columnActiveSegmentsEnd);
+		} else {
+			// Burst the column.
+			const CellIdx begin = column * cellsPerColumn;
+			for(CellIdx cell = begin; cell < begin + cellsPerColumn; ++cell)
+				state.activeCells.push_back(cell);
+
+			const auto bestMatchingSegment =
+				std::max_element(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd,
+								[&](Segment a, Segment b) {
+									return (state.numActivePotentialSynapsesForSegment[a] <
+											state.numActivePotentialSynapsesForSegment[b]);
+								});
+
+			state.winnerCells.push_back(
+				(bestMatchingSegment != columnMatchingSegmentsEnd)
+					? connections.cellForSegment(*bestMatchingSegment)
+					: getLeastUsedCell_(column, state.rng)
+			);
+		}
+	}
+	state.segmentsValid = false;
+}
+
+void FrozenTemporalMemory::compute(
+	const SDR& activeColumns,
+	TemporalMemoryExtensionState& state
+) const {
+	activateDendrites(state);
+	activateCells(activeColumns, state);
+}
+
+} // namespace htm
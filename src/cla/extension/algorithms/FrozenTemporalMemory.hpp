@@ -0,0 +1,170 @@
+// FrozenTemporalMemory.hpp
+
+/**
+ * @file
+ * Definitions for the FrozenTemporalMemory in C++
+ */
+
+#ifndef FROZEN_TEMPORAL_MEMORY_HPP
+#define FROZEN_TEMPORAL_MEMORY_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/Random.hpp>
+
+#include "cla/extension/algorithms/FrozenConnections.hpp"
+#include "cla/extension/algorithms/TemporalMemoryExtension.hpp"
+
+
+namespace htm {
+
+/**
+ * FrozenTemporalMemory implementation in C++.
+ *
+ * @b Description
+ * The FrozenTemporalMemory is the inference of TemporalMemoryExtension
+ * over the FrozenConnections of an image. It computes the same active
+ * cells, winner cells and active segments as the stateful compute of the
+ * TemporalMemoryExtension with the same TemporalMemoryExtensionState, so
+ * a stream can be moved between the live model and the image.
+ *
+ * The frozen view has no segment data, so only the threshold selectors
+ * are supported, and the anomaly is left to the live model.
+ */
+class FrozenTemporalMemory {
+
+public:
+
+	/**
+	 * The parameters of the inference, written beside the frozen
+	 * connections.
+	 */
+	struct Parameters {
+		UInt32 numColumns = 0u;
+		UInt32 cellsPerColumn = 1u;
+		UInt32 activationThreshold = 0u;
+		UInt32 minThreshold = 0u;
+		UInt32 externalPredictiveInputs = 0u;
+		UInt32 innerSegmentSelectorMode = 0u;
+		UInt32 reserved[2] = {};
+	};
+
+	FrozenConnections connections;
+
+private:
+
+	Parameters parameters_;
+
+private:
+
+	void selectSegments_(
+		const std::vector<SynapseIdx>& numSynsForSegment,
+		const SynapseIdx threshold,
+		const std::vector<Segment>& touchedSegments,
+		std::vector<Segment>& selectedSegments
+	) const;
+
+	CellIdx getLeastUsedCell_(const CellIdx column, Random& rng) const;
+
+public:
+
+	/**
+	 * FrozenTemporalMemory constructor. The view is empty until attach.
+	 */
+	FrozenTemporalMemory() = default;
+
+	/**
+	 * Get the parameters of the temporal memory.
+	 *
+	 * @param tm The temporal memory to freeze.
+	 */
+	static Parameters parametersOf(const TemporalMemoryExtension& tm);
+
+	/**
+	 * Attach the view to the parameters and the frozen connections.
+	 * See FrozenConnections::attach.
+	 *
+	 * @param parameters The parameters of the temporal memory.
+	 * @param image The first byte of the frozen connections image.
+	 * @param bytes The size of the frozen connections image.
+	 * @param validate Whether to validate the frozen connections image.
+	 */
+	void attach(
+		const Parameters& parameters,
+		const void* image,
+		const size_t bytes,
+		const bool validate = true
+	);
+
+	/**
+	 * Check whether the inference is supported by the selector of the
+	 * written temporal memory.
+	 */
+	bool isInferable() const;
+
+	/**
+	 * Calculate the dendrite segment activity of the stream, using the
+	 * current active cells of the state and the external predictive
+	 * inputs. See TemporalMemoryExtension::activateDendrites.
+	 *
+	 * @param state The state of the stream.
+	 * @param externalPredictiveInputsActive The active external cells.
+	 * @param externalPredictiveInputsWinners The winner external cells.
+	 */
+	void activateDendrites(
+		TemporalMemoryExtensionState& state,
+		const SDR& externalPredictiveInputsActive,
+		const SDR& externalPredictiveInputsWinners
+	) const;
+
+	/**
+	 * Calculate the dendrite segment activity of the stream without the
+	 * external predictive inputs.
+	 *
+	 * @param state The state of the stream.
+	 */
+	void activateDendrites(TemporalMemoryExtensionState& state) const;
+
+	/**
+	 * Calculate the active and the winner cells of the stream, using the
+	 * current segment activity of the state.
+	 * See TemporalMemoryExtension::activateCells.
+	 *
+	 * @param activeColumns The active columns.
+	 * @param state The state of the stream.
+	 */
+	void activateCells(
+		const SDR& activeColumns,
+		TemporalMemoryExtensionState& state
+	) const;
+
+	/**
+	 * Perform one time step of the inference of the stream.
+	 *
+	 * @param activeColumns The active columns.
+	 * @param state The state of the stream.
+	 */
+	void compute(
+		const SDR& activeColumns,
+		TemporalMemoryExtensionState& state
+	) const;
+
+	/**
+	 * Get the parameters of the temporal memory.
+	 */
+	const Parameters& getParameters() const { return parameters_; }
+
+	/**
+	 * Get the number of the cells.
+	 */
+	size_t numberOfCells() const {
+		return static_cast<size_t>(parameters_.numColumns) * parameters_.cellsPerColumn;
+	}
+};
+
+} // namespace htm
+
+#endif // FROZEN_TEMPORAL_MEMORY_HPP
@@ -31,6 +31,16 @@ SelectorArgs::SelectorArgs(
 	NTA_ASSERT(isCapacitySet || isThresholdSet);
 }
 
+SelectorArgs::SelectorArgs(
+	const UInt capacity,
+	const SynapseIdx threshold,
+	const std::vector<Segment>& touchedSegments
+):
+	SelectorArgs(capacity, threshold)
+{
+	this->touchedSegments = &touchedSegments;
+}
+
 
 
 /************************************************
@@ -75,6 +85,10 @@ void CoreSelector::summary(std::ostream& os) const {
 	os << "Segment Selector" << std::endl;
 }
 
+const bool CoreSelector::usesRelations() const {
+	return false;
+}
+
 const UInt CoreSelector::getNbCells() const {
 	return nbCells_;
 }
@@ -138,7 +152,7 @@ void ThresholdSelector::summary(std::ostream& os) const {
 
 void ThresholdSelector::select(
 	const std::vector<SynapseIdx>& numSynsForSegment,
-	const Relations<Segment, CellIdx>& relations,
+	const SegmentRelations& relations,
 	const SelectorArgs& args,
 	std::vector<Segment>& activateSegs
 ) const {
@@ -163,12 +177,70 @@ void ThresholdSelector::select(
 
 
 
+/************************************************
+ * SparseThresholdSelector public functions.
+ ***********************************************/
+
+SparseThresholdSelector::SparseThresholdSelector(
+	const Connections* connections,
+	const UInt nbCells,
+	const UInt nbRegions
+):
+	ThresholdSelector(
+		connections,
+		nbCells,
+		nbRegions
+	)
+{}
+
+void SparseThresholdSelector::summary(std::ostream& os) const {
+	os << "Sparse Threshold Selector" << std::endl;
+}
+
+void SparseThresholdSelector::select(
+	const std::vector<SynapseIdx>& numSynsForSegment,
+	const SegmentRelations& relations,
+	const SelectorArgs& args,
+	std::vector<Segment>& activateSegs
+) const {
+	const UInt threshold = args.threshold;
+
+	// Untouched segments only qualify for a zero threshold, so the full
+	// scan is needed to keep the result same as the ThresholdSelector.
+	if(args.touchedSegments == nullptr || threshold == 0u) {
+		ThresholdSelector::select(
+			numSynsForSegment, relations, args, activateSegs
+		);
+		return;
+	}
+
+	const auto& compareSegments 
+		= [&](const Segment a, const Segment b) { 
+			return compareSegments_(a, b); 
+		};
+
+
+	activateSegs.clear();
+
+	for(const Segment segment : *args.touchedSegments) {
+		NTA_ASSERT(segment < numSynsForSegment.size());
+
+		if(numSynsForSegment[segment] >= threshold) {
+			activateSegs.emplace_back(segment);
+		}
+	}
+
+	std::sort(activateSegs.begin(), activateSegs.end(), compareSegments);
+}
+
+
+
 /************************************************
  * ToggleThresholdSelector private functions.
  ***********************************************/
 
 const bool ToggleThresholdSelector::hasInnerCell_(
-	const SDR_sparse_t& cells,
+	const SegmentRelations::Cells& cells,
 	const std::size_t threshold
 ) const {
 	return std::find_if(
@@ -180,7 +252,7 @@ const bool ToggleThresholdSelector::hasInnerCell_(
 }
 
 const bool ToggleThresholdSelector::hasOuterCell_(
-	const SDR_sparse_t& cells,
+	const SegmentRelations::Cells& cells,
 	const std::size_t threshold
 ) const {
 	return !hasInnerCell_(cells, threshold);
@@ -205,6 +277,10 @@ ToggleThresholdSelector::ToggleThresholdSelector(
 	trigger_(trigger)
 {}
 
+const bool ToggleThresholdSelector::usesRelations() const {
+	return true;
+}
+
 void ToggleThresholdSelector::summary(std::ostream& os) const {
 	os	<< "Toggle Threshold Selector(" 
 		<< _triggerMap.at(trigger_)
@@ -214,7 +290,7 @@ void ToggleThresholdSelector::summary(std::ostream& os) const {
 
 void ToggleThresholdSelector::select(
 	const std::vector<SynapseIdx>& numSynsForSegment,
-	const Relations<Segment, CellIdx>& relations,
+	const SegmentRelations& relations,
 	const SelectorArgs& args,
 	std::vector<Segment>& activateSegs
 ) const {
@@ -233,7 +309,7 @@ void ToggleThresholdSelector::select(
 		if(numSynsForSegment.at(segment) < threshold) continue;
 		if(relations.count(segment) <= 0) continue;
 
-		const SDR_sparse_t& cells = relations.at(segment);
+		const SegmentRelations::Cells cells = relations.at(segment);
 
 		if(	((trigger_ == Trigger::INNER) && hasInnerCell_(cells, numCells)) ||
 			((trigger_ == Trigger::OUTER) && hasOuterCell_(cells, numCells)))
@@ -267,7 +343,7 @@ void AdaptiveSelector::summary(std::ostream& os) const {
 
 void AdaptiveSelector::select(
 	const std::vector<SynapseIdx>& numSynsForSegment,
-	const Relations<Segment, CellIdx>& relations,
+	const SegmentRelations& relations,
 	const SelectorArgs& args,
 	std::vector<Segment>& activateSegs
 ) const {
@@ -278,8 +354,11 @@ void AdaptiveSelector::select(
 			return compareSegments_(a, b); 
 		};
 
+	// The ties are broken by the segment order, not by the slot index,
+	// so the selection does not depend on the reuse of the slots.
 	const auto& compareHeapElems
-		= [](const auto& a, const auto& b) {
+		= [&](const auto& a, const auto& b) {
+			if(a.second == b.second) return compareSegments_(a.first, b.first);
 			return a.second > b.second;
 		};
 
@@ -336,7 +415,7 @@ void SeparateAdaptiveSelector::summary(std::ostream& os) const {
 
 void SeparateAdaptiveSelector::select(
 	const std::vector<SynapseIdx>& numSynsForSegment,
-		const Relations<Segment, CellIdx>& relations,
+		const SegmentRelations& relations,
 		const SelectorArgs& args,
 		std::vector<Segment>& activateSegs
 ) const {
@@ -350,8 +429,11 @@ void SeparateAdaptiveSelector::select(
 			return compareSegments_(a, b); 
 		};
 	
+	// The ties are broken by the segment order, not by the slot index,
+	// so the selection does not depend on the reuse of the slots.
 	const auto& compareHeapElems
-		= [](const auto& a, const auto& b) {
+		= [&](const auto& a, const auto& b) {
+			if(a.second == b.second) return compareSegments_(a.first, b.first);
 			return a.second > b.second;
 		};
 
@@ -410,6 +492,12 @@ PSelector SegmentSelectors::createSelector(
 			);
 		break;
 
+		case SSMode::SPARSE_THRESHOLD:
+			return SegmentSelector<SparseThresholdSelector>::make(
+				connections, nbCells, nbRegions
+			);
+		break;
+
 		case SSMode::INNER_TOGGLE_THRESHOLD:
 			return SegmentSelector<ToggleThresholdSelector>::make(
 				connections, nbCells, nbRegions,
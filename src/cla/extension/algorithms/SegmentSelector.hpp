@@ -37,11 +37,15 @@ class TemporalMemoryExtension;
  * used on the adaptive selectors.
  * @param threshold The threshold value of selected segments. This
  * value is used on the threshold selectors.
+ * @param touchedSegments The segments whose synapse count is non zero.
+ * This value is used on the sparse selectors, and they fall back on the
+ * full scan when it is not given.
  */
 struct SelectorArgs {
 
 	UInt capacity = 0u;
 	NumSyns threshold = 0u;
+	const std::vector<Segment>* touchedSegments = nullptr;
 
 	/**
 	 * SelectorArgs constructor.
@@ -56,6 +60,15 @@ struct SelectorArgs {
 		const SynapseIdx threshold
 	);
 
+	/**
+	 * SelectorArgs constructor with the parameters and touched segments.
+	 */
+	SelectorArgs(
+		const UInt capacity,
+		const SynapseIdx threshold,
+		const std::vector<Segment>& touchedSegments
+	);
+
 	/**
 	 * SelectorArgs destructor.
 	 */
@@ -125,6 +138,14 @@ public:
 	 */
 	virtual void summary(std::ostream& os = std::cout) const;
 
+	/**
+	 * Check whether the selector reads the relations between the segments
+	 * and the cells. The relations are recorded only for such selectors.
+	 * 
+	 * @return const bool Whether the relations are read.
+	 */
+	virtual const bool usesRelations() const;
+
 	/**
 	 * Select the segments that will be activated.
 	 * 
@@ -136,7 +157,7 @@ public:
 	 */
 	virtual void select(
 		const std::vector<SynapseIdx>& numSynsForSegment,
-		const Relations<Segment, CellIdx>& relations,
+		const SegmentRelations& relations,
 		const SelectorArgs& args,
 		std::vector<Segment>& activateSegs
 	) const = 0;
@@ -237,7 +258,72 @@ public:
 	 */
 	void select(
 		const std::vector<SynapseIdx>& numSynsForSegment,
-		const Relations<Segment, CellIdx>& relations,
+		const SegmentRelations& relations,
+		const SelectorArgs& args,
+		std::vector<Segment>& activateSegs
+	) const override;
+
+};
+
+
+
+/**
+ * SparseThresholdSelector implementation in C++.
+ * 
+ * @b Description
+ * The SparseThresholdSelector is one of the selectors. This class 
+ * selects the same segments as the ThresholdSelector, but it only
+ * visits the touched segments given in the args instead of scanning
+ * all segments. The cost of the selection is proportional to the number
+ * of touched segments, not to the number of segments on the layer.
+ */
+class SparseThresholdSelector : public ThresholdSelector {
+
+public:
+
+	/**
+	 * SparseThresholdSelector constructor.
+	 */
+	SparseThresholdSelector() = default;
+
+	/**
+	 * SparseThresholdSelector constructor with the parameters.
+	 * 
+	 * @param connections The connection pointer for using the compare functions.
+	 * @param nbCells The number of cells on the layer.
+	 * @param nbRegions The number of regions on the layer.
+	 */
+	SparseThresholdSelector(
+		const Connections* connections,
+		const UInt nbCells,
+		const UInt nbRegions
+	);
+
+	/**
+	 * SparseThresholdSelector destructor.
+	 */
+	~SparseThresholdSelector() = default;
+
+	/**
+	 * Summarize the selector.
+	 * 
+	 * @param os The output stream (The default is std::cout)
+	 */
+	void summary(std::ostream& os = std::cout) const override;
+
+	/**
+	 * Select the segments that will be activated.
+	 * 
+	 * @param numSynsForSegment The number of synapses on each segment.
+	 * @param relations The relations segments and cells.
+	 * @param args The arguments of the select. If the touched segments
+	 * are not given or the threshold is zero, all segments are scanned.
+	 * @param activateSegs The index vector of the selected segment. 
+	 * (This is return vector of this function.)
+	 */
+	void select(
+		const std::vector<SynapseIdx>& numSynsForSegment,
+		const SegmentRelations& relations,
 		const SelectorArgs& args,
 		std::vector<Segment>& activateSegs
 	) const override;
@@ -283,12 +369,12 @@ private:
 private:
 
 	const bool hasInnerCell_(
-		const SDR_sparse_t& cells,
+		const SegmentRelations::Cells& cells,
 		const std::size_t threshold
 	) const;
 
 	const bool hasOuterCell_(
-		const SDR_sparse_t& cells,
+		const SegmentRelations::Cells& cells,
 		const std::size_t threshold
 	) const;
 
@@ -326,6 +412,13 @@ public:
 	 */
 	void summary(std::ostream& os = std::cout) const override;
 
+	/**
+	 * The selector reads the relations for the trigger.
+	 * 
+	 * @return const bool Always true.
+	 */
+	const bool usesRelations() const override;
+
 	/**
 	 * Select the segments that will be activated.
 	 * 
@@ -337,7 +430,7 @@ public:
 	 */
 	void select(
 		const std::vector<SynapseIdx>& numSynsForSegment,
-		const Relations<Segment, CellIdx>& relations,
+		const SegmentRelations& relations,
 		const SelectorArgs& args,
 		std::vector<Segment>& activateSegs
 	) const override;
@@ -400,7 +493,7 @@ public:
 	 */
 	void select(
 		const std::vector<SynapseIdx>& numSynsForSegment,
-		const Relations<Segment, CellIdx>& relations,
+		const SegmentRelations& relations,
 		const SelectorArgs& args,
 		std::vector<Segment>& activateSegs
 	) const override;
@@ -463,7 +556,7 @@ public:
 	 */
 	void select(
 		const std::vector<SynapseIdx>& numSynsForSegment,
-		const Relations<Segment, CellIdx>& relations,
+		const SegmentRelations& relations,
 		const SelectorArgs& args,
 		std::vector<Segment>& activateSegs
 	) const override;
@@ -498,6 +591,8 @@ struct SegmentSelector {
  * 
  * The mode of the selector for active segments and matching segments.
  * THRESHOLD: The selector based on the threshold.
+ * SPARSE_THRESHOLD: The threshold selector which visits only the touched
+ * segments.
  * TOGGLE_THRESHOLD: The toggle selector based on the threshold. 
  * ADAPTIVE: The selector based on the number of connected synapses.
  * SEPARATE_ADAPTIVE: The selector based on the number of connected synapse
@@ -505,6 +600,7 @@ struct SegmentSelector {
  */
 enum class SegmentSelectorMode {
 	THRESHOLD,
+	SPARSE_THRESHOLD,
 	INNER_TOGGLE_THRESHOLD,
 	OUTER_TOGGLE_THRESHOLD,
 	ADAPTIVE,
@@ -527,6 +623,7 @@ private:
 
 	inline static const std::unordered_map<SSMode, std::string> _modeMap = {
 		{SSMode::THRESHOLD, "Threshold"},
+		{SSMode::SPARSE_THRESHOLD, "Sparse Threshold"},
 		{SSMode::INNER_TOGGLE_THRESHOLD, "Inner Toggle Threshold"},
 		{SSMode::OUTER_TOGGLE_THRESHOLD, "Outer Toggle Threshold"},
 		{SSMode::ADAPTIVE, "Adaptive"},
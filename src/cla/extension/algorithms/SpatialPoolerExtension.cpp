@@ -8,15 +8,18 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <memory>
 
 #include <cla/extension/algorithms/SpatialPoolerExtension.hpp>
+#include <cla/utils/ThreadPool.hpp>
+#include <htm/utils/Topology.hpp>
 
 namespace htm {
 
 /**
  * SpatialPoolerExtensionParameters methods.
  */
-std::ostream& htm::operator<<(
+std::ostream& operator<<(
 	std::ostream& os, 
 	const SpatialPoolerExtensionParameters& params
 ) {
@@ -37,12 +40,14 @@ std::ostream& htm::operator<<(
 	os << "\tspVerbosity\t\t\t= " << params.spVerbosity << "f" << std::endl;
 	os << "\twrapAround\t\t\t= " << ((params.wrapAround) ? "true" : "false") << std::endl;
 	os << "\tconstSynInitPermanence\t\t= " << ((params.constSynInitPermanence) ? "true" : "false") << std::endl;
+	os << "\tconnectedBitsRefreshPeriod\t= " << params.connectedBitsRefreshPeriod << "u" << std::endl;
+	os << "\tinitThreads\t\t\t= " << params.initThreads << "u" << std::endl;
 	os << std::endl;
 
 	return os;
 }
 
-void htm::to_json(
+void to_json(
 	json& j, 
 	const SpatialPoolerExtensionParameters& p
 ){
@@ -61,11 +66,13 @@ void htm::to_json(
 		{"boostStrength", p.boostStrength},
 		{"spVerbosity", p.spVerbosity},
 		{"wrapAround", p.wrapAround},
-		{"constSynInitPermanence", p.constSynInitPermanence}
+		{"constSynInitPermanence", p.constSynInitPermanence},
+		{"connectedBitsRefreshPeriod", p.connectedBitsRefreshPeriod},
+		{"initThreads", p.initThreads}
 	};
 }
 
-void htm::from_json(
+void from_json(
 	const json& j,
 	SpatialPoolerExtensionParameters& p
 ){
@@ -84,12 +91,174 @@ void htm::from_json(
 	j.at("spVerbosity").get_to(p.spVerbosity);
 	j.at("wrapAround").get_to(p.wrapAround);
 	j.at("constSynInitPermanence").get_to(p.constSynInitPermanence);
+
+	if(j.contains("connectedBitsRefreshPeriod"))
+		j.at("connectedBitsRefreshPeriod").get_to(p.connectedBitsRefreshPeriod);
+
+	if(j.contains("initThreads"))
+		j.at("initThreads").get_to(p.initThreads);
+}
+
+
+/**
+ * ConnectedBitsTable methods
+ */
+void ConnectedBitsTable::rebuild_(const CellIdx column) const {
+	auto& bits = bits_[column];
+	bits.clear();
+
+	const Permanence threshold = connections_->getConnectedThreshold();
+
+	for(const Synapse synapse : connections_->synapsesForSegment(column)) {
+		const auto& synData = connections_->dataForSynapse(synapse);
+
+		if(synData.permanence >= threshold) {
+			bits.push_back(synData.presynapticCell);
+		}
+	}
+
+	std::sort(bits.begin(), bits.end());
+}
+
+void ConnectedBitsTable::markDirty_(const Synapse synapse) {
+	// Each column has a single segment, so the segment is the column.
+	dirty_[connections_->dataForSynapse(synapse).segment].store(true);
+}
+
+void ConnectedBitsTable::initialize(
+	const Connections* connections,
+	const size_t numColumns
+) {
+	connections_ = connections;
+	inferenceSteps_ = 0u;
+
+	bits_.assign(numColumns, {});
+	dirty_ = std::vector<std::atomic<bool>>(numColumns);
+	invalidate();
+}
+
+void ConnectedBitsTable::invalidate() {
+	for(auto& dirty : dirty_) dirty.store(true);
+}
+
+void ConnectedBitsTable::step(const bool learn) {
+	if(learn || refreshPeriod_ == 0u) return;
+
+	if(++inferenceSteps_ >= refreshPeriod_) {
+		inferenceSteps_ = 0u;
+		invalidate();
+	}
+}
+
+void ConnectedBitsTable::setRefreshPeriod(const UInt period) {
+	refreshPeriod_ = period;
+	inferenceSteps_ = 0u;
+}
+
+const UInt ConnectedBitsTable::getRefreshPeriod() const {
+	return refreshPeriod_;
+}
+
+const std::vector<CellIdx>& ConnectedBitsTable::bitsForColumn(
+	const CellIdx column
+) const {
+	NTA_ASSERT(column < bits_.size());
+
+	if(dirty_[column].load(std::memory_order_acquire)) {
+		const std::lock_guard<std::mutex> lock(rebuildMutex_);
+
+		if(dirty_[column].load(std::memory_order_relaxed)) {
+			rebuild_(column);
+			dirty_[column].store(false, std::memory_order_release);
+		}
+	}
+
+	return bits_[column];
+}
+
+void ConnectedBitsTable::onCreateSynapse(Synapse synapse) {
+	markDirty_(synapse);
+}
+
+void ConnectedBitsTable::onDestroySynapse(Synapse synapse) {
+	markDirty_(synapse);
+}
+
+void ConnectedBitsTable::onUpdateSynapsePermanence(
+	Synapse synapse,
+	Permanence permanence
+) {
+	markDirty_(synapse);
+}
+
+void ConnectedBitsTable::onCompact(const ConnectionsRemap& remap) {
+	invalidate();
 }
 
 
 /**
  * SpatialPoolerExtension methods
  */
+namespace {
+
+/**
+ * Get the seed of the random stream of the column. The seed is mixed by
+ * splitmix64 so that the streams of the near columns are not correlated,
+ * and it is never zero since zero means an automatic seed.
+ */
+htm::UInt64 columnSeed(const htm::UInt64 seed, const htm::UInt column) {
+	htm::UInt64 z = seed + (static_cast<htm::UInt64>(column) + 1u) * 0x9E3779B97F4A7C15ull;
+	z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+	z = z ^ (z >> 31u);
+
+	// The generator is seeded by the lower 32 bits.
+	const htm::UInt64 low = z & 0xFFFFFFFFull;
+	return (low != 0u) ? low : 1u;
+}
+
+} // namespace
+
+void SpatialPoolerExtension::initColumn_(
+	const htm::UInt column,
+	htm::Random& rng,
+	const bool alwaysSample,
+	std::vector<htm::CellIdx>& presyns,
+	std::vector<htm::Permanence>& perms
+) const {
+	NTA_ASSERT(column < numColumns_);
+	const htm::UInt centerInput = initMapColumn_(column);
+
+	presyns.clear();
+	if(wrapAround_) {
+		for(const htm::UInt input : WrappingNeighborhood(centerInput, potentialRadius_, inputDimensions_))
+			presyns.push_back(input);
+	} else {
+		for(const htm::UInt input : Neighborhood(centerInput, potentialRadius_, inputDimensions_))
+			presyns.push_back(input);
+	}
+
+	const htm::UInt numPotential = (htm::UInt)round(presyns.size() * potentialPct_);
+	if(alwaysSample || numPotential < presyns.size()) {
+		presyns = rng.sample<htm::CellIdx>(presyns, numPotential);
+	}
+
+	// A wrapping neighborhood wider than the input visits some inputs twice.
+	std::sort(presyns.begin(), presyns.end());
+	presyns.erase(std::unique(presyns.begin(), presyns.end()), presyns.end());
+
+	perms.resize(presyns.size());
+	for(auto& perm : perms) {
+		if(constSynInitPermanence_) {
+			perm = synInitPermanence_;
+		} else if(rng.getReal64() <= initConnectedPct_) {
+			perm = rng.realRange(synPermConnected_, maxPermanence);
+		} else {
+			perm = rng.realRange(minPermanence, synPermConnected_);
+		}
+	}
+}
+
 SpatialPoolerExtension::SpatialPoolerExtension(
 	const std::vector<htm::UInt>& inputDimensions,
 	const std::vector<htm::UInt>& columnDimensions,
@@ -108,7 +277,9 @@ SpatialPoolerExtension::SpatialPoolerExtension(
 	const htm::Int seed,
 	const htm::UInt spVerbosity,
 	const bool wrapAround,
-	const bool constSynInitPermanence
+	const bool constSynInitPermanence,
+	const htm::UInt connectedBitsRefreshPeriod,
+	const htm::UInt initThreads
 ){
 	
 	initialize(
@@ -129,7 +300,9 @@ SpatialPoolerExtension::SpatialPoolerExtension(
 		seed,
 		spVerbosity,
 		wrapAround,
-		constSynInitPermanence
+		constSynInitPermanence,
+		connectedBitsRefreshPeriod,
+		initThreads
 	);
 }
 
@@ -152,7 +325,9 @@ SpatialPoolerExtension::SpatialPoolerExtension(const SpatialPoolerExtensionParam
 		params.seed,
 		params.spVerbosity,
 		params.wrapAround,
-		params.constSynInitPermanence
+		params.constSynInitPermanence,
+		params.connectedBitsRefreshPeriod,
+		params.initThreads
 	);
 }
 
@@ -175,7 +350,9 @@ void SpatialPoolerExtension::initialize(const SpatialPoolerExtensionParameters&
 		params.seed,
 		params.spVerbosity,
 		params.wrapAround,
-		params.constSynInitPermanence
+		params.constSynInitPermanence,
+		params.connectedBitsRefreshPeriod,
+		params.initThreads
 	);
 }
 
@@ -197,7 +374,9 @@ void SpatialPoolerExtension::initialize(
 	const htm::Int seed,
 	const htm::UInt spVerbosity,
 	const bool wrapAround,
-	const bool constSynInitPermanence
+	const bool constSynInitPermanence,
+	const htm::UInt connectedBitsRefreshPeriod,
+	const htm::UInt initThreads
 ){
 
 	version_ = 2u;
@@ -264,31 +443,74 @@ void SpatialPoolerExtension::initialize(
 	inhibitionRadius_ = 0;
 
 	connections_.initialize(numColumns_, synPermConnected_);
+	connectedBits_.setRefreshPeriod(connectedBitsRefreshPeriod);
 
-	for (htm::Size i = 0; i < numColumns_; ++i) {
-		connections_.createSegment((htm::CellIdx)i, 1 /* max segments per cell is fixed for SP to 1 */);
+	initThreads_ = initThreads;
 
-		// Note: initMapPotential_ & initPermanence_ return dense arrays.
+	if(initThreads_ == 0u) {
+		std::vector<htm::CellIdx> presyns;
+		std::vector<htm::Permanence> presynPerms;
 
-		std::vector<htm::UInt> potential = initMapPotential_((htm::UInt)i, wrapAround_);
-		std::vector<htm::Real> perm;
+		for (htm::Size i = 0; i < numColumns_; ++i) {
+			connections_.createSegment((htm::CellIdx)i, 1 /* max segments per cell is fixed for SP to 1 */);
 
-		if(constSynInitPermanence_){
-			perm.resize(numInputs_);
-			std::fill(perm.begin(), perm.end(), synInitPermanence_);
-		}else {
-			perm = initPermanence_(potential, initConnectedPct_);
-		}
+			initColumn_((htm::UInt)i, rng_, true, presyns, presynPerms);
+			connections_.createSynapses((htm::Segment)i, presyns, presynPerms);
 
-		for (htm::UInt presyn = 0; presyn < numInputs_; presyn++) {
-
-			if (potential[presyn])
-				connections_.createSynapse((htm::Segment)i, presyn, perm[presyn]);
+			connections_.raisePermanencesToThreshold((htm::Segment)i, stimulusThreshold_);
+		}
+	} else {
+		// The columns of a block are drawn in parallel, and then their
+		// synapses are created in the order of the columns, since the
+		// connections are not thread safe.
+		constexpr htm::Size BLOCK_SIZE = 256u;
+
+		std::vector<std::vector<htm::CellIdx>> presyns(BLOCK_SIZE);
+		std::vector<std::vector<htm::Permanence>> presynPerms(BLOCK_SIZE);
+
+		// The caller runs the tasks as well, so one worker less is enough.
+		std::unique_ptr<cla::ThreadPool> pool;
+		if(initThreads_ > 1u)
+			pool = std::make_unique<cla::ThreadPool>(initThreads_ - 1u);
+
+		const htm::UInt64 baseSeed = rng_.getSeed();
+
+		for(htm::Size begin = 0; begin < numColumns_; begin += BLOCK_SIZE) {
+			const htm::Size nbColumns = std::min(BLOCK_SIZE, numColumns_ - begin);
+
+			const auto& initColumns = [&](const std::size_t task) {
+				for(htm::Size k = task; k < nbColumns; k += initThreads_) {
+					const htm::UInt column = (htm::UInt)(begin + k);
+					htm::Random rng(columnSeed(baseSeed, column));
+
+					initColumn_(column, rng, false, presyns[k], presynPerms[k]);
+				}
+			};
+
+			if(pool) {
+				pool->parallelFor(initThreads_, initColumns);
+			} else {
+				initColumns(0u);
+			}
+
+			for(htm::Size k = 0; k < nbColumns; ++k) {
+				const htm::Size i = begin + k;
+				connections_.createSegment((htm::CellIdx)i, 1 /* max segments per cell is fixed for SP to 1 */);
+				connections_.createSynapses((htm::Segment)i, presyns[k], presynPerms[k]);
+
+				connections_.raisePermanencesToThreshold((htm::Segment)i, stimulusThreshold_);
+			}
 		}
-
-		connections_.raisePermanencesToThreshold((htm::Segment)i, stimulusThreshold_);
 	}
 
+	// The table is subscribed after the initial synapses are created,
+	// since all columns start dirty anyway.
+	connectedBits_.initialize(&connections_, numColumns_);
+	connections_.subscribe(&connectedBits_);
+
+	connectedMatrix_.initialize(&connections_, numColumns_, numInputs_);
+	connections_.subscribe(&connectedMatrix_);
+
 	updateInhibitionRadius_();
 
 	if (spVerbosity_ > 0) {
@@ -297,6 +519,84 @@ void SpatialPoolerExtension::initialize(
 	}
 }
 
+const std::vector<SynapseIdx> SpatialPoolerExtension::compute(
+	const SDR& input,
+	const bool learn,
+	SDR& active
+) {
+	if(learn) {
+		const auto overlaps = SpatialPooler::compute(input, learn, active);
+		connectedBits_.step(learn);
+
+		return overlaps;
+	}
+
+	input.reshape(inputDimensions_);
+	active.reshape(columnDimensions_);
+	updateBookeepingVars_(learn);
+
+	std::vector<SynapseIdx> overlaps;
+	connectedMatrix_.computeOverlaps(input.getSparse(), overlaps);
+
+	boostOverlaps_(overlaps, boostedOverlaps_);
+
+	auto& activeVector = active.getSparse();
+	inhibitColumns_(boostedOverlaps_, activeVector);
+
+	std::sort(activeVector.begin(), activeVector.end());
+	active.setSparse(activeVector);
+
+	connectedBits_.step(learn);
+
+	return overlaps;
+}
+
+void SpatialPoolerExtension::infer(const SDR& input, SDR& active) const {
+	SpatialPoolerExtensionState state;
+	infer(input, state, active);
+}
+
+void SpatialPoolerExtension::infer(
+	const SDR& input,
+	SpatialPoolerExtensionState& state,
+	SDR& active
+) const {
+	NTA_CHECK(input.size == numInputs_);
+	NTA_CHECK(active.size == numColumns_);
+
+	connectedMatrix_.computeOverlaps(
+		input.getSparse(), state.overlaps, state.inputWords
+	);
+
+	state.boostedOverlaps.resize(numColumns_);
+	boostOverlaps_(state.overlaps, state.boostedOverlaps);
+
+	auto& activeVector = state.activeColumns;
+	inhibitColumns_(state.boostedOverlaps, activeVector);
+
+	// The active columns are copied, so the buffer keeps its capacity.
+	std::sort(activeVector.begin(), activeVector.end());
+	active.setSparse(activeVector.data(), static_cast<UInt>(activeVector.size()));
+}
+
+const std::vector<CellIdx>& SpatialPoolerExtension::connectedBitsForColumn(
+	const CellIdx column
+) const {
+	return connectedBits_.bitsForColumn(column);
+}
+
+void SpatialPoolerExtension::setConnectedBitsRefreshPeriod(const UInt period) {
+	connectedBits_.setRefreshPeriod(period);
+}
+
+const UInt SpatialPoolerExtension::getConnectedBitsRefreshPeriod() const {
+	return connectedBits_.getRefreshPeriod();
+}
+
+const UInt SpatialPoolerExtension::getInitThreads() const {
+	return initThreads_;
+}
+
 const bool SpatialPoolerExtension::getConstSynInitPermanence() const {
 	return constSynInitPermanence_;
 }
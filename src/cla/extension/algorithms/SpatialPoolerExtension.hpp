@@ -8,10 +8,13 @@
 #ifndef SPATIAL_POOLER_EXTENSION_HPP
 #define SPATIAL_POOLER_EXTENSION_HPP
 
+#include <atomic>
 #include <functional>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <string>
 
+#include <cla/extension/algorithms/ConnectedBitMatrix.hpp>
 #include <cla/extension/types/SdrExtension.hpp>
 #include <htm/algorithms/SpatialPooler.hpp>
 
@@ -38,6 +41,19 @@ using json = nlohmann::json;
  * The boolean value whether synapses are initialized by const value or
  * random value.
  *
+ * @param connectedBitsRefreshPeriod
+ * The number of the inference steps after which the connected bits table
+ * is rebuilt. If the value is 0, the table is refreshed only by the
+ * synapse events.
+ *
+ * @param initThreads
+ * The number of the threads that build the initial synapses of the
+ * columns. If the value is 0, the columns draw from the shared random
+ * generator one by one as before. Otherwise each column draws from its own
+ * random stream seeded by the seed and the column, so the synapses are
+ * the same for any number of the threads, and a full potential pool
+ * (potentialPct = 1) is taken without sampling.
+ *
  * For any other params
  * See htm/algorithm/SpatialPooler.hpp
  */
@@ -60,6 +76,8 @@ struct SpatialPoolerExtensionParameters {
 	htm::UInt spVerbosity = 0u;
 	bool wrapAround = true;
 	bool constSynInitPermanence = false;
+	htm::UInt connectedBitsRefreshPeriod = 0u;
+	htm::UInt initThreads = 0u;
 
 	/**
 	 * SpatialPoolerExtensionParameters constructor.
@@ -79,6 +97,142 @@ using SPEParameters = SpatialPoolerExtensionParameters;
 
 
 
+/**
+ * ConnectedBitsTable implementation in C++.
+ *
+ * @b Description
+ * The ConnectedBitsTable keeps the connected input bits for each column
+ * of the spatial pooler. A column is marked dirty when one of its
+ * synapses is created, destroyed or crosses the connected threshold, and
+ * the bits of the column are collected again on the next lookup. While
+ * learning is off, the whole table can also be refreshed periodically.
+ * Lookups may run concurrently as long as the connections are not
+ * modified at the same time.
+ */
+class ConnectedBitsTable : public ConnectionsEventHandler {
+
+private:
+
+	const Connections* connections_ = nullptr;
+
+	UInt refreshPeriod_ = 0u;
+	UInt inferenceSteps_ = 0u;
+
+	mutable std::vector<std::vector<CellIdx>> bits_;
+	mutable std::vector<std::atomic<bool>> dirty_;
+	mutable std::mutex rebuildMutex_;
+
+private:
+
+	void rebuild_(const CellIdx column) const;
+	void markDirty_(const Synapse synapse);
+
+public:
+
+	/**
+	 * ConnectedBitsTable constructor.
+	 */
+	ConnectedBitsTable() = default;
+
+	/**
+	 * ConnectedBitsTable destructor.
+	 */
+	~ConnectedBitsTable() = default;
+
+	/**
+	 * Initialize ConnectedBitsTable. All columns are marked dirty.
+	 *
+	 * @param connections The column-synapses of the spatial pooler.
+	 * @param numColumns The number of columns.
+	 */
+	void initialize(const Connections* connections, const size_t numColumns);
+
+	/**
+	 * Mark all columns dirty.
+	 */
+	void invalidate();
+
+	/**
+	 * Count a compute step. When learning is off for the refresh period,
+	 * the whole table is invalidated.
+	 *
+	 * @param learn The boolean value whether or not learning is enabled.
+	 */
+	void step(const bool learn);
+
+	/**
+	 * Set the refresh period. If the period is 0, the table is refreshed
+	 * only by the synapse events.
+	 *
+	 * @param period The number of the inference steps.
+	 */
+	void setRefreshPeriod(const UInt period);
+
+	/**
+	 * Get the refresh period.
+	 *
+	 * @return const UInt The number of the inference steps.
+	 */
+	const UInt getRefreshPeriod() const;
+
+	/**
+	 * Get the connected bits of the column. The bits are sorted.
+	 *
+	 * @param column The index of the column.
+	 * @return const std::vector<CellIdx>& The indexes of bits.
+	 */
+	const std::vector<CellIdx>& bitsForColumn(const CellIdx column) const;
+
+	void onCreateSegment(Segment segment) override {}
+	void onDestroySegment(Segment segment) override {}
+
+	/**
+	 * Called after a synapse is created.
+	 */
+	void onCreateSynapse(Synapse synapse) override;
+
+	/**
+	 * Called before a synapse is destroyed.
+	 */
+	void onDestroySynapse(Synapse synapse) override;
+
+	/**
+	 * Called after a synapse crosses the connected threshold.
+	 */
+	void onUpdateSynapsePermanence(
+		Synapse synapse,
+		Permanence permanence
+	) override;
+
+	/**
+	 * Called after the connections are compacted.
+	 */
+	void onCompact(const ConnectionsRemap& remap) override;
+};
+
+
+
+/**
+ * SpatialPoolerExtensionState implementation in C++
+ *
+ * @b Description
+ * The SpatialPoolerExtensionState holds the buffers of the inference of
+ * one input stream: the input words, the overlaps, the boosted overlaps
+ * and the active columns. It keeps no activity between steps, only the
+ * memory, so the inference of a stream does not allocate after its first
+ * step, and the streams on other threads do not share the buffers.
+ */
+struct SpatialPoolerExtensionState {
+	std::vector<UInt64> inputWords;
+	std::vector<SynapseIdx> overlaps;
+	std::vector<Real> boostedOverlaps;
+	SDR_sparse_t activeColumns;
+};
+
+using SPEState = SpatialPoolerExtensionState;
+
+
+
 /**
  * SpatialPoolerExtension implementation in C++
  *
@@ -93,6 +247,33 @@ protected:
 	bool constSynInitPermanence_ = false;
 	htm::Real synInitPermanence_ = 0.5f;
 
+	ConnectedBitsTable connectedBits_;
+	ConnectedBitMatrix connectedMatrix_;
+
+	htm::UInt initThreads_ = 0u;
+
+private:
+
+	/**
+	 * Collect the potential inputs of the column and their initial
+	 * permanences, sorted by the inputs.
+	 *
+	 * @param column The index of the column.
+	 * @param rng The random generator to draw from.
+	 * @param alwaysSample The boolean value whether the inputs are sampled
+	 * even if all of them are potential, which keeps the draws of the
+	 * shared generator as before.
+	 * @param presyns The potential inputs. (This param has a return value.)
+	 * @param perms The permanences. (This param has a return value.)
+	 */
+	void initColumn_(
+		const htm::UInt column,
+		htm::Random& rng,
+		const bool alwaysSample,
+		std::vector<htm::CellIdx>& presyns,
+		std::vector<htm::Permanence>& perms
+	) const;
+
 public:
 
 	/**
@@ -124,7 +305,9 @@ public:
 		const htm::Int seed = 1,
 		const htm::UInt spVerbosity = 0u,
 		const bool wrapAround = true,
-		const bool constSynInitPermanence = false
+		const bool constSynInitPermanence = false,
+		const htm::UInt connectedBitsRefreshPeriod = 0u,
+		const htm::UInt initThreads = 0u
 	);
 
 	/**
@@ -170,9 +353,100 @@ public:
 		const htm::Int seed = 1,
 		const htm::UInt spVerbosity = 0u,
 		const bool wrapAround = true,
-		const bool constSynInitPermanence = false
+		const bool constSynInitPermanence = false,
+		const htm::UInt connectedBitsRefreshPeriod = 0u,
+		const htm::UInt initThreads = 0u
 	);
 
+	CerealAdapter;
+	template<class Archive>
+	void save_ar(Archive& ar) const {
+		SpatialPooler::save_ar(ar);
+	}
+
+	template<class Archive>
+	void load_ar(Archive& ar) {
+		SpatialPooler::load_ar(ar);
+
+		// Connections::load_ar() re-initializes the connections, which
+		// drops the subscribed table.
+		connectedBits_.initialize(&connections_, numColumns_);
+		connections_.subscribe(&connectedBits_);
+
+		connectedMatrix_.initialize(&connections_, numColumns_, numInputs_);
+		connections_.subscribe(&connectedMatrix_);
+	}
+
+	/**
+	 * Compute the spatial pooler. See htm::SpatialPooler::compute.
+	 * Additionally, the step is counted for the connected bits table.
+	 * Without learning, the overlaps are computed from the connected bit
+	 * matrix, which gives the same active columns.
+	 */
+	const std::vector<SynapseIdx> compute(
+		const SDR& input,
+		const bool learn,
+		SDR& active
+	) override;
+
+	/**
+	 * Infer the active columns without learning. Unlike compute, this
+	 * does not update any internal state, so a trained spatial pooler can
+	 * be shared by many threads. The overlaps are computed from the
+	 * connected bit matrix, which is rebuilt after learning.
+	 *
+	 * @param input The input SDR.
+	 * @param active The active columns. (This param has a return value.)
+	 */
+	void infer(const SDR& input, SDR& active) const;
+
+	/**
+	 * Infer the active columns without learning into the buffers of the
+	 * stream state, so the repeated calls do not allocate.
+	 *
+	 * @param input The input SDR.
+	 * @param state The buffers of the stream.
+	 * @param active The active columns. (This param has a return value.)
+	 */
+	void infer(
+		const SDR& input,
+		SpatialPoolerExtensionState& state,
+		SDR& active
+	) const;
+
+	/**
+	 * Get the connected bits of the column from the connected bits table.
+	 *
+	 * @param column The index of the column.
+	 * @return const std::vector<CellIdx>& The sorted indexes of bits.
+	 */
+	const std::vector<CellIdx>& connectedBitsForColumn(
+		const CellIdx column
+	) const;
+
+	/**
+	 * Set the refresh period of the connected bits table.
+	 *
+	 * @param period The number of the inference steps. If the value is 0,
+	 * the table is refreshed only by the synapse events.
+	 */
+	void setConnectedBitsRefreshPeriod(const UInt period);
+
+	/**
+	 * Get the refresh period of the connected bits table.
+	 *
+	 * @return const UInt The number of the inference steps.
+	 */
+	const UInt getConnectedBitsRefreshPeriod() const;
+
+	/**
+	 * Get the number of the threads that built the initial synapses.
+	 *
+	 * @return const UInt The number of the threads. (0 is the shared
+	 * random generator.)
+	 */
+	const UInt getInitThreads() const;
+
 	/**
 	 * Compute inverse spatial pooler. This functions requests type of args
 	 * implements the ExtensionDataInterface.
@@ -182,7 +456,7 @@ public:
 	 */
 	template <
 		typename SdrType,
-		typename DataType = SdrType::ExtensionDataType>
+		typename DataType = typename SdrType::ExtensionDataType>
 	const std::vector<CellIdx> inverseCompute(
 		const SdrType& predictiveColumns,
 		SdrType& predictiveBits
@@ -204,7 +478,7 @@ public:
 	template <
 		typename SdrType,
 		typename Func,
-		typename DataType = SdrType::ExtensionDataType>
+		typename DataType = typename SdrType::ExtensionDataType>
 	const std::vector<CellIdx> inverseCompute(
 		const SdrType& predictiveColumns,
 		SdrType& predictiveBits,
@@ -6,6 +6,7 @@
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <string>
 #include <vector>
 #include <set>
@@ -130,6 +131,40 @@ void htm::from_json(const json& j, TemporalMemoryExtensionParameters& p){
 
 
 
+/**
+ * Helpers for the compaction of the connections.
+ */
+namespace {
+
+// Renumber the segments in the list, dropping the removed ones.
+void remapSegments_(vector<Segment>& segments, const ConnectionsRemap& remap) {
+	size_t size = 0u;
+	for(const auto segment : segments) {
+		if(segment < remap.segments.size()
+			&& remap.segments[segment] != ConnectionsRemap::removed)
+			segments[size++] = remap.segments[segment];
+	}
+	segments.resize(size);
+}
+
+// Move the values indexed by segment to the new segments.
+void remapValues_(vector<SynapseIdx>& values, const ConnectionsRemap& remap) {
+	vector<SynapseIdx> remapped(values.size(), 0);
+	size_t size = 0u;
+	for(size_t segment = 0u; segment < values.size() && segment < remap.segments.size(); ++segment) {
+		const Segment newSegment = remap.segments[segment];
+		if(newSegment == ConnectionsRemap::removed) continue;
+		remapped[newSegment] = values[segment];
+		size = std::max(size, static_cast<size_t>(newSegment) + 1u);
+	}
+	remapped.resize(size);
+	values = std::move(remapped);
+}
+
+} // namespace
+
+
+
 /**
  * SegmentDutyCycle methods
  */
@@ -143,38 +178,240 @@ void SegmentDutyCycle::initialize(const UInt32 cycle) {
 }
 
 void SegmentDutyCycle::reset() {
-	dutyCycle_.clear();
+	periods_.clear();
+	duties_.clear();
+	valid_.clear();
 }
 
 void SegmentDutyCycle::updateDutyCycle(
 	const Segment segment,
 	const bool correct
 ) {
-	auto [period, duty] = dutyCycle_.at(segment);
-	period = std::min(period + 1u, cycle_);
+	NTA_CHECK(isExistSegment(segment)) << "The segment does not exist: " << segment;
 
-	Real decay = static_cast<Real>(period - 1u) / static_cast<Real>(period);
-	duty *= decay;
+	const UInt32 period = std::min(periods_[segment] + 1u, cycle_);
+	const Real decay = static_cast<Real>(period - 1u) / static_cast<Real>(period);
 
+	Real duty = duties_[segment] * decay;
 	if(correct) duty += 1.0f / static_cast<Real>(period);
 
-	dutyCycle_.at(segment) = std::make_pair(period, duty);
+	periods_[segment] = period;
+	duties_[segment] = duty;
 }
 
-const bool SegmentDutyCycle::isExistSegment(const Segment segment) const {
-	return dutyCycle_.count(segment) != 0u;
+void SegmentDutyCycle::updateDutyCycles(
+	const std::vector<Segment>& segments,
+	const std::function<bool(const Segment)>& isCorrect
+) {
+	// Gather the values of the segments into the contiguous buffers.
+	batchSegments_.clear();
+	batchPeriods_.clear();
+	batchDuties_.clear();
+	batchCorrects_.clear();
+
+	for(const auto segment : segments) {
+		if(!isExistSegment(segment)) continue;
+
+		batchSegments_.push_back(segment);
+		batchPeriods_.push_back(periods_[segment]);
+		batchDuties_.push_back(duties_[segment]);
+		batchCorrects_.push_back(isCorrect(segment) ? 1.0f : 0.0f);
+	}
+
+	// Update the buffers in a branchless loop. It gives the same values
+	// as updateDutyCycle, as adding zero does not change the duty.
+	const UInt32 cycle = cycle_;
+	UInt32* periods = batchPeriods_.data();
+	Real* duties = batchDuties_.data();
+	const Real* corrects = batchCorrects_.data();
+
+	for(size_t i = 0u, size = batchSegments_.size(); i < size; ++i) {
+		const UInt32 period = std::min(periods[i] + 1u, cycle);
+		const Real realPeriod = static_cast<Real>(period);
+
+		duties[i] *= static_cast<Real>(period - 1u) / realPeriod;
+		duties[i] += corrects[i] * (1.0f / realPeriod);
+		periods[i] = period;
+	}
+
+	// Scatter the values back to the segments.
+	for(size_t i = 0u, size = batchSegments_.size(); i < size; ++i) {
+		periods_[batchSegments_[i]] = batchPeriods_[i];
+		duties_[batchSegments_[i]] = batchDuties_[i];
+	}
 }
 
-const std::pair<UInt32, Real>& SegmentDutyCycle::getDutyCycle(const Segment segment) const {
-	return dutyCycle_.at(segment);
+const std::pair<UInt32, Real> SegmentDutyCycle::getDutyCycle(const Segment segment) const {
+	NTA_CHECK(isExistSegment(segment)) << "The segment does not exist: " << segment;
+	return std::make_pair(periods_[segment], duties_[segment]);
 }
 
 void SegmentDutyCycle::onCreateSegment(Segment segment) {
-	dutyCycle_.insert(std::make_pair(segment, std::make_pair(1u, 1.0f)));
+	if(segment >= periods_.size()) {
+		periods_.resize(segment + 1u, 0u);
+		duties_.resize(segment + 1u, 0.0f);
+		valid_.resize(segment / 64u + 1u, 0u);
+	}
+
+	periods_[segment] = 1u;
+	duties_[segment] = 1.0f;
+	setValid_(segment, true);
 }
 
 void SegmentDutyCycle::onDestroySegment(Segment segment) {
-	dutyCycle_.erase(segment);
+	if(segment < periods_.size()) setValid_(segment, false);
+}
+
+void SegmentDutyCycle::onCompact(const ConnectionsRemap& remap) {
+	std::vector<UInt32> periods;
+	std::vector<Real> duties;
+
+	for(Segment segment = 0u; segment < periods_.size(); ++segment) {
+		const Segment newSegment = remap.segments.at(segment);
+		if(newSegment == ConnectionsRemap::removed) continue;
+
+		periods.resize(newSegment + 1u, 0u);
+		duties.resize(newSegment + 1u, 0.0f);
+		periods[newSegment] = periods_[segment];
+		duties[newSegment] = duties_[segment];
+	}
+
+	std::vector<UInt64> valid(periods.size() / 64u + 1u, 0u);
+	for(Segment segment = 0u; segment < periods_.size(); ++segment) {
+		const Segment newSegment = remap.segments.at(segment);
+		if(newSegment != ConnectionsRemap::removed && isExistSegment(segment))
+			valid[newSegment / 64u] |= UInt64{1u} << (newSegment % 64u);
+	}
+
+	periods_ = std::move(periods);
+	duties_ = std::move(duties);
+	valid_ = std::move(valid);
+}
+
+
+
+/**
+ * LeastUsedCellTracker methods.
+ */
+void LeastUsedCellTracker::rescan_(const CellIdx column) {
+	const CellIdx begin = column * cellsPerColumn_;
+	const CellIdx end = begin + cellsPerColumn_;
+	CellIdx* minCells = &minCells_[begin];
+
+	SegmentIdx minSegments = std::numeric_limits<SegmentIdx>::max();
+	CellIdx numMinCells = 0u;
+
+	for(CellIdx cell = begin; cell < end; cell++) {
+		const SegmentIdx numSegments 
+			= static_cast<SegmentIdx>(connections_->numSegments(cell));
+
+		if(numSegments < minSegments) {
+			minSegments = numSegments;
+			numMinCells = 0u;
+		}
+		if(numSegments == minSegments) {
+			minCells[numMinCells++] = cell;
+		}
+	}
+
+	minSegments_[column] = minSegments;
+	numMinCells_[column] = numMinCells;
+}
+
+void LeastUsedCellTracker::initialize(
+	const Connections* connections,
+	const size_t numColumns,
+	const CellIdx cellsPerColumn
+) {
+	NTA_ASSERT(connections != nullptr);
+	NTA_ASSERT(cellsPerColumn > 0u);
+
+	connections_ = connections;
+	cellsPerColumn_ = cellsPerColumn;
+	numCells_ = static_cast<CellIdx>(numColumns * cellsPerColumn);
+
+	minSegments_.assign(numColumns, 0u);
+	numMinCells_.assign(numColumns, 0u);
+	minCells_.assign(numCells_, 0u);
+
+	for(CellIdx column = 0u; column < numColumns; column++) {
+		rescan_(column);
+	}
+}
+
+CellIdx LeastUsedCellTracker::getLeastUsedCell(
+	const CellIdx column,
+	Random& rng
+) const {
+	// The minimal cells are kept in the cell order, so the k-th one is
+	// the same cell as the one found by a scan over the column.
+	const UInt32 k = rng.getUInt32(numMinCells_[column]);
+
+	return minCells_[column * cellsPerColumn_ + k];
+}
+
+void LeastUsedCellTracker::onCreateSegment(Segment segment) {
+	const CellIdx cell = connections_->cellForSegment(segment);
+	if(cell >= numCells_) return;
+
+	// The segment is already added to the cell.
+	const CellIdx column = cell / cellsPerColumn_;
+	const size_t numSegments = connections_->numSegments(cell);
+	if(numSegments - 1u != minSegments_[column]) return;
+
+	CellIdx* minCells = &minCells_[column * cellsPerColumn_];
+	CellIdx* last = minCells + numMinCells_[column];
+	CellIdx* pos = std::lower_bound(minCells, last, cell);
+	NTA_ASSERT(pos != last && *pos == cell);
+	std::copy(pos + 1, last, pos);
+
+	if(--numMinCells_[column] == 0u) {
+		rescan_(column);
+	}
+}
+
+void LeastUsedCellTracker::onDestroySegment(Segment segment) {
+	const CellIdx cell = connections_->cellForSegment(segment);
+	if(cell >= numCells_) return;
+
+	// The segment is still on the cell.
+	const CellIdx column = cell / cellsPerColumn_;
+	const SegmentIdx numSegments 
+		= static_cast<SegmentIdx>(connections_->numSegments(cell) - 1u);
+	CellIdx* minCells = &minCells_[column * cellsPerColumn_];
+
+	if(numSegments < minSegments_[column]) {
+		minSegments_[column] = numSegments;
+		numMinCells_[column] = 1u;
+		minCells[0] = cell;
+	} else if(numSegments == minSegments_[column]) {
+		CellIdx* last = minCells + numMinCells_[column];
+		CellIdx* pos = std::lower_bound(minCells, last, cell);
+		std::copy_backward(pos, last, last + 1);
+		*pos = cell;
+		numMinCells_[column]++;
+	}
+}
+
+
+
+/**
+ * ConnectionsEvent methods
+ */
+const ConnectionsEvents ConnectionsEvent::getEvents(
+	const std::vector<std::string>& names
+) {
+	ConnectionsEvents events = NONE;
+
+	for(const auto& name : names) {
+		if(name == "segments") events |= SEGMENTS;
+		else if(name == "synapses") events |= SYNAPSES;
+		else if(name == "permanences") events |= PERMANENCES;
+		else if(name == "all") events |= ALL;
+		else NTA_THROW << "Unknown connections event: " << name;
+	}
+
+	return events;
 }
 
 
@@ -194,27 +431,130 @@ void TemporalMemoryConnectionsHandler::reset() {
 	updatePermanences_.clear();
 }
 
+void TemporalMemoryConnectionsHandler::setEvents(
+	const ConnectionsEvents events,
+	const std::size_t capacity
+) {
+	events_ = events;
+
+	if(events_ & ConnectionsEvent::SEGMENTS) {
+		createdSegments_.reserve(capacity);
+		destroyedSegments_.reserve(capacity);
+	}
+
+	if(events_ & ConnectionsEvent::SYNAPSES) {
+		createdSynapses_.reserve(capacity);
+		destroyedSynapses_.reserve(capacity);
+	}
+
+	if(events_ & ConnectionsEvent::PERMANENCES)
+		updatePermanences_.reserve(capacity);
+}
+
 void TemporalMemoryConnectionsHandler::onCreateSegment(Segment segment) {
-	createdSegments_.emplace_back(segment);
+	if(events_ & ConnectionsEvent::SEGMENTS)
+		createdSegments_.emplace_back(segment);
 }
 
 void TemporalMemoryConnectionsHandler::onDestroySegment(Segment segment) {
-	destroyedSegments_.emplace_back(segment);
+	if(events_ & ConnectionsEvent::SEGMENTS)
+		destroyedSegments_.emplace_back(segment);
 }
 
 void TemporalMemoryConnectionsHandler::onCreateSynapse(Synapse synapse) {
-	createdSynapses_.emplace_back(synapse);
+	if(events_ & ConnectionsEvent::SYNAPSES)
+		createdSynapses_.emplace_back(synapse);
 }
 
 void TemporalMemoryConnectionsHandler::onDestroySynapse(Synapse synapse) {
-	destroyedSynapses_.emplace_back(synapse);
+	if(events_ & ConnectionsEvent::SYNAPSES)
+		destroyedSynapses_.emplace_back(synapse);
 }
 
 void TemporalMemoryConnectionsHandler::onUpdateSynapsePermanence(
 	Synapse synapse,
 	Permanence permanence
 ) {
-	updatePermanences_.emplace_back(std::make_pair(synapse, permanence));
+	if(events_ & ConnectionsEvent::PERMANENCES)
+		updatePermanences_.emplace_back(std::make_pair(synapse, permanence));
+}
+
+void TemporalMemoryConnectionsHandler::onEvents(
+	const std::vector<ConnectionsEventRecord>& events
+) {
+	using Type = ConnectionsEventRecord::Type;
+
+	for(const auto& event : events) {
+		switch(event.type) {
+		case Type::CREATE_SEGMENT:
+			if(events_ & ConnectionsEvent::SEGMENTS)
+				createdSegments_.emplace_back(event.index);
+			break;
+		case Type::DESTROY_SEGMENT:
+			if(events_ & ConnectionsEvent::SEGMENTS)
+				destroyedSegments_.emplace_back(event.index);
+			break;
+		case Type::CREATE_SYNAPSE:
+			if(events_ & ConnectionsEvent::SYNAPSES)
+				createdSynapses_.emplace_back(event.index);
+			break;
+		case Type::DESTROY_SYNAPSE:
+			if(events_ & ConnectionsEvent::SYNAPSES)
+				destroyedSynapses_.emplace_back(event.index);
+			break;
+		case Type::UPDATE_SYNAPSE_PERMANENCE:
+			if(events_ & ConnectionsEvent::PERMANENCES)
+				updatePermanences_.emplace_back(event.index, event.permanence);
+			break;
+		}
+	}
+}
+
+void TemporalMemoryConnectionsHandler::onCompact(const ConnectionsRemap& remap) {
+	const auto& remapAll = [](auto& indices, const auto& map) {
+		std::size_t size = 0u;
+		for(const auto index : indices) {
+			if(map.at(index) != ConnectionsRemap::removed)
+				indices.at(size++) = map.at(index);
+		}
+		indices.resize(size);
+	};
+
+	remapAll(createdSegments_, remap.segments);
+	remapAll(createdSynapses_, remap.synapses);
+
+	std::size_t size = 0u;
+	for(const auto& [synapse, permanence] : updatePermanences_) {
+		if(remap.synapses.at(synapse) != ConnectionsRemap::removed)
+			updatePermanences_.at(size++)
+				= std::make_pair(remap.synapses.at(synapse), permanence);
+	}
+	updatePermanences_.resize(size);
+}
+
+/**
+ * TemporalMemoryExtensionState methods.
+ */
+void TemporalMemoryExtensionState::reset() {
+	activeCells.clear();
+	winnerCells.clear();
+	activeSegmentsForInner.clear();
+	activeSegmentsForOuter.clear();
+	matchingSegmentsForInner.clear();
+	segmentsValid = false;
+	anomaly = -1.0f;
+}
+
+void TemporalMemoryExtensionState::remap(const ConnectionsRemap& remap) {
+	remapSegments_(activeSegmentsForInner, remap);
+	remapSegments_(activeSegmentsForOuter, remap);
+	remapSegments_(matchingSegmentsForInner, remap);
+	remapSegments_(activeSegmentsTouched, remap);
+	remapSegments_(matchingSegmentsTouched, remap);
+	remapValues_(numActiveConnectedSynapsesForSegment, remap);
+	remapValues_(numActivePotentialSynapsesForSegment, remap);
+	activeRelations.remap(remap.segments);
+	matchingRelations.remap(remap.segments);
 }
 
 /**
@@ -386,12 +726,21 @@ void TemporalMemoryExtension::initialize(
 			static_cast<UInt>(numberOfCells()),
 			numRegions
 		);
+	connections_.setRecordRelations(
+		innerSelector_->usesRelations() || outerSelector_->usesRelations()
+	);
 
 	handler_.initialize();
 	segmentDutyCycle_.initialize(1000u);
 
-	connections_.subscribe(&handler_);
-	connections_.subscribe(&segmentDutyCycle_);
+	leastUsedCells_.initialize(&connections_, numberOfColumns(), cellsPerColumn_);
+	prevActiveCells_.resize(static_cast<UInt>(numberOfCells() + externalPredictiveInputs_));
+	segmentCells_.resize(static_cast<UInt>(numberOfCells() + externalPredictiveInputs_));
+
+	// Connections::initialize() drops the subscribed handlers.
+	handlerSubscribed_ = false;
+	setRecordedEvents(handler_.getEvents());
+	connections_.subscribe(&staticHandlers_);
 }
 
 void TemporalMemoryExtension::initialize(const TMEParameters& params){
@@ -428,21 +777,7 @@ void TemporalMemoryExtension::initialize(const TMEParameters& params){
 CellIdx TemporalMemoryExtension::getLeastUsedCell_(const CellIdx column){
 	if(cellsPerColumn_ == 1) return column;
 
-	vector<CellIdx> cells = cellsForColumn(column);
-
-	//TODO: decide if we need to choose randomly from the "least used" cells, or if 1st is fine. 
-	//In that case the line below is not needed, and this method can become const, deterministic results in tests need to be updated
-	//un/comment line below: 
-	rng_.shuffle(cells.begin(), cells.end()); //as min_element selects 1st minimal element, and we want to randomly choose 1 from the minimals.
-
-	const auto compareByNumSegments 
-		= [&](const CellIdx a, const CellIdx b) {
-			if(connections.numSegments(a) == connections.numSegments(b)) 
-			return a < b; //TODO rm? 
-			else return connections.numSegments(a) < connections.numSegments(b);
-		};
-	
-	return *std::min_element(cells.begin(), cells.end(), compareByNumSegments);
+	return leastUsedCells_.getLeastUsedCell(column, rng_);
 }
 
 
@@ -451,8 +786,10 @@ void TemporalMemoryExtension::growSynapses_(
 	const SynapseIdx nDesiredNewSynapses,
 	const vector<CellIdx> &prevWinnerCells
 ){
-	
-	vector<CellIdx> candidates(prevWinnerCells.begin(), prevWinnerCells.end());
+	// The candidates are shuffled in place in the scratch buffer, which
+	// keeps its capacity over the steps.
+	vector<CellIdx>& candidates = growCandidates_;
+	candidates.assign(prevWinnerCells.begin(), prevWinnerCells.end());
 	NTA_ASSERT(std::is_sorted(candidates.begin(), candidates.end()));
 
 	//figure the number of new synapses to grow
@@ -466,44 +803,59 @@ void TemporalMemoryExtension::growSynapses_(
 	// ..Recalculate in case we weren't able to destroy as many synapses as needed.
 	const size_t nActualWithMax = std::min(nActual, static_cast<size_t>(maxSynapsesPerSegment_) - connections.numSynapses(segment));
 
+	// Move a random cell of [first, last) to first, the next step of the
+	// Fisher-Yates shuffle. Only the cells that are used are drawn.
+	const auto& drawCandidate = [&](const size_t first, const size_t last) {
+		const size_t other = first + rng_.getUInt32(static_cast<UInt32>(last - first));
+		std::swap(candidates[first], candidates[other]);
+		return candidates[first];
+	};
+
+	// The cells are collected and the synapses are created at once. The
+	// cells already synapsed on by the segment are drawn, but skipped.
+	vector<CellIdx>& newCells = growCells_;
+	newCells.clear();
+	segmentCells_.clear();
+	for (const auto synapse : connections.synapsesForSegment(segment)) {
+		segmentCells_.set(connections.dataForSynapse(synapse).presynapticCell);
+	}
+
+	const auto& collect = [&](const CellIdx cell) {
+		if(!segmentCells_.contains(cell)) newCells.push_back(cell);
+	};
 
 	/********************************************************************
 	 * for synapse destination weights
 	 * *****************************************************************/
 
 	if(externalPredictiveInputs_ > 0u){
-		const auto& border
-			= find_if(
-				candidates.begin(), candidates.end(),
-				[&](const auto& cell){
-					return cell >= numberOfCells();
-				}
-			);
-
-		vector<CellIdx> insideCandidates(candidates.begin(), border);
-		vector<CellIdx> outsideCandidates(border, candidates.end());
-
-		rng_.shuffle(insideCandidates.begin(), insideCandidates.end());
-		rng_.shuffle(outsideCandidates.begin(), outsideCandidates.end());
-
-		candidates.clear();
-		candidates.reserve(nActualWithMax);
+		const size_t border = static_cast<size_t>(
+			std::distance(
+				candidates.begin(),
+				find_if(
+					candidates.begin(), candidates.end(),
+					[&](const auto& cell){
+						return cell >= numberOfCells();
+					}
+				)
+			)
+		);
 
 		const htm::Int64 requestInsideCandidatesNum 
 			= static_cast<htm::Int64>(static_cast<double>(nActualWithMax) * synapseDestinationWeight_);
 		const htm::Int64 requestOutsideCandidatesNum 
 			= static_cast<htm::Int64>(static_cast<double>(nActualWithMax) * (1.0 - synapseDestinationWeight_));
 	
-		const htm::Int64 insideSize = static_cast<htm::Int64>(insideCandidates.size());
-		const htm::Int64 outsideSize = static_cast<htm::Int64>(outsideCandidates.size());
+		const htm::Int64 insideSize = static_cast<htm::Int64>(border);
+		const htm::Int64 outsideSize = static_cast<htm::Int64>(candidates.size() - border);
 
 		htm::Int64 diffInsideCandidatesNum = insideSize - requestInsideCandidatesNum;
 		htm::Int64 diffOutsizeCandidatesNum = outsideSize - requestOutsideCandidatesNum;
 
 		// If the value is positive, the number of cells does not
 		// exceed, round to zero
-		diffInsideCandidatesNum = std::min(diffInsideCandidatesNum, 0LL);
-		diffOutsizeCandidatesNum = std::min(diffOutsizeCandidatesNum, 0LL);
+		diffInsideCandidatesNum = std::min(diffInsideCandidatesNum, Int64{0});
+		diffOutsizeCandidatesNum = std::min(diffOutsizeCandidatesNum, Int64{0});
 
 		// For the requested number of cells, the missing number of
 		// cells is pushed to the opposite side.
@@ -512,41 +864,36 @@ void TemporalMemoryExtension::growSynapses_(
 		const htm::Int64 requestAdjustOutsizeNum
 			= requestOutsideCandidatesNum - diffInsideCandidatesNum;
 
-		const htm::Int64 requestInsideNum = std::min(requestAdjustInsideNum, insideSize);
-		const htm::Int64 requestOutsideNum = std::min(requestAdjustOutsizeNum, outsideSize);
-
-		std::copy(
-			insideCandidates.begin(),
-			insideCandidates.begin() + requestInsideNum,
-			back_inserter(candidates)
-		);
-
-		std::copy(
-			outsideCandidates.begin(),
-			outsideCandidates.begin() + requestOutsideNum,
-			back_inserter(candidates)
-		);
+		const size_t requestInsideNum
+			= static_cast<size_t>(std::min(requestAdjustInsideNum, insideSize));
+		const size_t requestOutsideNum
+			= static_cast<size_t>(std::min(requestAdjustOutsizeNum, outsideSize));
 
+		// The inside cells first, then the outside cells.
+		for (size_t i = 0u; i < requestInsideNum; i++) {
+			if(newCells.size() == nActualWithMax) break;
+			collect(drawCandidate(i, border));
+		}
+		for (size_t i = border; i < border + requestOutsideNum; i++) {
+			if(newCells.size() == nActualWithMax) break;
+			collect(drawCandidate(i, candidates.size()));
+		}
 	}else{
 		// Pick nActual cells randomly.
-		rng_.shuffle(candidates.begin(), candidates.end());
+		for (size_t i = 0u; i < candidates.size(); i++) {
+			// #COND: this loop finishes two folds: a) we ran out of candidates (above), b) we collected the desired number of new cells (below)
+			if(newCells.size() == nActualWithMax) break;
+			collect(drawCandidate(i, candidates.size()));
+		}
 	}
 
-	/*******************************************************************/
-
-	const size_t nDesired = connections.numSynapses(segment) + nActualWithMax; //num synapses on seg after this function (+-), see #COND
-	for (const auto syn : candidates) {
-		// #COND: this loop finishes two folds: a) we ran out of candidates (above), b) we grew the desired number of new synapses (below)
-		if(connections.numSynapses(segment) == nDesired) break;
-
-		connections_.createSynapse(segment, syn, initialPermanence_); //TODO createSynapse consider creating a vector of new synapses at once?
-	}
+	connections_.createSynapses(segment, newCells, initialPermanence_);
 }
 
 void TemporalMemoryExtension::activatePredictedColumn_(
 	vector<Segment>::const_iterator columnActiveSegmentsBegin,
 	vector<Segment>::const_iterator columnActiveSegmentsEnd,
-	const SDR &prevActiveCells,
+	const Bitset &prevActiveCells,
 	const vector<CellIdx> &prevWinnerCells,
 	const bool learn
 ){
@@ -560,7 +907,6 @@ void TemporalMemoryExtension::activatePredictedColumn_(
 		// This cell might have multiple active segments.
 		do {
 			if (learn) {
-				segmentDutyCycle_.updateDutyCycle(*activeSegment, true);
 				connections_.adaptSegment(*activeSegment, prevActiveCells,
 							permanenceIncrement_, permanenceDecrement_, true);
 
@@ -595,7 +941,7 @@ void TemporalMemoryExtension::burstColumn_(
 	const UInt column,
 	vector<Segment>::const_iterator columnMatchingSegmentsBegin,
 	vector<Segment>::const_iterator columnMatchingSegmentsEnd,
-	const SDR &prevActiveCells,
+	const Bitset &prevActiveCells,
 	const vector<CellIdx> &prevWinnerCells,
 	const bool learn
 ){
@@ -614,7 +960,7 @@ void TemporalMemoryExtension::burstColumn_(
 	const CellIdx winnerCell =
 		(bestMatchingSegment != columnMatchingSegmentsEnd)
 			? connections.cellForSegment(*bestMatchingSegment)
-			: getLeastUsedCell_(column); //TODO replace (with random?) this is extremely costly, removing makes TM 6x faster!
+			: getLeastUsedCell_(column);
 
 	winnerCells_.push_back(winnerCell);
 
@@ -670,7 +1016,7 @@ void TemporalMemoryExtension::burstColumn_(
 void TemporalMemoryExtension::punishPredictedColumn_(
 	vector<Segment>::const_iterator columnMatchingSegmentsBegin,
 	vector<Segment>::const_iterator columnMatchingSegmentsEnd,
-	const SDR &prevActiveCells
+	const Bitset &prevActiveCells
 ) {
 	if (predictedSegmentDecrement_ > 0.0) {
 		for (auto matchingSegment = columnMatchingSegmentsBegin;
@@ -689,8 +1035,6 @@ void TemporalMemoryExtension::destroySynapsesByASA_(
 		activeSegment != columnActiveSegmentEnd; activeSegment++) {
 		
 		if(segmentDutyCycle_.isExistSegment(*activeSegment)) {
-			segmentDutyCycle_.updateDutyCycle(*activeSegment, false);
-			
 			const auto& [period, eacc] = segmentDutyCycle_.getDutyCycle(*activeSegment);
 			const auto& segData = connections_.dataForSegment(*activeSegment);
 
@@ -732,8 +1076,8 @@ void TemporalMemoryExtension::activateCells(
 		
 	auto &sparse = activeColumns.getSparse();
 
-	SDR prevActiveCells({static_cast<CellIdx>(numberOfCells() + externalPredictiveInputs_)});
-	prevActiveCells.setSparse(activeCells_);
+	prevActiveCells_.assign(activeCells_);
+	const Bitset &prevActiveCells = prevActiveCells_;
 	activeCells_.clear();
 
 	const vector<CellIdx> prevWinnerCells = std::move(winnerCells_);
@@ -756,6 +1100,14 @@ void TemporalMemoryExtension::activateCells(
 
 	handler_.reset();
 
+	// Update the duty cycles of all active segments at once. A segment
+	// is correct when its column becomes active.
+	if (learn) {
+		const auto &dense = activeColumns.getDense();
+		segmentDutyCycle_.updateDutyCycles(activeSegmentsForInner_,
+			[&](const Segment segment) { return dense[toColumns(segment)] != 0u; });
+	}
+
 	for (auto &&columnData : groupBy( //group by columns, and convert activeSegments & matchingSegments to cols. 
 			sparse, identity,
 			activeSegmentsForInner_,   toColumns,
@@ -798,6 +1150,9 @@ void TemporalMemoryExtension::activateCells(
 			}
 		} //else: not predicted & not active -> no activity -> does not show up at all
 	}
+
+	// Pass the events that no adaptSegment flushed to the batched handler.
+	connections_.flushEvents();
 	segmentsValid_ = false;
 }
 
@@ -860,14 +1215,20 @@ void TemporalMemoryExtension::activateDendrites(
 	innerSelector_->select(
 		numActiveConnectedSynapsesForSegment_,
 		connections_.getActiveRelationsForSegments(),
-		{activateSegmentsCapacity_, activationThreshold_},
+		{
+			activateSegmentsCapacity_, activationThreshold_,
+			connections_.getActiveSegmentsTouched()
+		},
 		activeSegmentsForInner_
 	);
 
 	outerSelector_->select(
 		numActiveConnectedSynapsesForSegment_,
 		connections_.getActiveRelationsForSegments(),
-		{activateSegmentsCapacity_, activationThreshold_},
+		{
+			activateSegmentsCapacity_, activationThreshold_,
+			connections_.getActiveSegmentsTouched()
+		},
 		activeSegmentsForOuter_
 	);
 
@@ -885,7 +1246,10 @@ void TemporalMemoryExtension::activateDendrites(
 	innerSelector_->select(
 		numActivePotentialSynapsesForSegment_,
 		connections_.getMatchingRelationsForSegments(),
-		{matchingSegmentsCapacity_, minThreshold_},
+		{
+			matchingSegmentsCapacity_, minThreshold_,
+			connections_.getMatchingSegmentsTouched()
+		},
 		matchingSegmentsForInner_
 	);
 	
@@ -910,47 +1274,58 @@ void TemporalMemoryExtension::calculateAnomalyScore_(const SDR &activeColumns){
 	// Update Anomaly Metric.  The anomaly is the percent of active columns that
 	// were not predicted. 
 	// Must be computed here, between `activateDendrites()` and `activateCells()`.
+	NTA_CHECK( segmentsValid_ )
+		<< "Call TM.activateDendrites() before TM.getPredictiveCells()!";
+
+	tmAnomaly_.anomaly_ = computeAnomalyScore_(
+		activeColumns, activeSegmentsForOuter_, tmAnomaly_.anomalyLikelihood_
+	);
+
+	NTA_ASSERT(tmAnomaly_.anomaly_ >= 0.0f and tmAnomaly_.anomaly_ <= 1.0f) << "TM.anomaly is out-of-bounds!";
+
+}
+
+Real TemporalMemoryExtension::computeAnomalyScore_(
+	const SDR &activeColumns,
+	const vector<Segment> &activeSegments,
+	AnomalyLikelihood &anomalyLikelihood
+) const {
 	switch(tmAnomaly_.mode_) {
 
 		case ANMode::DISABLED: {
-			tmAnomaly_.anomaly_ = 0.5f;
-		} break;
+			return 0.5f;
+		}
 
 		case ANMode::RAW: {
-			tmAnomaly_.anomaly_ 
-				= computeRawAnomalyScore(
-					activeColumns,
-					cellsToColumns( getPredictiveCells())
-				);
-		} break;
+			return computeRawAnomalyScore(
+				activeColumns,
+				cellsToColumns( predictiveCellsForSegments_(activeSegments))
+			);
+		}
 
 		case ANMode::LIKELIHOOD: {
 			const Real raw 
 				= computeRawAnomalyScore(
 					activeColumns,
-					cellsToColumns( getPredictiveCells())
+					cellsToColumns( predictiveCellsForSegments_(activeSegments))
 				);
-			tmAnomaly_.anomaly_ 
-				= tmAnomaly_.anomalyLikelihood_.anomalyProbability(raw);
-		} break;
+			return anomalyLikelihood.anomalyProbability(raw);
+		}
 
 		case ANMode::LOGLIKELIHOOD: {
 			const Real raw 
 				= computeRawAnomalyScore(
 					activeColumns,
-					cellsToColumns( getPredictiveCells())
+					cellsToColumns( predictiveCellsForSegments_(activeSegments))
 				);
 			const Real like
-				= tmAnomaly_.anomalyLikelihood_.anomalyProbability(raw);
-			const Real log 
-				= tmAnomaly_.anomalyLikelihood_.computeLogLikelihood(like);
-			tmAnomaly_.anomaly_ = log;
-		} break;
+				= anomalyLikelihood.anomalyProbability(raw);
+			return anomalyLikelihood.computeLogLikelihood(like);
+		}
 	// TODO: Update mean & standard deviation of anomaly here.
 	};
 
-	NTA_ASSERT(tmAnomaly_.anomaly_ >= 0.0f and tmAnomaly_.anomaly_ <= 1.0f) << "TM.anomaly is out-of-bounds!";
-
+	return 0.5f;
 }
 
 void TemporalMemoryExtension::compute(
@@ -962,6 +1337,227 @@ void TemporalMemoryExtension::compute(
 	compute( activeColumns, learn, externalPredictiveInputsActive, externalPredictiveInputsWinners );
 }
 
+void TemporalMemoryExtension::initializeState(
+	TemporalMemoryExtensionState &state
+) const {
+	state.rng = rng_;
+	state.reset();
+}
+
+TemporalMemoryExtensionState TemporalMemoryExtension::captureState() const {
+	TemporalMemoryExtensionState state(tmAnomaly_.anomalyLikelihood_);
+
+	state.activeCells = activeCells_;
+	state.winnerCells = winnerCells_;
+	state.segmentsValid = segmentsValid_;
+
+	state.activeSegmentsForInner = activeSegmentsForInner_;
+	state.activeSegmentsForOuter = activeSegmentsForOuter_;
+	state.matchingSegmentsForInner = matchingSegmentsForInner_;
+
+	state.numActiveConnectedSynapsesForSegment = numActiveConnectedSynapsesForSegment_;
+	state.numActivePotentialSynapsesForSegment = numActivePotentialSynapsesForSegment_;
+
+	state.rng = rng_;
+	state.anomaly = tmAnomaly_.anomaly_;
+
+	return state;
+}
+
+void TemporalMemoryExtension::activateCells(
+	const SDR &activeColumns,
+	TemporalMemoryExtensionState &state
+) const {
+	NTA_CHECK( activeColumns.dimensions.size() == columnDimensions_.size() )
+		<< "TM invalid input dimensions: " << activeColumns.dimensions.size() << " vs. " << columnDimensions_.size();
+
+	for(size_t i=0; i< columnDimensions_.size(); i++) {
+		NTA_CHECK(static_cast<size_t>(activeColumns.dimensions[i]) == static_cast<size_t>(columnDimensions_[i])) << "Dimensions must be the same.";
+	}
+
+	auto &sparse = activeColumns.getSparse();
+
+	state.activeCells.clear();
+	state.winnerCells.clear();
+
+	const auto toColumns = [&](const Segment segment) {
+		return connections.cellForSegment(segment) / cellsPerColumn_;
+	};
+	const auto identity = [](const ElemSparse a) {return a;};
+
+	for (auto &&columnData : groupBy(
+			sparse, identity,
+			state.activeSegmentsForInner,   toColumns,
+			state.matchingSegmentsForInner, toColumns)) {
+
+		Segment column;
+		vector<Segment>::const_iterator activeColumnsBegin, activeColumnsEnd, 
+									columnActiveSegmentsBegin, columnActiveSegmentsEnd, 
+										columnMatchingSegmentsBegin, columnMatchingSegmentsEnd;
+
+		std::tie(column, 
+				activeColumnsBegin, activeColumnsEnd, 
+				columnActiveSegmentsBegin, columnActiveSegmentsEnd, 
+				columnMatchingSegmentsBegin, columnMatchingSegmentsEnd
+		) = columnData;
+
+		// Without learning, predicted but inactive columns have no effect.
+		if (activeColumnsBegin == activeColumnsEnd) continue;
+
+		if (columnActiveSegmentsBegin != columnActiveSegmentsEnd) {
+			// The predicted cells become active and winner.
+			auto activeSegment = columnActiveSegmentsBegin;
+			do {
+				const CellIdx cell = connections.cellForSegment(*activeSegment);
+				state.activeCells.push_back(cell);
+				state.winnerCells.push_back(cell);
+
+				while (++activeSegment != columnActiveSegmentsEnd &&
+						connections.cellForSegment(*activeSegment) == cell) {}
+			} while (activeSegment != columnActiveSegmentsEnd);
+		} else {
+			// Burst the column.
+			const auto newCells = cellsForColumn(column);
+			state.activeCells.insert(state.activeCells.end(), newCells.begin(), newCells.end());
+
+			const auto bestMatchingSegment =
+				std::max_element(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd,
+								[&](Segment a, Segment b) {
+									return (state.numActivePotentialSynapsesForSegment[a] <
+											state.numActivePotentialSynapsesForSegment[b]);
+								});
+
+			state.winnerCells.push_back(
+				(bestMatchingSegment != columnMatchingSegmentsEnd)
+					? connections.cellForSegment(*bestMatchingSegment)
+					: leastUsedCells_.getLeastUsedCell(column, state.rng)
+			);
+		}
+	}
+	state.segmentsValid = false;
+}
+
+void TemporalMemoryExtension::activateDendrites(
+	TemporalMemoryExtensionState &state,
+	const SDR &externalPredictiveInputsActive,
+	const SDR &externalPredictiveInputsWinners
+) const {
+	if( externalPredictiveInputs_ > 0 ){
+		NTA_CHECK( externalPredictiveInputsActive.size  == externalPredictiveInputs_ );
+		NTA_CHECK( externalPredictiveInputsWinners.size == externalPredictiveInputs_ );
+		NTA_CHECK( externalPredictiveInputsActive.dimensions == externalPredictiveInputsWinners.dimensions);
+	} else {
+		NTA_CHECK( externalPredictiveInputsActive.getSum() == 0u && externalPredictiveInputsWinners.getSum() == 0u )
+			<< "External predictive inputs must be declared to TM constructor!";
+	}
+
+	if( state.segmentsValid ) return;
+
+	for(const auto &active : externalPredictiveInputsActive.getSparse()) {
+		NTA_ASSERT( active < externalPredictiveInputs_ );
+		state.activeCells.push_back( static_cast<CellIdx>(active + numberOfCells()) ); 
+	}
+
+	for(const auto &winner : externalPredictiveInputsWinners.getSparse()) {
+		NTA_ASSERT( winner < externalPredictiveInputs_ );
+		state.winnerCells.push_back( static_cast<CellIdx>(winner + numberOfCells()) );
+	}
+
+	// The winner excitations are used only for learning.
+	state.activeRelations.setEnabled(connections.getRecordRelations());
+	state.matchingRelations.setEnabled(connections.getRecordRelations());
+	connections.computeActivity(
+		state.activeCells,
+		state.numActiveConnectedSynapsesForSegment,
+		state.numActivePotentialSynapsesForSegment,
+		state.activeSegmentsTouched,
+		state.matchingSegmentsTouched,
+		state.activeRelations,
+		state.matchingRelations
+	);
+
+	state.activeSegmentsForInner.clear();
+	state.activeSegmentsForOuter.clear();
+
+	innerSelector_->select(
+		state.numActiveConnectedSynapsesForSegment,
+		state.activeRelations,
+		{
+			activateSegmentsCapacity_, activationThreshold_,
+			state.activeSegmentsTouched
+		},
+		state.activeSegmentsForInner
+	);
+
+	outerSelector_->select(
+		state.numActiveConnectedSynapsesForSegment,
+		state.activeRelations,
+		{
+			activateSegmentsCapacity_, activationThreshold_,
+			state.activeSegmentsTouched
+		},
+		state.activeSegmentsForOuter
+	);
+
+	state.matchingSegmentsForInner.clear();
+	innerSelector_->select(
+		state.numActivePotentialSynapsesForSegment,
+		state.matchingRelations,
+		{
+			matchingSegmentsCapacity_, minThreshold_,
+			state.matchingSegmentsTouched
+		},
+		state.matchingSegmentsForInner
+	);
+
+	state.segmentsValid = true;
+}
+
+void TemporalMemoryExtension::activateDendrites(
+	TemporalMemoryExtensionState &state
+) const {
+	const SDR externalPredictiveInputsActive(std::vector<UInt>{ externalPredictiveInputs_ });
+	const SDR externalPredictiveInputsWinners(std::vector<UInt>{ externalPredictiveInputs_ });
+	activateDendrites(state, externalPredictiveInputsActive, externalPredictiveInputsWinners);
+}
+
+void TemporalMemoryExtension::compute(
+	const SDR &activeColumns,
+	TemporalMemoryExtensionState &state
+) const {
+	activateDendrites(state);
+
+	state.anomaly = computeAnomalyScore_(
+		activeColumns, state.activeSegmentsForOuter, state.anomalyLikelihood
+	);
+
+	activateCells(activeColumns, state);
+}
+
+void TemporalMemoryExtension::setRecordedEvents(const ConnectionsEvents events) {
+	// A step grows at most maxNewSynapseCount synapses on each column.
+	handler_.setEvents(events, numberOfColumns() * maxNewSynapseCount_);
+
+	if(events != ConnectionsEvent::NONE && !handlerSubscribed_) {
+		connections_.subscribe(&handler_);
+		handlerSubscribed_ = true;
+	}
+}
+
+const ConnectionsRemap TemporalMemoryExtension::compact() {
+	const ConnectionsRemap remap = connections_.compact();
+
+	remapSegments_(activeSegmentsForInner_, remap);
+	remapSegments_(activeSegmentsForOuter_, remap);
+	remapSegments_(matchingSegmentsForInner_, remap);
+	remapValues_(numActiveConnectedSynapsesForSegment_, remap);
+	remapValues_(numActivePotentialSynapsesForSegment_, remap);
+	remapValues_(numWinnerConnectedSynapsesForSegment_, remap);
+	remapValues_(numWinnerPotentialSynapsesForSegment_, remap);
+
+	return remap;
+}
+
 void TemporalMemoryExtension::reset(void) {
 	activeCells_.clear();
 	winnerCells_.clear();
@@ -1160,6 +1756,12 @@ SDR TemporalMemoryExtension::getPredictiveCells(
 	NTA_CHECK( segmentsValid_ )
 		<< "Call TM.activateDendrites() before TM.getPredictiveCells()!";
 
+	return predictiveCellsForSegments_(activeSegments);
+}
+
+SDR TemporalMemoryExtension::predictiveCellsForSegments_(
+	const vector<Segment>& activeSegments
+) const {
 	auto correctDims = getColumnDimensions();
 	correctDims.push_back(static_cast<CellIdx>(getCellsPerColumn()));
 	SDR predictive(correctDims);
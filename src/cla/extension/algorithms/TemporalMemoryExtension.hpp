@@ -12,6 +12,7 @@
 #include <htm/types/Sdr.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/utils/Random.hpp>
+#include <htm/utils/Bitset.hpp>
 #include <htm/algorithms/AnomalyLikelihood.hpp>
 
 #include <vector>
@@ -21,7 +22,7 @@
 #include <nlohmann/json.hpp>
 
 #include "cla/extension/types/SdrExtension.hpp"
-#include "cla/extension/types/PsdrExtension.hpp"
+#include "cla/extension/types/PSdrExtension.hpp"
 
 #include "cla/extension/algorithms/AdjusterFunctions.hpp"
 
@@ -55,14 +56,34 @@ enum class SegmentSelectorMode;
  * has the segments' duty cycle which means the prediction
  * accuracy of the segment in the range of the cycle.
  * 
+ * The periods and the duty values are held in the flat arrays
+ * indexed by the segment, and a bitmap marks the segments that
+ * exist. The arrays follow the flat segment list of the connections.
+ * 
  * More information is in SpatialPooler.hpp.
  */
-class SegmentDutyCycle : public ConnectionsEventHandler {
+class SegmentDutyCycle final : public ConnectionsEventHandler {
 
 private:
 
 	UInt32 cycle_;
-	std::unordered_map<Segment, pair<UInt32, Real>> dutyCycle_;
+	std::vector<UInt32> periods_;
+	std::vector<Real> duties_;
+	std::vector<UInt64> valid_;
+
+	// The buffers of the batched update.
+	std::vector<Segment> batchSegments_;
+	std::vector<UInt32> batchPeriods_;
+	std::vector<Real> batchDuties_;
+	std::vector<Real> batchCorrects_;
+
+private:
+
+	inline void setValid_(const Segment segment, const bool valid) {
+		const UInt64 mask = UInt64{1u} << (segment % 64u);
+		if(valid) valid_[segment / 64u] |= mask;
+		else valid_[segment / 64u] &= ~mask;
+	}
 
 public:
 
@@ -91,14 +112,25 @@ public:
 	 * 
 	 * @param segment The segment index.
 	 * @param correct The whether segment is correct.
-	 * 
-	 * @return The whether the segment should be destroyed.
 	 */
 	void updateDutyCycle(
 		const Segment segment,
 		const bool correct
 	);
 
+	/**
+	 * Update duty cycles of the segments at once. The segments which do
+	 * not exist are skipped. The result is the same as updateDutyCycle
+	 * called for each segment.
+	 * 
+	 * @param segments The segment indexes.
+	 * @param isCorrect The function which returns whether the segment is correct.
+	 */
+	void updateDutyCycles(
+		const std::vector<Segment>& segments,
+		const std::function<bool(const Segment)>& isCorrect
+	);
+
 	/**
 	 * Get the whether of existing segment.
 	 * 
@@ -106,16 +138,19 @@ public:
 	 * 
 	 * @return The whether of existing segment.
 	 */
-	const bool isExistSegment(const Segment segment) const;
+	inline const bool isExistSegment(const Segment segment) const {
+		return segment < periods_.size()
+			&& (valid_[segment / 64u] >> (segment % 64u)) & UInt64{1u};
+	}
 
 	/**
 	 * Get the duty cycle info of segment.
 	 * 
 	 * @param segment The segment index.
 	 * 
-	 * @return The duty cycle data (acc duty value, num cycle) of segment.
+	 * @return The duty cycle data (num cycle, acc duty value) of segment.
 	 */
-	const std::pair<UInt32, Real>& getDutyCycle(const Segment segment) const;
+	const std::pair<UInt32, Real> getDutyCycle(const Segment segment) const;
 
 	/**
 	 * Set cycle which is used to calculate duty cycle.
@@ -144,6 +179,119 @@ public:
 	void onDestroySegment(Segment segment) override;
 
 	void onCreateSynapse(Synapse synapse) override {}
+	void onCreateSynapses(const std::vector<Synapse>& synapses) override {}
+	void onDestroySynapse(Synapse synapse) override {}
+	void onUpdateSynapsePermanence(Synapse synapse, Permanence permanence) override {}
+
+	/**
+	 * Called after the connections are compacted.
+	 */
+	void onCompact(const ConnectionsRemap& remap) override;
+
+	/**
+	 * Save (serialize) / Load (deserialize) the duty cycles.
+	 *
+	 * @param Archive & ar   a Cereal container.
+	 */
+	template<class Archive>
+	void save_ar(Archive & ar) const {
+		ar(
+			CEREAL_NVP(cycle_),
+			CEREAL_NVP(periods_),
+			CEREAL_NVP(duties_),
+			CEREAL_NVP(valid_)
+		);
+	}
+
+	template<class Archive>
+	void load_ar(Archive & ar) {
+		ar(
+			CEREAL_NVP(cycle_),
+			CEREAL_NVP(periods_),
+			CEREAL_NVP(duties_),
+			CEREAL_NVP(valid_)
+		);
+	}
+
+};
+
+
+
+/**
+ * LeastUsedCellTracker implementation in C++.
+ * 
+ * @b Description
+ * The LeastUsedCellTracker is extended class for finding the least
+ * used cell (the cell with the fewest segments) in a column. It keeps
+ * the minimum number of segments and the sorted list of the cells with
+ * that minimum for each column, which are updated by the create/destroy
+ * segment events. A column is rescanned only when its last minimal
+ * cell grows a segment, so the query itself is O(1).
+ */
+class LeastUsedCellTracker final : public ConnectionsEventHandler {
+
+private:
+
+	const Connections* connections_ = nullptr;
+	CellIdx cellsPerColumn_ = 1u;
+	CellIdx numCells_ = 0u;
+
+	std::vector<SegmentIdx> minSegments_;
+	std::vector<CellIdx> numMinCells_;
+	std::vector<CellIdx> minCells_; // cellsPerColumn slots per column.
+
+private:
+
+	void rescan_(const CellIdx column);
+
+public:
+
+	/**
+	 * LeastUsedCellTracker constructor.
+	 */
+	LeastUsedCellTracker() = default;
+
+	/**
+	 * LeastUsedCellTracker destructor.
+	 */
+	~LeastUsedCellTracker() = default;
+
+	/**
+	 * Initialize LeastUsedCellTracker from the current segments.
+	 * 
+	 * @param connections The connections to read the segments from.
+	 * @param numColumns The number of columns.
+	 * @param cellsPerColumn The number of cells per column.
+	 */
+	void initialize(
+		const Connections* connections,
+		const size_t numColumns,
+		const CellIdx cellsPerColumn
+	);
+
+	/**
+	 * Get the least used cell in the column. If some cells have the
+	 * same number of segments, one of them is chosen at random.
+	 * 
+	 * @param column The column index.
+	 * @param rng The random generator for the tie-break.
+	 * 
+	 * @return The least used cell.
+	 */
+	CellIdx getLeastUsedCell(const CellIdx column, Random& rng) const;
+
+	/**
+	 * Called after a segment is created.
+	 */
+	void onCreateSegment(Segment segment) override;
+
+	/**
+	 * Called before a segment is destroyed.
+	 */
+	void onDestroySegment(Segment segment) override;
+
+	void onCreateSynapse(Synapse synapse) override {}
+	void onCreateSynapses(const std::vector<Synapse>& synapses) override {}
 	void onDestroySynapse(Synapse synapse) override {}
 	void onUpdateSynapsePermanence(Synapse synapse, Permanence permanence) override {}
 
@@ -151,17 +299,65 @@ public:
 
 
 
+using ConnectionsEvents = UInt32;
+
+/**
+ * ConnectionsEvent definitions in C++.
+ * 
+ * @b Description
+ * The ConnectionsEvent defines the classes of the connections events that
+ * the TemporalMemoryConnectionsHandler records. The classes are combined
+ * with the bitwise or. Nothing is recorded by default.
+ */
+struct ConnectionsEvent {
+
+	inline static constexpr ConnectionsEvents NONE = 0u;
+
+	// The created and destroyed segments.
+	inline static constexpr ConnectionsEvents SEGMENTS = 1u << 0u;
+
+	// The created and destroyed synapses.
+	inline static constexpr ConnectionsEvents SYNAPSES = 1u << 1u;
+
+	// The synapses whose permanences cross the connected threshold.
+	inline static constexpr ConnectionsEvents PERMANENCES = 1u << 2u;
+
+	inline static constexpr ConnectionsEvents ALL
+		= SEGMENTS | SYNAPSES | PERMANENCES;
+
+	/**
+	 * Get the event classes from the names ("segments", "synapses",
+	 * "permanences" and "all").
+	 * 
+	 * @param names The names of the event classes.
+	 * 
+	 * @return The event classes.
+	 */
+	static const ConnectionsEvents getEvents(const std::vector<std::string>& names);
+};
+
+
+
 /**
  * TemporalMemoryConnectionsHandler implementation in C++.
  * 
  * @b Description
  * The TemporalMemorySynapseSegmentHandle is extended class for handling
  * the segment and synapse information such as creating, destroying, update.
+ * 
+ * Only the event classes set by setEvents are recorded. The buffers are
+ * cleared, not freed, by reset, so the recording does not allocate once
+ * the buffers have grown to the size of a step.
+ * 
+ * The handler is batched: the connections pass it the events of each
+ * adaptSegment at once, and the rest at Connections::flushEvents.
  */
 class TemporalMemoryConnectionsHandler : public ConnectionsEventHandler {
 
 private:
 
+	ConnectionsEvents events_ = ConnectionsEvent::NONE;
+
 	std::vector<Segment> createdSegments_;
 	std::vector<Segment> destroyedSegments_;
 	std::vector<Synapse> createdSynapses_;
@@ -192,6 +388,36 @@ public:
 	 */
 	void reset();
 
+	/**
+	 * Set the event classes to record. The buffers of the classes are
+	 * reserved for the capacity.
+	 * 
+	 * @param events The event classes.
+	 * @param capacity The number of the events of a class in a step.
+	 */
+	void setEvents(const ConnectionsEvents events, const std::size_t capacity = 0u);
+
+	/**
+	 * Get the event classes to record.
+	 * 
+	 * @return The event classes.
+	 */
+	inline const ConnectionsEvents getEvents() const {
+		return events_;
+	}
+
+	/**
+	 * The handler takes the events in batches.
+	 */
+	inline bool isBatched() const override {
+		return true;
+	}
+
+	/**
+	 * Called with the events logged since the last flush.
+	 */
+	void onEvents(const std::vector<ConnectionsEventRecord>& events) override;
+
 	/**
 	 * Called after a segment is created.
 	 */
@@ -220,6 +446,13 @@ public:
 		Permanence permanence
 	) override;
 
+	/**
+	 * Called after the connections are compacted. The created segments,
+	 * the created synapses and the updated permanences are renumbered.
+	 * The destroyed ones keep the old numbers, as they are already gone.
+	 */
+	void onCompact(const ConnectionsRemap& remap) override;
+
 	/**
 	 * Get created segments in a step.
 	 * 
@@ -271,6 +504,70 @@ using TMConnectionsHandler = TemporalMemoryConnectionsHandler;
 
 
 
+/**
+ * TemporalMemoryExtensionState implementation in C++.
+ *
+ * @b Description
+ * The TemporalMemoryExtensionState holds the activity of one input stream:
+ * the active and winner cells, the selected segments and the buffers of
+ * the segment excitations. It owns no synapses, so a trained
+ * TemporalMemoryExtension can infer many streams through the compute and
+ * activate functions which take a state.
+ */
+struct TemporalMemoryExtensionState {
+	vector<CellIdx> activeCells;
+	vector<CellIdx> winnerCells;
+	bool segmentsValid = false;
+
+	vector<Segment> activeSegmentsForInner;
+	vector<Segment> activeSegmentsForOuter;
+	vector<Segment> matchingSegmentsForInner;
+
+	vector<SynapseIdx> numActiveConnectedSynapsesForSegment;
+	vector<SynapseIdx> numActivePotentialSynapsesForSegment;
+	vector<Segment> activeSegmentsTouched;
+	vector<Segment> matchingSegmentsTouched;
+	SegmentRelations activeRelations;
+	SegmentRelations matchingRelations;
+
+	Random rng;
+	Real anomaly = -1.0f;
+	AnomalyLikelihood anomalyLikelihood;
+
+	/**
+	 * TemporalMemoryExtensionState constructor with an empty anomaly
+	 * likelihood.
+	 */
+	TemporalMemoryExtensionState() = default;
+
+	/**
+	 * TemporalMemoryExtensionState constructor with the anomaly likelihood
+	 * of another stream. The AnomalyLikelihood has const members and no
+	 * assignment, so the likelihood is copied only by the construction.
+	 *
+	 * @param anomalyLikelihood The anomaly likelihood to copy.
+	 */
+	explicit TemporalMemoryExtensionState(const AnomalyLikelihood& anomalyLikelihood)
+		: anomalyLikelihood(anomalyLikelihood) {}
+
+	/**
+	 * Reset the sequence state of the stream.
+	 */
+	void reset();
+
+	/**
+	 * Renumber the segments of the state after the connections are
+	 * compacted.
+	 *
+	 * @param remap The renumbering returned by the compaction.
+	 */
+	void remap(const ConnectionsRemap& remap);
+};
+
+using TMEState = TemporalMemoryExtensionState;
+
+
+
 /**
  * Temporal Memory implementation in C++.
  *
@@ -466,6 +763,11 @@ public:
 	 */
 	virtual ~TemporalMemoryExtension() = default;
 
+	// The event handlers hold pointers to this instance and to its
+	// connections, so a copy or a move would leave them dangling.
+	TemporalMemoryExtension(const TemporalMemoryExtension&) = delete;
+	TemporalMemoryExtension& operator=(const TemporalMemoryExtension&) = delete;
+
 	//----------------------------------------------------------------------
 	//  Main functions
 	//----------------------------------------------------------------------
@@ -570,6 +872,73 @@ public:
 		const bool learn = true
 	);
 
+	// ==============================
+	//  Stream inference
+	// ==============================
+
+	/**
+	 * Initialize a stream state for this temporal memory. The random
+	 * generator starts from the one of this temporal memory, while the
+	 * anomaly likelihood of the stream starts empty.
+	 *
+	 * @param state The stream state. (This param has a return value.)
+	 */
+	void initializeState(TemporalMemoryExtensionState &state) const;
+
+	/**
+	 * Copy the current activity of this temporal memory into a new stream
+	 * state, so the stream continues from where this temporal memory is.
+	 * Only the activity and the anomaly likelihood are copied, the
+	 * synapses stay shared. The scratch buffers of the state are
+	 * recomputed by the next activateDendrites.
+	 *
+	 * @return TemporalMemoryExtensionState The stream state.
+	 */
+	TemporalMemoryExtensionState captureState() const;
+
+	/**
+	 * Calculate the active cells of the stream without learning. This is
+	 * the same as activateCells(activeColumns, false), except that the
+	 * activity is read from and written to the stream state.
+	 *
+	 * @param activeColumns
+	 * A sorted list of active column indices.
+	 *
+	 * @param state The stream state.
+	 */
+	void activateCells(
+		const SDR &activeColumns,
+		TemporalMemoryExtensionState &state
+	) const;
+
+	/**
+	 * Calculate the dendrite segment activity of the stream without
+	 * learning. See activateDendrites(learn, ...).
+	 *
+	 * @param state The stream state.
+	 * @param externalPredictiveInputsActive SDR of active external inputs.
+	 * @param externalPredictiveInputsWinners SDR of winning external inputs.
+	 */
+	void activateDendrites(
+		TemporalMemoryExtensionState &state,
+		const SDR &externalPredictiveInputsActive,
+		const SDR &externalPredictiveInputsWinners
+	) const;
+
+	void activateDendrites(TemporalMemoryExtensionState &state) const;
+
+	/**
+	 * Perform one time step of the stream without learning. See
+	 * compute(activeColumns, learn).
+	 *
+	 * @param activeColumns Sorted SDR of active columns.
+	 * @param state The stream state.
+	 */
+	void compute(
+		const SDR &activeColumns,
+		TemporalMemoryExtensionState &state
+	) const;
+
 	// ==============================
 	//  Helper functions
 	// ==============================
@@ -602,6 +971,16 @@ public:
 		connections_.destroySynapse(syn);
 	}
 
+	/**
+	 * Compact the connections. The slots of the destroyed segments and
+	 * synapses are removed and the segments held by the temporal memory
+	 * are renumbered. The states given to the inference functions must
+	 * be renumbered by TemporalMemoryExtensionState::remap.
+	 *
+	 * @return The renumbering of the segments and the synapses.
+	 */
+	const ConnectionsRemap compact();
+
 	/**
 	 * Returns the indices of cells that belong to a mini-column.
 	 *
@@ -862,6 +1241,24 @@ public:
 		return handler_;
 	}
 
+	/**
+	 * Set the connections events that the handler records. The handler
+	 * is subscribed to the connections only when some events are set,
+	 * so the learning pays nothing for the events by default.
+	 * 
+	 * @param events The event classes to record.
+	 */
+	void setRecordedEvents(const ConnectionsEvents events);
+
+	/**
+	 * Get the connections events that the handler records.
+	 * 
+	 * @return The event classes to record.
+	 */
+	inline const ConnectionsEvents getRecordedEvents() const {
+		return handler_.getEvents();
+	}
+
 	/**
 	 * Returns the TemporalMemory segment duty cycle handler.
 	 * 
@@ -871,38 +1268,26 @@ public:
 		return segmentDutyCycle_;
 	}
 
+	/**
+	 * Returns the TemporalMemory least used cell tracker.
+	 * 
+	 * @return The least used cell tracker.
+	 */
+	inline const LeastUsedCellTracker& getLeastUsedCellTracker() const {
+		return leastUsedCells_;
+	}
+
 	
 
 	/**
-	 * Save (serialize) / Load (deserialize) the current state of the spatial pooler
-	 * to the specified stream.
+	 * Save (serialize) / Load (deserialize) the current state of the
+	 * temporal memory to the specified stream. The segments keep their
+	 * indexes through the connections, so the segments and the synapse
+	 * counts of the current step are written as they are and the loaded
+	 * instance continues exactly like the saved one.
 	 *
 	 * @param Archive & ar   a Cereal container.
 	 */
-	// a container to hold the data for one sequence item during serialization
-	struct container_ar {
-		SegmentIdx idx;
-		CellIdx cell;
-		SynapseIdx syn;
-
-		template<class Archive>
-		void save_ar(Archive & ar) const {
-			ar(
-				CEREAL_NVP(idx),
-				CEREAL_NVP(cell),
-				CEREAL_NVP(syn)
-			);
-		}
-		template<class Archive>
-		void load_ar(Archive & ar) {
-			ar(
-				CEREAL_NVP(idx),
-				CEREAL_NVP(cell),
-				CEREAL_NVP(syn)
-			);
-		}
-	};
-
 	CerealAdapter;
 
 	template<class Archive>
@@ -930,43 +1315,15 @@ public:
 		CEREAL_NVP(tmAnomaly_.mode_),
 		CEREAL_NVP(tmAnomaly_.anomalyLikelihood_),
 		CEREAL_NVP(connections_));
-		
-		size_t activeSize = activeSegmentsForInner_.size();
-		ar(CEREAL_NVP(activeSize));
-
-		if (activeSize > 0) {
-		cereal::size_type numActiveSegments = activeSegmentsForInner_.size();
-		ar( cereal::make_size_tag(numActiveSegments));
-		for (Segment segment : activeSegmentsForInner_) {
-			struct container_ar c;
-			c.cell = connections.cellForSegment(segment);
-			const vector<Segment> &segments = connections.segmentsForCell(c.cell);
-
-			c.idx = (SegmentIdx)std::distance(
-								segments.begin(), 
-								std::find(segments.begin(), 
-								segments.end(), segment));
-			c.syn = numActiveConnectedSynapsesForSegment_[segment];
-			ar(c); // to keep iteration counts correct, only serialize one item per iteration.
-		}
-		}
-
-		size_t matchSize = matchingSegmentsForInner_.size();
-		ar(CEREAL_NVP(matchSize));
-		if (matchSize > 0) {
-		cereal::size_type numMatchingSegments = matchingSegmentsForInner_.size();
-		ar(cereal::make_size_tag(numMatchingSegments));
-		for (Segment segment : matchingSegmentsForInner_) {
-			struct container_ar c;
-			c.cell = connections.cellForSegment(segment);
-			const vector<Segment> &segments = connections.segmentsForCell(c.cell);
-
-			c.idx = (SegmentIdx)std::distance(segments.begin(), std::find(segments.begin(), segments.end(), segment));
-			c.syn = numActivePotentialSynapsesForSegment_[segment];
-			ar(c);
-		}
-		}
 
+		ar(CEREAL_NVP(activeSegmentsForInner_),
+		CEREAL_NVP(activeSegmentsForOuter_),
+		CEREAL_NVP(matchingSegmentsForInner_),
+		CEREAL_NVP(numActiveConnectedSynapsesForSegment_),
+		CEREAL_NVP(numActivePotentialSynapsesForSegment_),
+		CEREAL_NVP(numWinnerConnectedSynapsesForSegment_),
+		CEREAL_NVP(numWinnerPotentialSynapsesForSegment_),
+		CEREAL_NVP(segmentDutyCycle_));
 	}
 
 	template<class Archive>
@@ -996,40 +1353,27 @@ public:
 			CEREAL_NVP(tmAnomaly_.anomalyLikelihood_),
 			CEREAL_NVP(connections_)
 		);
-			
-		size_t activeSize;
-		ar(CEREAL_NVP(activeSize));
-
-		if (activeSize > 0) {
-			numActiveConnectedSynapsesForSegment_.assign(connections.segmentFlatListLength(), 0);
-			cereal::size_type numActiveSegments;
-			ar(cereal::make_size_tag(numActiveSegments));
-			activeSegmentsForInner_.resize(static_cast<size_t>(numActiveSegments));
-			for (size_t i = 0; i < static_cast<size_t>(numActiveSegments); i++) {
-				struct container_ar c;
-				ar(c);  
-				Segment segment = connections.getSegment(c.cell, c.idx);
-				activeSegmentsForInner_[i] = segment;
-				numActiveConnectedSynapsesForSegment_[segment] = c.syn;
-			}
-		}
-
-		size_t matchSize;
-		ar(CEREAL_NVP(matchSize));
-
-		if (matchSize > 0) {
-			numActivePotentialSynapsesForSegment_.assign(connections.segmentFlatListLength(), 0);
-			cereal::size_type numMatchingSegments;
-			ar(cereal::make_size_tag(numMatchingSegments));
-			matchingSegmentsForInner_.resize(static_cast<size_t>(numMatchingSegments));
-			for (size_t i = 0; i < static_cast<size_t>(numMatchingSegments); i++) {
-				struct container_ar c;
-				ar(c);
-				Segment segment = connections.getSegment(c.cell, c.idx);
-				matchingSegmentsForInner_[i] = segment;
-				numActivePotentialSynapsesForSegment_[segment] = c.syn;
-			}
-		}
+
+		ar(
+			CEREAL_NVP(activeSegmentsForInner_),
+			CEREAL_NVP(activeSegmentsForOuter_),
+			CEREAL_NVP(matchingSegmentsForInner_),
+			CEREAL_NVP(numActiveConnectedSynapsesForSegment_),
+			CEREAL_NVP(numActivePotentialSynapsesForSegment_),
+			CEREAL_NVP(numWinnerConnectedSynapsesForSegment_),
+			CEREAL_NVP(numWinnerPotentialSynapsesForSegment_),
+			CEREAL_NVP(segmentDutyCycle_)
+		);
+
+		// Connections::load_ar() re-initializes the connections, which
+		// drops the subscribed handlers.
+		leastUsedCells_.initialize(&connections_, numberOfColumns(), cellsPerColumn_);
+		prevActiveCells_.resize(static_cast<UInt>(numberOfCells() + externalPredictiveInputs_));
+		segmentCells_.resize(static_cast<UInt>(numberOfCells() + externalPredictiveInputs_));
+
+		handlerSubscribed_ = false;
+		setRecordedEvents(handler_.getEvents());
+		connections_.subscribe(&staticHandlers_);
 	}
 
 	virtual bool operator==(const TemporalMemoryExtension &other) const;
@@ -1131,13 +1475,13 @@ private:
 	void punishPredictedColumn_(
 		vector<Segment>::const_iterator columnMatchingSegmentsBegin, 
 		vector<Segment>::const_iterator columnMatchingSegmentsEnd, 
-		const SDR& prevActiveCells
+		const Bitset& prevActiveCells
 	);
 
 	void activatePredictedColumn_(
 		vector<Segment>::const_iterator columnActiveSegmentsBegin,
 		vector<Segment>::const_iterator columnActiveSegmentsEnd,
-		const SDR &prevActiveCells,
+		const Bitset &prevActiveCells,
 		const vector<CellIdx> &prevWinnerCells,
 		const bool learn
 	);
@@ -1146,7 +1490,7 @@ private:
 		const UInt column,
 		vector<Segment>::const_iterator columnMatchingSegmentsBegin,
 		vector<Segment>::const_iterator columnMatchingSegmentsEnd,
-		const SDR &prevActiveCells,
+		const Bitset &prevActiveCells,
 		const vector<CellIdx> &prevWinnerCells,
 		const bool learn
 	);
@@ -1166,6 +1510,14 @@ private:
 
 	void calculateAnomalyScore_(const SDR &activeColumns);
 
+	Real computeAnomalyScore_(
+		const SDR &activeColumns,
+		const vector<Segment> &activeSegments,
+		AnomalyLikelihood &anomalyLikelihood
+	) const;
+
+	SDR predictiveCellsForSegments_(const vector<Segment>& activeSegments) const;
+
 protected:
 
 	//all these could be const
@@ -1237,7 +1589,24 @@ private:
 
 	// TMSynapseHandler handler_;
 	TMConnectionsHandler handler_;
+	bool handlerSubscribed_ = false;
 	SegmentDutyCycle segmentDutyCycle_;
+	LeastUsedCellTracker leastUsedCells_;
+
+	// The duty cycles and the least used cells are subscribed as one
+	// handler, so an event costs one virtual call for both.
+	StaticEventHandlers<SegmentDutyCycle, LeastUsedCellTracker> staticHandlers_{
+		&segmentDutyCycle_, &leastUsedCells_};
+
+	// The active cells of the previous step, refilled at each step. The
+	// external predictive inputs follow the cells.
+	Bitset prevActiveCells_;
+
+	// The candidate cells and the chosen cells of growSynapses_, and the
+	// cells the grown segment already synapses on, reused over the calls.
+	vector<CellIdx> growCandidates_;
+	vector<CellIdx> growCells_;
+	Bitset segmentCells_;
 
 public:
 	const Connections& connections = connections_; //const view of Connections for the public
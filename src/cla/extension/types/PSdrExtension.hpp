@@ -121,52 +121,52 @@ public:
 	 * Split PSDRex
 	 */
 	const std::vector<SDRex<DataType>> split() const {
-	
-		getDense();
+		std::vector<SDRex<DataType>> sdrexs;
+		split(sdrexs);
 
-		std::vector<SDR_dense_t> denses(splitNum_);
-		std::vector<std::vector<DataType>> dataDenses(splitNum_);
+		return sdrexs;
+	}
 
-		std::vector<SDR_dense_t::iterator> denseBegins;
-		std::vector<std::vector<DataType>::iterator> dataDenseBegins;
+	/**
+	 * Split PSDRex into the caller-owned SDRexs. The SDRexs are
+	 * reinitialized only if they do not have the partial dimensions.
+	 * 
+	 * @param sdrexs The SDRexs. (This param has a return value.)
+	 */
+	void split(std::vector<SDRex<DataType>>& sdrexs) const {
+		const SDR_sparse_t& sparse = getSparse();
+		const std::vector<DataType>& data = getExDataSparse();
 
-		const UInt subDenseSize = SDR(partialDimensions_).size;
+		NTA_CHECK(data.size() == sparse.size())
+			<< "Not match size.";
 
-		for(std::size_t i = 0u, size = denses.size(); i < size; ++i){
-			denses.at(i).resize(subDenseSize);
-			denseBegins.emplace_back(denses.at(i).begin());
+		if(sdrexs.size() != static_cast<std::size_t>(splitNum_))
+			sdrexs.resize(splitNum_);
 
-			dataDenses.at(i).resize(subDenseSize);
-			dataDenseBegins.emplace_back(dataDenses.at(i).begin());
-		}
+		std::vector<SDR_sparse_t*> subSparses;
+		std::vector<std::vector<DataType>> subData(splitNum_);
+		subSparses.reserve(splitNum_);
 
-		PartialDenseFuncs::splitDense(
-			dense_.begin(),
-			dense_.end(),
-			denseBegins,
-			dimensions,
-			splitNum_, axis_
-		);
+		for(auto& sdrex : sdrexs){
+			if(!(sdrex.dimensions == partialDimensions_))
+				sdrex.initialize(partialDimensions_);
 
-		const auto dataDense = getExDataDense();
+			subSparses.emplace_back(&sdrex.getSparse());
+			subSparses.back()->clear();
+		}
 
-		PartialDenseFuncs::splitDense(
-			dataDense.begin(),
-			dataDense.end(),
-			dataDenseBegins,
-			dimensions,
-			splitNum_, axis_
+		PartialSparseFuncs::splitSparse(
+			sparse, partialDimensions_, splitNum_, axis_,
+			[&](const std::size_t pos, const UInt sub, const UInt index){
+				subSparses[sub]->emplace_back(index);
+				subData[sub].emplace_back(data[pos]);
+			}
 		);
 
-		std::vector<SDRex<DataType>> sdrexs(splitNum_);
-
 		for(std::size_t i = 0u, size = sdrexs.size(); i < size; ++i){
-			sdrexs.at(i).initialize(partialDimensions_);
-			sdrexs.at(i).setDense(denses.at(i));
-			sdrexs.at(i).setExDataDense(dataDenses.at(i));
+			sdrexs.at(i).setSparse(*subSparses.at(i));
+			sdrexs.at(i).setExDataSparse(subData.at(i));
 		}
-
-		return sdrexs;
 	}
 
 	/**
@@ -179,60 +179,27 @@ public:
 		NTA_CHECK(sdrexs.size() == static_cast<std::size_t>(splitNum_))
 			<< "Not match the subspace num and sdrexs size.\n";
 
-		// Check sdrs.
-		// NTA_CHECK( sdrexs.size() >= 2u )
-		// 	<< "Not enough sdrs to SDR::concatenate, need at least 2 SDRs got " << sdrexs.size() << "!";
-		NTA_CHECK( axis_ < dimensions.size() );
-			UInt concat_axis_size = 0u;
-
-		for(const auto &sdrex : sdrexs ) {
-			NTA_CHECK( sdrex.dimensions.size() == dimensions.size() )
-				<< "All sdrs to SDR::concatenate must have the same number of dimensions as the output SDR!";
-			for(auto dim = 0u; dim < dimensions.size(); dim++ ) {
-				if( dim == axis_ ) {
-					concat_axis_size += sdrex.dimensions.at(axis_);
-				} else {
-					NTA_CHECK( sdrex.dimensions.at(dim) == dimensions.at(dim) )
-						<< "All dimensions except the axis must be the same!";
-				}
-			}
-		}
-		NTA_CHECK( concat_axis_size == dimensions.at(axis_))
-			<< "Axis of concatenation dimensions do not match, sdrs sum to "
-			<< concat_axis_size << ", output expects " << dimensions.at(axis_) << "!";
-	
-		std::vector<SDR_dense_t::iterator> denseBegins;
-		std::vector<std::vector<DataType>> dataDenses;
-		std::vector<std::vector<DataType>::iterator> dataDensesBegins;
-		denseBegins.reserve(sdrexs.size());
-		dataDenses.reserve(sdrexs.size());
-		dataDensesBegins.reserve(sdrexs.size());
-
-
 		for(const auto& sdrex : sdrexs){
-			denseBegins.emplace_back(sdrex.getDense().begin());
-			dataDenses.emplace_back(sdrex.getExDataDense());
-			dataDensesBegins.emplace_back(dataDenses.back().begin());
+			NTA_CHECK(sdrex.dimensions == partialDimensions_)
+				<< "All sdrexs to concatenate must have the partial dimensions!";
 		}
 
-		zero();
-		dense_.resize(size);
-		std::vector<DataType> dataDense(size);
+		SDR_sparse_t& sparse = getSparse();
+		std::vector<DataType> data;
 
-		PartialDenseFuncs::concatenateDense(
-			dense_.begin(), dense_.end(),
-			denseBegins, partialDimensions_,
-			axis_
-		);
+		sparse.clear();
+		data.reserve(sparse.capacity());
 
-		PartialDenseFuncs::concatenateDense(
-			dataDense.begin(), dataDense.end(),
-			dataDensesBegins, partialDimensions_,
-			axis_
+		PartialSparseFuncs::concatenateSparse(
+			sdrexs, partialDimensions_, axis_,
+			[&](const UInt sub, const std::size_t pos, const UInt index){
+				sparse.emplace_back(index);
+				data.emplace_back(sdrexs[sub].getExDataSparse()[pos]);
+			}
 		);
 
-		SDR::setDenseInplace();
-		setExDataDense(dataDense);
+		setSparse(sparse);
+		setExDataSparse(data);
 	}
 
 	void setSDRex(const SDRex<DataType>& sdrex){
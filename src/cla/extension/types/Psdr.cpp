@@ -63,6 +63,81 @@ const std::vector<UInt> PartialDenseFuncs::splitDimensions(
 
 
 
+/**
+ * PartialSparseFuncs
+ */
+
+void PartialSparseFuncs::splitSDR(
+	const SDR& sdr,
+	std::vector<SDR>& sdrs,
+	const UInt splitNum,
+	const UInt axis
+){
+	const std::vector<UInt> subDims
+		= PartialDenseFuncs::splitDimensions(sdr.dimensions, splitNum, axis);
+
+	if(sdrs.size() != static_cast<std::size_t>(splitNum))
+		sdrs.resize(splitNum);
+
+	// Refill the sparse vectors of the subspace SDRs in place to keep
+	// their capacity.
+	std::vector<SDR_sparse_t*> sparses;
+	sparses.reserve(splitNum);
+
+	for(auto& sub : sdrs){
+		if(!(sub.dimensions == subDims))
+			sub.initialize(subDims);
+
+		sparses.emplace_back(&sub.getSparse());
+		sparses.back()->clear();
+	}
+
+	splitSparse(
+		sdr.getSparse(), subDims, splitNum, axis,
+		[&](const std::size_t, const UInt sub, const UInt index){
+			sparses[sub]->emplace_back(index);
+		}
+	);
+
+	for(std::size_t i = 0u, size = sdrs.size(); i < size; ++i)
+		sdrs.at(i).setSparse(*sparses.at(i));
+}
+
+void PartialSparseFuncs::concatenateSDR(
+	const std::vector<SDR>& sdrs,
+	SDR& sdr,
+	const UInt axis
+){
+	NTA_CHECK(!sdrs.empty())
+		<< "There is no sdr to concatenate.";
+
+	const std::vector<UInt>& subDims = sdrs.front().dimensions;
+
+	for(const auto& sub : sdrs){
+		NTA_CHECK(sub.dimensions == subDims)
+			<< "All sdrs to concatenate must have the same dimensions!";
+	}
+	NTA_CHECK(
+		PartialDenseFuncs::splitDimensions(
+			sdr.dimensions, static_cast<UInt>(sdrs.size()), axis
+		) == subDims
+	) << "The sdrs do not match the dimensions of the concatenated sdr!";
+
+	SDR_sparse_t& sparse = sdr.getSparse();
+	sparse.clear();
+
+	concatenateSparse(
+		sdrs, subDims, axis,
+		[&](const UInt, const std::size_t, const UInt index){
+			sparse.emplace_back(index);
+		}
+	);
+
+	sdr.setSparse(sparse);
+}
+
+
+
 /**
  * PartialSDR methods
  */
@@ -100,76 +175,21 @@ void PartialSDR::initialize(
 }
 
 const std::vector<SDR> PartialSDR::split() const {
-	getDense();
-	
-	std::vector<SDR_dense_t> denseVec(splitNum_);
-	std::vector<SDR_dense_t::iterator> denseBegins;
-
-	const UInt subDenseSize = SDR(partialDimensions_).size;
-
-	for(auto& dense : denseVec){
-		dense.resize(subDenseSize);
-		denseBegins.emplace_back(dense.begin());
-	}
-
-	PartialDenseFuncs::splitDense(
-		dense_.begin(), dense_.end(),
-		denseBegins, 
-		dimensions,
-		splitNum_, axis_
-	);
-
-	std::vector<SDR> sdrs(splitNum_);
-
-	for(std::size_t i = 0u, size = sdrs.size(); i < size; ++i){
-		sdrs.at(i).initialize(partialDimensions_);
-		sdrs.at(i).setDense(denseVec.at(i));
-	}
+	std::vector<SDR> sdrs;
+	split(sdrs);
 
 	return sdrs;
 }
 
-void PartialSDR::concatenate(const std::vector<SDR>& sdrs) {
-	// Check sdrs.
-	// NTA_CHECK( sdrs.size() >= 2u )
-	// 	<< "Not enough sdrs to SDR::concatenate, need at least 2 SDRs got " << sdrs.size() << "!";
-	NTA_CHECK( axis_ < dimensions.size() );
-		UInt concat_axis_size = 0u;
-
-	for( const auto &sdr : sdrs ) {
-		NTA_CHECK( sdr.dimensions.size() == dimensions.size() )
-			<< "All sdrs to SDR::concatenate must have the same number of dimensions as the output SDR!";
-		for( auto dim = 0u; dim < dimensions.size(); dim++ ) {
-			if( dim == axis_ ) {
-				concat_axis_size += sdr.dimensions.at(axis_);
-			} else {
-				NTA_CHECK( sdr.dimensions.at(dim) == dimensions.at(dim) )
-					<< "All dimensions except the axis must be the same!";
-			}
-		}
-	}
-	NTA_CHECK( concat_axis_size == dimensions.at(axis_))
-		<< "Axis of concatenation dimensions do not match, sdrs sum to "
-		<< concat_axis_size << ", output expects " << dimensions.at(axis_) << "!";
-
-
-	std::vector<SDR_dense_t::iterator> denseBegins;
-	denseBegins.reserve(sdrs.size());
-
-	for(auto& sdr : sdrs){
-		denseBegins.emplace_back(sdr.getDense().begin());
-	}
-
-	zero();
-	dense_.resize(size);
+void PartialSDR::split(std::vector<SDR>& sdrs) const {
+	PartialSparseFuncs::splitSDR(*this, sdrs, splitNum_, axis_);
+}
 
-	PartialDenseFuncs::concatenateDense(
-		dense_.begin(), dense_.end(),
-		denseBegins, partialDimensions_,
-		axis_
-	);
+void PartialSDR::concatenate(const std::vector<SDR>& sdrs) {
+	NTA_CHECK(sdrs.size() == static_cast<std::size_t>(splitNum_))
+		<< "Not match the subspace num and sdrs size.";
 
-	SDR::setDenseInplace();
+	PartialSparseFuncs::concatenateSDR(sdrs, *this, axis_);
 }
 
 void PartialSDR::setSDR(const SDR& sdr){
@@ -107,6 +107,140 @@ struct PartialDenseFuncs {
 };
 
 
+/**
+ * PartialSparseFuncs implementation in C++.
+ * 
+ * @b Description
+ * The PartialSparseFuncs is the packages of splitter and concatenator of
+ * sparse. These functions map the indices between the sparse and the
+ * subspace sparses while referring to the partial dimensions and axis, so
+ * the dense buffers are never materialized.
+ */
+struct PartialSparseFuncs {
+
+	/**
+	 * Split sparse
+	 * 
+	 * @param sparse The splitted sparse. The sparse must be sorted.
+	 * @param subDims The dimensions of subspace sparse.
+	 * @param splitNum The number of split sparse. The splitNum must be
+	 * greater than zero.
+	 * @param axis The axis splitting a sparse in the dimensions.
+	 * @param func The function called for each index in the order of the
+	 * sparse with the position in the sparse, the subspace number and the
+	 * index in the subspace. The indices of each subspace are given in
+	 * ascending order.
+	 */
+	template<typename Func>
+	static void splitSparse(
+		const SDR_sparse_t& sparse,
+		const std::vector<UInt>& subDims,
+		const UInt splitNum,
+		const UInt axis,
+		Func func
+	){
+		const UInt row = getRowSize(subDims, axis);
+
+		for(std::size_t i = 0u, size = sparse.size(); i < size; ++i){
+			const UInt block = sparse[i] / row;
+			func(i, block % splitNum, (block / splitNum) * row + sparse[i] % row);
+		}
+	}
+
+	/**
+	 * Concatenate sparse
+	 * 
+	 * @param sdrs The subspace SDRs. The sparse of each SDR is used.
+	 * @param subDims The dimensions of subspace sparse.
+	 * @param axis The axis splitting a sparse in the dimensions.
+	 * @param func The function called for each index in ascending order of
+	 * the concatenated index with the subspace number, the position in the
+	 * subspace sparse and the concatenated index.
+	 */
+	template<typename SDRs, typename Func>
+	static void concatenateSparse(
+		const SDRs& sdrs,
+		const std::vector<UInt>& subDims,
+		const UInt axis,
+		Func func
+	){
+		const UInt row = getRowSize(subDims, axis);
+		const UInt splitNum = static_cast<UInt>(sdrs.size());
+
+		UInt nbBlocks = 1u;
+		for(UInt d = 0u; d < axis; ++d)
+			nbBlocks *= subDims.at(d);
+
+		// The block of each subspace is placed after the same block of the
+		// previous subspaces, so walking the blocks in order keeps the
+		// concatenated indices sorted.
+		std::vector<std::size_t> positions(splitNum, 0u);
+
+		for(UInt block = 0u; block < nbBlocks; ++block){
+			const UInt blockEnd = (block + 1u) * row;
+
+			for(UInt s = 0u; s < splitNum; ++s){
+				const SDR_sparse_t& sparse = sdrs.at(s).getSparse();
+				const UInt offset = (block * splitNum + s) * row - block * row;
+				std::size_t& pos = positions.at(s);
+
+				for(const auto size = sparse.size(); pos < size && sparse[pos] < blockEnd; ++pos)
+					func(s, pos, offset + sparse[pos]);
+			}
+		}
+	}
+
+	/**
+	 * Split the SDR into the subspace SDRs. The subspace SDRs are
+	 * initialized only if the number or the dimensions are different, so
+	 * the buffers of the caller-owned SDRs are reused.
+	 * 
+	 * @param sdr The splitted SDR.
+	 * @param sdrs The subspace SDRs. (This param has a return value.)
+	 * @param splitNum The number of split SDR. The splitNum must be greater
+	 * than zero.
+	 * @param axis The axis splitting a SDR in the dimensions. 
+	 */
+	static void splitSDR(
+		const SDR& sdr,
+		std::vector<SDR>& sdrs,
+		const UInt splitNum = 1u,
+		const UInt axis = 0u
+	);
+
+	/**
+	 * Concatenate the subspace SDRs into the SDR. The SDR must have been
+	 * initialized with the concatenated dimensions.
+	 * 
+	 * @param sdrs The subspace SDRs. All SDRs must have same dimensions.
+	 * @param sdr The concatenated SDR. (This param has a return value.)
+	 * @param axis The axis splitting a SDR in the dimensions. 
+	 */
+	static void concatenateSDR(
+		const std::vector<SDR>& sdrs,
+		SDR& sdr,
+		const UInt axis = 0u
+	);
+
+	/**
+	 * Get the number of the contiguous elements of one subspace block.
+	 * 
+	 * @param subDims The dimensions of subspace.
+	 * @param axis The axis splitting in the dimensions.
+	 */
+	static const UInt getRowSize(
+		const std::vector<UInt>& subDims,
+		const UInt axis = 0u
+	){
+		UInt row = 1u;
+		for(UInt d = axis, size = static_cast<UInt>(subDims.size()); d < size; ++d)
+			row *= subDims.at(d);
+
+		return row;
+	}
+};
+
+
 /**
  * PartialInterface definition in C++.
  * 
@@ -213,6 +347,14 @@ public:
 	 */
 	const std::vector<SDR> split() const;
 
+	/**
+	 * Split this PartialSDR into the caller-owned SDRs. The SDRs are
+	 * reinitialized only if they do not have the partial dimensions.
+	 * 
+	 * @param sdrs Some SDRs. (This param has a return value.)
+	 */
+	void split(std::vector<SDR>& sdrs) const;
+
 	/**
 	 * Concatenate some SDR.
 	 * 
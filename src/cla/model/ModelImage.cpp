@@ -0,0 +1,420 @@
+// ModelImage.cpp
+
+/**
+ * @file
+ * Implementation of ModelImage.cpp
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <utility>
+
+#include "cla/extension/algorithms/ConnectedBitMatrix.hpp"
+#include "cla/extension/types/Psdr.hpp"
+#include "cla/model/ModelImage.hpp"
+#include "cla/model/module/io/ScalarIO.hpp"
+#include "cla/model/module/sp/HtmSpatialPooler.hpp"
+#include "cla/model/module/tm/HtmTemporalMemory.hpp"
+#include "cla/utils/Checker.hpp"
+
+namespace cla {
+
+namespace {
+
+constexpr std::size_t SECTION_ALIGNMENT = 64u;
+
+struct ImageHeader {
+	char magic[16];
+	htm::UInt32 version;
+	htm::UInt32 nbLayers;
+	htm::UInt32 nbInputs;
+	htm::UInt32 nbActiveBits;
+	htm::UInt32 nbDimensions;
+	htm::UInt32 reserved[3];
+};
+
+struct LayerHeader {
+	htm::UInt32 nbRegions;
+	htm::UInt32 reserved;
+	htm::UInt64 tmBytes;
+	htm::FrozenTemporalMemory::Parameters tmParameters;
+};
+
+struct SpatialPoolerHeader {
+	htm::UInt32 numColumns;
+	htm::UInt32 numInputs;
+	htm::UInt32 wordsPerRow;
+	htm::UInt32 stimulusThreshold;
+	htm::Real localAreaDensity;
+	htm::UInt32 globalInhibition;
+	htm::UInt32 boosted;
+	htm::UInt32 reserved;
+};
+
+/**
+ * The output stream of the image which pads the sections.
+ */
+class ImageWriter {
+public:
+	explicit ImageWriter(std::ofstream& ofs) : ofs_(ofs), position_(0u) {}
+
+	void write(const void* data, const std::size_t bytes) {
+		ofs_.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+		position_ += bytes;
+	}
+
+	template<typename T>
+	void write(const std::vector<T>& values) {
+		write(values.data(), values.size() * sizeof(T));
+	}
+
+	void align() {
+		static const char zeros[SECTION_ALIGNMENT] = {};
+		write(zeros, (SECTION_ALIGNMENT - position_ % SECTION_ALIGNMENT) % SECTION_ALIGNMENT);
+	}
+
+	void skip(const std::size_t bytes) {
+		position_ += bytes;
+	}
+
+private:
+	std::ofstream& ofs_;
+	std::size_t position_;
+};
+
+/**
+ * The cursor of the mapped image which checks the bounds of the sections.
+ */
+class ImageReader {
+public:
+	ImageReader(const char* data, const std::size_t size)
+		: data_(data), size_(size), position_(0u) {}
+
+	template<typename T>
+	const T* read(const std::size_t count) {
+		CLA_CHECK(
+			size_ - position_ >= count * sizeof(T),
+			"The model image is truncated."
+		)
+		const T* values = reinterpret_cast<const T*>(data_ + position_);
+		position_ += count * sizeof(T);
+		return values;
+	}
+
+	void align() {
+		position_ += (SECTION_ALIGNMENT - position_ % SECTION_ALIGNMENT) % SECTION_ALIGNMENT;
+		CLA_CHECK(position_ <= size_, "The model image is truncated.")
+	}
+
+private:
+	const char* data_;
+	std::size_t size_;
+	std::size_t position_;
+};
+
+} // namespace
+
+
+/************************************************
+ * ModelImage::SpatialPoolerView functions.
+ ***********************************************/
+
+void ModelImage::SpatialPoolerView::computeOverlaps(
+	const std::vector<htm::CellIdx>& activeInputs,
+	std::vector<htm::SynapseIdx>& overlaps
+) const {
+	htm::ConnectedBitMatrix::computeOverlaps(
+		rows, numColumns, wordsPerRow, numInputs, activeInputs, overlaps
+	);
+}
+
+void ModelImage::SpatialPoolerView::infer(
+	const htm::SDR& input,
+	htm::SpatialPoolerExtensionState& state,
+	htm::SDR& active
+) const {
+	CLA_CHECK(globalInhibition, "The model image supports only the global inhibition.")
+	CLA_CHECK(input.size == numInputs, "The input size is not " << numInputs)
+	CLA_CHECK(active.size == numColumns, "The active columns size is not " << numColumns)
+
+	htm::ConnectedBitMatrix::computeOverlaps(
+		rows, numColumns, wordsPerRow, numInputs, input.getSparse(),
+		state.overlaps, state.inputWords
+	);
+
+	auto& boosted = state.boostedOverlaps;
+	boosted.assign(state.overlaps.begin(), state.overlaps.end());
+	if(boostFactors != nullptr) {
+		for(htm::UInt i = 0u; i < numColumns; ++i)
+			boosted[i] = state.overlaps[i] * boostFactors[i];
+	}
+
+	// The global inhibition of the SpatialPooler: the columns with the
+	// largest overlaps win, and the ties go to the larger index.
+	const htm::UInt numDesired = static_cast<htm::UInt>(localAreaDensity * numColumns);
+	CLA_CHECK(numDesired > 0u, "Not enough columns for the density " << localAreaDensity)
+
+	auto& activeVector = state.activeColumns;
+	activeVector.resize(numColumns);
+	std::iota(activeVector.begin(), activeVector.end(), 0u);
+
+	const auto compare = [&boosted](const htm::UInt a, const htm::UInt b) {
+		return (boosted[a] == boosted[b]) ? a > b : boosted[a] > boosted[b];
+	};
+	std::nth_element(
+		activeVector.begin(), activeVector.begin() + numDesired,
+		activeVector.end(), compare
+	);
+	activeVector.resize(numDesired);
+	std::sort(activeVector.begin(), activeVector.end(), compare);
+	while(!activeVector.empty() && boosted[activeVector.back()] < stimulusThreshold)
+		activeVector.pop_back();
+
+	// The active columns are copied, so the buffer keeps its capacity.
+	std::sort(activeVector.begin(), activeVector.end());
+	active.setSparse(activeVector.data(), static_cast<htm::UInt>(activeVector.size()));
+}
+
+
+/************************************************
+ * ModelImage::LayerView functions.
+ ***********************************************/
+
+void ModelImage::LayerView::forward(
+	const htm::SDR& activeBits,
+	LayerState& state,
+	htm::SDR& activeColumns,
+	htm::SDR& activeCells,
+	htm::SDR& winnerCells
+) const {
+	const htm::UInt nbRegions = static_cast<htm::UInt>(sps.size());
+
+	htm::PartialSparseFuncs::splitSDR(activeBits, state.subActiveBits, nbRegions);
+
+	// The regions split the columns on the first axis.
+	auto dimensions = activeColumns.dimensions;
+	dimensions.front() /= nbRegions;
+	if(state.subActiveColumns.size() != nbRegions
+		|| state.subActiveColumns.front().dimensions != dimensions) {
+		state.subActiveColumns.assign(nbRegions, htm::SDR(dimensions));
+	}
+	state.sps.resize(nbRegions);
+
+	for(std::size_t i = 0u; i < sps.size(); ++i) {
+		sps.at(i).infer(
+			state.subActiveBits.at(i), state.sps.at(i), state.subActiveColumns.at(i)
+		);
+	}
+
+	htm::PartialSparseFuncs::concatenateSDR(state.subActiveColumns, activeColumns);
+
+	tm.compute(activeColumns, state.tm);
+
+	// Copy the cells, the non-const setSparse swaps them out of the state.
+	activeCells.setSparse(std::as_const(state.tm.activeCells));
+	winnerCells.setSparse(std::as_const(state.tm.winnerCells));
+}
+
+void ModelImage::LayerView::backward(
+	LayerState& state,
+	htm::SDR_sparse_t& activeSegments
+) const {
+	tm.activateDendrites(state.tm);
+	activeSegments = state.tm.activeSegmentsForInner;
+}
+
+void ModelImage::LayerView::backward(
+	const htm::SDR& externalActiveSDR,
+	const htm::SDR& externalWinnerSDR,
+	LayerState& state,
+	htm::SDR_sparse_t& activeSegments
+) const {
+	tm.activateDendrites(state.tm, externalActiveSDR, externalWinnerSDR);
+	activeSegments = state.tm.activeSegmentsForInner;
+}
+
+
+/************************************************
+ * ModelImage public functions.
+ ***********************************************/
+
+ModelImage::ModelImage(const std::string& path, const bool validate) {
+	open(path, validate);
+}
+
+void ModelImage::write(
+	const std::vector<PLayer>& layers,
+	const PIO& io,
+	const std::string& path
+) {
+	const auto* scalarIO = dynamic_cast<const ScalarIO*>(io.get());
+	CLA_CHECK(scalarIO != nullptr, "The model image supports only the ScalarIO.")
+
+	std::ofstream ofs(path, std::ios_base::binary | std::ios_base::trunc);
+	CLA_CHECK(!ofs.fail(), "Cannot open the model image file: " << path)
+
+	ImageWriter writer(ofs);
+
+	ImageHeader header = {};
+	std::strncpy(header.magic, _imageMagic.c_str(), sizeof(header.magic) - 1u);
+	header.version = _imageVersion;
+	header.nbLayers = static_cast<htm::UInt32>(layers.size());
+	header.nbInputs = scalarIO->getNbInputs();
+	header.nbActiveBits = scalarIO->getNbActiveBits();
+	header.nbDimensions = static_cast<htm::UInt32>(
+		scalarIO->getInputDimensions().size()
+	);
+	writer.write(&header, sizeof(ImageHeader));
+	writer.write(scalarIO->getInputDimensions());
+	writer.align();
+	writer.write(scalarIO->getMins());
+	writer.write(scalarIO->getMaxs());
+
+	for(const auto& layer : layers) {
+		const auto& sps = layer->getSPs();
+		const auto* htmTM = dynamic_cast<const HtmTemporalMemory*>(layer->getTM().get());
+		CLA_CHECK(htmTM != nullptr, "The model image supports only the HtmTemporalMemory.")
+		const auto& tm = htmTM->getTemporalMemory();
+
+		// The size of the frozen connections is known after they are
+		// written, so it is patched in the layer header.
+		writer.align();
+		const auto headerPos = ofs.tellp();
+
+		LayerHeader layerHeader = {};
+		layerHeader.nbRegions = static_cast<htm::UInt32>(sps.size());
+		layerHeader.tmParameters = htm::FrozenTemporalMemory::parametersOf(tm);
+		writer.write(&layerHeader, sizeof(LayerHeader));
+
+		for(const auto& psp : sps) {
+			const auto* htmSP = dynamic_cast<const HtmSpatialPooler*>(psp.get());
+			CLA_CHECK(htmSP != nullptr, "The model image supports only the HtmSpatialPooler.")
+			const auto& sp = htmSP->getSpatialPooler();
+
+			const auto columnDimensions = sp.getColumnDimensions();
+			const htm::UInt maxDimension
+				= *std::max_element(columnDimensions.begin(), columnDimensions.end());
+
+			SpatialPoolerHeader spHeader = {};
+			spHeader.numColumns = sp.getNumColumns();
+			spHeader.numInputs = sp.getNumInputs();
+			spHeader.wordsPerRow = htm::ConnectedBitMatrix::wordsPerRow(
+				spHeader.numInputs
+			);
+			spHeader.stimulusThreshold = sp.getStimulusThreshold();
+			spHeader.localAreaDensity = sp.getLocalAreaDensity();
+			// The local inhibition over a radius larger than the columns is
+			// the global inhibition, as in SpatialPooler::inhibitColumns_.
+			spHeader.globalInhibition
+				= sp.getGlobalInhibition() || sp.getInhibitionRadius() > maxDimension;
+			spHeader.boosted = sp.getBoostStrength() >= htm::Epsilon;
+
+			std::vector<htm::UInt64> rows(
+				static_cast<std::size_t>(spHeader.numColumns) * spHeader.wordsPerRow
+			);
+			htm::ConnectedBitMatrix::fillRows(
+				sp.connections, spHeader.numColumns, spHeader.wordsPerRow,
+				rows.data()
+			);
+
+			writer.align();
+			writer.write(&spHeader, sizeof(SpatialPoolerHeader));
+			writer.align();
+			writer.write(rows);
+
+			if(spHeader.boosted) {
+				std::vector<htm::Real> boostFactors(spHeader.numColumns);
+				sp.getBoostFactors(boostFactors.data());
+				writer.align();
+				writer.write(boostFactors);
+			}
+		}
+
+		writer.align();
+		layerHeader.tmBytes = htm::FrozenConnections::write(ofs, tm.connections);
+		writer.skip(layerHeader.tmBytes);
+
+		const auto endPos = ofs.tellp();
+		ofs.seekp(headerPos);
+		ofs.write(reinterpret_cast<const char*>(&layerHeader), sizeof(LayerHeader));
+		ofs.seekp(endPos);
+	}
+
+	CLA_CHECK(!ofs.fail(), "Cannot write the model image file: " << path)
+}
+
+void ModelImage::open(const std::string& path, const bool validate) {
+	layers_.clear();
+	file_.open(path);
+
+	ImageReader reader(file_.data(), file_.size());
+
+	const auto* header = reader.read<ImageHeader>(1u);
+	CLA_CHECK(
+		std::strncmp(header->magic, _imageMagic.c_str(), sizeof(header->magic)) == 0,
+		"The file is not a cla model image: " << path
+	)
+	CLA_CHECK(
+		header->version == _imageVersion,
+		"The model image version " << header->version << " is not supported."
+	)
+
+	nbInputs_ = header->nbInputs;
+	nbActiveBits_ = header->nbActiveBits;
+
+	const auto* dimensions = reader.read<htm::UInt32>(header->nbDimensions);
+	inputDimensions_.assign(dimensions, dimensions + header->nbDimensions);
+	reader.align();
+
+	const auto* mins = reader.read<Value>(nbInputs_);
+	mins_.assign(mins, mins + nbInputs_);
+	const auto* maxs = reader.read<Value>(nbInputs_);
+	maxs_.assign(maxs, maxs + nbInputs_);
+
+	layers_.resize(header->nbLayers);
+
+	for(auto& layer : layers_) {
+		reader.align();
+		const auto* layerHeader = reader.read<LayerHeader>(1u);
+
+		layer.sps.resize(layerHeader->nbRegions);
+
+		for(auto& sp : layer.sps) {
+			reader.align();
+			const auto* spHeader = reader.read<SpatialPoolerHeader>(1u);
+			CLA_CHECK(
+				spHeader->wordsPerRow
+					== htm::ConnectedBitMatrix::wordsPerRow(spHeader->numInputs),
+				"The model image has a different row layout."
+			)
+
+			sp.numColumns = spHeader->numColumns;
+			sp.numInputs = spHeader->numInputs;
+			sp.wordsPerRow = spHeader->wordsPerRow;
+			sp.stimulusThreshold = spHeader->stimulusThreshold;
+			sp.localAreaDensity = spHeader->localAreaDensity;
+			sp.globalInhibition = spHeader->globalInhibition != 0u;
+
+			reader.align();
+			sp.rows = reader.read<htm::UInt64>(
+				static_cast<std::size_t>(sp.numColumns) * sp.wordsPerRow
+			);
+
+			sp.boostFactors = nullptr;
+			if(spHeader->boosted != 0u) {
+				reader.align();
+				sp.boostFactors = reader.read<htm::Real>(sp.numColumns);
+			}
+		}
+
+		reader.align();
+		const auto* tmImage = reader.read<char>(layerHeader->tmBytes);
+		layer.tm.attach(
+			layerHeader->tmParameters, tmImage, layerHeader->tmBytes, validate
+		);
+	}
+}
+
+} // namespace cla
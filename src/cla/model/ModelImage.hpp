@@ -0,0 +1,274 @@
+// ModelImage.hpp
+
+/**
+ * @file
+ * Definitions for the ModelImage class in C++
+ */
+
+#ifndef MODEL_IMAGE_HPP
+#define MODEL_IMAGE_HPP
+
+#include <string>
+#include <vector>
+
+#include "cla/extension/algorithms/FrozenTemporalMemory.hpp"
+#include "cla/extension/algorithms/SpatialPoolerExtension.hpp"
+#include "cla/extension/algorithms/TemporalMemoryExtension.hpp"
+#include "cla/model/core/CoreIO.hpp"
+#include "cla/model/core/CoreLayer.hpp"
+#include "cla/utils/MappedFile.hpp"
+
+namespace cla {
+
+/**
+ * ModelImage implementation in C++.
+ *
+ * @b Description
+ * The ModelImage is the read-only image of a trained cla model for the
+ * inference. Unlike the snapshot, the image is a flat file of fixed-layout
+ * arrays which is memory-mapped and read in place: the encoder parameters
+ * of the io, the connected bit matrix and the inhibition parameters of
+ * each spatial pooler, and the frozen connections and the parameters of
+ * each temporal memory. The processes which open the same image share
+ * its pages. Opening an image validates the frozen connections, which
+ * reads them once; a trusted image can be opened without the validation,
+ * so the startup is bounded by the page faults of the used pages.
+ *
+ * The layer views run the inference of a stream from the active bits of
+ * a layer: the global inhibition of the spatial poolers and the threshold
+ * selection of the temporal memory give the same columns, cells and
+ * segments as the live layer. The accepters, the adapters, the senders,
+ * the receivers, the decoding and the anomaly stay in the live model, so
+ * the caller routes the bits and the external cells between the layers.
+ *
+ * Each section starts at a multiple of 64 bytes:
+ *
+ * +---------------+---------------------------------------------------+
+ * |    Section    |                      Content                      |
+ * +---------------+---------------------------------------------------+
+ * |    Header     | magic, version, nbLayers, encoder parameters      |
+ * |   Layer(i)    | nbRegions, bytes, temporal memory parameters      |
+ * |  Spatial(i,r) | numColumns, numInputs, inhibition, bit rows,      |
+ * |               | boost factors                                     |
+ * |  Temporal(i)  | FrozenConnections image                           |
+ * +---------------+---------------------------------------------------+
+ */
+class ModelImage {
+
+public:
+
+	/**
+	 * The connected bit matrix of a spatial pooler in the image.
+	 * See ConnectedBitMatrix.
+	 */
+	struct SpatialPoolerView {
+		htm::UInt numColumns;
+		htm::UInt numInputs;
+		htm::UInt wordsPerRow;
+		htm::UInt stimulusThreshold;
+		htm::Real localAreaDensity;
+		bool globalInhibition;
+		const htm::UInt64* rows;
+		const htm::Real* boostFactors; // nullptr without the boosting.
+
+		/**
+		 * Compute the number of the connected synapses to the active inputs
+		 * for each column.
+		 *
+		 * @param activeInputs The indexes of active inputs.
+		 * @param overlaps The overlaps of the columns. (This param has a
+		 * return value.)
+		 */
+		void computeOverlaps(
+			const std::vector<htm::CellIdx>& activeInputs,
+			std::vector<htm::SynapseIdx>& overlaps
+		) const;
+
+		/**
+		 * Infer the active columns of the input without learning, as
+		 * SpatialPoolerExtension::infer. Only the global inhibition is
+		 * supported.
+		 *
+		 * @param input The active input bits.
+		 * @param state The buffers of the stream.
+		 * @param active The active columns. (This param has a return value.)
+		 */
+		void infer(
+			const htm::SDR& input,
+			htm::SpatialPoolerExtensionState& state,
+			htm::SDR& active
+		) const;
+	};
+
+	/**
+	 * The state of a stream on a layer of the image. The random generator
+	 * of the temporal memory state chooses the winner cells of the bursting
+	 * columns, so it is seeded by the caller.
+	 */
+	struct LayerState {
+		std::vector<htm::SDR> subActiveBits;
+		std::vector<htm::SDR> subActiveColumns;
+		std::vector<htm::SpatialPoolerExtensionState> sps;
+		htm::TemporalMemoryExtensionState tm;
+	};
+
+	/**
+	 * The spatial poolers of the regions and the temporal memory of a
+	 * layer in the image.
+	 */
+	struct LayerView {
+		std::vector<SpatialPoolerView> sps;
+		htm::FrozenTemporalMemory tm;
+
+		/**
+		 * Compute the active columns and the active cells of the active
+		 * bits, as the forward of HtmLayer after the adapter.
+		 *
+		 * @param activeBits The active bits of the layer.
+		 * @param state The state of the stream.
+		 * @param activeColumns The active columns, initialized with the
+		 * column dimensions of the layer. (This param has a return value.)
+		 * @param activeCells The active cells. (This param has a return value.)
+		 * @param winnerCells The winner cells. (This param has a return value.)
+		 */
+		void forward(
+			const htm::SDR& activeBits,
+			LayerState& state,
+			htm::SDR& activeColumns,
+			htm::SDR& activeCells,
+			htm::SDR& winnerCells
+		) const;
+
+		/**
+		 * Activate the segments by the active cells of the layer, as the
+		 * backward of the top HtmLayer.
+		 *
+		 * @param state The state of the stream.
+		 * @param activeSegments The active segments. (This param has a return value.)
+		 */
+		void backward(
+			LayerState& state,
+			htm::SDR_sparse_t& activeSegments
+		) const;
+
+		/**
+		 * Activate the segments by the active cells of the layer and the
+		 * external cells received from the upper layer.
+		 *
+		 * @param externalActiveSDR The active external cells.
+		 * @param externalWinnerSDR The winner external cells.
+		 * @param state The state of the stream.
+		 * @param activeSegments The active segments. (This param has a return value.)
+		 */
+		void backward(
+			const htm::SDR& externalActiveSDR,
+			const htm::SDR& externalWinnerSDR,
+			LayerState& state,
+			htm::SDR_sparse_t& activeSegments
+		) const;
+	};
+
+private:
+
+	inline static const std::string _imageMagic = "CLA-IMAGE";
+	inline static const htm::UInt32 _imageVersion = 2u;
+
+	MappedFile file_;
+
+	htm::UInt nbInputs_;
+	std::vector<htm::UInt> inputDimensions_;
+	htm::UInt nbActiveBits_;
+	Values mins_;
+	Values maxs_;
+
+	std::vector<LayerView> layers_;
+
+public:
+
+	/**
+	 * ModelImage constructor. The image is empty until open.
+	 */
+	ModelImage() = default;
+
+	/**
+	 * ModelImage constructor with the path.
+	 * See open.
+	 */
+	explicit ModelImage(const std::string& path, const bool validate = true);
+
+	/**
+	 * ModelImage destructor.
+	 */
+	~ModelImage() = default;
+
+	/**
+	 * Write the image of the layers and the io. The io must be a ScalarIO,
+	 * and the layers must have the HtmSpatialPooler and the
+	 * HtmTemporalMemory.
+	 *
+	 * @param layers The layers of the cla model.
+	 * @param io The io of the cla model.
+	 * @param path The path of the image file.
+	 */
+	static void write(
+		const std::vector<PLayer>& layers,
+		const PIO& io,
+		const std::string& path
+	);
+
+	/**
+	 * Map the image file and attach the views. The image opened before is
+	 * released.
+	 *
+	 * @param path The path of the image file.
+	 * @param validate Whether to validate the frozen connections. See
+	 * FrozenConnections::attach.
+	 */
+	void open(const std::string& path, const bool validate = true);
+
+	/**
+	 * Get the number of the input values.
+	 */
+	const htm::UInt getNbInputs() const { return nbInputs_; }
+
+	/**
+	 * Get the input bits dimensions.
+	 */
+	const std::vector<htm::UInt>& getInputDimensions() const {
+		return inputDimensions_;
+	}
+
+	/**
+	 * Get the number of the active bits.
+	 */
+	const htm::UInt getNbActiveBits() const { return nbActiveBits_; }
+
+	/**
+	 * Get the minimum values of each input value.
+	 */
+	const Values& getMins() const { return mins_; }
+
+	/**
+	 * Get the maximum values of each input value.
+	 */
+	const Values& getMaxs() const { return maxs_; }
+
+	/**
+	 * Get the views of the layers, in the order of the cla model.
+	 */
+	const std::vector<LayerView>& getLayers() const { return layers_; }
+
+	/**
+	 * Get the size of the mapped image in bytes.
+	 */
+	std::size_t size() const { return file_.size(); }
+
+	/**
+	 * Check whether the pages of the image are shared between processes.
+	 */
+	const bool isShared() const { return file_.isShared(); }
+};
+
+} // namespace cla
+
+#endif // MODEL_IMAGE_HPP
@@ -0,0 +1,114 @@
+// ModelPool.cpp
+
+/**
+ * @file
+ * Implementation of ModelPool.cpp
+ */
+
+#include "cla/model/ModelPool.hpp"
+#include "cla/utils/Checker.hpp"
+
+namespace cla {
+
+/************************************************
+ * ModelPool private functions.
+ ***********************************************/
+
+void ModelPool::dispatch_(
+	const std::vector<ModelInput>& inputs,
+	const std::function<void(const std::size_t)>& func
+) {
+	// Group the inputs by the model, keeping the submission order.
+	std::vector<std::vector<std::size_t>> inputsForModel(models_.size());
+	std::vector<ModelId> modelIds;
+
+	for(std::size_t i = 0u, size = inputs.size(); i < size; ++i) {
+		const ModelId modelId = inputs.at(i).modelId;
+		CLA_CHECK(modelId < models_.size(), "The model id is out of range.");
+
+		if(inputsForModel.at(modelId).empty()) modelIds.emplace_back(modelId);
+		inputsForModel.at(modelId).emplace_back(i);
+	}
+
+	threadPool_.parallelFor(modelIds.size(), [&](const std::size_t idx) {
+		for(const auto i : inputsForModel.at(modelIds.at(idx)))
+			func(i);
+	});
+}
+
+/************************************************
+ * ModelPool public functions.
+ ***********************************************/
+
+ModelPool::ModelPool(
+	std::vector<PCLA> models,
+	const std::size_t nbThreads,
+	const bool pinThreads
+) :
+	models_(std::move(models)),
+	threadPool_(nbThreads, pinThreads)
+{
+	for(const auto& model : models_) {
+		CLA_ASSERT(model);
+	}
+}
+
+ModelPool::ModelPool(
+	std::vector<JsonConfig>& configs,
+	const std::size_t nbThreads,
+	const bool pinThreads
+) :
+	threadPool_(nbThreads, pinThreads)
+{
+	models_.reserve(configs.size());
+
+	for(auto&& config : configs)
+		models_.emplace_back(config.buildModel());
+}
+
+void ModelPool::reset() {
+	threadPool_.parallelFor(models_.size(), [&](const std::size_t idx) {
+		models_.at(idx)->reset();
+	});
+}
+
+const std::vector<Values> ModelPool::feedforward(
+	const std::vector<ModelInput>& inputs,
+	const bool learn
+) {
+	std::vector<Values> predictions(inputs.size());
+
+	dispatch_(inputs, [&](const std::size_t i) {
+		const auto& input = inputs.at(i);
+		predictions.at(i) = models_.at(input.modelId)->feedforward(
+			input.values, learn
+		);
+	});
+
+	return predictions;
+}
+
+void ModelPool::feedback(
+	const std::vector<ModelInput>& nexts,
+	const bool learn
+) {
+	dispatch_(nexts, [&](const std::size_t i) {
+		const auto& next = nexts.at(i);
+		models_.at(next.modelId)->feedback(next.values, learn);
+	});
+}
+
+const std::size_t ModelPool::size() const {
+	return models_.size();
+}
+
+const std::size_t ModelPool::getNbThreads() const {
+	return threadPool_.size();
+}
+
+const PCLA& ModelPool::getModel(const ModelId modelId) const {
+	CLA_ASSERT(modelId < models_.size());
+	return models_.at(modelId);
+}
+
+} // namespace cla
@@ -0,0 +1,155 @@
+// ModelPool.hpp
+
+/**
+ * @file
+ * Definitions for the ModelPool class in C++
+ */
+
+#ifndef MODEL_POOL_HPP
+#define MODEL_POOL_HPP
+
+#include <vector>
+
+#include "cla/config/ModelConfig.hpp"
+#include "cla/model/core/CoreCLA.hpp"
+#include "cla/utils/ThreadPool.hpp"
+
+namespace cla {
+
+using ModelId = std::size_t;
+
+/**
+ * ModelInput implementation in C++.
+ *
+ * @b Description
+ * The ModelInput is the pair of the model index and the values given to
+ * the model.
+ */
+struct ModelInput {
+	ModelId modelId;
+	Values values;
+};
+
+
+/**
+ * ModelPool implementation in C++.
+ *
+ * @b Description
+ * The ModelPool owns many independent cla models and runs them on a
+ * work-stealing thread pool. A batch of inputs is grouped by the model,
+ * and the inputs of one model run in the submission order on one thread
+ * at a time, while the different models run in parallel. The outputs are
+ * returned in the submission order.
+ */
+class ModelPool {
+
+private:
+
+	std::vector<PCLA> models_;
+	ThreadPool threadPool_;
+
+private:
+
+	/**
+	 * Run the function on each input of the batch. The inputs of the same
+	 * model are given in the submission order and never concurrently.
+	 *
+	 * @param inputs The batch of the inputs.
+	 * @param func The function called with the index of the input.
+	 */
+	void dispatch_(
+		const std::vector<ModelInput>& inputs,
+		const std::function<void(const std::size_t)>& func
+	);
+
+public:
+
+	/**
+	 * ModelPool constructor with the models.
+	 *
+	 * @param models The pointers of the cla models.
+	 * @param nbThreads The number of the worker threads. If the number is
+	 * zero, the number of the hardware threads is used.
+	 * @param pinThreads The boolean value whether each worker is pinned to
+	 * one core.
+	 */
+	ModelPool(
+		std::vector<PCLA> models,
+		const std::size_t nbThreads = 0u,
+		const bool pinThreads = false
+	);
+
+	/**
+	 * ModelPool constructor with the configs. One model is built from
+	 * each config.
+	 *
+	 * @param configs The configs of the cla models.
+	 * @param nbThreads The number of the worker threads. If the number is
+	 * zero, the number of the hardware threads is used.
+	 * @param pinThreads The boolean value whether each worker is pinned to
+	 * one core.
+	 */
+	ModelPool(
+		std::vector<JsonConfig>& configs,
+		const std::size_t nbThreads = 0u,
+		const bool pinThreads = false
+	);
+
+	/**
+	 * ModelPool destructor.
+	 */
+	~ModelPool() = default;
+
+	/**
+	 * Reset all the cla models.
+	 */
+	void reset();
+
+	/**
+	 * Feedforward the batch of the inputs to the prediction values.
+	 *
+	 * @param inputs The batch of the inputs.
+	 * @param learn The boolean value whether learning mode.
+	 * @return const std::vector<Values> The prediction values in the
+	 * submission order.
+	 */
+	const std::vector<Values> feedforward(
+		const std::vector<ModelInput>& inputs,
+		const bool learn
+	);
+
+	/**
+	 * Feedback the batch of the next values to the cla models.
+	 *
+	 * @param nexts The batch of the next values.
+	 * @param learn The boolean value whether learning mode.
+	 */
+	void feedback(const std::vector<ModelInput>& nexts, const bool learn);
+
+	/**
+	 * Get the number of the cla models.
+	 *
+	 * @return const std::size_t The number of the cla models.
+	 */
+	const std::size_t size() const;
+
+	/**
+	 * Get the number of the worker threads.
+	 *
+	 * @return const std::size_t The number of the worker threads.
+	 */
+	const std::size_t getNbThreads() const;
+
+	/**
+	 * Get the cla model. The model must not be used while the pool runs.
+	 *
+	 * @param modelId The index of the model.
+	 * @return const PCLA& The pointer of the cla model.
+	 */
+	const PCLA& getModel(const ModelId modelId) const;
+};
+
+
+} // namespace cla
+
+#endif // MODEL_POOL_HPP
@@ -8,9 +8,64 @@
 #include "cla/utils/Checker.hpp"
 #include "cla/utils/SdrHelpers.hpp"
 #include "cla/model/MultiLayerCLA.hpp"
+#include "cla/model/ModelImage.hpp"
 
 namespace cla {
 
+/************************************************
+ * MultiLayerCLA private functions.
+ ***********************************************/
+
+std::vector<Values> MultiLayerCLA::rollout_(
+	StreamState& state,
+	const Step horizon
+) const {
+	std::vector<Values> forecasts;
+	forecasts.reserve(horizon);
+
+	if(horizon == 0u) return forecasts;
+
+	// The bottom layer holds the prediction of the last step.
+	forecasts.emplace_back(io_->decode(state.layers.back()->proxy));
+
+	while(forecasts.size() < horizon)
+		forecasts.emplace_back(feedforward(forecasts.back(), state));
+
+	return forecasts;
+}
+
+
+/************************************************
+ * MultiLayerCLA protected functions.
+ ***********************************************/
+
+void MultiLayerCLA::saveState_(cereal::BinaryOutputArchive& ar) const {
+	const htm::UInt nbLayers = static_cast<htm::UInt>(layers_.size());
+	ar(nbLayers);
+
+	for(const auto& layer : layers_)
+		saveModule(ar, *layer);
+
+	saveModule(ar, *io_);
+}
+
+void MultiLayerCLA::loadState_(cereal::BinaryInputArchive& ar) {
+	htm::UInt nbLayers;
+	ar(nbLayers);
+
+	CLA_CHECK_THROW(
+		nbLayers == layers_.size(),
+		"Error: The snapshot has " << nbLayers << " layers, but the model has "
+		<< layers_.size() << " layers."
+	);
+
+	for(const auto& layer : layers_)
+		loadModule(ar, *layer);
+
+	loadModule(ar, *io_);
+}
+
+
 /************************************************
  * MultiLayerCLA public functions.
  ***********************************************/
@@ -105,6 +160,92 @@ const Values MultiLayerCLA::feedforward(
 	return io_->decode(proxy);
 }
 
+StreamState MultiLayerCLA::makeStreamState() const {
+	StreamState state;
+
+	for(auto&& layer : layers_)
+		state.layers.emplace_back(layer->makeState());
+
+	return state;
+}
+
+const Values MultiLayerCLA::feedforward(
+	const Values& inputs,
+	StreamState& state
+) const {
+	CLA_ASSERT(state.layers.size() == layers_.size());
+
+	// The preparation process.
+	for(std::size_t i = 0u, size = layers_.size(); i < size; ++i) {
+		layers_.at(i)->restate(*state.layers.at(i));
+	}
+
+	// Initialize local variables.
+	htm::SDR inputSDR, activeSDR;
+	PLayerProxy proxy;
+	int nbLayers = static_cast<int>(layers_.size()), idx = nbLayers - 1;
+	bool isContinueRun;
+
+	// forward process.
+	io_->encode(inputs, inputSDR);
+
+	for(; idx >= 0; --idx) {
+		isContinueRun = layers_.at(idx)->forward(
+			inputSDR, *state.layers.at(idx), activeSDR
+		);
+
+		if(isContinueRun && idx > 0) copy(activeSDR, inputSDR);
+		else break;
+	}
+
+
+	// backward process.
+	for(; idx < nbLayers; ++idx) {
+		if(idx == 0) {
+			// The case when the top layer run.
+			proxy = layers_.at(idx)->backward(*state.layers.at(idx));
+		} else {
+			// The case when the middle layer run.
+			proxy = layers_.at(idx)->backward(proxy, *state.layers.at(idx));
+		}
+	}
+
+	return io_->decode(proxy);
+}
+
+StreamState MultiLayerCLA::fork() const {
+	StreamState state;
+
+	for(auto&& layer : layers_)
+		state.layers.emplace_back(layer->forkState());
+
+	return state;
+}
+
+StreamState MultiLayerCLA::fork(const StreamState& state) const {
+	CLA_ASSERT(state.layers.size() == layers_.size());
+
+	StreamState forked;
+
+	for(std::size_t i = 0u, size = layers_.size(); i < size; ++i)
+		forked.layers.emplace_back(layers_.at(i)->forkState(*state.layers.at(i)));
+
+	return forked;
+}
+
+std::vector<Values> MultiLayerCLA::rollout(const Step horizon) const {
+	StreamState state = fork();
+	return rollout_(state, horizon);
+}
+
+std::vector<Values> MultiLayerCLA::rollout(
+	const StreamState& state,
+	const Step horizon
+) const {
+	StreamState forked = fork(state);
+	return rollout_(forked, horizon);
+}
+
 void MultiLayerCLA::feedback(
 	const Values& nexts,
 	const bool learn
@@ -114,6 +255,29 @@ void MultiLayerCLA::feedback(
 	}
 }
 
+const std::size_t MultiLayerCLA::compact(
+	const htm::Real threshold,
+	const std::vector<StreamState*>& states
+) {
+	std::size_t nbCompacted = 0u;
+	std::vector<LayerState*> layerStates(states.size());
+
+	for(std::size_t i = 0u, size = layers_.size(); i < size; ++i) {
+		auto& layer = layers_.at(i);
+		if(layer->getFragmentation() < threshold) continue;
+
+		for(std::size_t s = 0u; s < states.size(); ++s) {
+			CLA_ASSERT(states.at(s)->layers.size() == layers_.size());
+			layerStates.at(s) = states.at(s)->layers.at(i).get();
+		}
+
+		layer->compact(layerStates);
+		nbCompacted++;
+	}
+
+	return nbCompacted;
+}
+
 const std::vector<PLayerProxy> MultiLayerCLA::getLayers() const {
 	std::vector<PLayerProxy> proxies(layers_.size());
 
@@ -127,4 +291,8 @@ const PIO& MultiLayerCLA::getIO() const {
 	return io_;
 }
 
+void MultiLayerCLA::writeImage(const std::string& path) const {
+	ModelImage::write(layers_, io_, path);
+}
+
 } // namespace cla
\ No newline at end of file
@@ -45,6 +45,34 @@ private:
 	std::vector<PLayer> layers_;
 	PIO io_;
 
+private:
+
+	/**
+	 * Forecast the next steps on the forked stream state. The state is
+	 * run forward by the forecasts.
+	 *
+	 * @param state The forked stream state.
+	 * @param horizon The number of the forecast steps.
+	 * @return std::vector<Values> The forecast values of the steps.
+	 */
+	std::vector<Values> rollout_(StreamState& state, const Step horizon) const;
+
+protected:
+
+	/**
+	 * Save the states of the layers and the io to the archive.
+	 *
+	 * @param ar The binary cereal archive.
+	 */
+	void saveState_(cereal::BinaryOutputArchive& ar) const override;
+
+	/**
+	 * Load the states of the layers and the io from the archive.
+	 *
+	 * @param ar The binary cereal archive.
+	 */
+	void loadState_(cereal::BinaryInputArchive& ar) override;
+
 public:
 
 	/**
@@ -104,6 +132,88 @@ public:
 	 */
 	void feedback(const Values& nexts, const bool learn) override;
 
+	/**
+	 * Make a new stream state for this cla model. The state holds the
+	 * per-stream activity, so the model can serve several streams.
+	 *
+	 * @return StreamState The stream state.
+	 */
+	StreamState makeStreamState() const override;
+
+	/**
+	 * Feedforward input values to the prediction values on the stream
+	 * without learning. The model is only read, so the function can be
+	 * called from several threads as long as each thread has its own
+	 * stream state.
+	 *
+	 * @param inputs The input values which is vector of float.
+	 * @param state The stream state.
+	 * @return const Values: The prediction values.
+	 */
+	const Values feedforward(
+		const Values& inputs,
+		StreamState& state
+	) const override;
+
+	/**
+	 * Fork the cla model into a stream state. The stream continues from
+	 * the current activity of the model, while the synapses of the model
+	 * are shared and only read. Running the stream does not change the
+	 * model.
+	 *
+	 * @return StreamState The forked stream state.
+	 */
+	StreamState fork() const override;
+
+	/**
+	 * Fork the stream state. The forked stream continues from the given
+	 * one, which is not changed.
+	 *
+	 * @param state The stream state to fork.
+	 * @return StreamState The forked stream state.
+	 */
+	StreamState fork(const StreamState& state) const override;
+
+	/**
+	 * Forecast the next steps by feeding the predictions back on a fork
+	 * of the cla model. The first forecast is the prediction of the last
+	 * feedforward and each next one is predicted from the previous one.
+	 * The model itself is not changed.
+	 *
+	 * @param horizon The number of the forecast steps.
+	 * @return std::vector<Values> The forecast values of the steps.
+	 */
+	std::vector<Values> rollout(const Step horizon) const override;
+
+	/**
+	 * Forecast the next steps of the stream. See rollout. The stream
+	 * state is not changed.
+	 *
+	 * @param state The stream state.
+	 * @param horizon The number of the forecast steps.
+	 * @return std::vector<Values> The forecast values of the steps.
+	 */
+	std::vector<Values> rollout(
+		const StreamState& state,
+		const Step horizon
+	) const override;
+
+	/**
+	 * Compact the temporal memories of the layers whose fragmentation is
+	 * at least the threshold. The segments are renumbered, so the stream
+	 * states made from this model must be given to be renumbered too;
+	 * the other stream states must not be used after the compaction. It
+	 * must be called between two steps.
+	 *
+	 * @param threshold The minimum fragmentation of a compacted layer.
+	 * @param states The stream states of this model to renumber.
+	 * @return const std::size_t The number of the compacted layers.
+	 */
+	const std::size_t compact(
+		const htm::Real threshold = 0.0f,
+		const std::vector<StreamState*>& states = {}
+	) override;
+
 	/**
 	 * Get the layer proxies of the cla model.
 	 * 
@@ -118,6 +228,14 @@ public:
 	 */
 	const PIO& getIO() const override;
 
+	/**
+	 * Write the read-only image of the layers and the io.
+	 * See ModelImage.
+	 *
+	 * @param path The path of the image file.
+	 */
+	void writeImage(const std::string& path) const override;
+
 };
 
 } // namespace cla
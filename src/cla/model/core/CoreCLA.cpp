@@ -5,6 +5,9 @@
  * Implementation of CoreCLA.cpp
  */
 
+#include <fstream>
+#include <sstream>
+
 #include "cla/model/core/CoreCLA.hpp"
 #include "cla/model/core/CoreCallback.hpp" // for cross-referencing
 #include "cla/model/generator/CallbackGenerator.hpp"
@@ -104,6 +107,57 @@ void CoreCLA::test(
 	compile_(nbStep, verbose, false, env, callback);
 }
 
+void CoreCLA::save(const std::string& path) const {
+	std::ofstream out(path, std::ios_base::out | std::ios_base::binary);
+	CLA_CHECK(out, "Error: Cannot open the snapshot file: " << path);
+
+	{
+		cereal::BinaryOutputArchive ar(out);
+		ar(_snapshotMagic, _snapshotVersion);
+		saveState_(ar);
+	}
+
+	CLA_CHECK(out.good(), "Error: Cannot write the snapshot file: " << path);
+}
+
+void CoreCLA::load(const std::string& path) {
+	std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+	CLA_CHECK(in, "Error: Cannot open the snapshot file: " << path);
+
+	cereal::BinaryInputArchive ar(in);
+
+	std::string magic;
+	htm::UInt32 version;
+	ar(magic, version);
+
+	CLA_CHECK(
+		magic == _snapshotMagic,
+		"Error: The file is not a cla snapshot: " << path
+	);
+	CLA_CHECK(
+		version == _snapshotVersion,
+		"Error: Unsupported snapshot version: " << version
+	);
+
+	// The current state is kept, so a snapshot which does not match the
+	// model leaves the model as it was instead of half-loaded.
+	std::stringstream backup(
+		std::ios_base::in | std::ios_base::out | std::ios_base::binary
+	);
+	{
+		cereal::BinaryOutputArchive backupAr(backup);
+		saveState_(backupAr);
+	}
+
+	try {
+		loadState_(ar);
+	} catch(...) {
+		cereal::BinaryInputArchive backupAr(backup);
+		loadState_(backupAr);
+		throw;
+	}
+}
+
 
 /************************************************
  * CoreCLA helper functions.
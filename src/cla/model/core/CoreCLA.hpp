@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
 
 #include "cla/environment/core/CoreEnv.hpp"
 #include "cla/model/core/CoreLayer.hpp"
@@ -32,6 +33,9 @@ class CoreCLA {
 
 private:
 
+	inline static const std::string _snapshotMagic = "CLA-SNAPSHOT";
+	inline static const htm::UInt32 _snapshotVersion = 1u;
+
 	/**
 	 * Compile the given environment.
 	 *
@@ -65,6 +69,22 @@ private:
 		const Values& predictions
 	) const;
 
+protected:
+
+	/**
+	 * Save the state of the cla model to the archive of the snapshot.
+	 *
+	 * @param ar The binary cereal archive.
+	 */
+	virtual void saveState_(cereal::BinaryOutputArchive& ar) const = 0;
+
+	/**
+	 * Load the state of the cla model from the archive of the snapshot.
+	 *
+	 * @param ar The binary cereal archive.
+	 */
+	virtual void loadState_(cereal::BinaryInputArchive& ar) = 0;
+
 public:
 
 	/**
@@ -124,6 +144,88 @@ public:
 	 */
 	virtual void feedback(const Values& nexts, const bool learn) = 0;
 
+	/**
+	 * Make a new stream state for this cla model. The state holds the
+	 * per-stream activity, so the model can serve several streams.
+	 *
+	 * @return StreamState The stream state.
+	 */
+	virtual StreamState makeStreamState() const = 0;
+
+	/**
+	 * Feedforward input values to the prediction values on the stream
+	 * without learning. The model is only read, so the function can be
+	 * called from several threads as long as each thread has its own
+	 * stream state.
+	 *
+	 * @param inputs The input values which is vector of float.
+	 * @param state The stream state.
+	 * @return const Values: The prediction values.
+	 */
+	virtual const Values feedforward(
+		const Values& inputs,
+		StreamState& state
+	) const = 0;
+
+	/**
+	 * Fork the cla model into a stream state. The stream continues from
+	 * the current activity of the model, while the synapses of the model
+	 * are shared and only read. Running the stream does not change the
+	 * model.
+	 *
+	 * @return StreamState The forked stream state.
+	 */
+	virtual StreamState fork() const = 0;
+
+	/**
+	 * Fork the stream state. The forked stream continues from the given
+	 * one, which is not changed.
+	 *
+	 * @param state The stream state to fork.
+	 * @return StreamState The forked stream state.
+	 */
+	virtual StreamState fork(const StreamState& state) const = 0;
+
+	/**
+	 * Forecast the next steps by feeding the predictions back on a fork
+	 * of the cla model. The first forecast is the prediction of the last
+	 * feedforward and each next one is predicted from the previous one.
+	 * The model itself is not changed.
+	 *
+	 * @param horizon The number of the forecast steps.
+	 * @return std::vector<Values> The forecast values of the steps.
+	 */
+	virtual std::vector<Values> rollout(const Step horizon) const = 0;
+
+	/**
+	 * Forecast the next steps of the stream. See rollout. The stream
+	 * state is not changed.
+	 *
+	 * @param state The stream state.
+	 * @param horizon The number of the forecast steps.
+	 * @return std::vector<Values> The forecast values of the steps.
+	 */
+	virtual std::vector<Values> rollout(
+		const StreamState& state,
+		const Step horizon
+	) const = 0;
+
+	/**
+	 * Compact the temporal memories of the layers whose fragmentation is
+	 * at least the threshold. The segments are renumbered, so the stream
+	 * states made from this model must be given to be renumbered too;
+	 * the other stream states must not be used after the compaction. It
+	 * must be called between two steps.
+	 *
+	 * @param threshold The minimum fragmentation of a compacted layer.
+	 * @param states The stream states of this model to renumber.
+	 * @return const std::size_t The number of the compacted layers.
+	 */
+	virtual const std::size_t compact(
+		const htm::Real threshold = 0.0f,
+		const std::vector<StreamState*>& states = {}
+	) = 0;
+
 	/**
 	 * Get the layer proxies of the cla model.
 	 * 
@@ -138,6 +240,14 @@ public:
 	 */
 	virtual const PIO& getIO() const = 0;
 
+	/**
+	 * Write the read-only image of the cla model for the inference.
+	 * See ModelImage.
+	 *
+	 * @param path The path of the image file.
+	 */
+	virtual void writeImage(const std::string& path) const = 0;
+
 
 	/************************************************
 	 * public functions.
@@ -200,6 +310,26 @@ public:
 		PEnv& env,
 		PCallback& callback
 	);
+
+	/**
+	 * Save the cla model to the file as a binary snapshot. The snapshot
+	 * holds the learned synapses and the state of the current step of all
+	 * layers and modules, but not the structure and the parameters.
+	 *
+	 * @param path The path of the snapshot file.
+	 */
+	void save(const std::string& path) const;
+
+	/**
+	 * Load the binary snapshot into the cla model. The model must be built
+	 * from the same configuration as the saved model, and then it
+	 * continues exactly like the saved model. If the snapshot does not
+	 * match the model or cannot be read, the exception is rethrown after
+	 * the model is restored, so the model is never half-loaded.
+	 *
+	 * @param path The path of the snapshot file.
+	 */
+	void load(const std::string& path);
 	
 };
 
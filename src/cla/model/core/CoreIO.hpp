@@ -15,6 +15,7 @@
 
 #include "cla/environment/core/CoreEnv.hpp" // for tyep values.
 #include "cla/model/module/helper/LayerProxy.hpp"
+#include "cla/utils/SerializeHelpers.hpp"
 
 namespace cla {
 
@@ -26,7 +27,7 @@ namespace cla {
  * vector of floating values and the sdr representation. This class is
  * based on the strategy design pattern.
  */
-class CoreIO {
+class CoreIO : public htm::Serializable {
 
 public:
 
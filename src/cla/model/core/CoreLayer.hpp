@@ -20,7 +20,9 @@
 #include "cla/model/core/CoreReceiver.hpp"
 #include "cla/model/module/helper/SDRContainer.hpp"
 #include "cla/model/module/helper/LayerProxy.hpp"
+#include "cla/model/module/helper/StreamState.hpp"
 #include "cla/utils/Status.hpp"
+#include "cla/utils/SerializeHelpers.hpp"
 
 
 namespace cla {
@@ -32,7 +34,7 @@ namespace cla {
  * The CoreLayer is the base (interface) class for layers. This class
  * defines additional functions for layers.
  */
-class CoreLayer {
+class CoreLayer : public htm::Serializable {
 
 public:
 
@@ -71,6 +73,23 @@ public:
 	 */
 	virtual void detail(std::ostream& os = std::cout) const = 0;
 
+	/**
+	 * Get the fragmentation of the temporal memory, the ratio of the
+	 * destroyed segment slots to all the segment slots.
+	 *
+	 * @return const htm::Real The fragmentation in [0, 1].
+	 */
+	virtual const htm::Real getFragmentation() const = 0;
+
+	/**
+	 * Compact the temporal memory of the layer, and renumber the segments
+	 * held by the layer and by the stream states. It must be called
+	 * between two steps.
+	 *
+	 * @param states The stream states of this layer to renumber.
+	 */
+	virtual void compact(const std::vector<LayerState*>& states) = 0;
+
 	/**
 	 * Forward the input sdr.
 	 * This function transfers the sdr of the input values to the columns
@@ -124,6 +143,84 @@ public:
 	) = 0;
 
 
+	/************************************************
+	 * The stream inference functions.
+	 ***********************************************/
+
+	/**
+	 * Make a new stream state for this layer.
+	 *
+	 * @return PLayerState The stream state.
+	 */
+	virtual PLayerState makeState() const = 0;
+
+	/**
+	 * Make a new stream state which continues from the current activity
+	 * of this layer. The synapses of the modules are shared, only the
+	 * activity is copied.
+	 *
+	 * @return PLayerState The stream state.
+	 */
+	virtual PLayerState forkState() const = 0;
+
+	/**
+	 * Make a new stream state which continues from the stream state.
+	 *
+	 * @param state The stream state of this layer to copy.
+	 * @return PLayerState The stream state.
+	 */
+	virtual PLayerState forkState(const LayerState& state) const = 0;
+
+	/**
+	 * reset the stream state of the layer. The function is assumed to be
+	 * executed at every time step.
+	 *
+	 * @param state The stream state of this layer.
+	 */
+	virtual void restate(LayerState& state) const = 0;
+
+	/**
+	 * Forward the input sdr on the stream without learning.
+	 * The modules of the layer are only read, so the function can be
+	 * called from several threads as long as each thread has its own
+	 * state.
+	 *
+	 * @param inputSDR The input sdr from the lower layer.
+	 * @param state The stream state of this layer.
+	 * @param activeSDR The active SDR for the upper layer. (This param has
+	 * a return value.)
+	 *
+	 * @return The boolean value whether the upper layer should run.
+	 */
+	virtual const bool forward(
+		const htm::SDR& inputSDR,
+		LayerState& state,
+		htm::SDR& activeSDR
+	) const = 0;
+
+	/**
+	 * Backward on the stream without learning.
+	 *
+	 * @param state The stream state of this layer.
+	 *
+	 * @returns The proxy of this layer on the stream.
+	 */
+	virtual const PLayerProxy& backward(LayerState& state) const = 0;
+
+	/**
+	 * Backward on the stream without learning.
+	 *
+	 * @param upperLayer The proxy of the upper layer on the stream.
+	 * @param state The stream state of this layer.
+	 *
+	 * @returns The proxy of this layer on the stream.
+	 */
+	virtual const PLayerProxy& backward(
+		const PLayerProxy& upperLayer,
+		LayerState& state
+	) const = 0;
+
+
 	/************************************************
 	 * The module getters.
 	 ***********************************************/
@@ -14,9 +14,42 @@
 #include "htm/types/Sdr.hpp"
 #include "cla/utils/Status.hpp"
 #include "cla/model/module/helper/LayerProxy.hpp"
+#include "cla/utils/SerializeHelpers.hpp"
 
 namespace cla {
 
+/**
+ * CoreReceiverState implementation in C++.
+ *
+ * @b Description
+ * The CoreReceiverState is the base (interface) class for the per-stream
+ * state of the receivers. It holds what the receiver keeps between steps
+ * for one input stream.
+ */
+class CoreReceiverState {
+
+public:
+
+	/**
+	 * CoreReceiverState destructor.
+	 */
+	virtual ~CoreReceiverState() = default;
+
+	/**
+	 * Reset the state of the stream.
+	 */
+	virtual void reset() = 0;
+
+	/**
+	 * Copy the state of the stream.
+	 *
+	 * @return std::unique_ptr<CoreReceiverState> The copied state.
+	 */
+	virtual std::unique_ptr<CoreReceiverState> clone() const = 0;
+};
+
+using PReceiverState = std::unique_ptr<CoreReceiverState>;
+
 /**
  * CoreReceiver implementation in C++.
  *
@@ -25,7 +58,7 @@ namespace cla {
  * output sdrs for the lower layer. This class is based on the strategy
  * design pattern.
  */
-class CoreReceiver {
+class CoreReceiver : public htm::Serializable {
 
 public:
 
@@ -79,6 +112,40 @@ public:
 		htm::SDR& activeSDR,
 		htm::SDR& winnerSDR
 	) = 0;
+
+	/**
+	 * Make a new stream state for this receiver.
+	 *
+	 * @return PReceiverState The stream state.
+	 */
+	virtual PReceiverState makeState() const = 0;
+
+	/**
+	 * Make a new stream state which continues from what this receiver
+	 * keeps now.
+	 *
+	 * @return PReceiverState The stream state.
+	 */
+	virtual PReceiverState forkState() const = 0;
+
+	/**
+	 * Receive the sdrs from the proxy of the layer on the stream. The
+	 * receiver itself is not modified.
+	 *
+	 * @param upperLayer The proxy of the upper layer. This function receives a kind of sdr
+	 * from this proxy.
+	 * @param state The stream state.
+	 * @param activeSDR The active sdr in this layer to activate the lower
+	 * layer.
+	 * @param winnerSDR The winner sdr in this layer to activate the lower
+	 * layer.
+	 */
+	virtual void receive(
+		const PLayerProxy& upperLayer,
+		CoreReceiverState& state,
+		htm::SDR& activeSDR,
+		htm::SDR& winnerSDR
+	) const = 0;
 };
 
 using PReceiver = std::unique_ptr<CoreReceiver>;
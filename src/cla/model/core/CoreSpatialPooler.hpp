@@ -12,9 +12,43 @@
 
 #include "htm/algorithms/Connections.hpp"
 #include "htm/types/Sdr.hpp"
+#include "cla/utils/SerializeHelpers.hpp"
 
 namespace cla {
 
+/**
+ * CoreSpatialPoolerState implementation in C++.
+ *
+ * @b Description
+ * The CoreSpatialPoolerState is the base (interface) class for the
+ * per-stream state of the spatial poolers. The state holds the buffers of
+ * the inference of one input stream, so several streams can share one
+ * spatial pooler without allocating on each step.
+ */
+class CoreSpatialPoolerState {
+
+public:
+
+	/**
+	 * CoreSpatialPoolerState destructor.
+	 */
+	virtual ~CoreSpatialPoolerState() = default;
+
+	/**
+	 * Reset the state of the stream.
+	 */
+	virtual void reset() = 0;
+
+	/**
+	 * Copy the state of the stream.
+	 *
+	 * @return std::unique_ptr<CoreSpatialPoolerState> The copied state.
+	 */
+	virtual std::unique_ptr<CoreSpatialPoolerState> clone() const = 0;
+};
+
+using PSpatialPoolerState = std::unique_ptr<CoreSpatialPoolerState>;
+
 /**
  * CoreSpatialPooler implementation in C++.
  *
@@ -23,7 +57,7 @@ namespace cla {
  * poolers. This class defines necessary functions for the spatial pooler
  * on the cla layer.
  */
-class CoreSpatialPooler {
+class CoreSpatialPooler : public htm::Serializable {
 
 public:
 
@@ -79,14 +113,38 @@ public:
 		htm::SDR& activeColumns
 	) = 0;
 
+	/**
+	 * Make a new stream state for this spatial pooler.
+	 *
+	 * @return PSpatialPoolerState The stream state.
+	 */
+	virtual PSpatialPoolerState makeState() const = 0;
+
+	/**
+	 * Infer the active columns of the input active bits without learning.
+	 * The column-synapses and the inner state are only read, so the
+	 * function can be called from several threads at once, each with its
+	 * own stream state.
+	 *
+	 * @param activeBits The active bits sdr
+	 * @param state The stream state.
+	 * @param activeColumns The active columns SDR. (This param has a
+	 * return value.)
+	 */
+	virtual void infer(
+		const htm::SDR& activeBits,
+		CoreSpatialPoolerState& state,
+		htm::SDR& activeColumns
+	) const = 0;
+
 	/**
 	 * Map a column to bits. This function collects bits with the connected
 	 * synapses.
 	 *
 	 * @param column The index of the column.
-	 * @return const std::vector<htm::CellIdx> The indexes of bits.
+	 * @return const std::vector<htm::CellIdx>& The indexes of bits.
 	 */
-	virtual const std::vector<htm::CellIdx> bitsForColumn(
+	virtual const std::vector<htm::CellIdx>& bitsForColumn(
 		const htm::CellIdx column
 	) const = 0;
 
@@ -96,6 +154,20 @@ public:
 	 * @return const htm::Connections& the column-synapses.
 	 */
 	virtual const htm::Connections& getConnections() const = 0;
+
+	/**
+	 * Get the number of the input bits of the spatial pooler.
+	 *
+	 * @return const htm::UInt The number of the input bits.
+	 */
+	virtual const htm::UInt getNumInputs() const = 0;
+
+	/**
+	 * Get the number of the columns of the spatial pooler.
+	 *
+	 * @return const htm::UInt The number of the columns.
+	 */
+	virtual const htm::UInt getNumColumns() const = 0;
 };
 
 using PSpatialPooler = std::shared_ptr<CoreSpatialPooler>;
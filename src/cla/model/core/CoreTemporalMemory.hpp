@@ -13,9 +13,58 @@
 #include "htm/algorithms/Connections.hpp"
 #include "cla/extension/algorithms/TemporalMemoryExtension.hpp"
 #include "htm/types/Sdr.hpp"
+#include "cla/utils/SerializeHelpers.hpp"
 
 namespace cla {
 
+/**
+ * CoreTemporalMemoryState implementation in C++.
+ *
+ * @b Description
+ * The CoreTemporalMemoryState is the base (interface) class for the
+ * per-stream state of the temporal memories. The state holds the cell
+ * activity of one input stream, so several streams can share one temporal
+ * memory for inference.
+ */
+class CoreTemporalMemoryState {
+
+public:
+
+	/**
+	 * CoreTemporalMemoryState destructor.
+	 */
+	virtual ~CoreTemporalMemoryState() = default;
+
+	/**
+	 * Reset the sequence state of the stream.
+	 */
+	virtual void reset() = 0;
+
+	/**
+	 * Get the anomaly value of the stream.
+	 *
+	 * @return const htm::Real The anomaly value.
+	 */
+	virtual const htm::Real getAnomaly() const = 0;
+
+	/**
+	 * Renumber the segments of the stream after the connections are
+	 * compacted.
+	 *
+	 * @param remap The renumbering returned by the compaction.
+	 */
+	virtual void remap(const htm::ConnectionsRemap& remap) = 0;
+
+	/**
+	 * Copy the state of the stream.
+	 *
+	 * @return std::unique_ptr<CoreTemporalMemoryState> The copied state.
+	 */
+	virtual std::unique_ptr<CoreTemporalMemoryState> clone() const = 0;
+};
+
+using PTemporalMemoryState = std::unique_ptr<CoreTemporalMemoryState>;
+
 /**
  * CoreTemporalMemory implementation in C++.
  *
@@ -24,7 +73,7 @@ namespace cla {
  * class defines the necessary functions for temporal memory on the cla
  * layer.
  */
-class CoreTemporalMemory {
+class CoreTemporalMemory : public htm::Serializable {
 
 public:
 
@@ -116,6 +165,74 @@ public:
 		htm::SDR_sparse_t& activeSegments
 	) = 0;
 
+	/************************************************
+	 * Stream inference functions.
+	 ***********************************************/
+
+	/**
+	 * Make a new stream state for this temporal memory.
+	 *
+	 * @return PTemporalMemoryState The stream state.
+	 */
+	virtual PTemporalMemoryState makeState() const = 0;
+
+	/**
+	 * Make a new stream state which continues from the current activity
+	 * of this temporal memory. The cell-synapses are shared, only the
+	 * activity is copied.
+	 *
+	 * @return PTemporalMemoryState The stream state.
+	 */
+	virtual PTemporalMemoryState forkState() const = 0;
+
+	/**
+	 * Compute the input active columns on the stream without learning.
+	 * The cell-synapses are only read, so the function can be called from
+	 * several threads as long as each thread has its own state.
+	 *
+	 * @param activeColumns The active column sdr
+	 * @param state The stream state.
+	 * @param activeCells The active cell sdr (This param has a
+	 * return value.)
+	 * @param winnerCells The winner cell sdr (This param has a
+	 * return value.)
+	 */
+	virtual void compute(
+		const htm::SDR& activeColumns,
+		CoreTemporalMemoryState& state,
+		htm::SDR& activeCells,
+		htm::SDR& winnerCells
+	) const = 0;
+
+	/**
+	 * Activate segments on the cells of the stream without learning.
+	 *
+	 * @param state The stream state.
+	 * @param activeSegments The active segment sdr (This param has a
+	 * return value.)
+	 */
+	virtual void activate(
+		CoreTemporalMemoryState& state,
+		htm::SDR_sparse_t& activeSegments
+	) const = 0;
+
+	/**
+	 * Activate segments on the cells of the stream without learning,
+	 * including the external active sdr and the external winner sdr.
+	 *
+	 * @param externalActiveSDR The external active sdr.
+	 * @param externalWinnerSDR The external winner sdr.
+	 * @param state The stream state.
+	 * @param activeSegments The active segment sdr (This param has a
+	 * return value.)
+	 */
+	virtual void activate(
+		const htm::SDR& externalActiveSDR,
+		const htm::SDR& externalWinnerSDR,
+		CoreTemporalMemoryState& state,
+		htm::SDR_sparse_t& activeSegments
+	) const = 0;
+
 	/**
 	 * Map a segment to a cell.
 	 *
@@ -146,6 +263,31 @@ public:
 	 */
 	virtual const htm::TMConnectionsHandler& getConnectionHandler() const = 0;
 
+	/**
+	 * Set the connections events that the connection handler records.
+	 * Nothing is recorded by default.
+	 *
+	 * @param events The event classes to record.
+	 */
+	virtual void setRecordedEvents(const htm::ConnectionsEvents events) = 0;
+
+	/**
+	 * Get the connections events that the connection handler records.
+	 *
+	 * @return const htm::ConnectionsEvents The event classes to record.
+	 */
+	virtual const htm::ConnectionsEvents getRecordedEvents() const = 0;
+
+	/**
+	 * Compact the cell-synapses. The slots of the destroyed segments and
+	 * synapses are removed, and the segments are renumbered. See
+	 * htm::Connections::compact.
+	 *
+	 * @return const htm::ConnectionsRemap The renumbering of the segments
+	 * and the synapses.
+	 */
+	virtual const htm::ConnectionsRemap compact() = 0;
+
 	/**
 	 * Get the anomaly value.
 	 * 
@@ -17,6 +17,8 @@
 // #include "cla/model/module/callback/SaveNumSynsCallback.hpp"
 // #include "cla/model/module/callback/SaveActiveSegmentsCallback.hpp"
 #include "cla/model/module/callback/CompositeCallback.hpp"
+#include "cla/model/module/callback/AsyncCallback.hpp"
+#include "cla/model/module/callback/CheckpointCallback.hpp"
 
 namespace cla {
 
@@ -58,6 +60,31 @@ struct CallbackGenerator<CompositeCallback> {
 	}
 };
 
+template<>
+struct CallbackGenerator<AsyncCallback> {
+
+	/**
+	 * Generate the Callback module instance.
+	 *
+	 * @param callbacks The callbacks to run on the background thread.
+	 * @param capacity The number of the snapshots held in the queue.
+	 * @param policy The behavior when the queue is full.
+	 * @param sampleInterval The interval of the captured steps for the
+	 * SAMPLE policy.
+	 * @return PCallback The pointer of the Callback module.
+	 */
+	static PCallback generate(
+		const std::vector<PCallback>& callbacks,
+		const std::size_t capacity,
+		const BackpressurePolicy policy = BackpressurePolicy::BLOCK,
+		const Step sampleInterval = 1u
+	) {
+		return std::make_shared<AsyncCallback>(
+			callbacks, capacity, policy, sampleInterval
+		);
+	}
+};
+
 } // namespace cla
 
 #endif // CALLBACK_GENERATOR_HPP
\ No newline at end of file
@@ -0,0 +1,220 @@
+// AsyncCallback.cpp
+
+/**
+ * @file
+ * Implementation of AsyncCallback.cpp
+ */
+
+#include <chrono>
+#include <future>
+
+#include "cla/model/module/callback/AsyncCallback.hpp"
+#include "cla/utils/Checker.hpp"
+
+namespace cla {
+
+/************************************************
+ * AsyncCallback helper functions.
+ ***********************************************/
+
+namespace {
+
+/**
+ * Wait a moment while the queue is empty or full. It yields first, and
+ * sleeps after some tries not to burn the core.
+ *
+ * @param nbTries The number of the tries.
+ */
+void backoff(const std::size_t nbTries) {
+	if(nbTries < 64u)
+		std::this_thread::yield();
+	else
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+} // namespace for inner linker.
+
+
+/************************************************
+ * AsyncCallback private functions.
+ ***********************************************/
+
+void AsyncCallback::run_(const CoreCLA* cla) {
+	std::size_t nbTries = 0u;
+
+	while(true) {
+		const StepSnapshot* snapshot = queue_->front();
+
+		if(snapshot) {
+			// After a failure the snapshots are only released, so the
+			// compute thread waiting for a free slot is not blocked.
+			if(!error_) {
+				try {
+					for(auto&& callback : callbacks_)
+						callback->doSnapshotProcessing(*snapshot);
+				} catch(...) {
+					error_ = std::current_exception();
+					failed_.store(true, std::memory_order_relaxed);
+				}
+			}
+
+			queue_->pop();
+			nbTries = 0u;
+			continue;
+		}
+
+		// The stop is set after the last push, so the queue is drained
+		// if it is empty after the stop is seen.
+		if(stop_.load(std::memory_order_acquire)) {
+			if(!queue_->front()) break;
+			continue;
+		}
+
+		backoff(nbTries++);
+	}
+
+	// The end is called even after a failure, so the callbacks can
+	// close their files.
+	try {
+		for(auto&& callback : callbacks_)
+			callback->doEndProcessing(cla);
+	} catch(...) {
+		if(!error_) error_ = std::current_exception();
+	}
+}
+
+
+/************************************************
+ * AsyncCallback public functions.
+ ***********************************************/
+
+AsyncCallback::AsyncCallback(
+	const std::vector<PCallback>& callbacks,
+	const std::size_t capacity,
+	const BackpressurePolicy policy,
+	const Step sampleInterval
+) {
+	initialize(callbacks, capacity, policy, sampleInterval);
+}
+
+AsyncCallback::~AsyncCallback() {
+	if(worker_.joinable()) {
+		stop_.store(true, std::memory_order_release);
+		worker_.join();
+	}
+}
+
+void AsyncCallback::initialize(
+	const std::vector<PCallback>& callbacks,
+	const std::size_t capacity,
+	const BackpressurePolicy policy,
+	const Step sampleInterval
+) {
+	CLA_ASSERT(!worker_.joinable());
+	CLA_ASSERT(capacity > 0u);
+	CLA_ASSERT(sampleInterval > 0u);
+
+	callbacks_.clear();
+	fields_ = SnapshotField::NONE;
+
+	for(const auto& callback : callbacks) {
+		const auto snapshotCallback
+			= std::dynamic_pointer_cast<SnapshotCallback>(callback);
+
+		CLA_CHECK(
+			snapshotCallback,
+			"The AsyncCallback only runs the SnapshotCallbacks."
+		);
+
+		callbacks_.emplace_back(snapshotCallback);
+		fields_ |= snapshotCallback->getSnapshotFields();
+	}
+
+	policy_ = policy;
+	sampleInterval_ = sampleInterval;
+
+	queue_ = std::make_unique<SpscQueue<StepSnapshot>>(capacity);
+	stop_.store(false, std::memory_order_relaxed);
+	nbDropped_.store(0u, std::memory_order_relaxed);
+	failed_.store(false, std::memory_order_relaxed);
+	error_ = nullptr;
+}
+
+void AsyncCallback::doStartProcessing(const CoreCLA* cla) {
+	CLA_ASSERT(queue_);
+	CLA_ASSERT(!worker_.joinable());
+
+	stop_.store(false, std::memory_order_relaxed);
+	nbDropped_.store(0u, std::memory_order_relaxed);
+	failed_.store(false, std::memory_order_relaxed);
+	error_ = nullptr;
+
+	std::promise<void> started;
+	auto startedFuture = started.get_future();
+
+	worker_ = std::thread([this, cla, started = std::move(started)]() mutable {
+		try {
+			for(auto&& callback : callbacks_)
+				callback->doStartProcessing(cla);
+		} catch(...) {
+			started.set_exception(std::current_exception());
+			return;
+		}
+
+		started.set_value();
+		run_(cla);
+	});
+
+	// The callbacks read the model in the start, so wait for them.
+	try {
+		startedFuture.get();
+	} catch(...) {
+		worker_.join();
+		throw;
+	}
+}
+
+void AsyncCallback::doPostProcessing(
+	const Step step,
+	const Values& inputs,
+	const Values& nexts,
+	const Values& outputs,
+	const CoreCLA* cla
+) {
+	if(policy_ == BackpressurePolicy::SAMPLE && step % sampleInterval_ != 0u)
+		return;
+
+	// The snapshots are not processed after a failure of the callbacks.
+	if(failed_.load(std::memory_order_relaxed)) return;
+
+	StepSnapshot* snapshot = queue_->back();
+
+	for(std::size_t nbTries = 0u; !snapshot; ++nbTries) {
+		if(policy_ != BackpressurePolicy::BLOCK) {
+			nbDropped_.fetch_add(1u, std::memory_order_relaxed);
+			return;
+		}
+
+		backoff(nbTries);
+		snapshot = queue_->back();
+	}
+
+	snapshot->capture(step, inputs, nexts, outputs, cla, fields_);
+	queue_->push();
+}
+
+void AsyncCallback::doEndProcessing(const CoreCLA* cla) {
+	if(!worker_.joinable()) return;
+
+	stop_.store(true, std::memory_order_release);
+	worker_.join();
+
+	if(error_) {
+		const std::exception_ptr error = error_;
+		error_ = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+
+} // namespace cla
@@ -0,0 +1,185 @@
+// AsyncCallback.hpp
+
+/**
+ * @file
+ * Definitions for the AsyncCallback class in C++
+ */
+
+#ifndef ASYNC_CALLBACK_HPP
+#define ASYNC_CALLBACK_HPP
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "cla/model/core/CoreCallback.hpp"
+#include "cla/model/module/callback/SnapshotCallback.hpp"
+#include "cla/model/module/helper/StepSnapshot.hpp"
+#include "cla/utils/SpscQueue.hpp"
+
+namespace cla {
+
+/**
+ * BackpressurePolicy definitions in C++.
+ *
+ * @b Description
+ * The BackpressurePolicy defines the behavior of the AsyncCallback when
+ * the queue of the snapshots is full.
+ *
+ * BLOCK: The compute thread waits for a free slot. No step is lost.
+ * DROP: The snapshot of the step is dropped.
+ * SAMPLE: Only one in the sample interval steps is captured, and the
+ * snapshot is dropped if the queue is full.
+ */
+enum class BackpressurePolicy {
+	BLOCK,
+	DROP,
+	SAMPLE
+};
+
+
+/**
+ * AsyncCallback implementation in C++.
+ *
+ * @b Description
+ * AsyncCallback is one of the Callback-series. This class runs the
+ * SnapshotCallbacks on a background thread. The compute thread only
+ * captures the StepSnapshot of a step into a bounded lock-free queue,
+ * and the background thread passes the snapshots to the callbacks. So
+ * the compute thread never waits for the file io of the callbacks.
+ *
+ * The start and the end of the callbacks are also run on the background
+ * thread, while the compute thread waits for them.
+ *
+ * An exception thrown by a callback on the background thread stops the
+ * callbacks, and it is rethrown on the compute thread by the start or
+ * the end of the processing.
+ */
+class AsyncCallback : public CoreCallback {
+
+private:
+
+	std::vector<PSnapshotCallback> callbacks_;
+	SnapshotFields fields_;
+
+	BackpressurePolicy policy_;
+	Step sampleInterval_;
+
+	std::unique_ptr<SpscQueue<StepSnapshot>> queue_;
+	std::thread worker_;
+	std::atomic<bool> stop_;
+	std::atomic<std::size_t> nbDropped_;
+
+	// The first exception of the callbacks. It is written only by the
+	// background thread and read after the join.
+	std::exception_ptr error_;
+	std::atomic<bool> failed_;
+
+private:
+
+	/**
+	 * The loop of the background thread.
+	 *
+	 * @param cla A kind of cla agents. It needs to get the internal
+	 * data of cla. (ex: cla->getUnits();)
+	 */
+	void run_(const CoreCLA* cla);
+
+public:
+
+	/**
+	 * AsyncCallback constructor.
+	 */
+	AsyncCallback() = default;
+
+	/**
+	 * AsyncCallback constructor with the parameters.
+	 *
+	 * @param callbacks The callbacks to run on the background thread.
+	 * They must be SnapshotCallbacks.
+	 * @param capacity The number of the snapshots held in the queue.
+	 * @param policy The behavior when the queue is full.
+	 * @param sampleInterval The interval of the captured steps for the
+	 * SAMPLE policy.
+	 */
+	AsyncCallback(
+		const std::vector<PCallback>& callbacks,
+		const std::size_t capacity,
+		const BackpressurePolicy policy = BackpressurePolicy::BLOCK,
+		const Step sampleInterval = 1u
+	);
+
+	/**
+	 * AsyncCallback destructor.
+	 */
+	~AsyncCallback();
+
+	/**
+	 * Initialize AsyncCallback with the parameters.
+	 *
+	 * @param callbacks The callbacks to run on the background thread.
+	 * They must be SnapshotCallbacks.
+	 * @param capacity The number of the snapshots held in the queue.
+	 * @param policy The behavior when the queue is full.
+	 * @param sampleInterval The interval of the captured steps for the
+	 * SAMPLE policy.
+	 */
+	void initialize(
+		const std::vector<PCallback>& callbacks,
+		const std::size_t capacity,
+		const BackpressurePolicy policy = BackpressurePolicy::BLOCK,
+		const Step sampleInterval = 1u
+	);
+
+	/**
+	 * Called the start of the processing.
+	 *
+	 * @param cla A kind of cla agents. It needs to get the internal
+	 * data of cla. (ex: cla->getUnits();)
+	 */
+	void doStartProcessing(const CoreCLA* cla) override;
+
+	/**
+	 * Called after beginning processing of a step.
+	 *
+	 * @param step The step this function called.
+	 * @param inputs The input values from an environment in the step.
+	 * @param nexts The input values form the environemnt in the next step.
+	 * @param outputs The output values of CLA in the step.
+	 * @param cla A kind of cla agents. It needs to get the internal
+	 * data of cla. (ex: cla->getUnits();)
+	 */
+	void doPostProcessing(
+		const Step step,
+		const Values& inputs,
+		const Values& nexts,
+		const Values& outputs,
+		const CoreCLA* cla
+	) override;
+
+	/**
+	 * Called the end of the processing. It waits for the background
+	 * thread, and rethrows the exception of the callbacks if any.
+	 *
+	 * @param cla A kind of cla agents. It needs to get the internal
+	 * data of cla. (ex: cla->getUnits();)
+	 */
+	void doEndProcessing(const CoreCLA* cla) override;
+
+	/**
+	 * Get the number of the snapshots dropped because the queue was full.
+	 *
+	 * @return const std::size_t The number of the dropped snapshots.
+	 */
+	const std::size_t getNbDropped() const {
+		return nbDropped_.load(std::memory_order_relaxed);
+	}
+
+};
+
+
+} // namespace cla
+
+#endif // ASYNC_CALLBACK_HPP
@@ -0,0 +1,333 @@
+// CheckpointCallback.cpp
+
+/**
+ * @file
+ * Implementation of CheckpointCallback.cpp
+ */
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "cla/model/module/callback/CheckpointCallback.hpp"
+#include "cla/utils/Checker.hpp"
+
+#include "cla/environment/DataSource.hpp" // for cross-referencing
+#include "cla/model/core/CoreCLA.hpp" // for cross-referencing
+
+namespace cla {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string generationPrefix = "checkpoint_";
+
+struct WalHeader {
+	char magic[8];
+	htm::UInt32 version;
+	htm::UInt32 learn;
+	htm::UInt64 baseStep;
+};
+
+struct RecordHeader {
+	htm::UInt64 step;
+	htm::UInt32 nbValues;
+	htm::UInt32 reserved;
+};
+
+// FNV-1a, to find the torn record at the end of the log.
+htm::UInt32 checksum(const char* data, const std::size_t size) {
+	htm::UInt32 hash = 2166136261u;
+	for(std::size_t i = 0u; i < size; ++i) {
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// Get the step of the generation from the name of the snapshot file.
+bool parseGeneration(const fs::path& file, Step& step) {
+	const std::string stem = file.stem().string();
+
+	if(file.extension() != ".bin" || stem.rfind(generationPrefix, 0u) != 0u)
+		return false;
+
+	const std::string digits = stem.substr(generationPrefix.size());
+	if(digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+
+	step = std::stoull(digits);
+	return true;
+}
+
+template<typename T>
+void append(std::vector<char>& buffer, const T* values, const std::size_t count) {
+	const char* bytes = reinterpret_cast<const char*>(values);
+	buffer.insert(buffer.end(), bytes, bytes + count * sizeof(T));
+}
+
+} // namespace
+
+
+/************************************************
+ * CheckpointCallback private functions.
+ ***********************************************/
+
+std::string CheckpointCallback::generationFile_(
+	const std::string& path,
+	const Step step,
+	const std::string& extension
+) {
+	return (fs::path(path) / (generationPrefix + std::to_string(step) + extension)).string();
+}
+
+const bool CheckpointCallback::findGeneration_(const std::string& path, Step& step) {
+	bool found = false;
+	Step generation;
+
+	for(const auto& entry : fs::directory_iterator(path)) {
+		if(!parseGeneration(entry.path(), generation))
+			continue;
+
+		if(!found || generation > step) {
+			step = generation;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+void CheckpointCallback::removeGenerations_(const std::string& path, const Step kept) {
+	std::vector<Step> generations;
+	Step generation;
+
+	for(const auto& entry : fs::directory_iterator(path)) {
+		if(parseGeneration(entry.path(), generation) && generation != kept)
+			generations.push_back(generation);
+	}
+
+	for(const Step step : generations) {
+		fs::remove(generationFile_(path, step, ".bin"));
+		fs::remove(generationFile_(path, step, ".wal"));
+	}
+}
+
+
+/************************************************
+ * CheckpointCallback public functions.
+ ***********************************************/
+
+CheckpointCallback::CheckpointCallback(
+	const std::string& path,
+	const Step snapshotInterval,
+	const bool learn,
+	const Step firstStep
+) {
+	initialize(path, snapshotInterval, learn, firstStep);
+}
+
+void CheckpointCallback::initialize(
+	const std::string& path,
+	const Step snapshotInterval,
+	const bool learn,
+	const Step firstStep
+) {
+	CLA_ASSERT(!path.empty());
+	CLA_ASSERT(snapshotInterval > 0u);
+
+	path_ = path;
+	snapshotInterval_ = snapshotInterval;
+	learn_ = learn;
+	firstStep_ = firstStep;
+
+	reset();
+}
+
+const bool CheckpointCallback::hasCheckpoint(const std::string& path) {
+	Step step;
+	return fs::is_directory(path) && findGeneration_(path, step);
+}
+
+const Step CheckpointCallback::recover(CoreCLA& cla, const std::string& path) {
+	Step baseStep = 0u;
+	CLA_CHECK(
+		fs::exists(path) && findGeneration_(path, baseStep),
+		"Error: Cannot find a checkpoint in: " << path
+	);
+
+	cla.load(generationFile_(path, baseStep, ".bin"));
+
+	// The log is created after the snapshot, so a crash in between leaves
+	// the snapshot alone.
+	std::ifstream wal(generationFile_(path, baseStep, ".wal"), std::ios_base::binary);
+	if(!wal) return baseStep;
+
+	WalHeader header;
+	if(!wal.read(reinterpret_cast<char*>(&header), sizeof(WalHeader)))
+		return baseStep;
+
+	CLA_CHECK(
+		std::strncmp(header.magic, _walMagic.c_str(), sizeof(header.magic)) == 0
+		&& header.version == _walVersion
+		&& header.baseStep == baseStep,
+		"Error: The write-ahead log does not match the snapshot: " << path
+	);
+
+	const bool learn = header.learn != 0u;
+	Step step = baseStep;
+
+	RecordHeader record;
+	Values inputs, nexts;
+	htm::UInt32 expected;
+
+	while(wal.read(reinterpret_cast<char*>(&record), sizeof(RecordHeader))) {
+		inputs.resize(record.nbValues);
+		nexts.resize(record.nbValues);
+
+		const auto bytes = static_cast<std::streamsize>(record.nbValues * sizeof(Value));
+		if(!wal.read(reinterpret_cast<char*>(inputs.data()), bytes)
+			|| !wal.read(reinterpret_cast<char*>(nexts.data()), bytes)
+			|| !wal.read(reinterpret_cast<char*>(&expected), sizeof(expected)))
+			break;
+
+		std::vector<char> buffer;
+		append(buffer, &record, 1u);
+		append(buffer, inputs.data(), inputs.size());
+		append(buffer, nexts.data(), nexts.size());
+
+		if(checksum(buffer.data(), buffer.size()) != expected || record.step != step)
+			break;
+
+		cla.feedforward(inputs, learn);
+		cla.feedback(nexts, learn);
+		++step;
+	}
+
+	return step;
+}
+
+const Step CheckpointCallback::resume(
+	CoreCLA& cla,
+	const std::string& path,
+	DataSource& source
+) {
+	if(!hasCheckpoint(path)) return 0u;
+
+	const Step firstStep = recover(cla, path);
+	CLA_CHECK_THROW(
+		source.skip(firstStep) == firstStep,
+		"Error: The source ends before the checkpoint at step " << firstStep
+			<< " in: " << path
+	)
+
+	return firstStep;
+}
+
+void CheckpointCallback::reset() {
+	cla_ = nullptr;
+	baseStep_ = firstStep_;
+	nbSteps_ = firstStep_;
+	close();
+}
+
+void CheckpointCallback::open() {
+	close();
+
+	wal_.open(generationFile_(path_, baseStep_, ".wal"));
+
+	WalHeader header = {};
+	std::strncpy(header.magic, _walMagic.c_str(), sizeof(header.magic) - 1u);
+	header.version = _walVersion;
+	header.learn = learn_ ? 1u : 0u;
+	header.baseStep = baseStep_;
+
+	wal_.write(&header, sizeof(WalHeader));
+	wal_.sync();
+}
+
+void CheckpointCallback::save() {
+	CLA_ASSERT(cla_);
+
+	const Step previous = baseStep_;
+	baseStep_ = nbSteps_;
+
+	// A log left by an earlier processing at the same step must not be
+	// replayed onto the new snapshot.
+	const std::string snapshot = generationFile_(path_, baseStep_, ".bin");
+	cla_->save(snapshot + ".tmp");
+	SyncedFile::syncPath(snapshot + ".tmp");
+	fs::remove(generationFile_(path_, baseStep_, ".wal"));
+	fs::rename(snapshot + ".tmp", snapshot);
+
+	open();
+
+	// The rename and the new log reach the disk before the previous
+	// generation is removed.
+	SyncedFile::syncPath(path_);
+
+	if(previous != baseStep_) {
+		fs::remove(generationFile_(path_, previous, ".bin"));
+		fs::remove(generationFile_(path_, previous, ".wal"));
+	}
+}
+
+void CheckpointCallback::close() {
+	wal_.close();
+}
+
+void CheckpointCallback::doStartProcessing(const CoreCLA* cla) {
+	reset();
+	createDir_(path_);
+	cla_ = cla;
+
+	// The checkpoint of an earlier processing is replaced only after the
+	// first generation of this processing is written.
+	save();
+	removeGenerations_(path_, baseStep_);
+}
+
+void CheckpointCallback::doPreProcessing(
+	const Step step,
+	const Values& inputs,
+	const CoreCLA* cla
+) {
+	if(nbSteps_ - baseStep_ >= snapshotInterval_)
+		save();
+}
+
+void CheckpointCallback::doPostProcessing(
+	const Step step,
+	const Values& inputs,
+	const Values& nexts,
+	const Values& outputs,
+	const CoreCLA* cla
+) {
+	CLA_ASSERT(inputs.size() == nexts.size());
+
+	RecordHeader record = {};
+	record.step = nbSteps_;
+	record.nbValues = static_cast<htm::UInt32>(inputs.size());
+
+	std::vector<char> buffer;
+	append(buffer, &record, 1u);
+	append(buffer, inputs.data(), inputs.size());
+	append(buffer, nexts.data(), nexts.size());
+
+	const htm::UInt32 sum = checksum(buffer.data(), buffer.size());
+	append(buffer, &sum, 1u);
+
+	wal_.write(buffer.data(), buffer.size());
+	wal_.sync();
+
+	++nbSteps_;
+}
+
+void CheckpointCallback::doEndProcessing(const CoreCLA* cla) {
+	close();
+}
+
+
+} // namespace cla
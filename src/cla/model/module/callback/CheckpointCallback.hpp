@@ -0,0 +1,246 @@
+// CheckpointCallback.hpp
+
+/**
+ * @file
+ * Definitions for the CheckpointCallback class in C++
+ */
+
+#ifndef CHECKPOINT_CALLBACK_HPP
+#define CHECKPOINT_CALLBACK_HPP
+
+#include <string>
+
+#include "cla/model/core/CoreCallback.hpp"
+#include "cla/model/module/callback/SaveCallback.hpp"
+#include "cla/utils/SyncedFile.hpp"
+
+namespace cla {
+
+class DataSource; // for cross-referencing.
+
+/**
+ * CheckpointCallback implementation in C++.
+ *
+ * @b Description
+ * CheckpointCallback is one of the Callback-series. This class keeps a
+ * crash-safe checkpoint of the model in a directory: a full snapshot
+ * every snapshotInterval steps, and a write-ahead log which appends the
+ * values of each step since the snapshot. A step record is written and
+ * synced to the disk before the model learns the feedback of the step,
+ * so a logged step survives a crash of the machine; the sync bounds the
+ * step rate by the latency of the disk.
+ *
+ * The model is deterministic for the same values, so recover loads the
+ * last snapshot and replays the logged steps, which gives the same model
+ * as the live one. The record of a step is a few values, so the log can
+ * be written every step while the snapshot is written rarely.
+ *
+ * The steps are counted from the first step of the processing, which is
+ * zero unless the processing resumes a recovered model. Each generation
+ * of the checkpoint is the pair of the files checkpoint_<step>.bin and
+ * checkpoint_<step>.wal. The snapshot is renamed into place only after it
+ * is synced, and the older generations are removed only after the
+ * directory with the new one is synced. The log ends at the last
+ * complete record, so a torn write of the last record is ignored.
+ */
+class CheckpointCallback : public CoreCallback, public CoreSaver {
+
+private:
+
+	inline static const std::string _walMagic = "CLA-WAL";
+	inline static const htm::UInt32 _walVersion = 1u;
+
+	std::string path_;
+	Step snapshotInterval_;
+	bool learn_;
+	Step firstStep_;
+
+	const CoreCLA* cla_;
+	Step baseStep_;
+	Step nbSteps_;
+	SyncedFile wal_;
+
+private:
+
+	/**
+	 * Get the path of a file of the generation.
+	 *
+	 * @param path The directory of the checkpoint.
+	 * @param step The first step of the generation.
+	 * @param extension The extension of the file.
+	 */
+	static std::string generationFile_(
+		const std::string& path,
+		const Step step,
+		const std::string& extension
+	);
+
+	/**
+	 * Find the last complete generation in the directory.
+	 *
+	 * @param path The directory of the checkpoint.
+	 * @param step The first step of the generation. (This param has a
+	 * return value.)
+	 * @return const bool Whether a generation is found.
+	 */
+	static const bool findGeneration_(const std::string& path, Step& step);
+
+	/**
+	 * Remove the generations in the directory except the kept one.
+	 *
+	 * @param path The directory of the checkpoint.
+	 * @param kept The first step of the kept generation.
+	 */
+	static void removeGenerations_(const std::string& path, const Step kept);
+
+public:
+
+	/**
+	 * CheckpointCallback constructor.
+	 */
+	CheckpointCallback() = default;
+
+	/**
+	 * CheckpointCallback constructor with the parameters.
+	 *
+	 * @param path The directory where the checkpoint is kept.
+	 * @param snapshotInterval The number of the steps between the full
+	 * snapshots.
+	 * @param learn The boolean value whether the steps are learned. It is
+	 * used when the steps are replayed, so it must be the mode of the fit
+	 * or test which runs the callback.
+	 * @param firstStep The step number of the first step of the
+	 * processing. A processing which resumes a recovered model passes the
+	 * step returned by recover, so the steps are counted through.
+	 */
+	CheckpointCallback(
+		const std::string& path,
+		const Step snapshotInterval,
+		const bool learn = true,
+		const Step firstStep = 0u
+	);
+
+	/**
+	 * CheckpointCallback destructor.
+	 */
+	~CheckpointCallback() = default;
+
+	/**
+	 * Initialize the CheckpointCallback with the parameters.
+	 * For more details of the parameters, see the description of the
+	 * constructor.
+	 */
+	void initialize(
+		const std::string& path,
+		const Step snapshotInterval,
+		const bool learn = true,
+		const Step firstStep = 0u
+	);
+
+	/**
+	 * Check whether the directory has a checkpoint.
+	 *
+	 * @param path The directory where the checkpoint is kept.
+	 * @return const bool Whether a checkpoint is found.
+	 */
+	static const bool hasCheckpoint(const std::string& path);
+
+	/**
+	 * Restore the model from the checkpoint in the directory. The model
+	 * must be built with the same configuration as the checkpointed one.
+	 *
+	 * @param cla The cla model to restore.
+	 * @param path The directory where the checkpoint is kept.
+	 * @return const Step The number of the steps of the restored model
+	 * since the start of the first processing, which is the step to run
+	 * next.
+	 */
+	static const Step recover(CoreCLA& cla, const std::string& path);
+
+	/**
+	 * Resume the processing of a source from the checkpoint in the
+	 * directory. When the directory has a checkpoint, the model is
+	 * recovered and the steps of the source which the recovered model
+	 * already processed are skipped, so the next values of the source are
+	 * the values of the returned step. Without a checkpoint nothing is
+	 * done. A source which ends before the checkpoint throws
+	 * std::runtime_error.
+	 *
+	 * @param cla The cla model to restore.
+	 * @param path The directory where the checkpoint is kept.
+	 * @param source The source of the processing from its first step.
+	 * @return const Step The step to run next, zero without a checkpoint.
+	 */
+	static const Step resume(CoreCLA& cla, const std::string& path, DataSource& source);
+
+	/**
+	 * Reset the CheckpointCallback.
+	 */
+	void reset() override;
+
+	/**
+	 * Open the write-ahead log of the current generation.
+	 */
+	void open() override;
+
+	/**
+	 * Write the snapshot of the model and start a new generation.
+	 */
+	void save() override;
+
+	/**
+	 * Close the write-ahead log.
+	 */
+	void close() override;
+
+	/**
+	 * Called the start of the processing. The first snapshot is written.
+	 *
+	 * @param cla A kind of cla agents.
+	 */
+	void doStartProcessing(const CoreCLA* cla) override;
+
+	/**
+	 * Called before beginning processing of a step. The snapshot is
+	 * written every snapshotInterval steps.
+	 *
+	 * @param step The step this function called.
+	 * @param inputs The input values from an environment in the step.
+	 * @param cla A kind of cla agents.
+	 */
+	void doPreProcessing(
+		const Step step,
+		const Values& inputs,
+		const CoreCLA* cla
+	) override;
+
+	/**
+	 * Called after beginning processing of a step. The values of the step
+	 * are appended to the write-ahead log before the feedback.
+	 *
+	 * @param step The step this function called.
+	 * @param inputs The input values from an environment in the step.
+	 * @param nexts The input values form the environemnt in the next step.
+	 * @param outputs The output values of CLA in the step.
+	 * @param cla A kind of cla agents.
+	 */
+	void doPostProcessing(
+		const Step step,
+		const Values& inputs,
+		const Values& nexts,
+		const Values& outputs,
+		const CoreCLA* cla
+	) override;
+
+	/**
+	 * Called the end of the processing.
+	 *
+	 * @param cla A kind of cla agents.
+	 */
+	void doEndProcessing(const CoreCLA* cla) override;
+};
+
+
+} // namespace cla
+
+#endif // CHECKPOINT_CALLBACK_HPP
@@ -53,20 +53,15 @@ void SaveCallback::initialize(
 }
 
 void SaveCallback::doStartProcessing(const CoreCLA* cla) {
+	SnapshotCallback::doStartProcessing(cla);
 	reset();
 	open();
 }
 
-void SaveCallback::doPostProcessing(
-	const Step step,
-	const Values& inputs,
-	const Values& nexts,
-	const Values& outputs,
-	const CoreCLA* cla
-) {
-	add(step, inputs, nexts, outputs, cla);
+void SaveCallback::doSnapshotProcessing(const StepSnapshot& snapshot) {
+	add(snapshot);
 
-	if((step + 1u) % nbHoldingSteps_ == 0u)
+	if((snapshot.step + 1u) % nbHoldingSteps_ == 0u)
 		save();
 }
 
@@ -10,7 +10,7 @@
 
 #include <string>
 
-#include "cla/model/core/CoreCallback.hpp"
+#include "cla/model/module/callback/SnapshotCallback.hpp"
 
 namespace cla {
 
@@ -74,9 +74,11 @@ public:
  * @b Description
  * SaveCallback is one of the Callback-series. This class is an abstract 
  * class that can be used to define a Callback that saves CLA information.
+ * The data is added from the StepSnapshot, so the saving can be moved to
+ * the background thread by the AsyncCallback.
  */
 class SaveCallback : 
-	public CoreCallback,
+	public SnapshotCallback,
 	public CoreSaver
 {
 
@@ -131,20 +133,9 @@ public:
 	/**
 	 * Add the data to container.
 	 * 
-	 * @param step The step this function called.
-	 * @param inputs The input values from an environment in the step.
-	 * @param nexts The input values form the environemnt in the next step.
-	 * @param outputs The output values of CLA in the step.
-	 * @param cla A kind of cla agents. It needs to get the internal
-	 * data of cla. (ex: cla->getUnits();)
+	 * @param snapshot The snapshot of the step.
 	 */
-	virtual void add(
-		const Step step,
-		const Values& inputs,
-		const Values& nexts,
-		const Values& outputs,
-		const CoreCLA* cla
-	) = 0;
+	virtual void add(const StepSnapshot& snapshot) = 0;
 
 	/**
 	 * Called the start of the processing.
@@ -169,22 +160,11 @@ public:
 	) override {}
 
 	/**
-	 * Called after beginning processing of a step.
+	 * Called with the snapshot of a step after processing of the step.
 	 * 
-	 * @param step The step this function called.
-	 * @param inputs The input values from an environment in the step.
-	 * @param nexts The input values form the environemnt in the next step.
-	 * @param outputs The output values of CLA in the step.
-	 * @param cla A kind of cla agents. It needs to get the internal
-	 * data of cla. (ex: cla->getUnits();)
+	 * @param snapshot The snapshot of the step.
 	 */
-	void doPostProcessing(
-		const Step step,
-		const Values& inputs,
-		const Values& nexts,
-		const Values& outputs,
-		const CoreCLA* cla
-	) override;
+	void doSnapshotProcessing(const StepSnapshot& snapshot) override;
 
 	/**
 	 * Called the end of the processing.
@@ -77,7 +77,7 @@ ActiveSegDataHistory::ActiveSegDataHistory(
 
 	for(const htm::Segment activeSegment : activeSegments) {
 		if(relations.count(activeSegment)) {
-			const auto& cells = relations.at(activeSegment);
+			const auto cells = relations.at(activeSegment);
 
 			const htm::UInt numSynsFromInner
 				= static_cast<htm::UInt>(
@@ -109,7 +109,7 @@ ActiveSegDataHistory::ActiveSegDataHistory(
 
 	for(const htm::Segment activeSegment : activeSegments) {
 		if(relations.count(activeSegment)) {
-			const auto& cells = relations.at(activeSegment);
+			const auto cells = relations.at(activeSegment);
 		
 			activeSegs.emplace_back(ActiveSegData(
 				activeSegment, connections.cellForSegment(activeSegment),
@@ -121,21 +121,17 @@ void SaveLayerLog::open() {
 
 void SaveLayerLog::add(
 	const Step step,
-	const PLayerProxy& layer
+	const LayerSnapshot& layer
 ) {
-	const auto& pcells = layer->getPredictiveCells();
-	const auto& pcolumns = layer->getPredictiveColumnsWithNbPCells();
-	const auto& bcolumns = layer->getBurstColumns();
-
 	hists_.emplace_back(LayerHistory(
-		step, pcells.getSparse().size(),
-		pcolumns.getSparse().size(),
-		pcolumns.getExDataMean(),
-		bcolumns.getSparse().size(),
-		layer->getTmAnomaly(), 
-		layer->getNbTmSynapses(),
-		layer->getNbTmSegments(),
-		layer->getStatus()
+		step, layer.predictiveCells.size(),
+		layer.predictiveColumns.size(),
+		layer.getMeanNbPredictiveCells(),
+		layer.burstColumns.size(),
+		layer.anomaly,
+		layer.nbSynapses,
+		layer.nbSegments,
+		layer.status
 	));
 }
 
@@ -177,17 +173,11 @@ void SaveLayerLogCallback::open() {
 	for(auto&& log : logs_) log.open();
 }
 
-void SaveLayerLogCallback::add(
-	const Step step,
-	const Values& inputs,
-	const Values& nexts,
-	const Values& outputs,
-	const CoreCLA* cla
-) {
-	const auto& layers = cla->getLayers();
+void SaveLayerLogCallback::add(const StepSnapshot& snapshot) {
+	const auto& layers = snapshot.layers;
 
 	for(std::size_t i = 0u, size = layers.size(); i < size; ++i) {
-		logs_.at(i).add(step, layers.at(i));
+		logs_.at(i).add(snapshot.step, layers.at(i));
 	}
 }
 
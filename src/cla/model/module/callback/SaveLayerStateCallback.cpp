@@ -201,21 +201,16 @@ void SaveLayerStateCallback::open() {
 	for(auto&& log : predictiveColumnLogs_) log.open();
 }
 
-void SaveLayerStateCallback::add(
-	const Step step,
-	const Values& inputs,
-	const Values& nexts,
-	const Values& outputs,
-	const CoreCLA* cla
-) {
-	const auto& layers = cla->getLayers();
+void SaveLayerStateCallback::add(const StepSnapshot& snapshot) {
+	const Step step = snapshot.step;
+	const auto& layers = snapshot.layers;
 
 	for(std::size_t i = 0u, size = layers.size(); i < size; ++i) {
-		inputBitLogs_.at(i).add(step, layers.at(i)->getActiveBits().getSparse());
-		activeColumnLogs_.at(i).add(step, layers.at(i)->getActiveColumns().getSparse());
-		activeCellLogs_.at(i).add(step,layers.at(i)->getActiveCells().getSparse());
-		predictiveCellLogs_.at(i).add(step, layers.at(i)->getPredictiveCells().getSparse());
-		predictiveColumnLogs_.at(i).add(step, layers.at(i)->getPredictiveColumns().getSparse());
+		inputBitLogs_.at(i).add(step, layers.at(i).activeBits);
+		activeColumnLogs_.at(i).add(step, layers.at(i).activeColumns);
+		activeCellLogs_.at(i).add(step,layers.at(i).activeCells);
+		predictiveCellLogs_.at(i).add(step, layers.at(i).predictiveCells);
+		predictiveColumnLogs_.at(i).add(step, layers.at(i).predictiveColumns);
 	}
 }
 
@@ -327,18 +322,13 @@ void SaveLayerExStateCallback::open() {
 	for(auto&& log : externalWinnerSdrLogs_) log.open();
 }
 
-void SaveLayerExStateCallback::add(
-	const Step step,
-	const Values& inputs,
-	const Values& nexts,
-	const Values& outputs,
-	const CoreCLA* cla
-) {
-	const auto& layers = cla->getLayers();
+void SaveLayerExStateCallback::add(const StepSnapshot& snapshot) {
+	const Step step = snapshot.step;
+	const auto& layers = snapshot.layers;
 
 	for(std::size_t i = 0u, size = layers.size(); i < size; ++i) {
-		externalActiveSdrLogs_.at(i).add(step, layers.at(i)->getExternalActives().getSparse());
-		externalWinnerSdrLogs_.at(i).add(step, layers.at(i)->getExternalWinners().getSparse());
+		externalActiveSdrLogs_.at(i).add(step, layers.at(i).externalActives);
+		externalWinnerSdrLogs_.at(i).add(step, layers.at(i).externalWinners);
 	}
 }
 
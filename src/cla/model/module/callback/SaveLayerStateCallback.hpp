@@ -11,6 +11,7 @@
 #include "htm/types/Sdr.hpp"
 #include "cla/model/core/CoreLayer.hpp"
 #include "cla/model/module/callback/SaveCallback.hpp"
+#include "cla/model/module/helper/StepSnapshot.hpp"
 
 namespace cla {
 
@@ -242,23 +243,21 @@ public:
 	 */
 	void open() override;
 
+	/**
+	 * Get the groups of the layer data that the callback reads.
+	 * 
+	 * @return const SnapshotFields The groups of the layer data.
+	 */
+	const SnapshotFields getSnapshotFields() const override {
+		return SnapshotField::LAYER_STATE;
+	}
+
 	/**
 	 * Add the data to container.
 	 * 
-	 * @param step The step this function called.
-	 * @param inputs The input values from an environment in the step.
-	 * @param nexts The input values form the environemnt in the next step.
-	 * @param outputs The output values of CLA in the step.
-	 * @param cla A kind of cla agents. It needs to get the internal
-	 * data of cla. (ex: cla->getUnits();)
+	 * @param snapshot The snapshot of the step.
 	 */
-	void add(
-		const Step step,
-		const Values& inputs,
-		const Values& nexts,
-		const Values& outputs,
-		const CoreCLA* cla
-	) override;
+	void add(const StepSnapshot& snapshot) override;
 
 	/**
 	 * Save the data on the container.
@@ -362,23 +361,21 @@ public:
 	 */
 	void open() override;
 
+	/**
+	 * Get the groups of the layer data that the callback reads.
+	 * 
+	 * @return const SnapshotFields The groups of the layer data.
+	 */
+	const SnapshotFields getSnapshotFields() const override {
+		return SnapshotField::EXTERNAL_STATE;
+	}
+
 	/**
 	 * Add the data to container.
 	 * 
-	 * @param step The step this function called.
-	 * @param inputs The input values from an environment in the step.
-	 * @param nexts The input values form the environemnt in the next step.
-	 * @param outputs The output values of CLA in the step.
-	 * @param cla A kind of cla agents. It needs to get the internal
-	 * data of cla. (ex: cla->getUnits();)
+	 * @param snapshot The snapshot of the step.
 	 */
-	void add(
-		const Step step,
-		const Values& inputs,
-		const Values& nexts,
-		const Values& outputs,
-		const CoreCLA* cla
-	) override;
+	void add(const StepSnapshot& snapshot) override;
 
 	/**
 	 * Save the data on the container.
@@ -101,15 +101,15 @@ void SaveSynapseLog::open() {
 
 void SaveSynapseLog::add(
 	const Step step,
-	const PLayerProxy& layer
+	const LayerSnapshot& layer
 ) {
 
 	hists_.emplace_back(
 		SynapseHistory(
 			step, 
-			layer->getTmCreatedSynapses(), 
-			layer->getTmDestroyedSynapses(), 
-			layer->getTmUpdatedSynapses()
+			layer.createdSynapses, 
+			layer.destroyedSynapses, 
+			layer.updatedSynapses
 		)
 	);
 }
@@ -183,17 +183,11 @@ void SaveSynapseLogCallback::open() {
 	for(auto&& log : logs_) log.open();
 }
 
-void SaveSynapseLogCallback::add(
-	const Step step,
-	const Values& inputs,
-	const Values& nexts,
-	const Values& outputs,
-	const CoreCLA* cla
-) {
-	const auto& layers = cla->getLayers();
+void SaveSynapseLogCallback::add(const StepSnapshot& snapshot) {
+	const auto& layers = snapshot.layers;
 
 	for(std::size_t i = 0u, size = layers.size(); i < size; ++i) {
-		logs_.at(i).add(step, layers.at(i));
+		logs_.at(i).add(snapshot.step, layers.at(i));
 	}
 }
 
@@ -17,6 +17,7 @@
 
 #include "cla/model/module/helper/LayerProxy.hpp"
 #include "cla/model/module/callback/SaveCallback.hpp"
+#include "cla/model/module/helper/StepSnapshot.hpp"
 
 namespace cla {
 
@@ -154,12 +155,11 @@ public:
 	 * Add the data to container.
 	 * 
 	 * @param step The step this function called.
-	 * @param layer A kind of layer. It needs to get the internal
-	 * layer data.
+	 * @param layer The snapshot of the layer in the step.
 	 */
 	void add(
 		const Step step,
-		const PLayerProxy& layer
+		const LayerSnapshot& layer
 	);
 
 	/**
@@ -181,7 +181,8 @@ public:
  * 
  * @b Description
  * SaveSynapseLogCallback is one of the Callback-series. This class saves
- * the synapse data of layers to a json file.
+ * the synapse data of layers to a json file. The model must record the
+ * "synapses" and "permanences" events ("recordedEvents" of the config).
  */
 class SaveSynapseLogCallback : public SaveCallback {
 
@@ -241,23 +242,21 @@ public:
 	 */
 	void open() override;
 
+	/**
+	 * Get the groups of the layer data that the callback reads.
+	 * 
+	 * @return const SnapshotFields The groups of the layer data.
+	 */
+	const SnapshotFields getSnapshotFields() const override {
+		return SnapshotField::SYNAPSES;
+	}
+
 	/**
 	 * Add the data to container.
 	 * 
-	 * @param step The step this function called.
-	 * @param inputs The input values from an environment in the step.
-	 * @param nexts The input values form the environemnt in the next step.
-	 * @param outputs The output values of CLA in the step.
-	 * @param cla A kind of cla agents. It needs to get the internal
-	 * data of cla. (ex: cla->getUnits();)
+	 * @param snapshot The snapshot of the step.
 	 */
-	void add(
-		const Step step,
-		const Values& inputs,
-		const Values& nexts,
-		const Values& outputs,
-		const CoreCLA* cla
-	) override;
+	void add(const StepSnapshot& snapshot) override;
 
 	/**
 	 * Save the data on the container.
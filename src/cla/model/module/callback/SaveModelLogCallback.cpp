@@ -123,14 +123,10 @@ void SaveModelLogCallback::open() {
 	csv_.write(std::ios::out, ModelHistory::getHeader(valueDimension_));
 }
 
-void SaveModelLogCallback::add(
-	const Step step,
-	const Values& inputs,
-	const Values& nexts,
-	const Values& outputs,
-	const CoreCLA* cla
-) {
-	hists_.emplace_back(ModelHistory(step, inputs, nexts, outputs));
+void SaveModelLogCallback::add(const StepSnapshot& snapshot) {
+	hists_.emplace_back(ModelHistory(
+		snapshot.step, snapshot.inputs, snapshot.nexts, snapshot.outputs
+	));
 }
 
 void SaveModelLogCallback::save() {
@@ -162,23 +162,21 @@ public:
 	 */
 	void open() override;
 
+	/**
+	 * Get the groups of the layer data that the callback reads.
+	 * 
+	 * @return const SnapshotFields The groups of the layer data.
+	 */
+	const SnapshotFields getSnapshotFields() const override {
+		return SnapshotField::NONE;
+	}
+
 	/**
 	 * Add the data to container.
 	 * 
-	 * @param step The step this function called.
-	 * @param inputs The input values from an environment in the step.
-	 * @param nexts The input values form the environemnt in the next step.
-	 * @param outputs The output values of CLA in the step.
-	 * @param cla A kind of cla agents. It needs to get the internal
-	 * data of cla. (ex: cla->getUnits();)
+	 * @param snapshot The snapshot of the step.
 	 */
-	void add(
-		const Step step,
-		const Values& inputs,
-		const Values& nexts,
-		const Values& outputs,
-		const CoreCLA* cla
-	) override;
+	void add(const StepSnapshot& snapshot) override;
 
 	/**
 	 * Save the data on the container.
@@ -0,0 +1,45 @@
+// SnapshotCallback.cpp
+
+/**
+ * @file
+ * Implementation of SnapshotCallback.cpp
+ */
+
+#include "cla/model/core/CoreCLA.hpp" // for cross-referencing
+#include "cla/model/module/callback/SnapshotCallback.hpp"
+#include "cla/utils/Checker.hpp"
+
+namespace cla {
+
+/************************************************
+ * SnapshotCallback public functions.
+ ***********************************************/
+
+void SnapshotCallback::doStartProcessing(const CoreCLA* cla) {
+	if(getSnapshotFields() & SnapshotField::SYNAPSES) {
+		const htm::ConnectionsEvents events
+			= htm::ConnectionsEvent::SYNAPSES | htm::ConnectionsEvent::PERMANENCES;
+
+		for(const auto& layer : cla->getLayers()) {
+			CLA_CHECK(
+				(layer->getTmRecordedEvents() & events) == events,
+				"The callback reads the synapses, but the layers do not record them. "
+				"Set \"recordedEvents\" to [\"synapses\", \"permanences\"] in the model config."
+			)
+		}
+	}
+}
+
+void SnapshotCallback::doPostProcessing(
+	const Step step,
+	const Values& inputs,
+	const Values& nexts,
+	const Values& outputs,
+	const CoreCLA* cla
+) {
+	snapshot_.capture(step, inputs, nexts, outputs, cla, getSnapshotFields());
+	doSnapshotProcessing(snapshot_);
+}
+
+
+} // namespace cla
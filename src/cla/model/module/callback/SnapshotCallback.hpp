@@ -0,0 +1,94 @@
+// SnapshotCallback.hpp
+
+/**
+ * @file
+ * Definitions for the SnapshotCallback class in C++
+ */
+
+#ifndef SNAPSHOT_CALLBACK_HPP
+#define SNAPSHOT_CALLBACK_HPP
+
+#include <memory>
+
+#include "cla/model/core/CoreCallback.hpp"
+#include "cla/model/module/helper/StepSnapshot.hpp"
+
+namespace cla {
+
+/**
+ * SnapshotCallback implementation in C++.
+ *
+ * @b Description
+ * SnapshotCallback is one of the Callback-series. This class is an abstract
+ * class for the callbacks that read only the StepSnapshot of a step, not
+ * the model itself. So the callback can be run on the compute thread as
+ * it is, or on the background thread by the AsyncCallback.
+ */
+class SnapshotCallback : public CoreCallback {
+
+private:
+
+	StepSnapshot snapshot_;
+
+public:
+
+	/**
+	 * SnapshotCallback constructor.
+	 */
+	SnapshotCallback() = default;
+
+	/**
+	 * SnapshotCallback destructor.
+	 */
+	virtual ~SnapshotCallback() = default;
+
+	/**
+	 * Get the groups of the layer data that the callback reads.
+	 *
+	 * @return const SnapshotFields The groups of the layer data.
+	 */
+	virtual const SnapshotFields getSnapshotFields() const = 0;
+
+	/**
+	 * Called with the snapshot of a step after processing of the step.
+	 *
+	 * @param snapshot The snapshot of the step.
+	 */
+	virtual void doSnapshotProcessing(const StepSnapshot& snapshot) = 0;
+
+	/**
+	 * Called before beginning processing of all steps. If the callback
+	 * reads the synapses, it checks that the layers record the synapse
+	 * events, which are set by "recordedEvents" of the model config.
+	 *
+	 * @param cla A kind of cla agents.
+	 */
+	void doStartProcessing(const CoreCLA* cla) override;
+
+	/**
+	 * Called after beginning processing of a step. It captures the
+	 * snapshot and calls doSnapshotProcessing().
+	 *
+	 * @param step The step this function called.
+	 * @param inputs The input values from an environment in the step.
+	 * @param nexts The input values form the environemnt in the next step.
+	 * @param outputs The output values of CLA in the step.
+	 * @param cla A kind of cla agents. It needs to get the internal
+	 * data of cla. (ex: cla->getUnits();)
+	 */
+	void doPostProcessing(
+		const Step step,
+		const Values& inputs,
+		const Values& nexts,
+		const Values& outputs,
+		const CoreCLA* cla
+	) override;
+
+};
+
+using PSnapshotCallback = std::shared_ptr<SnapshotCallback>;
+
+
+} // namespace cla
+
+#endif // SNAPSHOT_CALLBACK_HPP
@@ -24,18 +24,6 @@ const htm::SDR_sparse_t LayerProxy::cell2columns_(
 	return {tm_->columnForCell(static_cast<htm::CellIdx>(cell))};
 }
 
-const htm::SDR_sparse_t LayerProxy::column2bits_(
-	const htm::ElemSparse column
-) const {
-	const auto& dimensions = container_.activeColumns.dimensions;
-	const htm::UInt nbColumnsByRegion
-		= htm::SDR(dimensions).size / static_cast<htm::UInt>(sps_.size());
-
-	const htm::UInt regionIdx = column / nbColumnsByRegion;
-
-	return sps_.at(regionIdx)->bitsForColumn(column);
-}
-
 
 /************************************************
  * LayerProxy reducter callbacks.
@@ -98,20 +86,41 @@ void LayerProxy::columnsToBits_(
 	const htm::SDRex<htm::NumCells>& columns,
 	htm::SDRex<htm::NumCells>& bits
 ) const {
-	convert_(
-		columns, bits,
-		[&](const htm::ElemSparse column) {
-			return column2bits_(column);
-		}, 
-		[&](
-			const htm::NumCells value,
-			const htm::NumCells sum,
-			const htm::ElemSparse inputIdx,
-			const htm::ElemSparse outputIdx
-		){
-			return sumCells_(value, sum, inputIdx, outputIdx);
+	const auto& columnsSparse = columns.getSparse();
+	const auto& columnsData = columns.getExDataDense();
+
+	const std::size_t size = bits.getDense().size();
+	const htm::UInt nbRegions = static_cast<htm::UInt>(sps_.size());
+
+	// The columns and the bits are split into the regions along the
+	// first axis, so each region owns a contiguous range of them.
+	const htm::UInt nbColumnsByRegion = columns.size / nbRegions;
+	const htm::UInt nbBitsByRegion = static_cast<htm::UInt>(size) / nbRegions;
+
+	bits.zero();
+	htm::SDR_dense_t outputDense(size);
+	std::vector<htm::NumCells> outputData(size, static_cast<htm::NumCells>(0));
+
+	for(const auto column : columnsSparse) {
+		const htm::UInt regionIdx = column / nbColumnsByRegion;
+		const htm::UInt offset = regionIdx * nbBitsByRegion;
+
+		const auto& regionBits = sps_[regionIdx]->bitsForColumn(
+			column - regionIdx * nbColumnsByRegion
+		);
+
+		for(const auto regionBit : regionBits) {
+			const htm::ElemSparse bit = offset + regionBit;
+
+			outputDense[bit] = static_cast<htm::ElemDense>(1);
+			outputData[bit] = sumCells_(
+				columnsData[column], outputData[bit], column, bit
+			);
 		}
-	);
+	}
+
+	bits.setDense(outputDense);
+	bits.setExDataDense(outputData);
 }
 
 void LayerProxy::updateBurstColumns_(
@@ -142,12 +151,14 @@ void LayerProxy::updateBurstColumns_(
 LayerProxy::LayerProxy(
 	const SDRContainer& container,
 	const std::vector<PSpatialPooler>& sps,
-	const PTemporalMemory& tm
+	const PTemporalMemory& tm,
+	const CoreTemporalMemoryState* tmState
 ) :
 	status_(Status::READY),
 	container_(container),
 	sps_(sps),
-	tm_(tm)
+	tm_(tm),
+	tmState_(tmState)
 {
 
 	predictiveCells_.initialize(container_.activeCells.dimensions);
@@ -196,7 +207,7 @@ const htm::SDR& LayerProxy::getBurstColumns() const {
 const htm::SDR& LayerProxy::getPredictiveCells() const {
 	if(!predictiveCellsValid_) {
 		segsToCells_(container_.activeSegments, predictiveCells_);
-		predictiveBitsValid_ = true;
+		predictiveCellsValid_ = true;
 	}
 
 	return predictiveCells_;
@@ -244,6 +255,7 @@ const std::size_t LayerProxy::getNbTmSegments() const {
 }
 
 const htm::Real LayerProxy::getTmAnomaly() const {
+	if(tmState_) return tmState_->getAnomaly();
 	return tm_->getAnomaly();
 }
 
@@ -275,6 +287,10 @@ const std::vector<SynapsePermanence>& LayerProxy::getTmUpdatedSynapses() const {
 	return tm_->getConnectionHandler().getUpdatePermanences();
 }
 
+const htm::ConnectionsEvents LayerProxy::getTmRecordedEvents() const {
+	return tm_->getRecordedEvents();
+}
+
 
 /************************************************
  * LayerProxy getter functions.
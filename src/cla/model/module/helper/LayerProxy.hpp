@@ -40,6 +40,7 @@ private:
 	const SDRContainer& container_;
 	const std::vector<PSpatialPooler>& sps_;
 	const PTemporalMemory& tm_;
+	const CoreTemporalMemoryState* tmState_;
 
 
 private:
@@ -63,7 +64,6 @@ private:
 
 	const htm::SDR_sparse_t seg2cells_(const htm::ElemSparse seg) const;
 	const htm::SDR_sparse_t cell2columns_(const htm::ElemSparse cell) const;
-	const htm::SDR_sparse_t column2bits_(const htm::ElemSparse column) const;
 
 	/************************************************
 	 * Reducter callbacks.
@@ -223,11 +223,15 @@ public:
 	 * @param container The original sdr container on this layer.
 	 * @param sps The pointers of the spatial poolers on this layer.
 	 * @param tm The pointer of the temporal memory on this layer.
+	 * @param tmState The stream state of the temporal memory when the
+	 * container belongs to a stream. The default value is nullptr, which
+	 * means the state of the temporal memory itself.
 	 */
 	LayerProxy(
 		const SDRContainer& container,
 		const std::vector<PSpatialPooler>& sps,
-		const PTemporalMemory& tm
+		const PTemporalMemory& tm,
+		const CoreTemporalMemoryState* tmState = nullptr
 	);
 
 	/**
@@ -394,6 +398,13 @@ public:
 	 */
 	const std::vector<SynapsePermanence>& getTmUpdatedSynapses() const;
 
+	/**
+	 * Get the connections events recorded by the temporal memory module.
+	 * 
+	 * @return const htm::ConnectionsEvents The recorded event classes.
+	 */
+	const htm::ConnectionsEvents getTmRecordedEvents() const;
+
 };
 
 using PLayerProxy = std::shared_ptr<LayerProxy>;
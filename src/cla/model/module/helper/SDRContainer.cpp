@@ -16,15 +16,17 @@ namespace cla {
 SDRContainer::SDRContainer(
 	const std::vector<htm::UInt>& bitDimension,
 	const std::vector<htm::UInt>& columnDimension,
-	const std::vector<htm::UInt>& cellDimension
+	const std::vector<htm::UInt>& cellDimension,
+	const htm::UInt nbRegions
 ) {
-	initialize(bitDimension, columnDimension, cellDimension);
+	initialize(bitDimension, columnDimension, cellDimension, nbRegions);
 }
 
 void SDRContainer::initialize(
 	const std::vector<htm::UInt>& bitDimension,
 	const std::vector<htm::UInt>& columnDimension,
-	const std::vector<htm::UInt>& cellDimension
+	const std::vector<htm::UInt>& cellDimension,
+	const htm::UInt nbRegions
 ) {
 	reset();
 
@@ -35,6 +37,15 @@ void SDRContainer::initialize(
 
 	externalActiveSDR.initialize({0u});
 	externalWinnerSDR.initialize({0u});
+
+	subActiveBits.assign(
+		nbRegions,
+		htm::SDR(htm::PartialDenseFuncs::splitDimensions(bitDimension, nbRegions))
+	);
+	subActiveColumns.assign(
+		nbRegions,
+		htm::SDR(htm::PartialDenseFuncs::splitDimensions(columnDimension, nbRegions))
+	);
 }
 
 void SDRContainer::increment() {
@@ -63,4 +74,19 @@ void SDRContainer::reset() {
 	preActiveSegments.clear();
 }
 
+void SDRContainer::remap(const htm::ConnectionsRemap& remap) {
+	for(auto segments : {&activeSegments, &preActiveSegments}) {
+		std::size_t size = 0u;
+
+		// The live segments keep their order, so the lists stay sorted.
+		for(const auto segment : *segments) {
+			if(segment < remap.segments.size()
+				&& remap.segments[segment] != htm::ConnectionsRemap::removed)
+				(*segments)[size++] = remap.segments[segment];
+		}
+
+		segments->resize(size);
+	}
+}
+
 } // namespace cla
\ No newline at end of file
@@ -9,8 +9,10 @@
 #define SDR_CONTAINER_HPP
 
 #include <memory>
+#include <vector>
 
 #include "cla/extension/types/Psdr.hpp"
+#include "htm/algorithms/Connections.hpp"
 #include "htm/types/Sdr.hpp"
 
 namespace cla {
@@ -38,6 +40,10 @@ public:
 	htm::SDR_sparse_t activeSegments;
 	htm::SDR_sparse_t preActiveSegments;
 
+	// The buffers of the regions, reused at every step.
+	std::vector<htm::SDR> subActiveBits;
+	std::vector<htm::SDR> subActiveColumns;
+
 public:
 
 	/**
@@ -51,11 +57,13 @@ public:
 	 * @param bitDimension The bit dimension.
 	 * @param columnDimension The column dimension.
 	 * @param cellDimension The cell dimension.
+	 * @param nbRegions The number of the regions.
 	 */
 	SDRContainer(
 		const std::vector<htm::UInt>& bitDimension,
 		const std::vector<htm::UInt>& columnDimension,
-		const std::vector<htm::UInt>& cellDimension
+		const std::vector<htm::UInt>& cellDimension,
+		const htm::UInt nbRegions = 1u
 	);
 
 	/**
@@ -69,11 +77,13 @@ public:
 	 * @param bitDimension The bit dimension.
 	 * @param columnDimension The column dimension.
 	 * @param cellDimension The cell dimension.
+	 * @param nbRegions The number of the regions.
 	 */
 	void initialize(
 		const std::vector<htm::UInt>& bitDimension,
 		const std::vector<htm::UInt>& columnDimension,
-		const std::vector<htm::UInt>& cellDimension
+		const std::vector<htm::UInt>& cellDimension,
+		const htm::UInt nbRegions = 1u
 	);
 
 	/**
@@ -86,6 +96,48 @@ public:
 	 * Reset sdrs of this container.
 	 */
 	void reset();
+
+	/**
+	 * Renumber the active segments after the connections of the
+	 * temporal memory are compacted.
+	 *
+	 * @param remap The renumbering returned by the compaction.
+	 */
+	void remap(const htm::ConnectionsRemap& remap);
+
+	/**
+	 * Save (serialize) / Load (deserialize) the sdrs of this container.
+	 * The buffers of the regions are not saved.
+	 *
+	 * @param ar The cereal archive.
+	 */
+	template<class Archive>
+	void save_ar(Archive& ar) const {
+		ar(
+			CEREAL_NVP(activeBits),
+			CEREAL_NVP(activeColumns),
+			CEREAL_NVP(activeCells),
+			CEREAL_NVP(winnerCells),
+			CEREAL_NVP(externalActiveSDR),
+			CEREAL_NVP(externalWinnerSDR),
+			CEREAL_NVP(activeSegments),
+			CEREAL_NVP(preActiveSegments)
+		);
+	}
+
+	template<class Archive>
+	void load_ar(Archive& ar) {
+		ar(
+			CEREAL_NVP(activeBits),
+			CEREAL_NVP(activeColumns),
+			CEREAL_NVP(activeCells),
+			CEREAL_NVP(winnerCells),
+			CEREAL_NVP(externalActiveSDR),
+			CEREAL_NVP(externalWinnerSDR),
+			CEREAL_NVP(activeSegments),
+			CEREAL_NVP(preActiveSegments)
+		);
+	}
 };
 
 using PSDRContainer = std::unique_ptr<SDRContainer>;
@@ -0,0 +1,124 @@
+// StepSnapshot.cpp
+
+/**
+ * @file
+ * Implementation of StepSnapshot.cpp
+ */
+
+#include <numeric>
+
+#include "cla/model/core/CoreCLA.hpp" // for cross-referencing
+#include "cla/model/module/helper/StepSnapshot.hpp"
+
+namespace cla {
+
+/************************************************
+ * LayerSnapshot public functions.
+ ***********************************************/
+
+void LayerSnapshot::capture(
+	const PLayerProxy& layer,
+	const SnapshotFields fields
+) {
+	clear();
+
+	status = layer->getStatus();
+
+	if(fields & SnapshotField::LAYER_STATE) {
+		activeBits = layer->getActiveBits().getSparse();
+		activeColumns = layer->getActiveColumns().getSparse();
+		activeCells = layer->getActiveCells().getSparse();
+		winnerCells = layer->getWinnerCells().getSparse();
+	}
+
+	if(fields & (SnapshotField::LAYER_STATE | SnapshotField::LAYER_LOG)) {
+		const auto& pcolumns = layer->getPredictiveColumnsWithNbPCells();
+
+		predictiveCells = layer->getPredictiveCells().getSparse();
+		predictiveColumns = pcolumns.getSparse();
+		nbPredictiveCells = pcolumns.getExDataSparse();
+	}
+
+	if(fields & SnapshotField::EXTERNAL_STATE) {
+		externalActives = layer->getExternalActives().getSparse();
+		externalWinners = layer->getExternalWinners().getSparse();
+	}
+
+	if(fields & SnapshotField::LAYER_LOG) {
+		burstColumns = layer->getBurstColumns().getSparse();
+		anomaly = layer->getTmAnomaly();
+		nbSynapses = layer->getNbTmSynapses();
+		nbSegments = layer->getNbTmSegments();
+	}
+
+	if(fields & SnapshotField::SYNAPSES) {
+		createdSynapses = layer->getTmCreatedSynapses();
+		destroyedSynapses = layer->getTmDestroyedSynapses();
+		updatedSynapses = layer->getTmUpdatedSynapses();
+	}
+}
+
+void LayerSnapshot::clear() {
+	status = Status::READY;
+
+	activeBits.clear();
+	activeColumns.clear();
+	activeCells.clear();
+	winnerCells.clear();
+	burstColumns.clear();
+	predictiveCells.clear();
+	predictiveColumns.clear();
+	nbPredictiveCells.clear();
+
+	externalActives.clear();
+	externalWinners.clear();
+
+	anomaly = 0.0f;
+	nbSynapses = 0u;
+	nbSegments = 0u;
+
+	createdSynapses.clear();
+	destroyedSynapses.clear();
+	updatedSynapses.clear();
+}
+
+const htm::MeanType LayerSnapshot::getMeanNbPredictiveCells() const {
+	if(nbPredictiveCells.empty()) return 0.0;
+
+	return std::accumulate(
+		nbPredictiveCells.begin(), nbPredictiveCells.end(),
+		static_cast<htm::NumCells>(0)
+	) / static_cast<htm::MeanType>(nbPredictiveCells.size());
+}
+
+
+/************************************************
+ * StepSnapshot public functions.
+ ***********************************************/
+
+void StepSnapshot::capture(
+	const Step step,
+	const Values& inputs,
+	const Values& nexts,
+	const Values& outputs,
+	const CoreCLA* cla,
+	const SnapshotFields fields
+) {
+	this->step = step;
+	this->inputs = inputs;
+	this->nexts = nexts;
+	this->outputs = outputs;
+
+	if(fields == SnapshotField::NONE) {
+		layers.clear();
+		return;
+	}
+
+	const auto& proxies = cla->getLayers();
+	layers.resize(proxies.size());
+
+	for(std::size_t i = 0u, size = proxies.size(); i < size; ++i)
+		layers.at(i).capture(proxies.at(i), fields);
+}
+
+} // namespace cla
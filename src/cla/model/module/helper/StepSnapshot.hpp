@@ -0,0 +1,179 @@
+// StepSnapshot.hpp
+
+/**
+ * @file
+ * Definitions for the StepSnapshot class in C++
+ */
+
+#ifndef STEP_SNAPSHOT_HPP
+#define STEP_SNAPSHOT_HPP
+
+#include <vector>
+
+#include "cla/environment/core/CoreEnv.hpp"
+#include "cla/model/module/helper/LayerProxy.hpp"
+#include "cla/utils/Status.hpp"
+
+namespace cla {
+
+class CoreCLA; // for cross-referencing.
+
+using SnapshotFields = unsigned int;
+
+/**
+ * SnapshotField definitions in C++.
+ *
+ * @b Description
+ * The SnapshotField defines the groups of the layer data that a snapshot
+ * captures. The groups are combined with the bitwise or. The values of
+ * the step (inputs, nexts and outputs) are always captured.
+ */
+struct SnapshotField {
+
+	inline static constexpr SnapshotFields NONE = 0u;
+
+	// The active bits, columns and cells, the winner cells and the
+	// predictive cells and columns.
+	inline static constexpr SnapshotFields LAYER_STATE = 1u << 0u;
+
+	// The external active and winner sdrs.
+	inline static constexpr SnapshotFields EXTERNAL_STATE = 1u << 1u;
+
+	// The status, the anomaly, the burst columns, the predictive cells
+	// and columns, and the number of the synapses and segments.
+	inline static constexpr SnapshotFields LAYER_LOG = 1u << 2u;
+
+	// The created, destroyed and updated synapses of the step.
+	inline static constexpr SnapshotFields SYNAPSES = 1u << 3u;
+
+	inline static constexpr SnapshotFields ALL
+		= LAYER_STATE | EXTERNAL_STATE | LAYER_LOG | SYNAPSES;
+};
+
+
+/**
+ * LayerSnapshot implementation in C++.
+ *
+ * @b Description
+ * The LayerSnapshot is the copy of the data of a layer at a step. The sdrs
+ * are held as the sparse indices. Only the groups given to capture() are
+ * updated, the others are left empty.
+ */
+struct LayerSnapshot {
+
+public:
+
+	Status status;
+
+	htm::SDR_sparse_t activeBits;
+	htm::SDR_sparse_t activeColumns;
+	htm::SDR_sparse_t activeCells;
+	htm::SDR_sparse_t winnerCells;
+	htm::SDR_sparse_t burstColumns;
+	htm::SDR_sparse_t predictiveCells;
+	htm::SDR_sparse_t predictiveColumns;
+	std::vector<htm::NumCells> nbPredictiveCells;
+
+	htm::SDR_sparse_t externalActives;
+	htm::SDR_sparse_t externalWinners;
+
+	htm::Real anomaly;
+	std::size_t nbSynapses;
+	std::size_t nbSegments;
+
+	std::vector<SynapseConnection> createdSynapses;
+	std::vector<htm::Synapse> destroyedSynapses;
+	std::vector<SynapsePermanence> updatedSynapses;
+
+public:
+
+	/**
+	 * LayerSnapshot constructor.
+	 */
+	LayerSnapshot() = default;
+
+	/**
+	 * LayerSnapshot destructor.
+	 */
+	~LayerSnapshot() = default;
+
+	/**
+	 * Capture the data of the layer. The buffers of the previous capture
+	 * are reused.
+	 *
+	 * @param layer The proxy of the layer.
+	 * @param fields The groups of the data to capture.
+	 */
+	void capture(const PLayerProxy& layer, const SnapshotFields fields);
+
+	/**
+	 * Clear the captured data.
+	 */
+	void clear();
+
+	/**
+	 * Get the mean number of the predictive cells of the predictive
+	 * columns.
+	 *
+	 * @return const htm::MeanType The mean number.
+	 */
+	const htm::MeanType getMeanNbPredictiveCells() const;
+};
+
+
+/**
+ * StepSnapshot implementation in C++.
+ *
+ * @b Description
+ * The StepSnapshot is the copy of the data that the callbacks read at a
+ * step. The snapshot does not refer to the model, so it can be read on
+ * another thread while the model computes the next steps.
+ */
+struct StepSnapshot {
+
+public:
+
+	Step step;
+	Values inputs;
+	Values nexts;
+	Values outputs;
+
+	std::vector<LayerSnapshot> layers;
+
+public:
+
+	/**
+	 * StepSnapshot constructor.
+	 */
+	StepSnapshot() = default;
+
+	/**
+	 * StepSnapshot destructor.
+	 */
+	~StepSnapshot() = default;
+
+	/**
+	 * Capture the data of the step. The buffers of the previous capture
+	 * are reused.
+	 *
+	 * @param step The step.
+	 * @param inputs The input values from an environment in the step.
+	 * @param nexts The input values form the environemnt in the next step.
+	 * @param outputs The output values of CLA in the step.
+	 * @param cla The cla model.
+	 * @param fields The groups of the layer data to capture.
+	 */
+	void capture(
+		const Step step,
+		const Values& inputs,
+		const Values& nexts,
+		const Values& outputs,
+		const CoreCLA* cla,
+		const SnapshotFields fields
+	);
+};
+
+
+} // namespace cla
+
+#endif // STEP_SNAPSHOT_HPP
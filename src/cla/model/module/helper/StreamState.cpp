@@ -0,0 +1,38 @@
+// StreamState.cpp
+
+/**
+ * @file
+ * Implementation of StreamState.cpp
+ */
+
+#include "cla/model/module/helper/StreamState.hpp"
+
+namespace cla {
+
+/************************************************
+ * LayerState public functions.
+ ***********************************************/
+
+void LayerState::reset() {
+	status = Status::READY;
+
+	container.reset();
+	for(auto&& sp : sps)
+		sp->reset();
+	tm->reset();
+	receiver->reset();
+
+	proxy->setStatus(status);
+	proxy->reset();
+}
+
+/************************************************
+ * StreamState public functions.
+ ***********************************************/
+
+void StreamState::reset() {
+	for(auto&& layer : layers)
+		layer->reset();
+}
+
+} // namespace cla
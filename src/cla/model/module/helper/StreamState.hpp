@@ -0,0 +1,95 @@
+// StreamState.hpp
+
+/**
+ * @file
+ * Definitions for the StreamState class in C++
+ */
+
+#ifndef STREAM_STATE_HPP
+#define STREAM_STATE_HPP
+
+#include <memory>
+#include <vector>
+
+#include "cla/model/core/CoreReceiver.hpp"
+#include "cla/model/core/CoreSpatialPooler.hpp"
+#include "cla/model/core/CoreTemporalMemory.hpp"
+#include "cla/model/module/helper/LayerProxy.hpp"
+#include "cla/model/module/helper/SDRContainer.hpp"
+#include "cla/utils/Status.hpp"
+
+namespace cla {
+
+/**
+ * LayerState implementation in C++.
+ *
+ * @b Description
+ * The LayerState is a container class that groups together the per-stream
+ * state of a layer: the layer status, the sdrs, the spatial pooler states
+ * of the regions, the temporal memory state and the receiver state. The proxy refers to the container and the
+ * temporal memory state of this instance, so the instance is always held
+ * by a pointer and never moved.
+ */
+struct LayerState {
+
+public:
+
+	Status status;
+	SDRContainer container;
+
+	std::vector<PSpatialPoolerState> sps;
+	PTemporalMemoryState tm;
+	PReceiverState receiver;
+
+	PLayerProxy proxy;
+
+public:
+
+	/**
+	 * LayerState constructor.
+	 */
+	LayerState() = default;
+
+	/**
+	 * LayerState destructor.
+	 */
+	~LayerState() = default;
+
+	/**
+	 * Reset the state of the layer for a new sequence.
+	 */
+	void reset();
+};
+
+using PLayerState = std::unique_ptr<LayerState>;
+
+
+/**
+ * StreamState implementation in C++.
+ *
+ * @b Description
+ * The StreamState is the whole state of one input stream on a cla model.
+ * The model weights are shared and only read, so the independent streams
+ * can run the inference on the same model at the same time, each with its
+ * own StreamState.
+ */
+struct StreamState {
+
+public:
+
+	std::vector<PLayerState> layers;
+
+public:
+
+	/**
+	 * Reset the state of the stream for a new sequence.
+	 */
+	void reset();
+};
+
+using PStreamState = std::unique_ptr<StreamState>;
+
+
+} // namespace cla
+
+#endif // STREAM_STATE_HPP
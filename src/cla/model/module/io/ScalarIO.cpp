@@ -107,7 +107,6 @@ void ScalarIO::detail(std::ostream& os) const {
 void ScalarIO::encode(const Values& inputs, htm::SDR& activeBits) const {
 	CLA_ASSERT(static_cast<htm::UInt>(inputs.size()) == nbInputs_);
 
-	htm::PSDR actives(inputDimensions_, nbInputs_);
 	std::vector<htm::SDR> sdrs(nbInputs_);
 	const std::vector<htm::UInt> subInputDimension
 		= htm::PartialDenseFuncs::splitDimensions(
@@ -121,8 +120,10 @@ void ScalarIO::encode(const Values& inputs, htm::SDR& activeBits) const {
 		encoders_.at(i).encode(inputs.at(i), sdrs.at(i));
 	}
 
-	actives.concatenate(sdrs);
-	activeBits = actives;
+	if(activeBits.dimensions.empty())
+		activeBits.initialize(inputDimensions_);
+
+	htm::PartialSparseFuncs::concatenateSDR(sdrs, activeBits);
 }
 
 const Values ScalarIO::decode(const PLayerProxy& layer) const {
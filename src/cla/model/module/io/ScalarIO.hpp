@@ -13,6 +13,7 @@
 #include "cla/model/core/CoreIO.hpp"
 #include "htm/encoders/ScalarEncoder.hpp"
 #include "cla/extension/algorithms/SDRClassifierScalar.hpp"
+#include "cla/utils/Checker.hpp"
 
 namespace cla {
 
@@ -124,6 +125,69 @@ public:
 	 * @param nexts The input values on the next time step.
 	 */
 	void learn(const PLayerProxy& layer, const Values& nexts) override {}
+
+	/**
+	 * Get the number of the input values.
+	 */
+	const htm::UInt getNbInputs() const { return nbInputs_; }
+
+	/**
+	 * Get the input bits dimensions.
+	 */
+	const std::vector<htm::UInt>& getInputDimensions() const {
+		return inputDimensions_;
+	}
+
+	/**
+	 * Get the number of the active bits.
+	 */
+	const htm::UInt getNbActiveBits() const { return nbActiveBits_; }
+
+	/**
+	 * Get the minimum values of each input value.
+	 */
+	const Values& getMins() const { return mins_; }
+
+	/**
+	 * Get the maximum values of each input value.
+	 */
+	const Values& getMaxs() const { return maxs_; }
+
+	CerealAdapter;
+
+	/**
+	 * Save (serialize) / Load (deserialize) the io. The encoders and the
+	 * decoders have no learned state, so only the shape of the io is
+	 * saved and checked on loading.
+	 *
+	 * @param ar The cereal archive.
+	 */
+	template<class Archive>
+	void save_ar(Archive& ar) const {
+		ar(
+			cereal::make_nvp("nbInputs", nbInputs_),
+			cereal::make_nvp("inputDimensions", inputDimensions_),
+			cereal::make_nvp("nbActiveBits", nbActiveBits_)
+		);
+	}
+
+	template<class Archive>
+	void load_ar(Archive& ar) {
+		htm::UInt nbInputs, nbActiveBits;
+		std::vector<htm::UInt> inputDimensions;
+		ar(
+			cereal::make_nvp("nbInputs", nbInputs),
+			cereal::make_nvp("inputDimensions", inputDimensions),
+			cereal::make_nvp("nbActiveBits", nbActiveBits)
+		);
+
+		CLA_CHECK_THROW(
+			nbInputs == nbInputs_
+			&& inputDimensions == inputDimensions_
+			&& nbActiveBits == nbActiveBits_,
+			"Error: The saved io does not match this io."
+		);
+	}
 };
 
 } // namespace cla
@@ -14,6 +14,23 @@
 
 namespace cla {
 
+/************************************************
+ * HtmLayer private functions.
+ ***********************************************/
+
+void HtmLayer::forEachRegion_(
+	const std::function<void(const std::size_t)>& func
+) const {
+	if(threadPool_) {
+		threadPool_->parallelFor(sps_.size(), func);
+		return;
+	}
+
+	for(std::size_t i = 0u; i < sps_.size(); ++i)
+		func(i);
+}
+
+
 /************************************************
  * HtmLayer public functions.
  ***********************************************/
@@ -28,13 +45,15 @@ HtmLayer::HtmLayer(
 	PSender sender,
 	PReceiver receiver,
 	const std::vector<PSpatialPooler>& sps,
-	PTemporalMemory tm
+	PTemporalMemory tm,
+	const htm::UInt nbThreads
 ) :
 	status_(Status::READY),
 	inputDimensions_(inputDimensions),
 	columnDimensions_(columnDimensions),
 	nbCellsForColumn_(nbCellsForColumn),
 	nbRegions_(nbRegions),
+	nbThreads_(nbThreads),
 	accepter_(std::move(accepter)),
 	adapter_(std::move(adapter)),
 	sender_(std::move(sender)),
@@ -86,10 +105,17 @@ HtmLayer::HtmLayer(
 	container_.initialize(
 		inputDimensions_, 
 		columnDimensions_, 
-		cellDimensions_
+		cellDimensions_,
+		nbRegions_
 	);
 
 	proxy_ = ProxyFunc::make(container_, sps_, tm_);
+
+	// The calling thread also computes the regions, so the pool has one
+	// thread less than the budget.
+	CLA_ASSERT(nbThreads_ >= 1u);
+	if(nbThreads_ > 1u && nbRegions_ > 1u)
+		threadPool_ = std::make_shared<ThreadPool>(nbThreads_ - 1u);
 }
 
 void HtmLayer::restate() {
@@ -123,7 +149,7 @@ void HtmLayer::reset() {
 	container_.reset();
 
 	proxy_->setStatus(status_);
-	proxy_.reset();
+	proxy_->reset();
 }
 
 void HtmLayer::summary(std::ostream& os) const {
@@ -201,6 +227,7 @@ void HtmLayer::detail(std::ostream& os) const {
 	   << std::endl
 	   << "\tnum cells for column\t\t= " << nbCellsForColumn_ << std::endl
 	   << "\tnum regions\t\t\t= " << nbRegions_ << std::endl
+	   << "\tnum threads\t\t\t= " << nbThreads_ << std::endl
 	   << std::endl
 	   << std::endl;
 
@@ -217,6 +244,29 @@ void HtmLayer::detail(std::ostream& os) const {
 	os << " =========================================================" << std::endl;
 }
 
+const htm::Real HtmLayer::getFragmentation() const {
+	const auto& connections = tm_->getConnections();
+	const std::size_t nbSlots = connections.segmentFlatListLength();
+
+	if(nbSlots == 0u) return 0.0f;
+
+	return static_cast<htm::Real>(nbSlots - connections.numSegments())
+		/ static_cast<htm::Real>(nbSlots);
+}
+
+void HtmLayer::compact(const std::vector<LayerState*>& states) {
+	const htm::ConnectionsRemap remap = tm_->compact();
+
+	container_.remap(remap);
+
+	for(auto&& state : states) {
+		CLA_ASSERT(state);
+
+		state->tm->remap(remap);
+		state->container.remap(remap);
+	}
+}
+
 const bool HtmLayer::forward(
 	const htm::SDR& inputSDR,
 	const bool learn,
@@ -237,23 +287,28 @@ const bool HtmLayer::forward(
 	// convert an input bits pattern to the active bits pattern.
 	adapter_->adapt(inputSDR, container_.activeBits);
 
-	const auto& subActiveBits
-		= htm::PSDR(container_.activeBits, nbRegions_).split();
-	htm::PSDR activeColumns(columnDimensions_, nbRegions_);
-	std::vector<htm::SDR> subActiveColumns = activeColumns.split();
+	auto& subActiveBits = container_.subActiveBits;
+	auto& subActiveColumns = container_.subActiveColumns;
+
+	htm::PartialSparseFuncs::splitSDR(
+		container_.activeBits, subActiveBits, nbRegions_
+	);
 
 	CLA_ASSERT(sps_.size() == subActiveBits.size());
 
 	// convert an active bits pattern to the active columns pattern.
-	for(std::size_t i = 0u; i < sps_.size(); ++i) {
+	// Each region has its own spatial pooler and output, so the result
+	// does not depend on the order of the regions.
+	forEachRegion_([&](const std::size_t i) {
 		sps_.at(i)->compute(
 			subActiveBits.at(i), learn, subActiveColumns.at(i)
 		);
-	}
-	
-	activeColumns.concatenate(subActiveColumns);
+	});
 
-	container_.activeColumns = activeColumns;
+
+	htm::PartialSparseFuncs::concatenateSDR(
+		subActiveColumns, container_.activeColumns
+	);
 
 
 	// convert an active columns pattern to the active cells pattern.
@@ -297,6 +352,153 @@ const PLayerProxy& HtmLayer::backward(
 }
 
 
+/************************************************
+ * HtmLayer public functions (stream inference).
+ ***********************************************/
+
+PLayerState HtmLayer::makeState() const {
+	auto state = std::make_unique<LayerState>();
+
+	state->status = Status::READY;
+	state->container.initialize(
+		inputDimensions_,
+		columnDimensions_,
+		cellDimensions_,
+		nbRegions_
+	);
+	for(const auto& sp : sps_)
+		state->sps.push_back(sp->makeState());
+	state->tm = tm_->makeState();
+	state->receiver = receiver_->makeState();
+	state->proxy = ProxyFunc::make(
+		state->container, sps_, tm_, state->tm.get()
+	);
+
+	return state;
+}
+
+PLayerState HtmLayer::forkState() const {
+	auto state = std::make_unique<LayerState>();
+
+	state->status = status_;
+	state->container = container_;
+	for(const auto& sp : sps_)
+		state->sps.push_back(sp->makeState());
+	state->tm = tm_->forkState();
+	state->receiver = receiver_->forkState();
+	state->proxy = ProxyFunc::make(
+		state->container, sps_, tm_, state->tm.get()
+	);
+	state->proxy->setStatus(state->status);
+
+	return state;
+}
+
+PLayerState HtmLayer::forkState(const LayerState& state) const {
+	auto forked = std::make_unique<LayerState>();
+
+	forked->status = state.status;
+	forked->container = state.container;
+	for(const auto& sp : state.sps)
+		forked->sps.push_back(sp->clone());
+	forked->tm = state.tm->clone();
+	forked->receiver = state.receiver->clone();
+	forked->proxy = ProxyFunc::make(
+		forked->container, sps_, tm_, forked->tm.get()
+	);
+	forked->proxy->setStatus(forked->status);
+
+	return forked;
+}
+
+void HtmLayer::restate(LayerState& state) const {
+	state.status = Status::SLEEP;
+	state.proxy->setStatus(state.status);
+}
+
+const bool HtmLayer::forward(
+	const htm::SDR& inputSDR,
+	LayerState& state,
+	htm::SDR& activeSDR
+) const {
+	// The case that inputSDR is not accepted.
+	if(!accepter_->isAccept(inputSDR)) return false;
+
+
+	// The case that inputSDR is accepted.
+	// update status.
+	state.status = Status::RUN;
+	state.container.increment();
+
+	state.proxy->setStatus(state.status);
+	state.proxy->reset();
+
+	// convert an input bits pattern to the active bits pattern.
+	adapter_->adapt(inputSDR, state.container.activeBits);
+
+	auto& subActiveBits = state.container.subActiveBits;
+	auto& subActiveColumns = state.container.subActiveColumns;
+
+	htm::PartialSparseFuncs::splitSDR(
+		state.container.activeBits, subActiveBits, nbRegions_
+	);
+
+	CLA_ASSERT(sps_.size() == subActiveBits.size());
+	CLA_ASSERT(sps_.size() == state.sps.size());
+
+	// infer the active columns pattern without learning. Each region
+	// infers into the buffers of its own state.
+	forEachRegion_([&](const std::size_t i) {
+		sps_.at(i)->infer(
+			subActiveBits.at(i), *state.sps.at(i), subActiveColumns.at(i)
+		);
+	});
+
+	htm::PartialSparseFuncs::concatenateSDR(
+		subActiveColumns, state.container.activeColumns
+	);
+
+
+	// convert an active columns pattern to the active cells pattern.
+	tm_->compute(
+		state.container.activeColumns, *state.tm,
+		state.container.activeCells, state.container.winnerCells
+	);
+
+	// select an active pattern send to the upper layer.
+	sender_->send(state.proxy, activeSDR);
+
+	return true;
+}
+
+const PLayerProxy& HtmLayer::backward(LayerState& state) const {
+	// activate segments by internal active cells.
+	tm_->activate(*state.tm, state.container.activeSegments);
+
+	return state.proxy;
+}
+
+const PLayerProxy& HtmLayer::backward(
+	const PLayerProxy& upperLayer,
+	LayerState& state
+) const {
+
+	// Receive and unzip the active and winner sdrs.
+	receiver_->receive(
+		upperLayer, *state.receiver,
+		state.container.externalActiveSDR, state.container.externalWinnerSDR
+	);
+
+	// activate segments by internal active cells.
+	tm_->activate(
+		state.container.externalActiveSDR, state.container.externalWinnerSDR,
+		*state.tm, state.container.activeSegments
+	);
+
+	return state.proxy;
+}
+
+
 /************************************************
  * HtmLayer public functions (getters).
  ***********************************************/
@@ -8,9 +8,12 @@
 #ifndef HTM_LAYER_HPP
 #define HTM_LAYER_HPP
 
+#include <functional>
 #include <vector>
 
 #include "cla/model/core/CoreLayer.hpp"
+#include "cla/utils/Checker.hpp"
+#include "cla/utils/ThreadPool.hpp"
 
 namespace cla {
 
@@ -33,6 +36,7 @@ private:
 	std::vector<htm::UInt> cellDimensions_;
 	htm::UInt nbCellsForColumn_;
 	htm::UInt nbRegions_;
+	htm::UInt nbThreads_;
 
 	PAccepter accepter_;
 	PAdapter adapter_;
@@ -45,6 +49,20 @@ private:
 	SDRContainer container_;
 	PLayerProxy proxy_;
 
+	PThreadPool threadPool_;
+
+private:
+
+	/**
+	 * Run the function for each region. The regions run on the thread pool
+	 * if the layer has one, otherwise they run in order on this thread.
+	 *
+	 * @param func The function called with the index of the region.
+	 */
+	void forEachRegion_(
+		const std::function<void(const std::size_t)>& func
+	) const;
+
 public:
 
 	/**
@@ -65,6 +83,9 @@ public:
 	 * @param receiver The pointer of the receiver module.
 	 * @param sps The pointers of the spatial pooler module.
 	 * @param tm The pointer of the temporal memory module.
+	 * @param nbThreads The number of the threads computing the spatial
+	 * poolers of the regions, including the calling thread. If the number
+	 * is one, the regions are computed serially.
 	 */
 	HtmLayer(
 		const std::vector<htm::UInt>& inputDimensions,
@@ -76,7 +97,8 @@ public:
 		PSender sender,
 		PReceiver receiver,
 		const std::vector<PSpatialPooler>& sps,
-		PTemporalMemory tm
+		PTemporalMemory tm,
+		const htm::UInt nbThreads = 1u
 	);
 
 	/**
@@ -109,6 +131,23 @@ public:
 	 */
 	void detail(std::ostream& os = std::cout) const override;
 
+	/**
+	 * Get the fragmentation of the temporal memory, the ratio of the
+	 * destroyed segment slots to all the segment slots.
+	 *
+	 * @return const htm::Real The fragmentation in [0, 1].
+	 */
+	const htm::Real getFragmentation() const override;
+
+	/**
+	 * Compact the temporal memory of the layer, and renumber the segments
+	 * held by the layer and by the stream states. It must be called
+	 * between two steps.
+	 *
+	 * @param states The stream states of this layer to renumber.
+	 */
+	void compact(const std::vector<LayerState*>& states) override;
+
 	/**
 	 * Forward the input sdr.
 	 * This function transfers the sdr of the input values to the columns
@@ -162,6 +201,84 @@ public:
 	) override;
 
 
+	/************************************************
+	 * The stream inference functions.
+	 ***********************************************/
+
+	/**
+	 * Make a new stream state for this layer.
+	 *
+	 * @return PLayerState The stream state.
+	 */
+	PLayerState makeState() const override;
+
+	/**
+	 * Make a new stream state which continues from the current activity
+	 * of this layer. The synapses of the modules are shared, only the
+	 * activity is copied.
+	 *
+	 * @return PLayerState The stream state.
+	 */
+	PLayerState forkState() const override;
+
+	/**
+	 * Make a new stream state which continues from the stream state.
+	 *
+	 * @param state The stream state of this layer to copy.
+	 * @return PLayerState The stream state.
+	 */
+	PLayerState forkState(const LayerState& state) const override;
+
+	/**
+	 * reset the stream state of the layer. The function is assumed to be
+	 * executed at every time step.
+	 *
+	 * @param state The stream state of this layer.
+	 */
+	void restate(LayerState& state) const override;
+
+	/**
+	 * Forward the input sdr on the stream without learning.
+	 * The modules of the layer are only read, so the function can be
+	 * called from several threads as long as each thread has its own
+	 * state.
+	 *
+	 * @param inputSDR The input sdr from the lower layer.
+	 * @param state The stream state of this layer.
+	 * @param activeSDR The active SDR for the upper layer. (This param has
+	 * a return value.)
+	 *
+	 * @return The boolean value whether the upper layer should run.
+	 */
+	const bool forward(
+		const htm::SDR& inputSDR,
+		LayerState& state,
+		htm::SDR& activeSDR
+	) const override;
+
+	/**
+	 * Backward on the stream without learning.
+	 *
+	 * @param state The stream state of this layer.
+	 *
+	 * @returns The proxy of this layer on the stream.
+	 */
+	const PLayerProxy& backward(LayerState& state) const override;
+
+	/**
+	 * Backward on the stream without learning.
+	 *
+	 * @param upperLayer The proxy of the upper layer on the stream.
+	 * @param state The stream state of this layer.
+	 *
+	 * @returns The proxy of this layer on the stream.
+	 */
+	const PLayerProxy& backward(
+		const PLayerProxy& upperLayer,
+		LayerState& state
+	) const override;
+
+
 	/************************************************
 	 * The module getters.
 	 ***********************************************/
@@ -242,6 +359,63 @@ public:
 	 * @return const std::vector<htm::UInt> The cell dimensions.
 	 */
 	const std::vector<htm::UInt>& getCellDimensions() const override;
+
+	CerealAdapter;
+
+	/**
+	 * Save (serialize) / Load (deserialize) the layer. The state of the
+	 * current step and the states of the spatial poolers, the temporal
+	 * memory and the receiver are saved. The other modules have no state
+	 * between the steps. The layer must be loaded into a layer with the
+	 * same structure, otherwise std::runtime_error is thrown.
+	 *
+	 * @param ar The cereal archive.
+	 */
+	template<class Archive>
+	void save_ar(Archive& ar) const {
+		ar(
+			cereal::make_nvp("inputDimensions", inputDimensions_),
+			cereal::make_nvp("cellDimensions", cellDimensions_),
+			cereal::make_nvp("nbRegions", nbRegions_),
+			cereal::make_nvp("status", status_)
+		);
+		ar(cereal::make_nvp("container", container_));
+
+		for(const auto& sp : sps_)
+			saveModule(ar, *sp);
+		saveModule(ar, *tm_);
+		saveModule(ar, *receiver_);
+	}
+
+	template<class Archive>
+	void load_ar(Archive& ar) {
+		std::vector<htm::UInt> inputDimensions, cellDimensions;
+		htm::UInt nbRegions;
+		ar(
+			cereal::make_nvp("inputDimensions", inputDimensions),
+			cereal::make_nvp("cellDimensions", cellDimensions),
+			cereal::make_nvp("nbRegions", nbRegions),
+			cereal::make_nvp("status", status_)
+		);
+
+		CLA_CHECK_THROW(
+			inputDimensions == inputDimensions_
+			&& cellDimensions == cellDimensions_
+			&& nbRegions == nbRegions_,
+			"Error: The saved layer does not match this layer."
+		);
+
+		ar(cereal::make_nvp("container", container_));
+
+		for(const auto& sp : sps_)
+			loadModule(ar, *sp);
+		loadModule(ar, *tm_);
+		loadModule(ar, *receiver_);
+
+		// The proxy caches the sdrs which are made from the modules.
+		proxy_->setStatus(status_);
+		proxy_->reset();
+	}
 };
 
 } // namespace cla
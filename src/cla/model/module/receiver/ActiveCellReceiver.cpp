@@ -10,6 +10,36 @@
 
 namespace cla {
 
+namespace {
+
+/**
+ * Make a stream state which keeps the copies of the sdrs. The sdrs have
+ * no dimensions until the first receive, and then the state is empty.
+ */
+PReceiverState copyState(const htm::SDR& activeSDR, const htm::SDR& winnerSDR) {
+	auto state = std::make_unique<ActiveCellReceiverState>();
+
+	if(!activeSDR.dimensions.empty()) copy(activeSDR, state->activeSDR);
+	if(!winnerSDR.dimensions.empty()) copy(winnerSDR, state->winnerSDR);
+
+	return state;
+}
+
+} // namespace
+
+/************************************************
+ * ActiveCellReceiverState public functions.
+ ***********************************************/
+
+void ActiveCellReceiverState::reset() {
+	activeSDR.zero();
+	winnerSDR.zero();
+}
+
+PReceiverState ActiveCellReceiverState::clone() const {
+	return copyState(activeSDR, winnerSDR);
+}
+
 /************************************************
  * ActiveCellReceiver public functions.
  ***********************************************/
@@ -38,4 +68,29 @@ void ActiveCellReceiver::receive(
 	copy(winnerSDR_, winnerSDR);
 }
 
+PReceiverState ActiveCellReceiver::makeState() const {
+	return std::make_unique<ActiveCellReceiverState>();
+}
+
+PReceiverState ActiveCellReceiver::forkState() const {
+	return copyState(activeSDR_, winnerSDR_);
+}
+
+void ActiveCellReceiver::receive(
+	const PLayerProxy& upperLayer,
+	CoreReceiverState& state,
+	htm::SDR& activeSDR,
+	htm::SDR& winnerSDR
+) const {
+	auto& receiverState = static_cast<ActiveCellReceiverState&>(state);
+
+	if(upperLayer->getStatus() == Status::RUN) {
+		copy(upperLayer->getActiveCells(), receiverState.activeSDR);
+		copy(upperLayer->getWinnerCells(), receiverState.winnerSDR);
+	}
+
+	copy(receiverState.activeSDR, activeSDR);
+	copy(receiverState.winnerSDR, winnerSDR);
+}
+
 } // namespace cla
\ No newline at end of file
@@ -12,6 +12,33 @@
 
 namespace cla {
 
+/**
+ * ActiveCellReceiverState implementation in C++.
+ *
+ * @b Description
+ * The ActiveCellReceiverState is the stream state of ActiveCellReceiver.
+ * It keeps the last sdrs received from the running upper layer.
+ */
+class ActiveCellReceiverState : public CoreReceiverState {
+
+public:
+
+	htm::SDR activeSDR;
+	htm::SDR winnerSDR;
+
+	/**
+	 * Reset the state of the stream.
+	 */
+	void reset() override;
+
+	/**
+	 * Copy the state of the stream.
+	 *
+	 * @return PReceiverState The copied state.
+	 */
+	PReceiverState clone() const override;
+};
+
 /**
  * ActiveCellReceiver implementation in C++.
  *
@@ -79,6 +106,73 @@ public:
 		htm::SDR& activeSDR,
 		htm::SDR& winnerSDR
 	) override;
+
+	/**
+	 * Make a new stream state for this receiver.
+	 *
+	 * @return PReceiverState The stream state.
+	 */
+	PReceiverState makeState() const override;
+
+	/**
+	 * Make a new stream state which continues from what this receiver
+	 * keeps now.
+	 *
+	 * @return PReceiverState The stream state.
+	 */
+	PReceiverState forkState() const override;
+
+	/**
+	 * Receive the sdrs from the proxy of the layer on the stream.
+	 *
+	 * @param upperLayer The proxy of the upper layer. This function receives a kind of sdr
+	 * from this proxy.
+	 * @param state The stream state.
+	 * @param activeSDR The active sdr in this layer to activate the lower
+	 * layer.
+	 * @param winnerSDR The winner sdr in this layer to activate the lower
+	 * layer.
+	 */
+	void receive(
+		const PLayerProxy& upperLayer,
+		CoreReceiverState& state,
+		htm::SDR& activeSDR,
+		htm::SDR& winnerSDR
+	) const override;
+
+	CerealAdapter;
+
+	/**
+	 * Save (serialize) / Load (deserialize) the received sdrs. The sdrs
+	 * have no dimensions until the first receive, e.g. on the top layer.
+	 *
+	 * @param ar The cereal archive.
+	 */
+	template<class Archive>
+	void save_ar(Archive& ar) const {
+		const bool received = !activeSDR_.dimensions.empty();
+		ar(cereal::make_nvp("received", received));
+
+		if(received) {
+			ar(
+				cereal::make_nvp("activeSDR", activeSDR_),
+				cereal::make_nvp("winnerSDR", winnerSDR_)
+			);
+		}
+	}
+
+	template<class Archive>
+	void load_ar(Archive& ar) {
+		bool received;
+		ar(cereal::make_nvp("received", received));
+
+		if(received) {
+			ar(
+				cereal::make_nvp("activeSDR", activeSDR_),
+				cereal::make_nvp("winnerSDR", winnerSDR_)
+			);
+		}
+	}
 	
 };
 
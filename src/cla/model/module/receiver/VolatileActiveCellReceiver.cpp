@@ -5,48 +5,115 @@
  * Implementation of VolatileActiveCellReceiver.cpp
  */
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
 #include "cla/model/module/receiver/VolatileActiveCellReceiver.hpp"
 
 #include "cla/utils/Checker.hpp"
 
 namespace cla {
 
+/************************************************
+ * VolatileActiveCellReceiverState public functions.
+ ***********************************************/
+
+void VolatileActiveCellReceiverState::reset() {
+	// The zero step means that the cell has never been active.
+	step = 0u;
+	std::fill(activeSteps.begin(), activeSteps.end(), 0u);
+	std::fill(winnerSteps.begin(), winnerSteps.end(), 0u);
+	liveActiveCells.clear();
+	liveWinnerCells.clear();
+}
+
+PReceiverState VolatileActiveCellReceiverState::clone() const {
+	return std::make_unique<VolatileActiveCellReceiverState>(*this);
+}
+
 /************************************************
  * VolatileActiveCellReceiver private functions.
  ***********************************************/
 
+const htm::UInt64 VolatileActiveCellReceiver::computeMaxAge_() const {
+	// The value never falls under the threshold.
+	if(volatileRate_ >= 1.0f || volatileThreshold_ <= 0.0f) {
+		return std::numeric_limits<htm::UInt64>::max();
+	}
+
+	// Repeat the same float multiplications as the step by step decay so
+	// that the boundary age is exactly the same. The value reaches zero
+	// at the latest by underflow, which is under the positive threshold.
+	htm::UInt64 maxAge = 0u;
+	for(htm::Real value = _initVolatile * volatileRate_;
+		value > 0.0f && value >= volatileThreshold_;
+		value *= volatileRate_
+	) {
+		maxAge++;
+	}
+
+	return maxAge;
+}
+
+const bool VolatileActiveCellReceiver::isLive_(
+	const htm::UInt64 step,
+	const htm::UInt64 lastStep
+) const {
+	return lastStep != _neverActive && step - lastStep <= maxAge_;
+}
+
 void VolatileActiveCellReceiver::update_(
 	const htm::SDR& additive,
-	std::vector<htm::Real>& volatileDense
-) {
+	const htm::UInt64 step,
+	std::vector<htm::UInt64>& lastSteps,
+	htm::SDR_sparse_t& liveCells
+) const {
+	const std::size_t numLiveCells = liveCells.size();
+
 	for(const htm::ElemSparse idx : additive.getSparse()) {
-		volatileDense.at(idx) = _initVolatile;
+		if(!isLive_(step, lastSteps.at(idx))) {
+			liveCells.emplace_back(idx);
+		}
+		lastSteps.at(idx) = step;
 	}
+
+	// The additive sparse is sorted, so are the appended cells.
+	std::inplace_merge(
+		liveCells.begin(),
+		liveCells.begin() + numLiveCells,
+		liveCells.end()
+	);
 }
 
 void VolatileActiveCellReceiver::volatilize_(
-	std::vector<htm::Real>& volatileDense
-) {
-	const auto& volatilizeElem
-		= [&](htm::Real& elem) { elem *= volatileRate_; };
+	const htm::UInt64 step,
+	const std::vector<htm::UInt64>& lastSteps,
+	htm::SDR_sparse_t& liveCells
+) const {
+	const auto& isVolatilized = [&](const htm::ElemSparse idx) {
+		return !isLive_(step, lastSteps[idx]);
+	};
 
-	std::for_each(
-		volatileDense.begin(), volatileDense.end(), volatilizeElem
+	liveCells.erase(
+		std::remove_if(liveCells.begin(), liveCells.end(), isVolatilized),
+		liveCells.end()
 	);
 }
 
 const htm::SDR_sparse_t VolatileActiveCellReceiver::convertSparse_(
-	const std::vector<htm::Real>& volatileDense
+	const htm::SDR_sparse_t& liveCells,
+	const std::size_t size
 ) const {
-	htm::SDR_sparse_t sparse;
-
-	for(std::size_t i = 0u, size = volatileDense.size(); i < size; ++i) {
-		if(volatileDense.at(i) >= volatileThreshold_) {
-			sparse.emplace_back(static_cast<htm::ElemSparse>(i));
-		}
+	// Every cell including the never received ones is over the zero
+	// threshold.
+	if(volatileThreshold_ <= 0.0f) {
+		htm::SDR_sparse_t sparse(size);
+		std::iota(sparse.begin(), sparse.end(), 0u);
+		return sparse;
 	}
 
-	return sparse;
+	return liveCells;
 }
 
 /************************************************
@@ -73,12 +140,11 @@ void VolatileActiveCellReceiver::initialize(
 	volatileRate_ = volatileRate;
 	volatileThreshold_ = volatileThreshold;
 
-	volatileActiveDense_.clear();
-	volatileWinnerDense_.clear();
-	volatileActiveDense_.resize(externalPredictiveInputs);
-	volatileWinnerDense_.resize(externalPredictiveInputs);
-	std::fill(volatileActiveDense_.begin(), volatileActiveDense_.end(), 0.0f);
-	std::fill(volatileWinnerDense_.begin(), volatileWinnerDense_.end(), 0.0f);
+	maxAge_ = computeMaxAge_();
+
+	state_.activeSteps.assign(externalPredictiveInputs, _neverActive);
+	state_.winnerSteps.assign(externalPredictiveInputs, _neverActive);
+	state_.reset();
 }
 
 void VolatileActiveCellReceiver::summary(std::ostream& os) const {
@@ -101,30 +167,63 @@ void VolatileActiveCellReceiver::receive(
 	htm::SDR& activeSDR,
 	htm::SDR& winnerSDR
 ) {
+	receive(upperLayer, state_, activeSDR, winnerSDR);
+}
+
+PReceiverState VolatileActiveCellReceiver::makeState() const {
+	auto state = std::make_unique<VolatileActiveCellReceiverState>();
+	state->activeSteps.assign(state_.activeSteps.size(), _neverActive);
+	state->winnerSteps.assign(state_.winnerSteps.size(), _neverActive);
+	return state;
+}
+
+PReceiverState VolatileActiveCellReceiver::forkState() const {
+	return std::make_unique<VolatileActiveCellReceiverState>(state_);
+}
+
+void VolatileActiveCellReceiver::receive(
+	const PLayerProxy& upperLayer,
+	CoreReceiverState& state,
+	htm::SDR& activeSDR,
+	htm::SDR& winnerSDR
+) const {
+	auto& receiverState = static_cast<VolatileActiveCellReceiverState&>(state);
 	const auto& activeCells = upperLayer->getActiveCells();
 	const auto& winnerCells = upperLayer->getWinnerCells();
 
 	CLA_ASSERT(
 		activeCells.size
-		== static_cast<htm::UInt>(volatileActiveDense_.size())
+		== static_cast<htm::UInt>(receiverState.activeSteps.size())
 	);
 	CLA_ASSERT(
 		winnerCells.size
-		== static_cast<htm::UInt>(volatileWinnerDense_.size())
+		== static_cast<htm::UInt>(receiverState.winnerSteps.size())
 	);
 
-	volatilize_(volatileActiveDense_);
-	volatilize_(volatileWinnerDense_);
+	const htm::UInt64 step = ++receiverState.step;
+
+	volatilize_(step, receiverState.activeSteps, receiverState.liveActiveCells);
+	volatilize_(step, receiverState.winnerSteps, receiverState.liveWinnerCells);
 
 	if(upperLayer->getStatus() == Status::RUN) {
-		update_(activeCells, volatileActiveDense_);
-		update_(winnerCells, volatileWinnerDense_);
+		update_(
+			activeCells, step,
+			receiverState.activeSteps, receiverState.liveActiveCells
+		);
+		update_(
+			winnerCells, step,
+			receiverState.winnerSteps, receiverState.liveWinnerCells
+		);
 	}
 
 	activeSDR.initialize(activeCells.dimensions);
 	winnerSDR.initialize(winnerCells.dimensions);
-	activeSDR.setSparse(convertSparse_(volatileActiveDense_));
-	winnerSDR.setSparse(convertSparse_(volatileWinnerDense_));
+	activeSDR.setSparse(convertSparse_(
+		receiverState.liveActiveCells, receiverState.activeSteps.size()
+	));
+	winnerSDR.setSparse(convertSparse_(
+		receiverState.liveWinnerCells, receiverState.winnerSteps.size()
+	));
 }
 
-} // namespace cla
\ No newline at end of file
+} // namespace cla
@@ -12,6 +12,39 @@
 
 namespace cla {
 
+/**
+ * VolatileActiveCellReceiverState implementation in C++.
+ *
+ * @b Description
+ * The VolatileActiveCellReceiverState is the stream state of
+ * VolatileActiveCellReceiver. It has the step of the last activation of
+ * each cell and the sorted set of live cells.
+ */
+class VolatileActiveCellReceiverState : public CoreReceiverState {
+
+public:
+
+	htm::UInt64 step = 0u;
+
+	std::vector<htm::UInt64> activeSteps;
+	std::vector<htm::UInt64> winnerSteps;
+
+	htm::SDR_sparse_t liveActiveCells;
+	htm::SDR_sparse_t liveWinnerCells;
+
+	/**
+	 * Reset the state of the stream. No cell is live after the reset.
+	 */
+	void reset() override;
+
+	/**
+	 * Copy the state of the stream.
+	 *
+	 * @return PReceiverState The copied state.
+	 */
+	PReceiverState clone() const override;
+};
+
 /**
  * VolatileActiveCellReceiver implementation in C++.
  *
@@ -19,30 +52,54 @@ namespace cla {
  * The VolatileActiveCellReceiver is extended class of CoreReceiver.
  * The VolatileActiveCellReceiver is a class that receives the active cell
  * from the upper layer and volatilizes the active cell.
+ *
+ * The volatile value of a cell is volatileRate^age, where age is the
+ * number of steps since the cell was last received. Instead of decaying
+ * every cell each step, the receiver keeps the step of the last
+ * activation and the sorted set of live cells, and drops a cell once its
+ * age exceeds the largest age whose value is still above the threshold.
+ * The work per step follows the number of live cells, not the number of
+ * cells in the upper layer.
  */
 class VolatileActiveCellReceiver : public CoreReceiver {
 
 private:
 
 	inline static const htm::Real _initVolatile = 1.0f;
+	inline static const htm::UInt64 _neverActive = 0u;
 
 	htm::Real volatileRate_;
 	htm::Real volatileThreshold_;
 
-	std::vector<htm::Real> volatileActiveDense_;
-	std::vector<htm::Real> volatileWinnerDense_;
+	htm::UInt64 maxAge_;
+
+	VolatileActiveCellReceiverState state_;
 
 private:
 
+	const htm::UInt64 computeMaxAge_() const;
+
+	const bool isLive_(
+		const htm::UInt64 step,
+		const htm::UInt64 lastStep
+	) const;
+
 	void update_(
 		const htm::SDR& additive,
-		std::vector<htm::Real>& volatileDense
-	);
+		const htm::UInt64 step,
+		std::vector<htm::UInt64>& lastSteps,
+		htm::SDR_sparse_t& liveCells
+	) const;
 
-	void volatilize_(std::vector<htm::Real>& volatileDense);
+	void volatilize_(
+		const htm::UInt64 step,
+		const std::vector<htm::UInt64>& lastSteps,
+		htm::SDR_sparse_t& liveCells
+	) const;
 
 	const htm::SDR_sparse_t convertSparse_(
-		const std::vector<htm::Real>& volatileDense
+		const htm::SDR_sparse_t& liveCells,
+		const std::size_t size
 	) const;
 
 public:
@@ -106,9 +163,10 @@ public:
 	void restate() override {}
 
 	/**
-	 * Reset internal state of the selector.
+	 * Reset internal state of the selector. No cell is live after the
+	 * reset, like in a new stream state.
 	 */
-	void reset() override {}
+	void reset() override { state_.reset(); }
 
 	/**
 	 * Summarize the selector model.
@@ -139,6 +197,69 @@ public:
 		htm::SDR& activeSDR,
 		htm::SDR& winnerSDR
 	) override;
+
+	/**
+	 * Make a new stream state for this receiver.
+	 *
+	 * @return PReceiverState The stream state.
+	 */
+	PReceiverState makeState() const override;
+
+	/**
+	 * Make a new stream state which continues from what this receiver
+	 * keeps now.
+	 *
+	 * @return PReceiverState The stream state.
+	 */
+	PReceiverState forkState() const override;
+
+	/**
+	 * Receive the sdrs from the proxy of the layer on the stream.
+	 *
+	 * @param upperLayer The proxy of the upper layer. This function receives a kind of sdr
+	 * from this proxy.
+	 * @param state The stream state.
+	 * @param activeSDR The active sdr in this layer to activate the lower
+	 * layer.
+	 * @param winnerSDR The winner sdr in this layer to activate the lower
+	 * layer.
+	 */
+	void receive(
+		const PLayerProxy& upperLayer,
+		CoreReceiverState& state,
+		htm::SDR& activeSDR,
+		htm::SDR& winnerSDR
+	) const override;
+
+	CerealAdapter;
+
+	/**
+	 * Save (serialize) / Load (deserialize) the live cells of the
+	 * receiver.
+	 *
+	 * @param ar The cereal archive.
+	 */
+	template<class Archive>
+	void save_ar(Archive& ar) const {
+		ar(
+			cereal::make_nvp("step", state_.step),
+			cereal::make_nvp("activeSteps", state_.activeSteps),
+			cereal::make_nvp("winnerSteps", state_.winnerSteps),
+			cereal::make_nvp("liveActiveCells", state_.liveActiveCells),
+			cereal::make_nvp("liveWinnerCells", state_.liveWinnerCells)
+		);
+	}
+
+	template<class Archive>
+	void load_ar(Archive& ar) {
+		ar(
+			cereal::make_nvp("step", state_.step),
+			cereal::make_nvp("activeSteps", state_.activeSteps),
+			cereal::make_nvp("winnerSteps", state_.winnerSteps),
+			cereal::make_nvp("liveActiveCells", state_.liveActiveCells),
+			cereal::make_nvp("liveWinnerCells", state_.liveWinnerCells)
+		);
+	}
 	
 };
 
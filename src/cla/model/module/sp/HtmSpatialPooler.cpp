@@ -31,7 +31,9 @@ HtmSpatialPooler::HtmSpatialPooler(
 	const htm::Int seed,
 	const htm::UInt spVerbosity,
 	const bool wrapAround,
-	const bool constSynInitPermanence
+	const bool constSynInitPermanence,
+	const htm::UInt connectedBitsRefreshPeriod,
+	const htm::UInt initThreads
 ) {
 	initialize(
 		inputDimensions, columnDimensions, potentialRadius, potentialPct,
@@ -39,7 +41,7 @@ HtmSpatialPooler::HtmSpatialPooler(
 		synPermInactiveDec, synPermActiveInc, synPermConnected,
 		synInitPermanence, minPctOverlapDutyCycles, dutyCyclePeriod,
 		boostStrength, seed, spVerbosity, wrapAround,
-		constSynInitPermanence
+		constSynInitPermanence, connectedBitsRefreshPeriod, initThreads
 	);
 }
 
@@ -61,7 +63,9 @@ void HtmSpatialPooler::initialize(
 	const htm::Int seed,
 	const htm::UInt spVerbosity,
 	const bool wrapAround,
-	const bool constSynInitPermanence
+	const bool constSynInitPermanence,
+	const htm::UInt connectedBitsRefreshPeriod,
+	const htm::UInt initThreads
 ) {
 	sp_.initialize(
 		inputDimensions, columnDimensions, potentialRadius, potentialPct,
@@ -69,7 +73,7 @@ void HtmSpatialPooler::initialize(
 		synPermInactiveDec, synPermActiveInc, synPermConnected,
 		synInitPermanence, minPctOverlapDutyCycles, dutyCyclePeriod,
 		boostStrength, seed, spVerbosity, wrapAround,
-		constSynInitPermanence
+		constSynInitPermanence, connectedBitsRefreshPeriod, initThreads
 	);
 }
 
@@ -97,6 +101,8 @@ void HtmSpatialPooler::detail(std::ostream& os) const {
 	os << "\tspVerbosity\t\t\t= " << sp_.getSpVerbosity() << "f" << std::endl;
 	os << "\twrapAround\t\t\t= " << ((sp_.getWrapAround()) ? "true" : "false") << std::endl;
 	os << "\tconstSynInitPermanence\t\t= " << ((sp_.getConstSynInitPermanence()) ? "true" : "false") << std::endl;
+	os << "\tconnectedBitsRefreshPeriod\t= " << sp_.getConnectedBitsRefreshPeriod() << "u" << std::endl;
+	os << "\tinitThreads\t\t\t= " << sp_.getInitThreads() << "u" << std::endl;
 	os << std::endl;
 }
 
@@ -108,25 +114,39 @@ void HtmSpatialPooler::compute(
 	sp_.compute(activeBits, learn, activeColumns);
 }
 
-const std::vector<htm::CellIdx> HtmSpatialPooler::bitsForColumn(
+PSpatialPoolerState HtmSpatialPooler::makeState() const {
+	return std::make_unique<HtmSpatialPoolerState>();
+}
+
+void HtmSpatialPooler::infer(
+	const htm::SDR& activeBits,
+	CoreSpatialPoolerState& state,
+	htm::SDR& activeColumns
+) const {
+	auto& spState = static_cast<HtmSpatialPoolerState&>(state).state;
+	sp_.infer(activeBits, spState, activeColumns);
+}
+
+const std::vector<htm::CellIdx>& HtmSpatialPooler::bitsForColumn(
 	const htm::CellIdx column
 ) const {
-	std::set<htm::CellIdx> bits;
-	const auto& synapses = sp_.connections.synapsesForSegment(column);
+	return sp_.connectedBitsForColumn(column);
+}
 
-	for(const htm::Synapse synapse : synapses) {
-		const auto& synData = sp_.connections.dataForSynapse(synapse);
+const htm::Connections& HtmSpatialPooler::getConnections() const {
+	return sp_.connections;
+}
 
-		if(synData.permanence > sp_.getSynPermConnected()) {
-			bits.insert(synData.presynapticCell);
-		}
-	}
+const htm::UInt HtmSpatialPooler::getNumInputs() const {
+	return sp_.getNumInputs();
+}
 
-	return std::vector(bits.begin(), bits.end());
+const htm::UInt HtmSpatialPooler::getNumColumns() const {
+	return sp_.getNumColumns();
 }
 
-const htm::Connections& HtmSpatialPooler::getConnections() const {
-	return sp_.connections;
+const htm::SpatialPoolerExtension& HtmSpatialPooler::getSpatialPooler() const {
+	return sp_;
 }
 
 } // namespace cla
\ No newline at end of file
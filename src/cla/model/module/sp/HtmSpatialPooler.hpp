@@ -14,6 +14,34 @@
 
 namespace cla {
 
+/**
+ * HtmSpatialPoolerState implementation in C++.
+ *
+ * @b Description
+ * The HtmSpatialPoolerState is the stream state of HtmSpatialPooler. It
+ * wraps the htm::SpatialPoolerExtensionState.
+ */
+class HtmSpatialPoolerState : public CoreSpatialPoolerState {
+
+public:
+
+	htm::SPEState state;
+
+	/**
+	 * Reset the state of the stream. The buffers keep no activity.
+	 */
+	void reset() override {}
+
+	/**
+	 * Copy the state of the stream.
+	 *
+	 * @return PSpatialPoolerState The copied state.
+	 */
+	PSpatialPoolerState clone() const override {
+		return std::make_unique<HtmSpatialPoolerState>(*this);
+	}
+};
+
 /**
  * HtmSpatialPooler implementation in C++.
  *
@@ -162,6 +190,17 @@ public:
 	 * @param constSynInitPermanence
 	 * Boolean value that determines whether or not synapse permanence
 	 * is initialized by the const value(synInitPermanence).
+	 *
+	 * @param connectedBitsRefreshPeriod
+	 * The number of the inference steps after which the cached connected
+	 * bits of the columns are rebuilt. If the value is 0, the cache is
+	 * refreshed only when a synapse crosses the connected threshold.
+	 *
+	 * @param initThreads
+	 * The number of the threads that build the initial synapses. If the
+	 * value is 0, the synapses are drawn from the shared random generator
+	 * as before; otherwise each column has its own random stream, so the
+	 * result does not depend on the number of the threads.
 	 */
 	HtmSpatialPooler(
 		const std::vector<htm::UInt>& inputDimensions,
@@ -181,7 +220,9 @@ public:
 		const htm::Int seed = 1,
 		const htm::UInt spVerbosity = 0u,
 		const bool wrapAround = true,
-		const bool constSynInitPermanence = false
+		const bool constSynInitPermanence = false,
+		const htm::UInt connectedBitsRefreshPeriod = 0u,
+		const htm::UInt initThreads = 0u
 	);
 
 	/**
@@ -211,7 +252,9 @@ public:
 		const htm::Int seed = 1,
 		const htm::UInt spVerbosity = 0u,
 		const bool wrapAround = true,
-		const bool constSynInitPermanence = false
+		const bool constSynInitPermanence = false,
+		const htm::UInt connectedBitsRefreshPeriod = 0u,
+		const htm::UInt initThreads = 0u
 	);
 
 	/**
@@ -257,13 +300,37 @@ public:
 	) override;
 
 	/**
-	 * Map a column to bits. This function collects bits with the connected
-	 * synapses.
+	 * Make a new stream state for this spatial pooler.
+	 *
+	 * @return PSpatialPoolerState The stream state.
+	 */
+	PSpatialPoolerState makeState() const override;
+
+	/**
+	 * Infer the active columns of the input active bits without learning.
+	 * The column-synapses and the inner state are only read, so the
+	 * function can be called from several threads at once, each with its
+	 * own stream state.
+	 *
+	 * @param activeBits The active bits sdr
+	 * @param state The stream state.
+	 * @param activeColumns The active columns SDR. (This param has a
+	 * return value.)
+	 */
+	void infer(
+		const htm::SDR& activeBits,
+		CoreSpatialPoolerState& state,
+		htm::SDR& activeColumns
+	) const override;
+
+	/**
+	 * Map a column to bits. This function looks up the bits with the
+	 * connected synapses from the cached table.
 	 *
 	 * @param column The index of the column.
-	 * @return const std::vector<htm::CellIdx> The indexes of bits.
+	 * @return const std::vector<htm::CellIdx>& The indexes of bits.
 	 */
-	const std::vector<htm::CellIdx> bitsForColumn(
+	const std::vector<htm::CellIdx>& bitsForColumn(
 		const htm::CellIdx column
 	) const override;
 
@@ -273,6 +340,44 @@ public:
 	 * @return const htm::Connections& the column-synapses.
 	 */
 	const htm::Connections& getConnections() const override;
+
+	/**
+	 * Get the number of the input bits of the spatial pooler.
+	 *
+	 * @return const htm::UInt The number of the input bits.
+	 */
+	const htm::UInt getNumInputs() const override;
+
+	/**
+	 * Get the number of the columns of the spatial pooler.
+	 *
+	 * @return const htm::UInt The number of the columns.
+	 */
+	const htm::UInt getNumColumns() const override;
+
+	/**
+	 * Get the spatial pooler algorithm.
+	 *
+	 * @return const htm::SpatialPoolerExtension& The spatial pooler.
+	 */
+	const htm::SpatialPoolerExtension& getSpatialPooler() const;
+
+	CerealAdapter;
+
+	/**
+	 * Save (serialize) / Load (deserialize) the spatial pooler.
+	 *
+	 * @param ar The cereal archive.
+	 */
+	template<class Archive>
+	void save_ar(Archive& ar) const {
+		ar(cereal::make_nvp("sp", sp_));
+	}
+
+	template<class Archive>
+	void load_ar(Archive& ar) {
+		ar(cereal::make_nvp("sp", sp_));
+	}
 };
 
 } // namespace cla
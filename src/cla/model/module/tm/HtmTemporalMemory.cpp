@@ -5,6 +5,8 @@
  * Implementation of HtmTemporalMemory.cpp
  */
 
+#include <utility>
+
 #include "cla/model/module/tm/HtmTemporalMemory.hpp"
 #include "cla/extension/algorithms/SegmentSelector.hpp"
 
@@ -182,6 +184,53 @@ void HtmTemporalMemory::activate(
 	activeSegments = tm_.getActiveSegments();
 }
 
+PTemporalMemoryState HtmTemporalMemory::makeState() const {
+	auto state = std::make_unique<HtmTemporalMemoryState>();
+	tm_.initializeState(state->state);
+	return state;
+}
+
+PTemporalMemoryState HtmTemporalMemory::forkState() const {
+	return std::make_unique<HtmTemporalMemoryState>(tm_.captureState());
+}
+
+void HtmTemporalMemory::compute(
+	const htm::SDR& activeColumns,
+	CoreTemporalMemoryState& state,
+	htm::SDR& activeCells,
+	htm::SDR& winnerCells
+) const {
+	auto& tmState = static_cast<HtmTemporalMemoryState&>(state).state;
+
+	tm_.compute(activeColumns, tmState);
+
+	// Copy the cells, the non-const setSparse swaps them out of the state.
+	activeCells.setSparse(std::as_const(tmState.activeCells));
+	winnerCells.setSparse(std::as_const(tmState.winnerCells));
+}
+
+void HtmTemporalMemory::activate(
+	CoreTemporalMemoryState& state,
+	htm::SDR_sparse_t& activeSegments
+) const {
+	auto& tmState = static_cast<HtmTemporalMemoryState&>(state).state;
+
+	tm_.activateDendrites(tmState);
+	activeSegments = tmState.activeSegmentsForInner;
+}
+
+void HtmTemporalMemory::activate(
+	const htm::SDR& externalActiveSDR,
+	const htm::SDR& externalWinnerSDR,
+	CoreTemporalMemoryState& state,
+	htm::SDR_sparse_t& activeSegments
+) const {
+	auto& tmState = static_cast<HtmTemporalMemoryState&>(state).state;
+
+	tm_.activateDendrites(tmState, externalActiveSDR, externalWinnerSDR);
+	activeSegments = tmState.activeSegmentsForInner;
+}
+
 htm::CellIdx HtmTemporalMemory::cellForSegment(const htm::Segment segment) const {
 	return tm_.connections.cellForSegment(segment);
 }
@@ -198,8 +247,24 @@ const htm::TMConnectionsHandler& HtmTemporalMemory::getConnectionHandler() const
 	return tm_.getSynapseHandler();
 }
 
+void HtmTemporalMemory::setRecordedEvents(const htm::ConnectionsEvents events) {
+	tm_.setRecordedEvents(events);
+}
+
+const htm::ConnectionsEvents HtmTemporalMemory::getRecordedEvents() const {
+	return tm_.getRecordedEvents();
+}
+
+const htm::ConnectionsRemap HtmTemporalMemory::compact() {
+	return tm_.compact();
+}
+
 const htm::Real HtmTemporalMemory::getAnomaly() const {
 	return tm_.anomaly;
 }
 
+const htm::TemporalMemoryExtension& HtmTemporalMemory::getTemporalMemory() const {
+	return tm_;
+}
+
 } // namespace cla
\ No newline at end of file
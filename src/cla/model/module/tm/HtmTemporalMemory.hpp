@@ -14,6 +14,64 @@
 
 namespace cla {
 
+/**
+ * HtmTemporalMemoryState implementation in C++.
+ *
+ * @b Description
+ * The HtmTemporalMemoryState is the stream state of HtmTemporalMemory. It
+ * wraps the htm::TemporalMemoryExtensionState.
+ */
+class HtmTemporalMemoryState : public CoreTemporalMemoryState {
+
+public:
+
+	htm::TMEState state;
+
+	/**
+	 * HtmTemporalMemoryState constructor.
+	 */
+	HtmTemporalMemoryState() = default;
+
+	/**
+	 * HtmTemporalMemoryState constructor with the state of the stream.
+	 *
+	 * @param tmState The state of the stream.
+	 */
+	explicit HtmTemporalMemoryState(htm::TMEState tmState)
+		: state(std::move(tmState)) {}
+
+	/**
+	 * Reset the sequence state of the stream.
+	 */
+	void reset() override { state.reset(); }
+
+	/**
+	 * Get the anomaly value of the stream.
+	 *
+	 * @return const htm::Real The anomaly value.
+	 */
+	const htm::Real getAnomaly() const override { return state.anomaly; }
+
+	/**
+	 * Renumber the segments of the stream after the connections are
+	 * compacted.
+	 *
+	 * @param remap The renumbering returned by the compaction.
+	 */
+	void remap(const htm::ConnectionsRemap& remap) override {
+		state.remap(remap);
+	}
+
+	/**
+	 * Copy the state of the stream.
+	 *
+	 * @return PTemporalMemoryState The copied state.
+	 */
+	PTemporalMemoryState clone() const override {
+		return std::make_unique<HtmTemporalMemoryState>(*this);
+	}
+};
+
 /**
  * HtmTemporalMemory implementation in C++.
  *
@@ -295,6 +353,67 @@ public:
 		htm::SDR_sparse_t& activeSegments
 	) override;
 
+	/**
+	 * Make a new stream state for this temporal memory.
+	 *
+	 * @return PTemporalMemoryState The stream state.
+	 */
+	PTemporalMemoryState makeState() const override;
+
+	/**
+	 * Make a new stream state which continues from the current activity
+	 * of this temporal memory.
+	 *
+	 * @return PTemporalMemoryState The stream state.
+	 */
+	PTemporalMemoryState forkState() const override;
+
+	/**
+	 * Compute the input active columns on the stream without learning.
+	 *
+	 * @param activeColumns The active column sdr
+	 * @param state The stream state.
+	 * @param activeCells The active cell sdr (This param has a
+	 * return value.)
+	 * @param winnerCells The winner cell sdr (This param has a
+	 * return value.)
+	 */
+	void compute(
+		const htm::SDR& activeColumns,
+		CoreTemporalMemoryState& state,
+		htm::SDR& activeCells,
+		htm::SDR& winnerCells
+	) const override;
+
+	/**
+	 * Activate segments on the cells of the stream without learning.
+	 *
+	 * @param state The stream state.
+	 * @param activeSegments The active segment sdr (This param has a
+	 * return value.)
+	 */
+	void activate(
+		CoreTemporalMemoryState& state,
+		htm::SDR_sparse_t& activeSegments
+	) const override;
+
+	/**
+	 * Activate segments on the cells of the stream without learning,
+	 * including the external active sdr and the external winner sdr.
+	 *
+	 * @param externalActiveSDR The external active sdr.
+	 * @param externalWinnerSDR The external winner sdr.
+	 * @param state The stream state.
+	 * @param activeSegments The active segment sdr (This param has a
+	 * return value.)
+	 */
+	void activate(
+		const htm::SDR& externalActiveSDR,
+		const htm::SDR& externalWinnerSDR,
+		CoreTemporalMemoryState& state,
+		htm::SDR_sparse_t& activeSegments
+	) const override;
+
 	/**
 	 * Map a segment to a cell.
 	 *
@@ -325,6 +444,30 @@ public:
 	 */
 	const htm::TMConnectionsHandler& getConnectionHandler() const override;
 
+	/**
+	 * Set the connections events that the connection handler records.
+	 * Nothing is recorded by default.
+	 *
+	 * @param events The event classes to record.
+	 */
+	void setRecordedEvents(const htm::ConnectionsEvents events) override;
+
+	/**
+	 * Get the connections events that the connection handler records.
+	 *
+	 * @return const htm::ConnectionsEvents The event classes to record.
+	 */
+	const htm::ConnectionsEvents getRecordedEvents() const override;
+
+	/**
+	 * Compact the cell-synapses. The slots of the destroyed segments and
+	 * synapses are removed, and the segments are renumbered.
+	 *
+	 * @return const htm::ConnectionsRemap The renumbering of the segments
+	 * and the synapses.
+	 */
+	const htm::ConnectionsRemap compact() override;
+
 	/**
 	 * Get the anomaly value.
 	 *
@@ -332,6 +475,31 @@ public:
 	 */
 	const htm::Real getAnomaly() const override;
 
+	/**
+	 * Get the temporal memory algorithm.
+	 *
+	 * @return const htm::TemporalMemoryExtension& The temporal memory.
+	 */
+	const htm::TemporalMemoryExtension& getTemporalMemory() const;
+
+	CerealAdapter;
+
+	/**
+	 * Save (serialize) / Load (deserialize) the temporal memory. The
+	 * recorded events of the connection handler are not saved.
+	 *
+	 * @param ar The cereal archive.
+	 */
+	template<class Archive>
+	void save_ar(Archive& ar) const {
+		ar(cereal::make_nvp("tm", tm_));
+	}
+
+	template<class Archive>
+	void load_ar(Archive& ar) {
+		ar(cereal::make_nvp("tm", tm_));
+	}
+
 };
 
 } // namespace cla
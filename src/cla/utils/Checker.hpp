@@ -9,6 +9,8 @@
 #define CHECKER_HPP
 
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 #define CLA_ALERT(msg) \
 	std::cerr << __FILE__ << ":" << __LINE__ << ": runtime error: " << msg << std::endl;\
@@ -21,5 +23,14 @@
 	if(!(condition)){\
 		CLA_ALERT(msg)}
 
+#define CLA_THROW(msg) \
+	{std::ostringstream claThrowOss;\
+	claThrowOss << __FILE__ << ":" << __LINE__ << ": runtime error: " << msg;\
+	throw std::runtime_error(claThrowOss.str());}
+
+#define CLA_CHECK_THROW(condition, msg) \
+	if(!(condition)){\
+		CLA_THROW(msg)}
+
 
 #endif // CHECKER_HPP
\ No newline at end of file
@@ -0,0 +1,118 @@
+// MappedFile.cpp
+
+/**
+ * @file
+ * Implementation of MappedFile.cpp
+ */
+
+#include <fstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CLA_MAPPED_FILE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "cla/utils/MappedFile.hpp"
+#include "cla/utils/Checker.hpp"
+
+namespace cla {
+
+/************************************************
+ * MappedFile private functions.
+ ***********************************************/
+
+void MappedFile::unmap_() {
+#ifdef CLA_MAPPED_FILE_MMAP
+	if(data_ != nullptr && buffer_.empty() && size_ > 0u)
+		::munmap(const_cast<char*>(data_), size_);
+#endif
+
+	data_ = nullptr;
+	size_ = 0u;
+	buffer_.clear();
+	buffer_.shrink_to_fit();
+}
+
+
+/************************************************
+ * MappedFile public functions.
+ ***********************************************/
+
+MappedFile::MappedFile() : data_(nullptr), size_(0u) {}
+
+MappedFile::MappedFile(const std::string& path) : MappedFile() {
+	open(path);
+}
+
+MappedFile::~MappedFile() {
+	unmap_();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	: data_(other.data_), size_(other.size_), buffer_(std::move(other.buffer_)) {
+	other.data_ = nullptr;
+	other.size_ = 0u;
+	other.buffer_.clear();
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if(this != &other) {
+		unmap_();
+		data_ = other.data_;
+		size_ = other.size_;
+		buffer_ = std::move(other.buffer_);
+		other.data_ = nullptr;
+		other.size_ = 0u;
+		other.buffer_.clear();
+	}
+	return *this;
+}
+
+void MappedFile::open(const std::string& path) {
+	unmap_();
+
+#ifdef CLA_MAPPED_FILE_MMAP
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	CLA_CHECK(fd >= 0, "Cannot open the mapped file: " << path)
+
+	struct stat st;
+	const bool stated = ::fstat(fd, &st) == 0;
+	if(!stated) ::close(fd);
+	CLA_CHECK(stated, "Cannot stat the mapped file: " << path)
+
+	size_ = static_cast<std::size_t>(st.st_size);
+
+	if(size_ > 0u) {
+		void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		CLA_CHECK(addr != MAP_FAILED, "Cannot map the file: " << path)
+		data_ = static_cast<const char*>(addr);
+	} else {
+		::close(fd);
+		buffer_.resize(1u);
+		data_ = buffer_.data();
+	}
+#else
+	std::ifstream ifs(path, std::ios_base::binary | std::ios_base::ate);
+	CLA_CHECK(!ifs.fail(), "Cannot open the mapped file: " << path)
+
+	size_ = static_cast<std::size_t>(ifs.tellg());
+	ifs.seekg(0);
+
+	// One byte more so that an empty file has a valid data pointer.
+	buffer_.resize(size_ + 1u);
+	ifs.read(buffer_.data(), static_cast<std::streamsize>(size_));
+	CLA_CHECK(!ifs.fail(), "Cannot read the mapped file: " << path)
+	data_ = buffer_.data();
+#endif
+}
+
+void MappedFile::close() {
+	unmap_();
+}
+
+} // namespace cla
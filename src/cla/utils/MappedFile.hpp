@@ -0,0 +1,93 @@
+// MappedFile.hpp
+
+/**
+ * @file
+ * Definitions for the MappedFile class in C++
+ */
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cla {
+
+/**
+ * MappedFile implementation in C++.
+ *
+ * @b Description
+ * The MappedFile maps a whole file read-only into the memory. The pages
+ * are loaded on the first access and are shared by all processes which
+ * map the same file. On the platforms without mmap the file is read into
+ * a buffer instead, so the data is the same but not shared.
+ */
+class MappedFile {
+
+private:
+
+	const char* data_;
+	std::size_t size_;
+	std::vector<char> buffer_;
+
+private:
+
+	void unmap_();
+
+public:
+
+	/**
+	 * MappedFile constructor. The file is empty until open.
+	 */
+	MappedFile();
+
+	/**
+	 * MappedFile constructor with the path.
+	 *
+	 * @param path The path of the file.
+	 */
+	explicit MappedFile(const std::string& path);
+
+	/**
+	 * MappedFile destructor. The mapping is released.
+	 */
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	/**
+	 * Map the file. The file mapped before is released.
+	 *
+	 * @param path The path of the file.
+	 */
+	void open(const std::string& path);
+
+	/**
+	 * Release the mapping.
+	 */
+	void close();
+
+	/**
+	 * Get the first byte of the file. The mapping is aligned to a page.
+	 */
+	const char* data() const { return data_; }
+
+	/**
+	 * Get the size of the file in bytes.
+	 */
+	std::size_t size() const { return size_; }
+
+	/**
+	 * Check whether the file is mapped by mmap (shared between processes).
+	 */
+	const bool isShared() const { return data_ != nullptr && buffer_.empty(); }
+};
+
+} // namespace cla
+
+#endif // MAPPED_FILE_HPP
@@ -0,0 +1,46 @@
+// SerializeHelpers.hpp
+
+/**
+ * @file
+ * Definitions for the SerializeHelpers class in C++
+ */
+
+#ifndef SERIALIZE_HELPERS_HPP
+#define SERIALIZE_HELPERS_HPP
+
+#include "htm/types/Serializable.hpp"
+
+namespace cla {
+
+// The CerealAdapter macro of htm names these types without the namespace.
+using htm::ArWrapper;
+using htm::SerializableFormat;
+
+/**
+ * Save the module to the archive. The module is reached through its base
+ * class, so the archive is passed to the cereal adapter of the module.
+ *
+ * @param ar The cereal archive.
+ * @param module The module to save.
+ */
+template<typename Archive>
+void saveModule(Archive& ar, const htm::Serializable& module) {
+	ArWrapper wrapper(&ar);
+	module.cereal_adapter_save(wrapper);
+}
+
+/**
+ * Load the module from the archive. See saveModule.
+ *
+ * @param ar The cereal archive.
+ * @param module The module to load.
+ */
+template<typename Archive>
+void loadModule(Archive& ar, htm::Serializable& module) {
+	ArWrapper wrapper(&ar);
+	module.cereal_adapter_load(wrapper);
+}
+
+} // namespace cla
+
+#endif // SERIALIZE_HELPERS_HPP
@@ -0,0 +1,124 @@
+// SpscQueue.hpp
+
+/**
+ * @file
+ * Definitions for the SpscQueue class in C++
+ */
+
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "cla/utils/Checker.hpp"
+
+namespace cla {
+
+/**
+ * SpscQueue implementation in C++.
+ *
+ * @b Description
+ * The SpscQueue is a bounded lock-free queue for one producer thread and
+ * one consumer thread. The slots are allocated once and reused, so the
+ * producer writes a value in place into back() and publishes it with
+ * push(), and the consumer reads front() and releases it with pop().
+ *
+ * @tparam T The type of the slot. It must be default constructible.
+ */
+template <typename T>
+class SpscQueue {
+
+private:
+
+	std::vector<T> slots_;
+
+	// The counters only increase; the slot index is the counter modulo
+	// the capacity.
+	alignas(64) std::atomic<std::size_t> head_;
+	alignas(64) std::atomic<std::size_t> tail_;
+
+public:
+
+	/**
+	 * SpscQueue constructor.
+	 *
+	 * @param capacity The number of the slots. It must be greater than zero.
+	 */
+	explicit SpscQueue(const std::size_t capacity) :
+		slots_(capacity),
+		head_(0u),
+		tail_(0u)
+	{
+		CLA_ASSERT(capacity > 0u);
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	/**
+	 * Get the free slot to write. Only the producer calls this function.
+	 *
+	 * @return T* The free slot, or nullptr if the queue is full.
+	 */
+	T* back() {
+		const std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+		if(tail - head_.load(std::memory_order_acquire) == slots_.size())
+			return nullptr;
+
+		return &slots_[tail % slots_.size()];
+	}
+
+	/**
+	 * Publish the slot given by back(). Only the producer calls this
+	 * function.
+	 */
+	void push() {
+		tail_.store(
+			tail_.load(std::memory_order_relaxed) + 1u,
+			std::memory_order_release
+		);
+	}
+
+	/**
+	 * Get the oldest published slot. Only the consumer calls this
+	 * function.
+	 *
+	 * @return T* The oldest slot, or nullptr if the queue is empty.
+	 */
+	T* front() {
+		const std::size_t head = head_.load(std::memory_order_relaxed);
+
+		if(head == tail_.load(std::memory_order_acquire))
+			return nullptr;
+
+		return &slots_[head % slots_.size()];
+	}
+
+	/**
+	 * Release the slot given by front(). Only the consumer calls this
+	 * function.
+	 */
+	void pop() {
+		head_.store(
+			head_.load(std::memory_order_relaxed) + 1u,
+			std::memory_order_release
+		);
+	}
+
+	/**
+	 * Get the number of the slots.
+	 *
+	 * @return const std::size_t The number of the slots.
+	 */
+	const std::size_t capacity() const {
+		return slots_.size();
+	}
+};
+
+
+} // namespace cla
+
+#endif // SPSC_QUEUE_HPP
@@ -0,0 +1,78 @@
+// SyncedFile.cpp
+
+/**
+ * @file
+ * Implementation of SyncedFile.cpp
+ */
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CLA_SYNCED_FILE_FSYNC
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "cla/utils/SyncedFile.hpp"
+#include "cla/utils/Checker.hpp"
+
+namespace cla {
+
+/************************************************
+ * SyncedFile public functions.
+ ***********************************************/
+
+SyncedFile::SyncedFile() : file_(nullptr) {}
+
+SyncedFile::SyncedFile(const std::string& path) : SyncedFile() {
+	open(path);
+}
+
+SyncedFile::~SyncedFile() {
+	close();
+}
+
+void SyncedFile::open(const std::string& path) {
+	close();
+
+	file_ = std::fopen(path.c_str(), "wb");
+	CLA_CHECK(file_ != nullptr, "Cannot open the synced file: " << path)
+	path_ = path;
+}
+
+void SyncedFile::write(const void* data, const std::size_t bytes) {
+	CLA_ASSERT(file_ != nullptr);
+
+	CLA_CHECK(
+		std::fwrite(data, 1u, bytes, file_) == bytes,
+		"Cannot write the synced file: " << path_
+	)
+}
+
+void SyncedFile::sync() {
+	CLA_ASSERT(file_ != nullptr);
+
+	CLA_CHECK(std::fflush(file_) == 0, "Cannot flush the synced file: " << path_)
+#ifdef CLA_SYNCED_FILE_FSYNC
+	CLA_CHECK(::fsync(::fileno(file_)) == 0, "Cannot sync the file: " << path_)
+#endif
+}
+
+void SyncedFile::close() {
+	if(file_ == nullptr) return;
+
+	std::fclose(file_);
+	file_ = nullptr;
+	path_.clear();
+}
+
+void SyncedFile::syncPath(const std::string& path) {
+#ifdef CLA_SYNCED_FILE_FSYNC
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	CLA_CHECK(fd >= 0, "Cannot open the synced path: " << path)
+
+	const bool synced = ::fsync(fd) == 0;
+	::close(fd);
+	CLA_CHECK(synced, "Cannot sync the path: " << path)
+#endif
+}
+
+} // namespace cla
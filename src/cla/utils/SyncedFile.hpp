@@ -0,0 +1,97 @@
+// SyncedFile.hpp
+
+/**
+ * @file
+ * Definitions for the SyncedFile class in C++
+ */
+
+#ifndef SYNCED_FILE_HPP
+#define SYNCED_FILE_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+namespace cla {
+
+/**
+ * SyncedFile implementation in C++.
+ *
+ * @b Description
+ * The SyncedFile writes a file whose data reach the disk on sync, so the
+ * synced data survive a crash of the machine, not only of the process.
+ * syncPath syncs a file written by another stream, or a directory after
+ * its entries are created, renamed or removed. On the platforms without
+ * fsync the data are only flushed to the operating system.
+ */
+class SyncedFile {
+
+private:
+
+	std::FILE* file_;
+	std::string path_;
+
+public:
+
+	/**
+	 * SyncedFile constructor. The file is closed until open.
+	 */
+	SyncedFile();
+
+	/**
+	 * SyncedFile constructor with the path.
+	 *
+	 * @param path The path of the file.
+	 */
+	explicit SyncedFile(const std::string& path);
+
+	/**
+	 * SyncedFile destructor. The file is closed without the sync.
+	 */
+	~SyncedFile();
+
+	SyncedFile(const SyncedFile&) = delete;
+	SyncedFile& operator=(const SyncedFile&) = delete;
+
+	/**
+	 * Create or truncate the file. The file opened before is closed.
+	 *
+	 * @param path The path of the file.
+	 */
+	void open(const std::string& path);
+
+	/**
+	 * Append the data to the file.
+	 *
+	 * @param data The first byte of the data.
+	 * @param bytes The size of the data.
+	 */
+	void write(const void* data, const std::size_t bytes);
+
+	/**
+	 * Flush the written data and wait until they are on the disk.
+	 */
+	void sync();
+
+	/**
+	 * Close the file.
+	 */
+	void close();
+
+	/**
+	 * Check whether the file is open.
+	 */
+	const bool isOpen() const { return file_ != nullptr; }
+
+	/**
+	 * Wait until the data of the file or the entries of the directory are
+	 * on the disk.
+	 *
+	 * @param path The path of the file or the directory.
+	 */
+	static void syncPath(const std::string& path);
+};
+
+} // namespace cla
+
+#endif // SYNCED_FILE_HPP
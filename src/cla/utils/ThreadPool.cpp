@@ -0,0 +1,210 @@
+// ThreadPool.cpp
+
+/**
+ * @file
+ * Implementation of ThreadPool.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "cla/utils/ThreadPool.hpp"
+
+namespace cla {
+
+namespace {
+
+// The pool and the worker index of the current thread. The thread which
+// is not a worker has nullptr.
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local std::size_t currentWorker = 0u;
+
+} // namespace
+
+/************************************************
+ * ThreadPool private functions.
+ ***********************************************/
+
+void ThreadPool::push_(Task task) {
+	// A worker pushes to its own queue to keep the task near its data,
+	// the other threads spread the tasks over the workers.
+	const std::size_t index = (currentPool == this)
+		? currentWorker
+		: nextWorker_.fetch_add(1u, std::memory_order_relaxed) % workers_.size();
+
+	{
+		std::lock_guard<std::mutex> lock(workers_.at(index)->mutex);
+		workers_.at(index)->tasks.emplace_back(std::move(task));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex_);
+		nbPendings_++;
+	}
+	wake_.notify_one();
+}
+
+const bool ThreadPool::pop_(const std::size_t index, Task& task) {
+	const std::size_t nbWorkers = workers_.size();
+
+	for(std::size_t i = 0u; i < nbWorkers; ++i) {
+		Worker& worker = *workers_.at((index + i) % nbWorkers);
+		std::lock_guard<std::mutex> lock(worker.mutex);
+
+		if(worker.tasks.empty()) continue;
+
+		// The own queue is used as a stack, the others are stolen from
+		// the opposite end.
+		if(i == 0u) {
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+		} else {
+			task = std::move(worker.tasks.front());
+			worker.tasks.pop_front();
+		}
+
+		nbPendings_--;
+		return true;
+	}
+
+	return false;
+}
+
+const bool ThreadPool::runPendingTask_() {
+	const std::size_t index = (currentPool == this)
+		? currentWorker
+		: nextWorker_.load(std::memory_order_relaxed) % workers_.size();
+
+	Task task;
+	if(!pop_(index, task)) return false;
+
+	task();
+	return true;
+}
+
+void ThreadPool::run_(const std::size_t index) {
+	currentPool = this;
+	currentWorker = index;
+
+	while(true) {
+		Task task;
+		if(pop_(index, task)) {
+			task();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(wakeMutex_);
+		wake_.wait(lock, [&]() { return stop_ || nbPendings_.load() > 0u; });
+
+		if(stop_ && nbPendings_.load() == 0u) return;
+	}
+}
+
+void ThreadPool::pin_(const std::size_t index) {
+#if defined(__linux__)
+	const std::size_t nbCores
+		= std::max(1u, std::thread::hardware_concurrency());
+
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+	CPU_SET(index % nbCores, &cpuset);
+	pthread_setaffinity_np(
+		threads_.at(index).native_handle(), sizeof(cpu_set_t), &cpuset
+	);
+#else
+	(void)index;
+#endif
+}
+
+/************************************************
+ * ThreadPool public functions.
+ ***********************************************/
+
+ThreadPool::ThreadPool(const std::size_t nbThreads, const bool pinThreads) :
+	nbPendings_(0u),
+	nextWorker_(0u),
+	stop_(false)
+{
+	const std::size_t size = (nbThreads > 0u)
+		? nbThreads
+		: std::max(1u, std::thread::hardware_concurrency());
+
+	for(std::size_t i = 0u; i < size; ++i)
+		workers_.emplace_back(std::make_unique<Worker>());
+
+	for(std::size_t i = 0u; i < size; ++i) {
+		threads_.emplace_back(&ThreadPool::run_, this, i);
+		if(pinThreads) pin_(i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+
+	for(auto&& thread : threads_)
+		thread.join();
+}
+
+const std::size_t ThreadPool::size() const {
+	return threads_.size();
+}
+
+void ThreadPool::parallelFor(
+	const std::size_t nbTasks,
+	const std::function<void(const std::size_t)>& func
+) {
+	if(nbTasks == 0u) return;
+
+	struct Group {
+		std::atomic<std::size_t> nbRemainings;
+		std::mutex mutex;
+		std::condition_variable done;
+		std::exception_ptr error;
+	};
+
+	auto group = std::make_shared<Group>();
+	group->nbRemainings = nbTasks;
+
+	for(std::size_t i = 0u; i < nbTasks; ++i) {
+		push_([group, &func, i]() {
+			try {
+				func(i);
+			} catch(...) {
+				std::lock_guard<std::mutex> lock(group->mutex);
+				if(!group->error) group->error = std::current_exception();
+			}
+
+			if(--group->nbRemainings == 0u) {
+				std::lock_guard<std::mutex> lock(group->mutex);
+				group->done.notify_all();
+			}
+		});
+	}
+
+	// Help the workers until all the calls have finished. The wait has a
+	// timeout so that the thread also runs the tasks which the running
+	// calls queue in the meantime.
+	while(group->nbRemainings.load() > 0u) {
+		if(runPendingTask_()) continue;
+
+		std::unique_lock<std::mutex> lock(group->mutex);
+		group->done.wait_for(
+			lock, std::chrono::microseconds(100),
+			[&]() { return group->nbRemainings.load() == 0u; }
+		);
+	}
+
+	if(group->error) std::rethrow_exception(group->error);
+}
+
+} // namespace cla
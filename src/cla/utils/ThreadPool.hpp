@@ -0,0 +1,115 @@
+// ThreadPool.hpp
+
+/**
+ * @file
+ * Definitions for the ThreadPool class in C++
+ */
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cla {
+
+/**
+ * ThreadPool implementation in C++.
+ *
+ * @b Description
+ * The ThreadPool is a work-stealing thread pool. Each worker has its own
+ * task queue; a worker takes the newest task of its own queue and, when
+ * the queue is empty, steals the oldest task of another worker. The thread
+ * waiting for a parallelFor also runs the queued tasks, so the pool can be
+ * used from inside its own tasks without a deadlock.
+ */
+class ThreadPool {
+
+public:
+
+	using Task = std::function<void()>;
+
+private:
+
+	struct Worker {
+		std::deque<Task> tasks;
+		std::mutex mutex;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers_;
+	std::vector<std::thread> threads_;
+
+	std::mutex wakeMutex_;
+	std::condition_variable wake_;
+	std::atomic<std::size_t> nbPendings_;
+	std::atomic<std::size_t> nextWorker_;
+	bool stop_;
+
+private:
+
+	void push_(Task task);
+
+	const bool pop_(const std::size_t index, Task& task);
+
+	const bool runPendingTask_();
+
+	void run_(const std::size_t index);
+
+	void pin_(const std::size_t index);
+
+public:
+
+	/**
+	 * ThreadPool constructor.
+	 *
+	 * @param nbThreads The number of the worker threads. If the number is
+	 * zero, the number of the hardware threads is used.
+	 * @param pinThreads The boolean value whether each worker is pinned to
+	 * one core (worker i to core i modulo the number of cores). Pinning is
+	 * supported on Linux and ignored on the other platforms.
+	 */
+	ThreadPool(const std::size_t nbThreads = 0u, const bool pinThreads = false);
+
+	/**
+	 * ThreadPool destructor. The queued tasks are finished before the
+	 * workers stop.
+	 */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * Get the number of the worker threads.
+	 *
+	 * @return const std::size_t The number of the worker threads.
+	 */
+	const std::size_t size() const;
+
+	/**
+	 * Run func(0), ..., func(nbTasks - 1) on the pool and wait for all of
+	 * them. If some calls throw, the first exception is rethrown after all
+	 * the calls have finished.
+	 *
+	 * @param nbTasks The number of the calls.
+	 * @param func The function called with the index of each call.
+	 */
+	void parallelFor(
+		const std::size_t nbTasks,
+		const std::function<void(const std::size_t)>& func
+	);
+};
+
+using PThreadPool = std::shared_ptr<ThreadPool>;
+
+
+} // namespace cla
+
+#endif // THREAD_POOL_HPP
@@ -31,6 +31,111 @@ using std::string;
 using std::vector;
 using namespace htm;
 
+void SegmentRelations::clear() {
+  // Only the entries of the last build are set, reset them instead of
+  // the whole lookup table.
+  for (const auto segment : rows_) {
+    rowForSegment_[segment] = npos;
+  }
+  rows_.clear();
+  offsets_.clear();
+  cells_.clear();
+  pairs_.clear();
+  built_ = true;
+}
+
+void SegmentRelations::remap(const vector<Segment> &segmentMap) {
+  for (const auto segment : rows_) {
+    rowForSegment_[segment] = npos;
+  }
+  rows_.clear();
+  offsets_.clear();
+  cells_.clear();
+
+  size_t size = 0u;
+  for (const auto &pair : pairs_) {
+    const Segment segment = segmentMap[pair.first];
+    if (segment == ConnectionsRemap::removed) continue;
+    pairs_[size++] = {segment, pair.second};
+  }
+  pairs_.resize(size);
+  built_ = pairs_.empty();
+}
+
+void SegmentRelations::build_() const {
+  for (const auto segment : rows_) {
+    rowForSegment_[segment] = npos;
+  }
+  rows_.clear();
+  offsets_.clear();
+
+  // Count the cells for each segment, rows keep the first record order.
+  for (const auto &pair : pairs_) {
+    const Segment segment = pair.first;
+    if (segment >= rowForSegment_.size()) {
+      rowForSegment_.resize(static_cast<size_t>(segment) + 1u, npos);
+    }
+    UInt32 &row = rowForSegment_[segment];
+    if (row == npos) {
+      row = static_cast<UInt32>(rows_.size());
+      rows_.push_back(segment);
+      offsets_.push_back(0u);
+    }
+    ++offsets_[row];
+  }
+
+  // Exclusive prefix sum, offsets_[row] becomes the insert position.
+  UInt32 sum = 0u;
+  for (auto &offset : offsets_) {
+    const UInt32 num = offset;
+    offset = sum;
+    sum += num;
+  }
+  offsets_.push_back(sum);
+
+  cells_.resize(pairs_.size());
+  for (const auto &pair : pairs_) {
+    cells_[offsets_[rowForSegment_[pair.first]]++] = pair.second;
+  }
+
+  // The insert positions moved to the end of each row, shift them back.
+  for (size_t row = offsets_.size() - 1u; row > 0u; row--) {
+    offsets_[row] = offsets_[row - 1u];
+  }
+  offsets_[0] = 0u;
+
+  built_ = true;
+}
+
+size_t SegmentRelations::count(const Segment segment) const {
+  if (not built_) build_();
+  return (segment < rowForSegment_.size() and
+          rowForSegment_[segment] != npos) ? 1u : 0u;
+}
+
+SegmentRelations::Cells SegmentRelations::at(const Segment segment) const {
+  NTA_CHECK(count(segment) > 0u) << "Segment " << segment
+                                 << " has no relations.";
+  return cells(rowForSegment_[segment]);
+}
+
+size_t SegmentRelations::size() const {
+  if (not built_) build_();
+  return rows_.size();
+}
+
+const vector<Segment> &SegmentRelations::segments() const {
+  if (not built_) build_();
+  return rows_;
+}
+
+SegmentRelations::Cells SegmentRelations::cells(const size_t row) const {
+  if (not built_) build_();
+  NTA_ASSERT(row < rows_.size());
+  return Cells(cells_.data() + offsets_[row], cells_.data() + offsets_[row + 1u]);
+}
+
+
 Connections::Connections(const CellIdx numCells, 
 		         const Permanence connectedThreshold, 
 			 const bool timeseries) {
@@ -45,7 +150,15 @@ void Connections::initialize(CellIdx numCells, Permanence connectedThreshold, bo
   connectedSynapsesForPresynapticCell_.clear();
   potentialSegmentsForPresynapticCell_.clear();
   connectedSegmentsForPresynapticCell_.clear();
+  pendingSegments_.clear();
+  freeSegments_.clear();
+  pendingSynapses_.clear();
+  freeSynapses_.clear();
+  destroyedSegments_ = 0;
+  destroyedSynapses_ = 0;
   eventHandlers_.clear();
+  eventLog_.clear();
+  updateHandlers_();
   NTA_CHECK(connectedThreshold >= minPermanence);
   NTA_CHECK(connectedThreshold <= maxPermanence);
   connectedThreshold_ = connectedThreshold - htm::Epsilon;
@@ -60,12 +173,49 @@ void Connections::initialize(CellIdx numCells, Permanence connectedThreshold, bo
 UInt32 Connections::subscribe(ConnectionsEventHandler *handler) {
   UInt32 token = nextEventToken_++;
   eventHandlers_[token] = handler;
+  updateHandlers_();
   return token;
 }
 
 void Connections::unsubscribe(UInt32 token) {
+  flushEvents();
   delete eventHandlers_.at(token);
   eventHandlers_.erase(token);
+  updateHandlers_();
+}
+
+void Connections::updateHandlers_() {
+  immediateHandlers_.clear();
+  batchedHandlers_.clear();
+  for (auto h : eventHandlers_) {
+    if( h.second->isBatched() )
+      batchedHandlers_.push_back(h.second);
+    else
+      immediateHandlers_.push_back(h.second);
+  }
+}
+
+void Connections::flushEvents() {
+  if( eventLog_.empty() ) return;
+  for (auto h : batchedHandlers_) {
+    h->onEvents(eventLog_);
+  }
+  eventLog_.clear();
+}
+
+void ConnectionsEventHandler::onEvents(const vector<ConnectionsEventRecord> &events) {
+  using Type = ConnectionsEventRecord::Type;
+  for( const auto &event : events ) {
+    switch( event.type ) {
+      case Type::CREATE_SEGMENT:  onCreateSegment(event.index);  break;
+      case Type::DESTROY_SEGMENT: onDestroySegment(event.index); break;
+      case Type::CREATE_SYNAPSE:  onCreateSynapse(event.index);  break;
+      case Type::DESTROY_SYNAPSE: onDestroySynapse(event.index); break;
+      case Type::UPDATE_SYNAPSE_PERMANENCE:
+        onUpdateSynapsePermanence(event.index, event.permanence);
+        break;
+    }
+  }
 }
 
 Segment Connections::createSegment(const CellIdx cell, 
@@ -77,7 +227,9 @@ Segment Connections::createSegment(const CellIdx cell,
     const auto& destroyCandidates = segmentsForCell(cell);
     const auto compareSegmentsByLRU = [&](const Segment a, const Segment b) {
 	if(dataForSegment(a).lastUsed == dataForSegment(b).lastUsed) {
-	  return a < b; //needed for deterministic sort
+	  //needed for deterministic sort, independent of the reused slots
+	  if(dataForSegment(a).id == dataForSegment(b).id) return a < b;
+	  return dataForSegment(a).id < dataForSegment(b).id;
         } 
 	else return dataForSegment(a).lastUsed < dataForSegment(b).lastUsed; //sort segments by access time
       };
@@ -87,19 +239,29 @@ Segment Connections::createSegment(const CellIdx cell,
     destroySegment(*leastRecentlyUsedSegment);
   }
 
-  //proceed to create a new segment
-  NTA_CHECK(segments_.size() < std::numeric_limits<Segment>::max()) << "Add segment failed: Range of Segment (data-type) insufficinet size."
-	    << (size_t)segments_.size() << " < " << (size_t)std::numeric_limits<Segment>::max();
-  const Segment segment = static_cast<Segment>(segments_.size());
+  //proceed to create a new segment, in a destroyed slot if there is one
   const SegmentData& segmentData = SegmentData(cell, iteration_, nextSegmentOrdinal_++);
-  segments_.push_back(segmentData);
+  Segment segment;
+  if( !freeSegments_.empty() ) {
+    segment = freeSegments_.back();
+    freeSegments_.pop_back();
+    segments_[segment] = segmentData;
+    destroyedSegments_--;
+  }
+  else {
+    NTA_CHECK(segments_.size() < std::numeric_limits<Segment>::max()) << "Add segment failed: Range of Segment (data-type) insufficinet size."
+	      << (size_t)segments_.size() << " < " << (size_t)std::numeric_limits<Segment>::max();
+    segment = static_cast<Segment>(segments_.size());
+    segments_.push_back(segmentData);
+  }
 
   CellData &cellData = cells_[cell];
   cellData.segments.push_back(segment); //assign the new segment to its mother-cell
 
-  for (auto h : eventHandlers_) {
-    h.second->onCreateSegment(segment);
+  for (auto h : immediateHandlers_) {
+    h->onCreateSegment(segment);
   }
+  logEvent_(ConnectionsEventRecord::Type::CREATE_SEGMENT, segment);
 
   return segment;
 }
@@ -126,13 +288,108 @@ Synapse Connections::createSynapse(Segment segment,
     }
   } //else: the new synapse is not duplicit, so keep creating it. 
 
+  reservePresynapticCell_(presynapticCell);
+  const Synapse synapse = addSynapse_(segment, presynapticCell);
+
+  for (auto h : immediateHandlers_) {
+    h->onCreateSynapse(synapse);
+  }
+  logEvent_(ConnectionsEventRecord::Type::CREATE_SYNAPSE, synapse);
+
+  updateSynapsePermanence(synapse, permanence);
+
+  return synapse;
+}
+
+void Connections::createSynapses(const Segment segment,
+                                 const vector<CellIdx> &presynapticCells,
+                                 const Permanence permanence) {
+  createSynapses_(segment, presynapticCells,
+                  [&](const size_t) { return permanence; });
+}
+
+void Connections::createSynapses(const Segment segment,
+                                 const vector<CellIdx> &presynapticCells,
+                                 const vector<Permanence> &permanences) {
+  NTA_CHECK(presynapticCells.size() == permanences.size());
+  createSynapses_(segment, presynapticCells,
+                  [&](const size_t i) { return permanences[i]; });
+}
+
+template<typename PermanenceAt>
+void Connections::createSynapses_(const Segment segment,
+                                  const vector<CellIdx> &presynapticCells,
+                                  const PermanenceAt &permanenceAt) {
+  if( presynapticCells.empty() ) return;
+
+  // The cells already synapsed on by the segment are skipped, as in
+  // createSynapse.
+  SegmentData &segmentData = segments_[segment];
+  existingCells_.clear();
+  for( const auto syn : segmentData.synapses )
+    existingCells_.push_back(synapses_[syn].presynapticCell);
+  std::sort(existingCells_.begin(), existingCells_.end());
+
+  // Reserve for the whole batch, keeping the geometric growth of the
+  // vectors, as an exact reserve on each call would reallocate each time.
+  const auto reserveFor = [](auto &vec, const size_t size) {
+    if( size > vec.capacity() )
+      vec.reserve(std::max(size, 2 * vec.capacity()));
+  };
+  const size_t numNew = presynapticCells.size();
+  reserveFor(segmentData.synapses, segmentData.synapses.size() + numNew);
+  if( freeSynapses_.size() < numNew )
+    reserveFor(synapses_, synapses_.size() + numNew - freeSynapses_.size());
+  reservePresynapticCell_(
+    *std::max_element(presynapticCells.begin(), presynapticCells.end()));
+
+  createdSynapses_.clear();
+  createdPermanences_.clear();
+  for( size_t i = 0; i < numNew; i++ ) {
+    const CellIdx presynapticCell = presynapticCells[i];
+    if( std::binary_search(existingCells_.begin(), existingCells_.end(),
+                           presynapticCell) )
+      continue;
+
+    createdSynapses_.push_back(addSynapse_(segment, presynapticCell));
+    createdPermanences_.push_back(permanenceAt(i));
+  }
+
+  for (auto h : immediateHandlers_) {
+    h->onCreateSynapses(createdSynapses_);
+  }
+  for( const auto synapse : createdSynapses_ ) {
+    logEvent_(ConnectionsEventRecord::Type::CREATE_SYNAPSE, synapse);
+  }
 
+  for( size_t i = 0; i < createdSynapses_.size(); i++ ) {
+    updateSynapsePermanence(createdSynapses_[i], createdPermanences_[i]);
+  }
+}
 
+Synapse Connections::addSynapse_(const Segment segment,
+                                  const CellIdx presynapticCell) {
   // Get an index into the synapses_ list, for the new synapse to reside at.
-  NTA_ASSERT(synapses_.size() < std::numeric_limits<Synapse>::max()) << "Add synapse failed: Range of Synapse (data-type) insufficient size."
-	    << synapses_.size() << " < " << (size_t)std::numeric_limits<Synapse>::max();
-  const Synapse synapse = static_cast<Synapse>(synapses_.size()); //TODO work on cache locality. Have all Synapse, SynapseData on Segment in continuous mem block ?
-  synapses_.emplace_back(SynapseData());
+  // A destroyed slot is reused first.
+  Synapse synapse;
+  if( !freeSynapses_.empty() ) {
+    synapse = freeSynapses_.back();
+    freeSynapses_.pop_back();
+    synapses_[synapse] = SynapseData();
+    destroyedSynapses_--;
+
+    // The slot starts with no update, as a new slot would.
+    if( synapse < previousUpdates_.size() ) {
+      previousUpdates_[synapse] = minPermanence;
+      currentUpdates_[synapse]  = minPermanence;
+    }
+  }
+  else {
+    NTA_ASSERT(synapses_.size() < std::numeric_limits<Synapse>::max()) << "Add synapse failed: Range of Synapse (data-type) insufficient size."
+	      << synapses_.size() << " < " << (size_t)std::numeric_limits<Synapse>::max();
+    synapse = static_cast<Synapse>(synapses_.size()); //TODO work on cache locality. Have all Synapse, SynapseData on Segment in continuous mem block ?
+    synapses_.emplace_back(SynapseData());
+  }
 
   // Fill in the new synapse's data
   SynapseData &synapseData    = synapses_[synapse];
@@ -149,13 +406,6 @@ Synapse Connections::createSynapse(Segment segment,
   SegmentData &segmentData = segments_[segment];
   segmentData.synapses.push_back(synapse);
 
-
-  for (auto h : eventHandlers_) {
-    h.second->onCreateSynapse(synapse);
-  }
-
-  updateSynapsePermanence(synapse, permanence);
-
   return synapse;
 }
 
@@ -197,16 +447,34 @@ void Connections::removeSynapseFromPresynapticMap_(
   preSegments.pop_back();
 }
 
+void Connections::releaseDestroyed_() {
+  freeSegments_.insert(freeSegments_.end(), pendingSegments_.cbegin(), pendingSegments_.cend());
+  pendingSegments_.clear();
+  freeSynapses_.insert(freeSynapses_.end(), pendingSynapses_.cbegin(), pendingSynapses_.cend());
+  pendingSynapses_.clear();
+}
+
+void Connections::reservePresynapticCell_(const CellIdx presynapticCell) {
+  if( presynapticCell < potentialSynapsesForPresynapticCell_.size() )
+    return;
+
+  const size_t size = static_cast<size_t>(presynapticCell) + 1u;
+  potentialSynapsesForPresynapticCell_.resize( size );
+  connectedSynapsesForPresynapticCell_.resize( size );
+  potentialSegmentsForPresynapticCell_.resize( size );
+  connectedSegmentsForPresynapticCell_.resize( size );
+}
+
 const Relations<CellIdx, CellIdx> Connections::convertToCellsRelations_(
-    const Relations<Segment, CellIdx> relations
+    const SegmentRelations& relations
 ) const {
 	Relations<CellIdx, CellIdx> cellRelations;
+	const auto& segments = relations.segments();
 
-	for(const auto& relation : relations) {
-		const Segment seg = relation.first;
-		const auto& cells = relation.second;
+	for(size_t row = 0; row < segments.size(); row++) {
+		const auto cells = relations.cells(row);
 
-		auto& cellsForPCell = cellRelations[cellForSegment(relation.first)];
+		auto& cellsForPCell = cellRelations[cellForSegment(segments[row])];
 		cellsForPCell.insert(cellsForPCell.end(), cells.begin(), cells.end());
 	}
 
@@ -216,9 +484,10 @@ const Relations<CellIdx, CellIdx> Connections::convertToCellsRelations_(
 
 void Connections::destroySegment(const Segment segment) {
   NTA_ASSERT(segmentExists_(segment));
-  for (auto h : eventHandlers_) {
-    h.second->onDestroySegment(segment);
+  for (auto h : immediateHandlers_) {
+    h->onDestroySegment(segment);
   }
+  logEvent_(ConnectionsEventRecord::Type::DESTROY_SEGMENT, segment);
 
   SegmentData &segmentData = segments_[segment];
 
@@ -234,15 +503,17 @@ void Connections::destroySegment(const Segment segment) {
   NTA_ASSERT(*segmentOnCell == segment);
 
   cellData.segments.erase(segmentOnCell);
+  pendingSegments_.push_back(segment);
   destroyedSegments_++;
 }
 
 
 void Connections::destroySynapse(const Synapse synapse) {
   NTA_ASSERT(synapseExists_(synapse));
-  for (auto h : eventHandlers_) {
-    h.second->onDestroySynapse(synapse);
+  for (auto h : immediateHandlers_) {
+    h->onDestroySynapse(synapse);
   }
+  logEvent_(ConnectionsEventRecord::Type::DESTROY_SYNAPSE, synapse);
 
   const SynapseData &synapseData = synapses_[synapse];
         SegmentData &segmentData = segments_[synapseData.segment];
@@ -253,24 +524,14 @@ void Connections::destroySynapse(const Synapse synapse) {
 
     removeSynapseFromPresynapticMap_(
       synapseData.presynapticMapIndex_,
-      connectedSynapsesForPresynapticCell_.at( presynCell ),
-      connectedSegmentsForPresynapticCell_.at( presynCell ));
-
-    if( connectedSynapsesForPresynapticCell_.at( presynCell ).empty() ){
-      connectedSynapsesForPresynapticCell_.erase( presynCell );
-      connectedSegmentsForPresynapticCell_.erase( presynCell );
-    }
+      connectedSynapsesForPresynapticCell_[ presynCell ],
+      connectedSegmentsForPresynapticCell_[ presynCell ]);
   }
   else {
     removeSynapseFromPresynapticMap_(
       synapseData.presynapticMapIndex_,
-      potentialSynapsesForPresynapticCell_.at( presynCell ),
-      potentialSegmentsForPresynapticCell_.at( presynCell ));
-
-    if( potentialSynapsesForPresynapticCell_.at( presynCell ).empty() ){
-      potentialSynapsesForPresynapticCell_.erase( presynCell );
-      potentialSegmentsForPresynapticCell_.erase( presynCell );
-    }
+      potentialSynapsesForPresynapticCell_[ presynCell ],
+      potentialSegmentsForPresynapticCell_[ presynCell ]);
   }
 
   const auto synapseOnSegment =
@@ -284,6 +545,7 @@ void Connections::destroySynapse(const Synapse synapse) {
   NTA_ASSERT(*synapseOnSegment == synapse);
 
   segmentData.synapses.erase(synapseOnSegment);
+  pendingSynapses_.push_back(synapse);
   destroyedSynapses_++;
 }
 
@@ -337,9 +599,11 @@ void Connections::updateSynapsePermanence(const Synapse synapse,
       potentialPreseg.push_back( segment );
     }
 
-    for (auto h : eventHandlers_) { //TODO handle callbacks in performance-critical method only in Debug?
-      h.second->onUpdateSynapsePermanence(synapse, permanence);
+    for (auto h : immediateHandlers_) {
+      h->onUpdateSynapsePermanence(synapse, permanence);
     }
+    logEvent_(ConnectionsEventRecord::Type::UPDATE_SYNAPSE_PERMANENCE,
+              synapse, permanence);
 }
 
 
@@ -365,15 +629,14 @@ bool Connections::compareSegments(const Segment a, const Segment b) const {
 vector<Synapse> Connections::synapsesForPresynapticCell(const CellIdx presynapticCell) const {
   vector<Synapse> all;
 
-  if (potentialSynapsesForPresynapticCell_.count(presynapticCell)) {
-    const auto& potential = potentialSynapsesForPresynapticCell_.at(presynapticCell);
-    all.assign(potential.cbegin(), potential.cend());
-  }
+  if (presynapticCell >= potentialSynapsesForPresynapticCell_.size())
+    return all;
 
-  if (connectedSynapsesForPresynapticCell_.count(presynapticCell)) {
-    const auto& connected = connectedSynapsesForPresynapticCell_.at(presynapticCell);
-    all.insert( all.cend(), connected.cbegin(), connected.cend());
-  }
+  const auto& potential = potentialSynapsesForPresynapticCell_[presynapticCell];
+  all.assign(potential.cbegin(), potential.cend());
+
+  const auto& connected = connectedSynapsesForPresynapticCell_[presynapticCell];
+  all.insert( all.cend(), connected.cbegin(), connected.cend());
 
   return all;
 }
@@ -390,11 +653,13 @@ void Connections::reset()
 
 vector<SynapseIdx> Connections::computeActivity(const vector<CellIdx> &activePresynapticCells, const bool learn) {
 
-  vector<SynapseIdx> numActiveConnectedSynapsesForSegment(segments_.size(), 0);
+  vector<SynapseIdx> numActiveConnectedSynapsesForSegment;
   if(learn) iteration_++;
+  flushEvents();
 
-  activeRelations_.clear();
-  matchingRelations_.clear();
+  // The segments of the previous step are dropped by the caller now, so
+  // the slots destroyed since then can be reused.
+  releaseDestroyed_();
 
   if( timeseries_ ) {
     // Before each cycle of computation move the currentUpdates to the previous
@@ -403,15 +668,11 @@ vector<SynapseIdx> Connections::computeActivity(const vector<CellIdx> &activePre
     currentUpdates_.clear();
   }
 
-  // Iterate through all connected synapses.
-  for (const auto& cell : activePresynapticCells) {
-    if (connectedSegmentsForPresynapticCell_.count(cell)) {
-      for(const auto& segment : connectedSegmentsForPresynapticCell_.at(cell)) {
-        ++numActiveConnectedSynapsesForSegment[segment];
-        activeRelations_[segment].emplace_back(cell);
-      }
-    }
-  }
+  computeActivity(activePresynapticCells, numActiveConnectedSynapsesForSegment,
+                  activeSegmentsTouched_, activeRelations_);
+  matchingRelations_.clear();
+  matchingSegmentsTouched_.clear();
+
   return numActiveConnectedSynapsesForSegment;
 }
 
@@ -430,16 +691,108 @@ vector<SynapseIdx> Connections::computeActivity(
   std::copy( numActiveConnectedSynapsesForSegment.begin(),
              numActiveConnectedSynapsesForSegment.end(),
              numActivePotentialSynapsesForSegment.begin());
+  matchingSegmentsTouched_ = activeSegmentsTouched_;
+
+  computePotentialActivity_(activePresynapticCells,
+                            numActivePotentialSynapsesForSegment,
+                            matchingSegmentsTouched_, matchingRelations_);
+  return numActiveConnectedSynapsesForSegment;
+}
+
+
+namespace {
+
+// Count the active synapses of the segments reached from the active
+// cells. The relations are visited only when the sink records them.
+template<bool recordRelations>
+void accumulateActivity(
+    const vector<CellIdx> &activePresynapticCells,
+    const vector<vector<Segment>> &segmentsForPresynapticCell,
+    vector<SynapseIdx> &numActiveSynapsesForSegment,
+    vector<Segment> &segmentsTouched,
+    SegmentRelations &relations) {
+
+  const auto numPresynapticCells = segmentsForPresynapticCell.size();
 
   for (const auto& cell : activePresynapticCells) {
-    if (potentialSegmentsForPresynapticCell_.count(cell)) {
-      for(const auto& segment : potentialSegmentsForPresynapticCell_.at(cell)) {
-        ++numActivePotentialSynapsesForSegment[segment];
-        matchingRelations_[segment].emplace_back(cell);
+    if (cell >= numPresynapticCells) continue;
+
+    for(const auto& segment : segmentsForPresynapticCell[cell]) {
+      if(numActiveSynapsesForSegment[segment]++ == 0) {
+        segmentsTouched.push_back(segment);
       }
+      if(recordRelations) relations.record(segment, cell);
     }
   }
-  return numActiveConnectedSynapsesForSegment;
+}
+
+void accumulateActivity(
+    const vector<CellIdx> &activePresynapticCells,
+    const vector<vector<Segment>> &segmentsForPresynapticCell,
+    vector<SynapseIdx> &numActiveSynapsesForSegment,
+    vector<Segment> &segmentsTouched,
+    SegmentRelations &relations) {
+
+  if(relations.isEnabled()) {
+    accumulateActivity<true>(activePresynapticCells, segmentsForPresynapticCell,
+                             numActiveSynapsesForSegment, segmentsTouched, relations);
+  } else {
+    accumulateActivity<false>(activePresynapticCells, segmentsForPresynapticCell,
+                              numActiveSynapsesForSegment, segmentsTouched, relations);
+  }
+}
+
+} // namespace
+
+
+void Connections::computeActivity(
+    const vector<CellIdx> &activePresynapticCells,
+    vector<SynapseIdx> &numActiveConnectedSynapsesForSegment,
+    vector<Segment> &activeSegmentsTouched,
+    SegmentRelations &activeRelations) const {
+
+  numActiveConnectedSynapsesForSegment.assign(segments_.size(), 0);
+  activeSegmentsTouched.clear();
+  activeRelations.clear();
+
+  // Iterate through all connected synapses.
+  accumulateActivity(activePresynapticCells, connectedSegmentsForPresynapticCell_,
+                     numActiveConnectedSynapsesForSegment, activeSegmentsTouched,
+                     activeRelations);
+}
+
+
+void Connections::computeActivity(
+    const vector<CellIdx> &activePresynapticCells,
+    vector<SynapseIdx> &numActiveConnectedSynapsesForSegment,
+    vector<SynapseIdx> &numActivePotentialSynapsesForSegment,
+    vector<Segment> &activeSegmentsTouched,
+    vector<Segment> &matchingSegmentsTouched,
+    SegmentRelations &activeRelations,
+    SegmentRelations &matchingRelations) const {
+
+  computeActivity(activePresynapticCells, numActiveConnectedSynapsesForSegment,
+                  activeSegmentsTouched, activeRelations);
+
+  numActivePotentialSynapsesForSegment = numActiveConnectedSynapsesForSegment;
+  matchingSegmentsTouched = activeSegmentsTouched;
+  matchingRelations.clear();
+
+  computePotentialActivity_(activePresynapticCells,
+                            numActivePotentialSynapsesForSegment,
+                            matchingSegmentsTouched, matchingRelations);
+}
+
+
+void Connections::computePotentialActivity_(
+    const vector<CellIdx> &activePresynapticCells,
+    vector<SynapseIdx> &numActivePotentialSynapsesForSegment,
+    vector<Segment> &matchingSegmentsTouched,
+    SegmentRelations &matchingRelations) const {
+
+  accumulateActivity(activePresynapticCells, potentialSegmentsForPresynapticCell_,
+                     numActivePotentialSynapsesForSegment, matchingSegmentsTouched,
+                     matchingRelations);
 }
 
 
@@ -450,7 +803,31 @@ void Connections::adaptSegment(const Segment segment,
 			       const bool pruneZeroSynapses)
 {
   const auto &inputArray = inputs.getDense();
+  adaptSegment_(segment,
+                [&](const CellIdx cell) { return inputArray[cell] != 0u; },
+                increment, decrement, pruneZeroSynapses);
+}
+
+
+void Connections::adaptSegment(const Segment segment,
+                               const Bitset &inputs,
+                               const Permanence increment,
+                               const Permanence decrement,
+                               const bool pruneZeroSynapses)
+{
+  adaptSegment_(segment,
+                [&](const CellIdx cell) { return inputs.contains(cell); },
+                increment, decrement, pruneZeroSynapses);
+}
 
+
+template<typename IsActive>
+void Connections::adaptSegment_(const Segment segment,
+                                const IsActive &isActive,
+                                const Permanence increment,
+                                const Permanence decrement,
+                                const bool pruneZeroSynapses)
+{
   if( timeseries_ ) {
     previousUpdates_.resize( synapses_.size(), minPermanence );
     currentUpdates_.resize(  synapses_.size(), minPermanence );
@@ -462,7 +839,7 @@ void Connections::adaptSegment(const Segment segment,
       const SynapseData &synapseData = dataForSynapse(synapse);
 
       Permanence update;
-      if( inputArray[synapseData.presynapticCell] ) {
+      if( isActive(synapseData.presynapticCell) ) {
         update = increment;
       } else {
         update = -decrement;
@@ -494,6 +871,7 @@ void Connections::adaptSegment(const Segment segment,
     destroySegment(segment);
     prunedSegs_++; //statistics
   }
+  flushEvents();
 }
 
 
@@ -635,7 +1013,7 @@ void Connections::destroyMinPermanenceSynapses(
     const Permanence A_perm = dataForSynapse(A).permanence;
     const Permanence B_perm = dataForSynapse(B).permanence;
     if( A_perm == B_perm ) {
-      return A < B;
+      return dataForSynapse(A).id < dataForSynapse(B).id; //creation order, independent of the reused slots
     }
     else {
       return A_perm < B_perm;
@@ -650,6 +1028,103 @@ void Connections::destroyMinPermanenceSynapses(
 }
 
 
+ConnectionsRemap Connections::compact() {
+  flushEvents();
+  ConnectionsRemap remap;
+  remap.segments.assign(segments_.size(), ConnectionsRemap::removed);
+  remap.synapses.assign(synapses_.size(), ConnectionsRemap::removed);
+
+  // Mark the destroyed slots, then number the live ones in order.
+  releaseDestroyed_();
+  for( const auto segment : freeSegments_ ) remap.segments[segment] = 0;
+  for( const auto synapse : freeSynapses_ ) remap.synapses[synapse] = 0;
+
+  Segment numSegments = 0;
+  for( auto &segment : remap.segments ) {
+    segment = (segment == ConnectionsRemap::removed) ? numSegments++ : ConnectionsRemap::removed;
+  }
+  Synapse numSynapses = 0;
+  for( auto &synapse : remap.synapses ) {
+    synapse = (synapse == ConnectionsRemap::removed) ? numSynapses++ : ConnectionsRemap::removed;
+  }
+
+  // Move the live data down to their new slots. The new slot is never
+  // after the old one, so this is done in place.
+  for( Segment segment = 0; segment < segments_.size(); segment++ ) {
+    const Segment newSegment = remap.segments[segment];
+    if( newSegment == ConnectionsRemap::removed ) continue;
+
+    SegmentData &segmentData = segments_[segment];
+    for( auto &synapse : segmentData.synapses ) synapse = remap.synapses[synapse];
+    if( newSegment != segment ) segments_[newSegment] = std::move(segmentData);
+  }
+  segments_.erase(segments_.begin() + numSegments, segments_.end());
+
+  const bool hasUpdates = !previousUpdates_.empty();
+  for( Synapse synapse = 0; synapse < synapses_.size(); synapse++ ) {
+    const Synapse newSynapse = remap.synapses[synapse];
+    if( newSynapse == ConnectionsRemap::removed ) continue;
+
+    SynapseData &synapseData = synapses_[synapse];
+    synapseData.segment = remap.segments[synapseData.segment];
+    synapses_[newSynapse] = synapseData;
+
+    if( hasUpdates and synapse < previousUpdates_.size() ) {
+      previousUpdates_[newSynapse] = previousUpdates_[synapse];
+      currentUpdates_[newSynapse]  = currentUpdates_[synapse];
+    }
+  }
+  synapses_.resize(numSynapses);
+  if( hasUpdates ) {
+    previousUpdates_.resize( std::min(previousUpdates_.size(), synapses_.size()) );
+    currentUpdates_.resize(  std::min(currentUpdates_.size(),  synapses_.size()) );
+  }
+
+  for( auto &cellData : cells_ ) {
+    for( auto &segment : cellData.segments ) segment = remap.segments[segment];
+  }
+
+  // The presynaptic rows keep their order, so presynapticMapIndex_ holds.
+  for( auto &synapses : potentialSynapsesForPresynapticCell_ ) {
+    for( auto &synapse : synapses ) synapse = remap.synapses[synapse];
+  }
+  for( auto &synapses : connectedSynapsesForPresynapticCell_ ) {
+    for( auto &synapse : synapses ) synapse = remap.synapses[synapse];
+  }
+  for( auto &segments : potentialSegmentsForPresynapticCell_ ) {
+    for( auto &segment : segments ) segment = remap.segments[segment];
+  }
+  for( auto &segments : connectedSegmentsForPresynapticCell_ ) {
+    for( auto &segment : segments ) segment = remap.segments[segment];
+  }
+
+  // The activity of the last computeActivity.
+  const auto remapSegments = [&](vector<Segment> &segments) {
+    size_t size = 0u;
+    for( const auto segment : segments ) {
+      if( remap.segments[segment] != ConnectionsRemap::removed )
+        segments[size++] = remap.segments[segment];
+    }
+    segments.resize(size);
+  };
+  remapSegments(activeSegmentsTouched_);
+  remapSegments(matchingSegmentsTouched_);
+  activeRelations_.remap(remap.segments);
+  matchingRelations_.remap(remap.segments);
+
+  freeSegments_.clear();
+  freeSynapses_.clear();
+  destroyedSegments_ = 0;
+  destroyedSynapses_ = 0;
+
+  for (auto h : eventHandlers_) {
+    h.second->onCompact(remap);
+  }
+
+  return remap;
+}
+
+
 namespace htm {
 /**
  * print statistics in human readable form
@@ -657,7 +1132,10 @@ namespace htm {
 std::ostream& operator<< (std::ostream& stream, const Connections& self)
 {
   stream << "Connections:" << std::endl;
-  const auto numPresyns = self.potentialSynapsesForPresynapticCell_.size();
+  const auto numPresyns = std::count_if(
+      self.potentialSynapsesForPresynapticCell_.cbegin(),
+      self.potentialSynapsesForPresynapticCell_.cend(),
+      [](const vector<Synapse> &synapses) { return not synapses.empty(); });
   stream << "    Inputs (" << numPresyns
          << ") ~> Outputs (" << self.cells_.size()
          << ") via Segments (" << self.numSegments() << ")" << std::endl;
@@ -26,6 +26,7 @@
 #include <map>
 #include <unordered_map>
 #include <set>
+#include <tuple>
 #include <utility>
 #include <vector>
 #include <deque>
@@ -33,6 +34,7 @@
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Sdr.hpp>
+#include <htm/utils/Bitset.hpp>
 
 namespace htm {
 
@@ -50,6 +52,164 @@ template<typename Idx, typename Value>
 using Relations = std::unordered_map<Idx, std::vector<Value>>;
 
 
+/**
+ * SegmentRelations class used in Connections.
+ *
+ * @b Description
+ * The SegmentRelations holds the relations between segments and the
+ * active presynaptic cells of one computeActivity call in a flat layout.
+ * While computing the activity only (segment, cell) pairs are appended to
+ * a buffer which is reused across steps. The CSR form (one offset per
+ * segment and one contiguous cell buffer) is built on the first query,
+ * so a layer which never reads the relations does not pay for it.
+ *
+ * Recording can be disabled. A disabled sink stays empty, and
+ * computeActivity does not visit it at all, so a caller which never
+ * reads the relations pays nothing per synapse. The sinks owned by
+ * Connections are disabled until setRecordRelations(true).
+ *
+ * The query functions mirror Relations<Segment, CellIdx>: count(segment)
+ * and at(segment), plus a row based access for iterating all segments.
+ */
+class SegmentRelations {
+public:
+  /**
+   * Read only range of the cells related to one segment.
+   */
+  class Cells {
+  public:
+    Cells(const CellIdx *first, const CellIdx *last)
+        : first_(first), last_(last) {}
+
+    const CellIdx *begin() const { return first_; }
+    const CellIdx *end() const { return last_; }
+    size_t size() const { return static_cast<size_t>(last_ - first_); }
+    bool empty() const { return first_ == last_; }
+
+  private:
+    const CellIdx *first_;
+    const CellIdx *last_;
+  };
+
+  /**
+   * SegmentRelations constructor.
+   *
+   * @param enabled Whether the relations are recorded.
+   */
+  explicit SegmentRelations(const bool enabled = true) : enabled_(enabled) {}
+
+  /**
+   * Enable or disable the recording. Disabling drops the recorded
+   * relations.
+   */
+  void setEnabled(const bool enabled) {
+    enabled_ = enabled;
+    if( not enabled_ ) clear();
+  }
+
+  /**
+   * @return Whether the relations are recorded.
+   */
+  bool isEnabled() const { return enabled_; }
+
+  /**
+   * Drop the recorded relations. The buffers keep their capacity.
+   */
+  void clear();
+
+  /**
+   * Renumber the recorded segments after Connections::compact. The
+   * relations of the removed segments are dropped.
+   *
+   * @param segmentMap The new segment for each old segment.
+   */
+  void remap(const std::vector<Segment> &segmentMap);
+
+  /**
+   * Record that the cell is related to the segment. A disabled sink
+   * ignores it.
+   */
+  inline void record(const Segment segment, const CellIdx cell) {
+    if( not enabled_ ) return;
+    pairs_.emplace_back(segment, cell);
+    built_ = false;
+  }
+
+  /**
+   * @return 1 if the segment has related cells, otherwise 0.
+   */
+  size_t count(const Segment segment) const;
+
+  /**
+   * @return The cells related to the segment, in the recorded order.
+   * The segment must have related cells.
+   */
+  Cells at(const Segment segment) const;
+
+  /**
+   * @return The number of segments which have related cells.
+   */
+  size_t size() const;
+
+  /**
+   * @return The segments which have related cells, in the order of
+   * their first record. The row index of at(segment) is the position
+   * in this vector.
+   */
+  const std::vector<Segment> &segments() const;
+
+  /**
+   * @return The cells related to the segment on the row.
+   */
+  Cells cells(const size_t row) const;
+
+  /**
+   * Save (serialize) / Load (deserialize) the recorded relations. The CSR
+   * form is rebuilt on the first query after loading.
+   */
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    std::vector<Segment> segments;
+    std::vector<CellIdx> cells;
+    segments.reserve(pairs_.size());
+    cells.reserve(pairs_.size());
+    for( const auto &pair : pairs_ ) {
+      segments.push_back(pair.first);
+      cells.push_back(pair.second);
+    }
+    ar(CEREAL_NVP(segments), CEREAL_NVP(cells));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    std::vector<Segment> segments;
+    std::vector<CellIdx> cells;
+    ar(CEREAL_NVP(segments), CEREAL_NVP(cells));
+    NTA_CHECK(segments.size() == cells.size());
+    clear();
+    if( not enabled_ ) return;
+    for( size_t i = 0; i < segments.size(); i++ )
+      pairs_.emplace_back(segments[i], cells[i]);
+    built_ = false;
+  }
+
+private:
+  static constexpr UInt32 npos = std::numeric_limits<UInt32>::max();
+
+  void build_() const;
+
+  bool enabled_;
+
+  std::vector<std::pair<Segment, CellIdx>> pairs_;
+
+  // CSR form, built lazily from pairs_.
+  mutable bool built_ = true;
+  mutable std::vector<Segment> rows_;
+  mutable std::vector<UInt32> offsets_;
+  mutable std::vector<CellIdx> cells_;
+  mutable std::vector<UInt32> rowForSegment_;
+};
+
+
 
 
 /**
@@ -77,11 +237,14 @@ struct SynapseData: public Serializable {
   template<class Archive>
   void save_ar(Archive & ar) const {
     ar(cereal::make_nvp("perm", permanence),
-      cereal::make_nvp("presyn", presynapticCell));
+      cereal::make_nvp("presyn", presynapticCell),
+      cereal::make_nvp("segment", segment),
+      cereal::make_nvp("presynIdx", presynapticMapIndex_),
+      cereal::make_nvp("id", id));
   }
   template<class Archive>
   void load_ar(Archive & ar) {
-    ar( permanence, presynapticCell);
+    ar( permanence, presynapticCell, segment, presynapticMapIndex_, id);
   }
 
 };
@@ -100,12 +263,23 @@ struct SynapseData: public Serializable {
  */
 struct SegmentData {
   SegmentData(const CellIdx cell, Segment id, UInt32 lastUsed = 0) : cell(cell), numConnected(0), lastUsed(lastUsed), id(id) {} //default constructor
+  SegmentData() : SegmentData(0, 0) {} //for deserialization
 
   std::vector<Synapse> synapses;
   CellIdx cell; //mother cell that this segment originates from
   SynapseIdx numConnected; //number of permanences from `synapses` that are >= synPermConnected, ie connected synapses
   UInt32 lastUsed = 0; //last used time (iteration). Used for segment pruning by "least recently used" (LRU) in `createSegment`
   Segment id; 
+
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    ar(CEREAL_NVP(synapses), CEREAL_NVP(cell), CEREAL_NVP(numConnected),
+       CEREAL_NVP(lastUsed), CEREAL_NVP(id));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    ar(synapses, cell, numConnected, lastUsed, id);
+  }
 };
 
 /**
@@ -121,6 +295,53 @@ struct SegmentData {
  */
 struct CellData {
   std::vector<Segment> segments;
+
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    ar(CEREAL_NVP(segments));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    ar(segments);
+  }
+};
+
+/**
+ * ConnectionsRemap class used in Connections.
+ *
+ * @b Description
+ * The ConnectionsRemap is the renumbering made by Connections::compact.
+ * The vectors are indexed by the old segment (synapse) and hold the new
+ * one, or ConnectionsRemap::removed if the slot was destroyed. The live
+ * segments and synapses keep their relative order.
+ */
+struct ConnectionsRemap {
+  static constexpr UInt32 removed = std::numeric_limits<UInt32>::max();
+
+  std::vector<Segment> segments;
+  std::vector<Synapse> synapses;
+};
+
+/**
+ * ConnectionsEventRecord class used in Connections.
+ *
+ * @b Description
+ * The ConnectionsEventRecord is one entry of the event log that is passed
+ * to the batched event handlers. The index is the segment or the synapse
+ * of the event, and the permanence is set only for the permanence updates.
+ */
+struct ConnectionsEventRecord {
+  enum class Type : unsigned char {
+    CREATE_SEGMENT,
+    DESTROY_SEGMENT,
+    CREATE_SYNAPSE,
+    DESTROY_SYNAPSE,
+    UPDATE_SYNAPSE_PERMANENCE
+  };
+
+  Type type;
+  UInt32 index;
+  Permanence permanence;
 };
 
 /**
@@ -128,11 +349,28 @@ struct CellData {
  *
  * @b Description
  * This acts as a plug-in point for logging / visualizations.
+ *
+ * A handler is called for each event as it happens, or, if isBatched()
+ * returns true, once with the log of the events at Connections::flushEvents.
+ * The events are flushed at the end of adaptSegment, at the beginning of
+ * computeActivity and before compact.
  */
 class ConnectionsEventHandler {
 public:
   virtual ~ConnectionsEventHandler() {}
 
+  /**
+   * Whether the handler takes the events in batches by onEvents. It is
+   * read when the handler is subscribed.
+   */
+  virtual bool isBatched() const { return false; }
+
+  /**
+   * Called with the events logged since the last flush, in order. The
+   * default calls the functions of the single events.
+   */
+  virtual void onEvents(const std::vector<ConnectionsEventRecord> &events);
+
   /**
    * Called after a segment is created.
    */
@@ -148,6 +386,15 @@ public:
    */
   virtual void onCreateSynapse(Synapse synapse) {}
 
+  /**
+   * Called after the synapses of Connections::createSynapses are created.
+   * The default calls onCreateSynapse for each synapse.
+   */
+  virtual void onCreateSynapses(const std::vector<Synapse> &synapses) {
+    for( const auto synapse : synapses )
+      onCreateSynapse(synapse);
+  }
+
   /**
    * Called before a synapse is destroyed.
    */
@@ -158,6 +405,64 @@ public:
    */
   virtual void onUpdateSynapsePermanence(Synapse synapse,
                                          Permanence permanence) {}
+
+  /**
+   * Called after the segments and synapses are renumbered by compact.
+   */
+  virtual void onCompact(const ConnectionsRemap &remap) {}
+};
+
+/**
+ * StaticEventHandlers implementation in C++.
+ *
+ * @b Description
+ * The StaticEventHandlers subscribes the handlers known at compile time as
+ * one handler. Connections makes one virtual call for an event, and the
+ * handlers are called directly, so declare them final to let the compiler
+ * inline the calls. The handlers are not owned.
+ *
+ * @tparam Handlers The classes of the handlers.
+ */
+template<typename... Handlers>
+class StaticEventHandlers final : public ConnectionsEventHandler {
+private:
+  std::tuple<Handlers *...> handlers_;
+
+  template<typename Function>
+  inline void forEach_(const Function &function) {
+    std::apply([&](auto *... handlers) { (function(*handlers), ...); }, handlers_);
+  }
+
+public:
+  explicit StaticEventHandlers(Handlers *... handlers) : handlers_(handlers...) {}
+
+  void onCreateSegment(Segment segment) override {
+    forEach_([&](auto &h) { h.onCreateSegment(segment); });
+  }
+
+  void onDestroySegment(Segment segment) override {
+    forEach_([&](auto &h) { h.onDestroySegment(segment); });
+  }
+
+  void onCreateSynapse(Synapse synapse) override {
+    forEach_([&](auto &h) { h.onCreateSynapse(synapse); });
+  }
+
+  void onCreateSynapses(const std::vector<Synapse> &synapses) override {
+    forEach_([&](auto &h) { h.onCreateSynapses(synapses); });
+  }
+
+  void onDestroySynapse(Synapse synapse) override {
+    forEach_([&](auto &h) { h.onDestroySynapse(synapse); });
+  }
+
+  void onUpdateSynapsePermanence(Synapse synapse, Permanence permanence) override {
+    forEach_([&](auto &h) { h.onUpdateSynapsePermanence(synapse, permanence); });
+  }
+
+  void onCompact(const ConnectionsRemap &remap) override {
+    forEach_([&](auto &h) { h.onCompact(remap); });
+  }
 };
 
 /**
@@ -187,6 +492,12 @@ public:
  * Create a vector of length `connections.segmentFlatListLength()`,
  * iterate over segments and update the vector at index `segment`.
  *
+ * The slots of destroyed segments and synapses are reused by the next
+ * created ones, so the flat lists stay bounded under steady churn. A
+ * destroyed slot becomes reusable at the next computeActivity, so the
+ * segments held by the caller for the current step are never reused
+ * under it. compact() removes the remaining holes.
+ *
  */
 class Connections : public Serializable
  {
@@ -279,6 +590,29 @@ public:
                         const CellIdx presynapticCell,
                         Permanence permanence);
 
+  /**
+   * Creates the synapses on the segment at once. The storage is reserved
+   * once, and the handlers get one onCreateSynapses call. The result is
+   * the same as createSynapse called for each cell in order, so the cells
+   * already synapsed on by the segment are skipped.
+   *
+   * @param segment          Segment to create synapses on.
+   * @param presynapticCells Cells to synapse on. They must not repeat.
+   * @param permanence       Initial permanence of the new synapses.
+   */
+  void createSynapses(const Segment segment,
+                      const std::vector<CellIdx> &presynapticCells,
+                      const Permanence permanence);
+
+  /**
+   * Same as above, with an initial permanence for each cell.
+   *
+   * @param permanences Initial permanences, one for each presynaptic cell.
+   */
+  void createSynapses(const Segment segment,
+                      const std::vector<CellIdx> &presynapticCells,
+                      const std::vector<Permanence> &permanences);
+
   /**
    * Destroys segment.
    *
@@ -401,15 +735,66 @@ public:
    */
   size_t segmentFlatListLength() const { return segments_.size(); };
 
+  /**
+   * Get the number of rows of the presynaptic tables, which is one more
+   * than the largest presynaptic cell that ever had a synapse.
+   *
+   * @retval A vector length
+   */
+  size_t presynapticCellFlatListLength() const {
+    return potentialSegmentsForPresynapticCell_.size();
+  }
+
+  /**
+   * Get the segments with a potential synapse to the presynaptic cell, in
+   * the order used by computeActivity.
+   *
+   * @param cell The presynaptic cell, less than presynapticCellFlatListLength().
+   *
+   * @retval Segments of the potential synapses.
+   */
+  const std::vector<Segment> &potentialSegmentsForPresynapticCell(const CellIdx cell) const {
+    return potentialSegmentsForPresynapticCell_[cell];
+  }
+
+  /**
+   * Get the segments with a connected synapse to the presynaptic cell, in
+   * the order used by computeActivity.
+   *
+   * @param cell The presynaptic cell, less than presynapticCellFlatListLength().
+   *
+   * @retval Segments of the connected synapses.
+   */
+  const std::vector<Segment> &connectedSegmentsForPresynapticCell(const CellIdx cell) const {
+    return connectedSegmentsForPresynapticCell_[cell];
+  }
+
+  /**
+   * Record the relations between the segments and the active cells in
+   * the next calls of computeActivity. The relations are not recorded by
+   * default, then the relation getters return empty relations.
+   *
+   * @param record Whether the relations are recorded.
+   */
+  void setRecordRelations(const bool record) {
+    activeRelations_.setEnabled(record);
+    matchingRelations_.setEnabled(record);
+  }
+
+  /**
+   * @return Whether the relations are recorded by computeActivity.
+   */
+  bool getRecordRelations() const { return activeRelations_.isEnabled(); }
+
   /**
    * Get the active relations between a segment and active cells
    * by the active connected synapses. 
    * 
-   * @return const Relations<Segment, CellIdx>& Active relations between 
+   * @return const SegmentRelations& Active relations between 
    * active segments and active cells.
    * Structure: {potential active segment : {active cells...}}.
    */
-  const Relations<Segment, CellIdx>& getActiveRelationsForSegments() const {
+  const SegmentRelations& getActiveRelationsForSegments() const {
     return activeRelations_;
   }
 
@@ -417,14 +802,36 @@ public:
    * Get the matching relations between a segment and active cells
    * by the active synapses. 
    * 
-   * @return const Relations<Segment, CellIdx>& Matching relations between 
+   * @return const SegmentRelations& Matching relations between 
    * segments and active cells.
    * Structure: {potential active segment : {active cells...}}.
    */
-  const Relations<Segment, CellIdx>& getMatchingRelationsForSegments() const {
+  const SegmentRelations& getMatchingRelationsForSegments() const {
     return matchingRelations_;
   }
 
+  /**
+   * Get the segments which have at least one active connected synapse
+   * in the last call of computeActivity. Every segment appears once and
+   * the order is the order in which they were first reached.
+   *
+   * @return Segments with a non zero active connected synapse count.
+   */
+  const std::vector<Segment>& getActiveSegmentsTouched() const {
+    return activeSegmentsTouched_;
+  }
+
+  /**
+   * Get the segments which have at least one active potential synapse
+   * in the last call of computeActivity (with the potential output).
+   * This is a superset of getActiveSegmentsTouched().
+   *
+   * @return Segments with a non zero active potential synapse count.
+   */
+  const std::vector<Segment>& getMatchingSegmentsTouched() const {
+    return matchingSegmentsTouched_;
+  }
+
   /**
    * Get the active relations by active connected synapses.
    * 
@@ -499,6 +906,52 @@ public:
   std::vector<SynapseIdx> computeActivity(const std::vector<CellIdx> &activePresynapticCells, 
 		                          const bool learn = true);
 
+  /**
+   * Compute the segment excitations into caller owned buffers. Unlike the
+   * functions above, this neither touches the internal relations and
+   * touched lists nor advances the iteration, so it may be called from
+   * many threads at once as long as the connections are not modified.
+   *
+   * The count vectors are resized to getSegmentFlatVectorLength() and the
+   * other outputs are cleared before they are filled.
+   *
+   * @param activePresynapticCells Active cells in the input.
+   *
+   * @param numActiveConnectedSynapsesForSegment
+   * An output vector for active connected synapse counts per segment.
+   *
+   * @param activeSegmentsTouched
+   * An output vector for the segments with a non zero connected count.
+   *
+   * @param activeRelations
+   * An output for the relations by active connected synapses.
+   */
+  void computeActivity(const std::vector<CellIdx> &activePresynapticCells,
+                       std::vector<SynapseIdx> &numActiveConnectedSynapsesForSegment,
+                       std::vector<Segment> &activeSegmentsTouched,
+                       SegmentRelations &activeRelations) const;
+
+  /**
+   * Compute the segment excitations and the potential excitations into
+   * caller owned buffers. See the overload above.
+   *
+   * @param numActivePotentialSynapsesForSegment
+   * An output vector for active potential synapse counts per segment.
+   *
+   * @param matchingSegmentsTouched
+   * An output vector for the segments with a non zero potential count.
+   *
+   * @param matchingRelations
+   * An output for the relations by active potential synapses.
+   */
+  void computeActivity(const std::vector<CellIdx> &activePresynapticCells,
+                       std::vector<SynapseIdx> &numActiveConnectedSynapsesForSegment,
+                       std::vector<SynapseIdx> &numActivePotentialSynapsesForSegment,
+                       std::vector<Segment> &activeSegmentsTouched,
+                       std::vector<Segment> &matchingSegmentsTouched,
+                       SegmentRelations &activeRelations,
+                       SegmentRelations &matchingRelations) const;
+
   /**
    * The primary method in charge of learning.   Adapts the permanence values of
    * the synapses based on the input SDR.  Learning is applied to a single
@@ -521,6 +974,20 @@ public:
                     const Permanence decrement,
 		    const bool pruneZeroSynapses = false);
 
+  /**
+   * Same as above, with the active inputs given as a Bitset. The bitset is
+   * filled once and reused for all the segments of a step, so no dense
+   * array of the inputs is made.
+   *
+   * @param inputs  The active presynaptic cells. Its size must cover all
+   *        the presynaptic cells of the segment.
+   */
+  void adaptSegment(const Segment segment,
+                    const Bitset &inputs,
+                    const Permanence increment,
+                    const Permanence decrement,
+                    const bool pruneZeroSynapses = false);
+
   /**
    * Ensures a minimum number of connected synapses.  This raises permance
    * values until the desired number of synapses have permanences above the
@@ -585,6 +1052,17 @@ public:
   void destroyMinPermanenceSynapses(const Segment segment, Int nDestroy,
                                     const SDR_sparse_t &excludeCells = {});
 
+  /**
+   * Remove the slots of the destroyed segments and synapses, and renumber
+   * the live ones densely, keeping their order. The structures indexed by
+   * segment or synapse inside Connections are remapped, and the subscribed
+   * event handlers are notified by onCompact. The segments and synapses
+   * held by the caller must be remapped with the returned map.
+   *
+   * @retval The renumbering of the segments and the synapses.
+   */
+  ConnectionsRemap compact();
+
   /**
    * Print diagnostic info
    */
@@ -592,57 +1070,72 @@ public:
 
 
   // Serialization
+  // The internal arrays are written as they are, so the segments and the
+  // synapses keep their indexes, the destroyed slots and the order of the
+  // presynaptic maps are restored, and a loaded instance continues exactly
+  // like the saved one. The subscribed event handlers are not saved.
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const {
-    // make this look like a queue of items to be sent. 
-    // and a queue of sizes so we can distribute the 
-		// correct number for each level when deserializing.
-    std::deque<SynapseData> syndata;
-    std::deque<size_t> sizes;
-    sizes.push_back(cells_.size());
-    for (CellData cellData : cells_) {
-      const std::vector<Segment> &segments = cellData.segments;
-      sizes.push_back(segments.size());
-      for (Segment segment : segments) {
-        const SegmentData &segmentData = segments_[segment];
-        const std::vector<Synapse> &synapses = segmentData.synapses;
-        sizes.push_back(synapses.size());
-        for (Synapse synapse : synapses) {
-          const SynapseData &synapseData = synapses_[synapse];
-          syndata.push_back(synapseData);
-        }
-      }
-    }
-    ar(CEREAL_NVP(connectedThreshold_));
-    ar(CEREAL_NVP(sizes));
-    ar(CEREAL_NVP(syndata));
-    ar(CEREAL_NVP(iteration_));
+    ar(CEREAL_NVP(connectedThreshold_),
+       CEREAL_NVP(iteration_),
+       CEREAL_NVP(timeseries_),
+       CEREAL_NVP(cells_),
+       CEREAL_NVP(segments_),
+       CEREAL_NVP(synapses_),
+       CEREAL_NVP(destroyedSegments_),
+       CEREAL_NVP(destroyedSynapses_));
+    ar(CEREAL_NVP(potentialSynapsesForPresynapticCell_),
+       CEREAL_NVP(connectedSynapsesForPresynapticCell_),
+       CEREAL_NVP(potentialSegmentsForPresynapticCell_),
+       CEREAL_NVP(connectedSegmentsForPresynapticCell_));
+    ar(CEREAL_NVP(pendingSegments_),
+       CEREAL_NVP(freeSegments_),
+       CEREAL_NVP(pendingSynapses_),
+       CEREAL_NVP(freeSynapses_),
+       CEREAL_NVP(nextSegmentOrdinal_),
+       CEREAL_NVP(nextSynapseOrdinal_));
+    ar(CEREAL_NVP(previousUpdates_),
+       CEREAL_NVP(currentUpdates_),
+       CEREAL_NVP(prunedSyns_),
+       CEREAL_NVP(prunedSegs_));
+    ar(CEREAL_NVP(activeRelations_),
+       CEREAL_NVP(matchingRelations_),
+       CEREAL_NVP(activeSegmentsTouched_),
+       CEREAL_NVP(matchingSegmentsTouched_));
   }
 
   template<class Archive>
   void load_ar(Archive & ar) {
-    std::deque<size_t> sizes;
-    std::deque<SynapseData> syndata;
-    ar(CEREAL_NVP(connectedThreshold_));
-    ar(CEREAL_NVP(sizes));
-    ar(CEREAL_NVP(syndata));
-
-    CellIdx numCells = static_cast<CellIdx>(sizes.front()); sizes.pop_front();
-    initialize(numCells, connectedThreshold_);
-    for (UInt cell = 0; cell < numCells; cell++) {
-      size_t numSegments = sizes.front(); sizes.pop_front();
-      for (SegmentIdx j = 0; j < static_cast<SegmentIdx>(numSegments); j++) {
-        Segment segment = createSegment( cell );
-
-        size_t numSynapses = sizes.front(); sizes.pop_front();
-        for (SynapseIdx k = 0; k < static_cast<SynapseIdx>(numSynapses); k++) {
-          SynapseData& syn = syndata.front(); syndata.pop_front();
-          createSynapse( segment, syn.presynapticCell, syn.permanence );
-        }
-      }
-    }
-    ar(CEREAL_NVP(iteration_));
+    // Drop the subscribed handlers and the logged events first.
+    initialize(0, minPermanence);
+
+    ar(CEREAL_NVP(connectedThreshold_),
+       CEREAL_NVP(iteration_),
+       CEREAL_NVP(timeseries_),
+       CEREAL_NVP(cells_),
+       CEREAL_NVP(segments_),
+       CEREAL_NVP(synapses_),
+       CEREAL_NVP(destroyedSegments_),
+       CEREAL_NVP(destroyedSynapses_));
+    ar(CEREAL_NVP(potentialSynapsesForPresynapticCell_),
+       CEREAL_NVP(connectedSynapsesForPresynapticCell_),
+       CEREAL_NVP(potentialSegmentsForPresynapticCell_),
+       CEREAL_NVP(connectedSegmentsForPresynapticCell_));
+    ar(CEREAL_NVP(pendingSegments_),
+       CEREAL_NVP(freeSegments_),
+       CEREAL_NVP(pendingSynapses_),
+       CEREAL_NVP(freeSynapses_),
+       CEREAL_NVP(nextSegmentOrdinal_),
+       CEREAL_NVP(nextSynapseOrdinal_));
+    ar(CEREAL_NVP(previousUpdates_),
+       CEREAL_NVP(currentUpdates_),
+       CEREAL_NVP(prunedSyns_),
+       CEREAL_NVP(prunedSegs_));
+    ar(CEREAL_NVP(activeRelations_),
+       CEREAL_NVP(matchingRelations_),
+       CEREAL_NVP(activeSegmentsTouched_),
+       CEREAL_NVP(matchingSegmentsTouched_));
   }
 
   /**
@@ -721,6 +1214,13 @@ public:
    */
   void unsubscribe(UInt32 token);
 
+  /**
+   * Pass the logged events to the batched event handlers, and clear the
+   * log. Call this before reading the state of a batched handler outside
+   * of adaptSegment and computeActivity.
+   */
+  void flushEvents();
+
 protected:
   /**
    * Check whether this segment still exists on its cell.
@@ -759,6 +1259,27 @@ protected:
                               std::vector<Synapse> &synapsesForPresynapticCell,
                               std::vector<Segment> &segmentsForPresynapticCell);
 
+  /**
+   * Make the slots destroyed since the last call reusable.
+   */
+  void releaseDestroyed_();
+
+  /**
+   * Grow the presynaptic tables so that they hold the presynaptic cell.
+   *
+   * @param presynapticCell The presynaptic cell to be indexed.
+   */
+  void reservePresynapticCell_(const CellIdx presynapticCell);
+
+  /**
+   * Add the activity of the potential (not connected) synapses on top of
+   * the connected counts already in numActivePotentialSynapsesForSegment.
+   */
+  void computePotentialActivity_(const std::vector<CellIdx> &activePresynapticCells,
+                                 std::vector<SynapseIdx> &numActivePotentialSynapsesForSegment,
+                                 std::vector<Segment> &matchingSegmentsTouched,
+                                 SegmentRelations &matchingRelations) const;
+
   /**
    * Convert to the cell relations.
    * 
@@ -766,7 +1287,7 @@ protected:
    * @return const Relations<CellIdx, CellIdx> 
    */
   const Relations<CellIdx, CellIdx> convertToCellsRelations_(
-	const Relations<Segment, CellIdx> relations
+	const SegmentRelations& relations
   ) const;
 
 private:
@@ -779,13 +1300,21 @@ private:
   UInt32 iteration_ = 0;
 
   // Extra bookkeeping for faster computing of segment activity.
- 
-  struct identity { constexpr size_t operator()( const CellIdx t ) const noexcept { return t; };   };	//TODO in c++20 use std::identity 
-
-  std::unordered_map<CellIdx, std::vector<Synapse>, identity> potentialSynapsesForPresynapticCell_;
-  std::unordered_map<CellIdx, std::vector<Synapse>, identity> connectedSynapsesForPresynapticCell_;
-  std::unordered_map<CellIdx, std::vector<Segment>, identity> potentialSegmentsForPresynapticCell_;
-  std::unordered_map<CellIdx, std::vector<Segment>, identity> connectedSegmentsForPresynapticCell_;
+  // The presynaptic cells are dense indices (the cells and the external
+  // inputs), so the tables are indexed directly by the presynaptic cell and
+  // grow on demand in createSynapse. A row is empty if the cell has no
+  // synapses.
+  std::vector<std::vector<Synapse>> potentialSynapsesForPresynapticCell_;
+  std::vector<std::vector<Synapse>> connectedSynapsesForPresynapticCell_;
+  std::vector<std::vector<Segment>> potentialSegmentsForPresynapticCell_;
+  std::vector<std::vector<Segment>> connectedSegmentsForPresynapticCell_;
+
+  // The slots of the destroyed segments and synapses. A slot is pending
+  // until the next computeActivity, then it is free to be reused.
+  std::vector<Segment> pendingSegments_;
+  std::vector<Segment> freeSegments_;
+  std::vector<Synapse> pendingSynapses_;
+  std::vector<Synapse> freeSynapses_;
 
   Segment nextSegmentOrdinal_ = 0;
   Synapse nextSynapseOrdinal_ = 0;
@@ -803,9 +1332,62 @@ private:
   //for listeners
   UInt32 nextEventToken_;
   std::map<UInt32, ConnectionsEventHandler *> eventHandlers_;
+  std::vector<ConnectionsEventHandler *> immediateHandlers_;
+  std::vector<ConnectionsEventHandler *> batchedHandlers_;
+  std::vector<ConnectionsEventRecord> eventLog_;
+
+  // Scratch buffers of createSynapses.
+  std::vector<CellIdx>    existingCells_;
+  std::vector<Synapse>    createdSynapses_;
+  std::vector<Permanence> createdPermanences_;
+
+  /**
+   * Split the subscribed handlers into the immediate and the batched ones.
+   */
+  void updateHandlers_();
+
+  /**
+   * Take a synapse slot and link the new synapse to the segment and to the
+   * presynaptic cell. No events are sent and the permanence is not set.
+   */
+  Synapse addSynapse_(const Segment segment, const CellIdx presynapticCell);
+
+  /**
+   * The body of createSynapses. permanenceAt gives the initial permanence
+   * of the i-th presynaptic cell.
+   */
+  template<typename PermanenceAt>
+  void createSynapses_(const Segment segment,
+                       const std::vector<CellIdx> &presynapticCells,
+                       const PermanenceAt &permanenceAt);
+
+  /**
+   * The body of adaptSegment. isActive tells whether a presynaptic cell
+   * is active.
+   */
+  template<typename IsActive>
+  void adaptSegment_(const Segment segment,
+                     const IsActive &isActive,
+                     const Permanence increment,
+                     const Permanence decrement,
+                     const bool pruneZeroSynapses);
+
+  /**
+   * Log an event for the batched handlers.
+   */
+  inline void logEvent_(const ConnectionsEventRecord::Type type,
+                        const UInt32 index,
+                        const Permanence permanence = 0.0f) {
+    if( !batchedHandlers_.empty() ) {
+      eventLog_.push_back({type, index, permanence});
+    }
+  }
+
+  SegmentRelations activeRelations_{false};
+  SegmentRelations matchingRelations_{false};
 
-  Relations<Segment, CellIdx> activeRelations_;
-  Relations<Segment, CellIdx> matchingRelations_;
+  std::vector<Segment> activeSegmentsTouched_;
+  std::vector<Segment> matchingSegmentsTouched_;
 
 }; // end class Connections
 
@@ -0,0 +1,118 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2016, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * ---------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the Bitset class.
+ */
+
+#ifndef NTA_BITSET_HPP
+#define NTA_BITSET_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/**
+ * Bitset implementation in C++.
+ *
+ * @b Description
+ * The Bitset is a packed set of the indices in [0, size), one bit for
+ * each index. It is meant to be filled once per step from a sparse list
+ * and queried many times, so the words are kept and reused between the
+ * steps, and only the words touched by the last assign are cleared.
+ */
+class Bitset {
+private:
+  static constexpr UInt BITS = 64u;
+
+  UInt size_ = 0u;
+  std::vector<UInt64> words_;
+  std::vector<UInt> touched_;
+
+public:
+  Bitset() = default;
+
+  explicit Bitset(const UInt size) { resize(size); }
+
+  /**
+   * Set the number of the indices and clear the set.
+   *
+   * @param size The number of the indices.
+   */
+  void resize(const UInt size) {
+    size_ = size;
+    words_.assign((size + BITS - 1u) / BITS, 0u);
+    touched_.clear();
+  }
+
+  /**
+   * Remove all the indices.
+   */
+  void clear() {
+    for( const auto word : touched_ )
+      words_[word] = 0u;
+    touched_.clear();
+  }
+
+  /**
+   * Add an index.
+   *
+   * @param index The index, less than size().
+   */
+  inline void set(const UInt index) {
+    NTA_ASSERT(index < size_);
+    UInt64 &word = words_[index / BITS];
+    if( word == 0u )
+      touched_.push_back(index / BITS);
+    word |= UInt64(1u) << (index % BITS);
+  }
+
+  /**
+   * Replace the set by the given indices.
+   *
+   * @param sparse The indices, each less than size().
+   */
+  template<typename Index>
+  void assign(const std::vector<Index> &sparse) {
+    clear();
+    for( const auto index : sparse )
+      set(static_cast<UInt>(index));
+  }
+
+  /**
+   * Whether the index is in the set.
+   *
+   * @param index The index, less than size().
+   */
+  inline bool contains(const UInt index) const {
+    NTA_ASSERT(index < size_);
+    return (words_[index / BITS] >> (index % BITS)) & 1u;
+  }
+
+  /**
+   * The number of the indices, not the number of the set ones.
+   */
+  inline UInt size() const { return size_; }
+};
+
+} // end namespace htm
+
+#endif // NTA_BITSET_HPP
@@ -20,6 +20,7 @@
 */
 #include <iostream> // for istream, ostream
 #include <chrono>   // for random seeds
+#include <mutex>
 
 #include <htm/utils/Log.hpp>
 #include <htm/utils/Random.hpp>
@@ -34,9 +35,11 @@ bool Random::operator==(const Random &o) const {
 
 bool static_gen_seeded = false;  //used only for seeding seed if 0/auto is passed for seed
 std::mt19937 static_gen;
+std::mutex static_gen_mutex; //models may be built on several threads
 
 Random::Random(UInt64 seed) {
   if (seed == 0) {
+    std::lock_guard<std::mutex> lock(static_gen_mutex);
     if( !static_gen_seeded ) {
       #if NDEBUG
         unsigned int static_seed = (unsigned int)std::chrono::system_clock::now().time_since_epoch().count();
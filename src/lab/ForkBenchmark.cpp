@@ -0,0 +1,136 @@
+// ForkBenchmark.cpp
+
+/**
+ * @file
+ * Benchmark of the fork of the cla model. The benchmark trains the model
+ * and reports the time of the fork of the model, the fork of a stream and
+ * the rollout on a fork, against the full copy of the model through the
+ * snapshot. The size of the snapshot is reported as the size of the model.
+ *
+ * usage: mlcla_fork_benchmark [config file] [steps] [repeats] [horizon]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "cla/config/ModelConfig.hpp"
+#include "cla/utils/Checker.hpp"
+
+
+/**
+ * Get the input values of the step. Each value is a sine wave in the
+ * range of the input.
+ *
+ * @param t The step.
+ * @param mins The minimum values of the inputs.
+ * @param maxs The maximum values of the inputs.
+ */
+cla::Values getValues(
+	const cla::Step t,
+	const cla::Values& mins,
+	const cla::Values& maxs
+) {
+	cla::Values values(mins.size());
+	for(std::size_t i = 0u; i < values.size(); ++i) {
+		const double wave = std::sin(0.1 * static_cast<double>(t + i));
+		values.at(i) = mins.at(i) + (maxs.at(i) - mins.at(i)) * 0.5 * (wave + 1.0);
+	}
+	return values;
+}
+
+
+int main(int argc, char** argv) {
+	const std::string configFile
+		= (argc > 1) ? argv[1] : "../../config/cla_params.json";
+	const cla::Step nbStep = (argc > 2) ? std::stoul(argv[2]) : 2000u;
+	const int nbRepeat = (argc > 3) ? std::stoi(argv[3]) : 100;
+	const cla::Step horizon = (argc > 4) ? std::stoul(argv[4]) : 24u;
+	const std::string snapshotFile = "mlcla_fork_benchmark.bin";
+
+	std::ifstream json_ifs(configFile);
+	CLA_CHECK(!json_ifs.fail(), "Cannot find param json file.")
+
+	cla::json config;
+	json_ifs >> config;
+	json_ifs.close();
+
+	// The range of the inputs is taken from the io of the model.
+	cla::Values mins, maxs;
+	for(auto&& [modelKey, model] : config.items()) {
+		for(auto&& [key, value] : model.items()) {
+			if(value.contains("mins")) {
+				mins = value.at("mins").get<cla::Values>();
+				maxs = value.at("maxs").get<cla::Values>();
+			}
+		}
+	}
+	CLA_CHECK(!mins.empty(), "Cannot find the range of the inputs.")
+
+	cla::JsonConfig jsonConfig(config);
+	auto model = jsonConfig.buildModel();
+
+	for(cla::Step t = 0u; t < nbStep; ++t) {
+		model->feedforward(getValues(t, mins, maxs), true);
+		model->feedback(getValues(t + 1u, mins, maxs), true);
+	}
+
+	using Clock = std::chrono::steady_clock;
+	using Micros = std::chrono::duration<double, std::micro>;
+
+	Micros forkElapsed(0.0), streamElapsed(0.0), rolloutElapsed(0.0), copyElapsed(0.0);
+
+	const cla::StreamState state = model->fork();
+	std::size_t nbForecasts = 0u;
+
+	for(int i = 0; i < nbRepeat; ++i) {
+		const auto forkStart = Clock::now();
+		const cla::StreamState forked = model->fork();
+		forkElapsed += Clock::now() - forkStart;
+
+		const auto streamStart = Clock::now();
+		const cla::StreamState copied = model->fork(state);
+		streamElapsed += Clock::now() - streamStart;
+
+		const auto rolloutStart = Clock::now();
+		nbForecasts += model->rollout(state, horizon).size();
+		rolloutElapsed += Clock::now() - rolloutStart;
+	}
+	CLA_CHECK(
+		nbForecasts == horizon * static_cast<std::size_t>(nbRepeat),
+		"The rollout does not forecast the whole horizon."
+	)
+
+	// The full copy saves and loads the whole model, as a fork had to do
+	// before the stream state.
+	auto copy = jsonConfig.buildModel();
+	const int nbCopy = std::max(1, nbRepeat / 10);
+	for(int i = 0; i < nbCopy; ++i) {
+		const auto copyStart = Clock::now();
+		model->save(snapshotFile);
+		copy->load(snapshotFile);
+		copyElapsed += Clock::now() - copyStart;
+	}
+
+	std::ifstream snapshot(snapshotFile, std::ios_base::binary | std::ios_base::ate);
+	const auto bytes = static_cast<double>(snapshot.tellg());
+	snapshot.close();
+	std::remove(snapshotFile.c_str());
+
+	std::cout << "steps\tMB\tfork us\tstream fork us\trollout us\tcopy us" << std::endl;
+	std::cout << nbStep << "\t"
+			  << std::fixed << std::setprecision(3)
+			  << bytes / (1024.0 * 1024.0) << "\t"
+			  << forkElapsed.count() / static_cast<double>(nbRepeat) << "\t"
+			  << streamElapsed.count() / static_cast<double>(nbRepeat) << "\t"
+			  << rolloutElapsed.count() / static_cast<double>(nbRepeat) << "\t"
+			  << copyElapsed.count() / static_cast<double>(nbCopy)
+			  << std::endl;
+
+	return 0;
+}
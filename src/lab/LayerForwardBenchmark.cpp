@@ -0,0 +1,125 @@
+// LayerForwardBenchmark.cpp
+
+/**
+ * @file
+ * Latency benchmark of the layer forward with the regions. The benchmark
+ * builds the model with 1 to 8 regions, one scalar input for each region,
+ * and reports the time of one step with the serial and the parallel
+ * spatial poolers.
+ *
+ * usage: mlcla_layer_benchmark [config file] [steps] [threads]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cla/config/ModelConfig.hpp"
+#include "cla/config/utils/ConfigHelpers.hpp"
+#include "cla/config/utils/JsonParamDefinition.hpp"
+#include "cla/utils/Checker.hpp"
+
+
+/**
+ * Set the number of the regions and the threads to the layers of the
+ * model config. Each region has one scalar input.
+ *
+ * @param config The model config.
+ * @param nbRegions The number of the regions.
+ * @param nbThreads The thread budget of the layers.
+ */
+void setRegions(
+	cla::json& config,
+	const htm::UInt nbRegions,
+	const htm::UInt nbThreads
+) {
+	using LJLabel = cla::LayerJsonLabels;
+	using IOJLabel = cla::IoJsonLabels;
+
+	for(auto&& [modelKey, model] : config.items()) {
+		for(auto&& [key, value] : model.items()) {
+			if(cla::KeyHelper::contain(key, LJLabel::HTM_LAYER_LABEL)) {
+				value[LJLabel::PARAM_NB_REGIONS_LABEL] = nbRegions;
+				value[LJLabel::PARAM_NB_THREADS_LABEL] = nbThreads;
+				continue;
+			}
+
+			if(cla::KeyHelper::contain(key, IOJLabel::SCALAR_IO_LABEL)) {
+				const std::vector<htm::UInt> dimensions
+					= value.at(IOJLabel::PARAM_INPUT_DIMENSIONS);
+				const htm::UInt nbActiveBits
+					= value.at(IOJLabel::PARAM_NB_ACTIVE_BITS);
+
+				value[IOJLabel::PARAM_NB_INPUTS] = nbRegions;
+				value[IOJLabel::PARAM_INPUT_DIMENSIONS]
+					= std::vector<htm::UInt>{dimensions.front() * nbRegions};
+				value[IOJLabel::PARAM_NB_ACTIVE_BITS] = nbActiveBits * nbRegions;
+				value[IOJLabel::PARAM_MINS] = cla::Values(nbRegions, -1.0);
+				value[IOJLabel::PARAM_MAXS] = cla::Values(nbRegions, 1.0);
+			}
+		}
+	}
+}
+
+
+int main(int argc, char** argv) {
+	const std::string configFile
+		= (argc > 1) ? argv[1] : "../../config/cla_params.json";
+	const cla::Step nbStep = (argc > 2) ? std::stoul(argv[2]) : 200u;
+	const htm::UInt nbThreads = (argc > 3)
+		? static_cast<htm::UInt>(std::stoul(argv[3]))
+		: std::max(1u, std::thread::hardware_concurrency());
+
+	std::ifstream json_ifs(configFile);
+	CLA_CHECK(!json_ifs.fail(), "Cannot find param json file.")
+
+	cla::json baseConfig;
+	json_ifs >> baseConfig;
+	json_ifs.close();
+
+	std::cout << "regions\tthreads\tsteps\tms/step" << std::endl;
+
+	for(htm::UInt nbRegions = 1u; nbRegions <= 8u; nbRegions *= 2u) {
+		for(const htm::UInt threads : {1u, nbThreads}) {
+			cla::json config = baseConfig;
+			setRegions(config, nbRegions, threads);
+
+			cla::JsonConfig jsonConfig(config);
+			const auto model = jsonConfig.buildModel();
+
+			cla::Values values(nbRegions);
+			const auto& getValues = [&](const cla::Step t) {
+				for(htm::UInt i = 0u; i < nbRegions; ++i)
+					values.at(i) = std::sin(0.1 * static_cast<double>(t + i));
+				return values;
+			};
+
+			const auto start = std::chrono::steady_clock::now();
+
+			for(cla::Step t = 0u; t < nbStep; ++t) {
+				model->feedforward(getValues(t), true);
+				model->feedback(getValues(t + 1u), true);
+			}
+
+			const std::chrono::duration<double, std::milli> elapsed
+				= std::chrono::steady_clock::now() - start;
+
+			std::cout << nbRegions << "\t"
+					  << threads << "\t"
+					  << nbStep << "\t"
+					  << std::fixed << std::setprecision(3)
+					  << elapsed.count() / static_cast<double>(nbStep)
+					  << std::endl;
+
+			if(threads == nbThreads) break;
+		}
+	}
+
+	return 0;
+}
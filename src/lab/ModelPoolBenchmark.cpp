@@ -0,0 +1,87 @@
+// ModelPoolBenchmark.cpp
+
+/**
+ * @file
+ * Throughput benchmark of the ModelPool. The benchmark runs 1 to 64
+ * independent models on the pool and reports the model steps per second.
+ *
+ * usage: mlcla_pool_benchmark [config file] [steps] [threads] [pin]
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cla/config/ModelConfig.hpp"
+#include "cla/environment/Envs.hpp"
+#include "cla/model/ModelPool.hpp"
+#include "cla/utils/Checker.hpp"
+
+
+int main(int argc, char** argv) {
+	const std::string configFile
+		= (argc > 1) ? argv[1] : "../../config/cla_params.json";
+	const cla::Step nbStep = (argc > 2) ? std::stoul(argv[2]) : 200u;
+	const std::size_t nbThreads = (argc > 3) ? std::stoul(argv[3]) : 0u;
+	const bool pinThreads = (argc > 4) && std::string(argv[4]) == "pin";
+	const int nbCycle = 100;
+
+	std::ifstream json_ifs(configFile);
+	CLA_CHECK(!json_ifs.fail(), "Cannot find param json file.")
+
+	cla::JsonConfig baseConfig;
+	json_ifs >> baseConfig;
+	json_ifs.close();
+
+	std::cout << "models\tthreads\tsteps\tseconds\tsteps/sec" << std::endl;
+
+	for(std::size_t nbModels = 1u; nbModels <= 64u; nbModels *= 2u) {
+
+		// One environment and one model for each sensor.
+		std::vector<cla::PEnv> envs;
+		std::vector<cla::JsonConfig> configs(nbModels, baseConfig);
+
+		for(std::size_t i = 0u; i < nbModels; ++i) {
+			envs.emplace_back(cla::Env<cla::SinEnv>::make(nbCycle));
+			envs.back()->reset();
+
+			configs.at(i).getModel().getIO().setMins(envs.back()->getMins());
+			configs.at(i).getModel().getIO().setMaxs(envs.back()->getMaxs());
+			configs.at(i).getModel().setSeed(static_cast<int>(i + 1u));
+		}
+
+		cla::ModelPool pool(configs, nbThreads, pinThreads);
+
+		std::vector<cla::ModelInput> inputs(nbModels), nexts(nbModels);
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for(cla::Step t = 0u; t < nbStep; ++t) {
+			for(std::size_t i = 0u; i < nbModels; ++i) {
+				inputs.at(i) = {i, envs.at(i)->getValues()};
+				envs.at(i)->increment();
+				nexts.at(i) = {i, envs.at(i)->getValues()};
+			}
+
+			pool.feedforward(inputs, true);
+			pool.feedback(nexts, true);
+		}
+
+		const std::chrono::duration<double> elapsed
+			= std::chrono::steady_clock::now() - start;
+		const double nbModelSteps
+			= static_cast<double>(nbModels) * static_cast<double>(nbStep);
+
+		std::cout << nbModels << "\t"
+				  << pool.getNbThreads() << "\t"
+				  << nbStep << "\t"
+				  << std::fixed << std::setprecision(3) << elapsed.count() << "\t"
+				  << std::setprecision(1) << nbModelSteps / elapsed.count()
+				  << std::endl;
+	}
+
+	return 0;
+}
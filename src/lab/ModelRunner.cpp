@@ -0,0 +1,332 @@
+// ModelRunner.cpp
+
+/**
+ * @file
+ * Headless runner of the cla model. The runner builds the model from the
+ * config, streams the inputs from a data source, and writes the
+ * predictions to the output sinks. Only the current and the next inputs
+ * are held, so the memory does not grow with the length of the data.
+ *
+ * The data source is a csv file, the standard input in csv, or a named
+ * environment. A csv row is the input values of one step; the blank
+ * lines, the lines which start with '#' and a header row are skipped.
+ * The range of the csv inputs is taken from the io of the config.
+ *
+ * With a checkpoint directory the model is checkpointed while running,
+ * and a run on a directory which has a checkpoint resumes it: the model
+ * is recovered and the steps of the source which it already processed
+ * are skipped.
+ *
+ * usage: mlcla_runner --config <file> (--csv <file> | --stdin | --env <name>) [options]
+ */
+
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cla/config/ModelConfig.hpp"
+#include "cla/environment/DataSource.hpp"
+#include "cla/environment/Envs.hpp"
+#include "cla/model/core/CoreCLA.hpp"
+#include "cla/model/generator/CallbackGenerator.hpp"
+#include "cla/utils/Checker.hpp"
+
+
+namespace fs = std::filesystem;
+template<typename CallbackType>
+using Callback = cla::CallbackGenerator<CallbackType>;
+
+
+const std::string usage =
+	"usage: mlcla_runner --config <file> (--csv <file> | --stdin | --env <name>) [options]\n"
+	"\n"
+	"data source:\n"
+	"  --csv <file>                 read the inputs from the csv file\n"
+	"  --stdin                      read the inputs in csv from the standard input\n"
+	"  --env <name>                 generate the inputs by SinEnv, SawEnv, TriEnv or LogisticMapEnv\n"
+	"  --period <n>                 the period of the wave environments (default 100)\n"
+	"  --steps <n>                  the maximum number of the steps (required with --env)\n"
+	"\n"
+	"model:\n"
+	"  --test                       run without learning\n"
+	"  --threads <n>                the threads of the regions of each layer (default 1)\n"
+	"  --seed <n>                   the seed of the model\n"
+	"  --checkpoint <dir>           checkpoint the model into the directory, and resume it\n"
+	"  --checkpoint-interval <n>    the steps between the snapshots (default 10000)\n"
+	"\n"
+	"output sinks:\n"
+	"  --predictions <file>         write the predictions in csv, '-' for the standard output\n"
+	"  --log <dir>                  save the model and the layer logs on a background thread\n"
+	"  --log-interval <n>           the steps held by the log callbacks (default 1000)\n"
+	"  --eval <n>                   print the accuracy of the predictions every n steps\n";
+
+
+/**
+ * The options of the runner.
+ */
+struct Options {
+	std::string configFile;
+	std::string csvFile;
+	bool useStdin = false;
+	std::string envName;
+	cla::Step period = 100u;
+	cla::Step nbSteps = std::numeric_limits<cla::Step>::max();
+
+	bool learn = true;
+	htm::UInt nbThreads = 1u;
+	bool hasSeed = false;
+	int seed = 0;
+	std::string checkpointDir;
+	cla::Step checkpointInterval = 10000u;
+
+	std::string predictionsFile;
+	std::string logDir;
+	cla::Step logInterval = 1000u;
+	cla::Step evalInterval = 0u;
+};
+
+
+/**
+ * Parse the command line. The runner exits with the usage on an error.
+ *
+ * @param argc The number of the arguments.
+ * @param argv The arguments.
+ */
+Options parseOptions(const int argc, char** argv) {
+	Options options;
+
+	const auto fail = [](const std::string& message) {
+		std::cerr << "mlcla_runner: " << message << std::endl << std::endl << usage;
+		std::exit(2);
+	};
+
+	for(int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+
+		const auto value = [&]() -> std::string {
+			if(i + 1 >= argc) fail("missing the value of " + arg);
+			return argv[++i];
+		};
+		const auto number = [&]() -> cla::Step {
+			const std::string text = value();
+			if(text.empty() || text.find_first_not_of("0123456789") != std::string::npos)
+				fail("the value of " + arg + " is not a number: " + text);
+			return std::stoull(text);
+		};
+
+		if(arg == "--help" || arg == "-h") { std::cout << usage; std::exit(0); }
+		else if(arg == "--config") options.configFile = value();
+		else if(arg == "--csv") options.csvFile = value();
+		else if(arg == "--stdin") options.useStdin = true;
+		else if(arg == "--env") options.envName = value();
+		else if(arg == "--period") options.period = number();
+		else if(arg == "--steps") options.nbSteps = number();
+		else if(arg == "--test") options.learn = false;
+		else if(arg == "--threads") options.nbThreads = static_cast<htm::UInt>(number());
+		else if(arg == "--seed") { options.seed = static_cast<int>(number()); options.hasSeed = true; }
+		else if(arg == "--checkpoint") options.checkpointDir = value();
+		else if(arg == "--checkpoint-interval") options.checkpointInterval = number();
+		else if(arg == "--predictions") options.predictionsFile = value();
+		else if(arg == "--log") options.logDir = value();
+		else if(arg == "--log-interval") options.logInterval = number();
+		else if(arg == "--eval") options.evalInterval = number();
+		else fail("unknown option: " + arg);
+	}
+
+	const int nbSources = static_cast<int>(!options.csvFile.empty())
+		+ static_cast<int>(options.useStdin)
+		+ static_cast<int>(!options.envName.empty());
+
+	if(options.configFile.empty()) fail("--config is required");
+	if(nbSources != 1) fail("give one of --csv, --stdin and --env");
+	if(!options.envName.empty() && options.nbSteps == std::numeric_limits<cla::Step>::max())
+		fail("--steps is required with --env");
+	if(options.nbThreads == 0u) fail("--threads must be positive");
+	if(options.checkpointInterval == 0u) fail("--checkpoint-interval must be positive");
+	if(options.logInterval == 0u) fail("--log-interval must be positive");
+
+	return options;
+}
+
+
+/**
+ * Make the named environment.
+ *
+ * @param name The name of the environment.
+ * @param period The period of the wave environments.
+ */
+cla::PEnv makeEnv(const std::string& name, const cla::Step period) {
+	if(name == cla::SinEnv::name) return cla::Env<cla::SinEnv>::make(period);
+	if(name == cla::SawEnv::name) return cla::Env<cla::SawEnv>::make(period);
+	if(name == cla::TriEnv::name) return cla::Env<cla::TriEnv>::make(period);
+	if(name == cla::LogisticMapEnv::name) return cla::Env<cla::LogisticMapEnv>::make();
+
+	CLA_ALERT("Unknown environment: " << name)
+	return nullptr;
+}
+
+
+/**
+ * Run the model on the data source with the options.
+ *
+ * @param options The options of the runner.
+ */
+int run(const Options& options) {
+
+	// load the model config.
+	std::ifstream json_ifs(options.configFile);
+	CLA_CHECK(!json_ifs.fail(), "Cannot find param json file: " << options.configFile)
+
+	cla::JsonConfig config;
+	json_ifs >> config;
+	json_ifs.close();
+
+	// open the data source.
+	std::ifstream csv_ifs;
+	cla::PDataSource source;
+	cla::PEnv env;
+
+	if(!options.envName.empty()) {
+		env = makeEnv(options.envName, options.period);
+		source = std::make_unique<cla::EnvSource>(env);
+
+		// copy env info to the model config.
+		config.getModel().getIO().setMins(env->getMins());
+		config.getModel().getIO().setMaxs(env->getMaxs());
+	} else if(options.useStdin) {
+		source = std::make_unique<cla::CsvSource>(std::cin, "stdin");
+	} else {
+		csv_ifs.open(options.csvFile);
+		CLA_CHECK(!csv_ifs.fail(), "Cannot open the csv file: " << options.csvFile)
+		source = std::make_unique<cla::CsvSource>(csv_ifs, options.csvFile);
+	}
+
+	config.getModel().setNbThreads(options.nbThreads);
+	if(options.hasSeed) config.getModel().setSeed(options.seed);
+
+	cla::PCLA model = config.buildModel(options.nbThreads);
+
+	// resume the checkpoint, and skip the processed steps of the source.
+	cla::Step firstStep = 0u;
+	cla::Values inputs, nexts;
+
+	if(!options.checkpointDir.empty()
+		&& cla::CheckpointCallback::hasCheckpoint(options.checkpointDir)) {
+		firstStep = cla::CheckpointCallback::resume(*model, options.checkpointDir, *source);
+		std::cerr << "resumed the checkpoint at step " << firstStep << std::endl;
+	}
+
+	if(!source->next(inputs)) {
+		std::cerr << "The source has no input." << std::endl;
+		return 0;
+	}
+
+	const cla::Dim dimension = inputs.size();
+
+	// create the callbacks of the output sinks.
+	std::vector<cla::PCallback> callbacks;
+
+	if(!options.checkpointDir.empty()) {
+		callbacks.push_back(Callback<cla::CheckpointCallback>::generate(
+			options.checkpointDir, options.checkpointInterval, options.learn, firstStep
+		));
+	}
+	if(options.evalInterval > 0u) {
+		callbacks.push_back(Callback<cla::EvalCallback>::generate(
+			dimension, options.evalInterval, 1
+		));
+	}
+	if(!options.logDir.empty()) {
+		// the logs are saved on the background thread.
+		const std::string logDir = (fs::path(options.logDir) / "").string();
+		callbacks.push_back(Callback<cla::AsyncCallback>::generate({
+			Callback<cla::SaveModelLogCallback>::generate(logDir, "log.csv", dimension, options.logInterval),
+			Callback<cla::SaveLayerLogCallback>::generate(logDir, "layerLog.csv", options.logInterval),
+		}, options.logInterval));
+	}
+
+	cla::PCallback callback = Callback<cla::CompositeCallback>::generate(callbacks);
+
+	// open the predictions sink.
+	std::ofstream predictions_ofs;
+	std::ostream* predictions = nullptr;
+	const bool isStdout = options.predictionsFile == "-";
+
+	if(isStdout) {
+		predictions = &std::cout;
+	} else if(!options.predictionsFile.empty()) {
+		predictions_ofs.open(options.predictionsFile, std::ios_base::trunc);
+		CLA_CHECK(!predictions_ofs.fail(), "Cannot open the predictions file: " << options.predictionsFile)
+		predictions = &predictions_ofs;
+	}
+
+	if(predictions) {
+		*predictions << "step";
+		for(cla::Dim i = 0u; i < dimension; ++i) *predictions << ",prediction_" << i;
+		*predictions << std::endl << std::setprecision(std::numeric_limits<cla::Value>::max_digits10);
+	}
+
+
+	// run the model on the stream. The prediction of a step is for the
+	// next step, so the source is read one step ahead.
+	using Clock = std::chrono::steady_clock;
+	const auto start = Clock::now();
+
+	cla::Step nbProcessed = 0u;
+	bool hasInputs = true;
+
+	callback->doStartProcessing(model.get());
+
+	for(cla::Step t = firstStep; hasInputs && nbProcessed < options.nbSteps; ++t) {
+		callback->doPreProcessing(t, inputs, model.get());
+		const cla::Values outputs = model->feedforward(inputs, options.learn);
+		++nbProcessed;
+
+		if(predictions) {
+			*predictions << t;
+			for(const auto value : outputs) *predictions << "," << value;
+			*predictions << "\n";
+			if(isStdout) predictions->flush();
+		}
+
+		// the last step has no next values to learn.
+		hasInputs = nbProcessed < options.nbSteps && source->next(nexts);
+		if(!hasInputs) break;
+
+		callback->doPostProcessing(t, inputs, nexts, outputs, model.get());
+		model->feedback(nexts, options.learn);
+
+		inputs.swap(nexts);
+	}
+
+	callback->doEndProcessing(model.get());
+	if(predictions) predictions->flush();
+
+	const std::chrono::duration<double> elapsed = Clock::now() - start;
+	std::cerr << "steps " << nbProcessed
+			  << ", seconds " << elapsed.count()
+			  << ", steps/s " << static_cast<double>(nbProcessed) / elapsed.count()
+			  << std::endl;
+
+	return 0;
+}
+
+
+int main(int argc, char** argv) {
+	const Options options = parseOptions(argc, argv);
+
+	// the errors of the data source and the model are reported at the exit.
+	try {
+		return run(options);
+	} catch(const std::exception& e) {
+		std::cerr << "mlcla_runner: " << e.what() << std::endl;
+		return 1;
+	}
+}
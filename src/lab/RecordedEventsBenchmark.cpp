@@ -0,0 +1,116 @@
+// RecordedEventsBenchmark.cpp
+
+/**
+ * @file
+ * Benchmark of the recorded connections events of the temporal memory
+ * modules. The benchmark trains the model with and without the recorded
+ * synapse events and reports the time of the training steps. The model
+ * with the recorded events is checked to predict the same values.
+ *
+ * usage: mlcla_recorded_events_benchmark [config file] [steps] [repeats]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cla/config/ModelConfig.hpp"
+#include "cla/utils/Checker.hpp"
+
+
+/**
+ * Get the input values of the step. Each value is a sine wave in the
+ * range of the input.
+ *
+ * @param t The step.
+ * @param mins The minimum values of the inputs.
+ * @param maxs The maximum values of the inputs.
+ */
+cla::Values getValues(
+	const cla::Step t,
+	const cla::Values& mins,
+	const cla::Values& maxs
+) {
+	cla::Values values(mins.size());
+	for(std::size_t i = 0u; i < values.size(); ++i) {
+		const double wave = std::sin(0.1 * static_cast<double>(t + i));
+		values.at(i) = mins.at(i) + (maxs.at(i) - mins.at(i)) * 0.5 * (wave + 1.0);
+	}
+	return values;
+}
+
+
+int main(int argc, char** argv) {
+	const std::string configFile
+		= (argc > 1) ? argv[1] : "../../config/cla_params.json";
+	const cla::Step nbStep = (argc > 2) ? std::stoul(argv[2]) : 2000u;
+	const int nbRepeat = (argc > 3) ? std::stoi(argv[3]) : 3;
+
+	std::ifstream json_ifs(configFile);
+	CLA_CHECK(!json_ifs.fail(), "Cannot find param json file.")
+
+	cla::json config;
+	json_ifs >> config;
+	json_ifs.close();
+
+	// The range of the inputs is taken from the io of the model.
+	cla::Values mins, maxs;
+	for(auto&& [modelKey, model] : config.items()) {
+		for(auto&& [key, value] : model.items()) {
+			if(value.contains("mins")) {
+				mins = value.at("mins").get<cla::Values>();
+				maxs = value.at("maxs").get<cla::Values>();
+			}
+		}
+	}
+	CLA_CHECK(!mins.empty(), "Cannot find the range of the inputs.")
+
+	using Clock = std::chrono::steady_clock;
+	using Millis = std::chrono::duration<double, std::milli>;
+
+	// The models of both settings are built from the same seed, so they
+	// learn the same synapses.
+	const std::vector<std::vector<std::string>> settings = {
+		{}, {"synapses", "permanences"}
+	};
+	std::vector<Millis> elapsed(settings.size(), Millis(0.0));
+	std::vector<cla::Values> lastPredictions(settings.size());
+
+	for(int r = 0; r < nbRepeat; ++r) {
+		for(std::size_t s = 0u; s < settings.size(); ++s) {
+			cla::JsonConfig jsonConfig(config);
+			jsonConfig.getModel().setSeed(42);
+			jsonConfig.getModel().setRecordedEvents(settings.at(s));
+			auto model = jsonConfig.buildModel();
+
+			const auto start = Clock::now();
+			for(cla::Step t = 0u; t < nbStep; ++t) {
+				lastPredictions.at(s) = model->feedforward(getValues(t, mins, maxs), true);
+				model->feedback(getValues(t + 1u, mins, maxs), true);
+			}
+			elapsed.at(s) += Clock::now() - start;
+		}
+	}
+
+	CLA_CHECK(
+		lastPredictions.front() == lastPredictions.back(),
+		"The recorded events change the predictions of the model."
+	)
+
+	const double off = elapsed.front().count() / static_cast<double>(nbRepeat);
+	const double on = elapsed.back().count() / static_cast<double>(nbRepeat);
+
+	std::cout << "steps\toff ms\ton ms\toverhead %" << std::endl;
+	std::cout << nbStep << "\t"
+			  << std::fixed << std::setprecision(3)
+			  << off << "\t"
+			  << on << "\t"
+			  << 100.0 * (on - off) / off
+			  << std::endl;
+
+	return 0;
+}
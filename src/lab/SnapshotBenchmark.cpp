@@ -0,0 +1,118 @@
+// SnapshotBenchmark.cpp
+
+/**
+ * @file
+ * Benchmark of the binary snapshot of the cla model. The benchmark trains
+ * the model, saves the snapshot, and reports the size of the snapshot and
+ * the time of the save and the load. The loaded model is checked to
+ * predict the same values as the saved model.
+ *
+ * usage: mlcla_snapshot_benchmark [config file] [steps] [repeats]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "cla/config/ModelConfig.hpp"
+#include "cla/utils/Checker.hpp"
+
+
+/**
+ * Get the input values of the step. Each value is a sine wave in the
+ * range of the input.
+ *
+ * @param t The step.
+ * @param mins The minimum values of the inputs.
+ * @param maxs The maximum values of the inputs.
+ */
+cla::Values getValues(
+	const cla::Step t,
+	const cla::Values& mins,
+	const cla::Values& maxs
+) {
+	cla::Values values(mins.size());
+	for(std::size_t i = 0u; i < values.size(); ++i) {
+		const double wave = std::sin(0.1 * static_cast<double>(t + i));
+		values.at(i) = mins.at(i) + (maxs.at(i) - mins.at(i)) * 0.5 * (wave + 1.0);
+	}
+	return values;
+}
+
+
+int main(int argc, char** argv) {
+	const std::string configFile
+		= (argc > 1) ? argv[1] : "../../config/cla_params.json";
+	const cla::Step nbStep = (argc > 2) ? std::stoul(argv[2]) : 2000u;
+	const int nbRepeat = (argc > 3) ? std::stoi(argv[3]) : 10;
+	const std::string snapshotFile = "mlcla_snapshot_benchmark.bin";
+
+	std::ifstream json_ifs(configFile);
+	CLA_CHECK(!json_ifs.fail(), "Cannot find param json file.")
+
+	cla::json config;
+	json_ifs >> config;
+	json_ifs.close();
+
+	// The range of the inputs is taken from the io of the model.
+	cla::Values mins, maxs;
+	for(auto&& [modelKey, model] : config.items()) {
+		for(auto&& [key, value] : model.items()) {
+			if(value.contains("mins")) {
+				mins = value.at("mins").get<cla::Values>();
+				maxs = value.at("maxs").get<cla::Values>();
+			}
+		}
+	}
+	CLA_CHECK(!mins.empty(), "Cannot find the range of the inputs.")
+
+	cla::JsonConfig jsonConfig(config);
+	auto model = jsonConfig.buildModel();
+
+	for(cla::Step t = 0u; t < nbStep; ++t) {
+		model->feedforward(getValues(t, mins, maxs), true);
+		model->feedback(getValues(t + 1u, mins, maxs), true);
+	}
+
+	using Clock = std::chrono::steady_clock;
+	using Millis = std::chrono::duration<double, std::milli>;
+
+	const auto saveStart = Clock::now();
+	model->save(snapshotFile);
+	const Millis saveElapsed = Clock::now() - saveStart;
+
+	std::ifstream snapshot(snapshotFile, std::ios_base::binary | std::ios_base::ate);
+	const auto bytes = static_cast<double>(snapshot.tellg());
+	snapshot.close();
+
+	auto loaded = jsonConfig.buildModel();
+	Millis loadElapsed(0.0);
+
+	for(int i = 0; i < nbRepeat; ++i) {
+		const auto loadStart = Clock::now();
+		loaded->load(snapshotFile);
+		loadElapsed += Clock::now() - loadStart;
+	}
+
+	std::remove(snapshotFile.c_str());
+
+	const auto inputs = getValues(nbStep, mins, maxs);
+	CLA_CHECK(
+		loaded->feedforward(inputs, true) == model->feedforward(inputs, true),
+		"The loaded model does not continue like the saved model."
+	)
+
+	std::cout << "steps\tMB\tsave ms\tload ms" << std::endl;
+	std::cout << nbStep << "\t"
+			  << std::fixed << std::setprecision(3)
+			  << bytes / (1024.0 * 1024.0) << "\t"
+			  << saveElapsed.count() << "\t"
+			  << loadElapsed.count() / static_cast<double>(nbRepeat)
+			  << std::endl;
+
+	return 0;
+}
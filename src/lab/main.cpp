@@ -48,8 +48,11 @@ int main(int argc, char** argv) {
 	// create callback
 	cla::PCallback callback = Callback<cla::CompositeCallback>::generate({
 		Callback<cla::EvalCallback>::generate(env->getDimension(), nbCycle, 1),
-		Callback<cla::SaveModelLogCallback>::generate(outputDir + "train\\", "log.csv", env->getDimension(), nbCycle),
-		Callback<cla::SaveLayerLogCallback>::generate(outputDir + "train\\", "layerLog.csv", nbCycle),
+		// the logs are saved on the background thread.
+		Callback<cla::AsyncCallback>::generate({
+			Callback<cla::SaveModelLogCallback>::generate(outputDir + "train\\", "log.csv", env->getDimension(), nbCycle),
+			Callback<cla::SaveLayerLogCallback>::generate(outputDir + "train\\", "layerLog.csv", nbCycle),
+		}, nbCycle),
 	});
 
 	// load model config
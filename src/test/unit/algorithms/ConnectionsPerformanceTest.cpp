@@ -152,6 +152,59 @@ float runSpatialPoolerTest(
 
 
 
+/**
+ * Measures the throughput of Connections::computeActivity. The presynaptic
+ * cells are the cells of the layer followed by the external inputs, as in
+ * a BM-CLA layer.
+ */
+float runComputeActivityTest(
+                  UInt   numCells,
+                  UInt   numExternalInputs,
+                  Real   inputSparsity,
+                  string label)
+{
+#ifdef NDEBUG
+  const auto numSteps = 2000u;
+#else
+  const auto numSteps = 20u;
+#endif
+  const UInt numSegmentsPerCell    = 4;
+  const UInt numSynapsesPerSegment = 32;
+  const UInt numPresynapticCells   = numCells + numExternalInputs;
+
+  // Initialize
+  Connections connections(numCells, 0.5f);
+  for (UInt cell = 0; cell < numCells; cell++) {
+    for (UInt i = 0; i < numSegmentsPerCell; i++) {
+      const Segment segment = connections.createSegment(cell, numSegmentsPerCell);
+      for (UInt j = 0; j < numSynapsesPerSegment; j++) {
+        connections.createSynapse(segment, rng.getUInt32(numPresynapticCells),
+                                  static_cast<Permanence>(rng.getReal64()));
+      }
+    }
+  }
+
+  vector<vector<CellIdx>> inputs;
+  SDR input({ numPresynapticCells });
+  for (UInt i = 0; i < 16; i++) {
+    input.randomize( inputSparsity, rng );
+    inputs.push_back( input.getSparse() );
+  }
+
+  // Compute
+  Timer timer(true);
+  for (auto i = 0u; i < numSteps; i++) {
+    connections.computeActivity( inputs[i % inputs.size()], false );
+  }
+  timer.stop();
+
+  cout << (float)timer.getElapsed() << " in " << label << ": "
+       << numSteps / timer.getElapsed() << " computeActivity/s" << endl;
+  return (float)timer.getElapsed();
+}
+
+
+
 // TESTS
 #if defined( NDEBUG) && !defined(NTA_OS_WINDOWS)
   const UInt COLS 	= 2048; //standard num of columns in SP/TM
@@ -206,4 +259,21 @@ TEST(ConnectionsPerformanceTest, testSP) {
   UNUSED(tim);
 }
 
+/**
+ * Tests the segment activity of a BM-CLA sized layer with the external
+ * inputs.
+ */
+TEST(ConnectionsPerformanceTest, testComputeActivity) {
+  auto tim = runComputeActivityTest(
+    /* numCells */           8192,
+    /* numExternalInputs */  8192,
+    /* inputSparsity */      0.02f,
+    /* label */              "compute activity");
+
+#ifdef NDEBUG
+  ASSERT_LE(tim, 1.0f * Timer::getSpeed());
+#endif
+  UNUSED(tim);
+}
+
 } // end namespace
@@ -136,6 +136,33 @@ TEST(ConnectionsTest, testCreateSynapseAvoidDuplicitPresynapticConnections) {
   ASSERT_EQ(connections.synapsesForSegment(segment).size(), numSynapses) << "Duplicit synapses should not be created!";
 }
 
+/**
+ * Creates synapses at once, and makes sure the result is the same as
+ * creating them one by one, duplicit cells included.
+ */
+TEST(ConnectionsTest, testCreateSynapses) {
+  Connections single(1024, 0.5f);
+  Connections batch(1024, 0.5f);
+  const vector<CellIdx> cells = {50, 51, 150, 7};
+  const vector<Permanence> perms = {0.34f, 0.6f, 0.48f, 0.9f};
+
+  for( auto *connections : {&single, &batch} ) {
+    const Segment segment = connections->createSegment(10);
+    connections->createSynapse(segment, 51, 0.2f);
+  }
+
+  for(size_t i = 0; i < cells.size(); i++) {
+    single.createSynapse(0, cells[i], perms[i]);
+  }
+  batch.createSynapses(0, cells, perms);
+
+  ASSERT_EQ(4ul, batch.numSynapses(0)) << "Duplicit synapses should not be created!";
+  ASSERT_EQ(single, batch);
+
+  batch.createSynapses(0, {}, 0.3f);
+  ASSERT_EQ(4ul, batch.numSynapses(0));
+}
+
 /**
  * Creates a segment, destroys it, and makes sure it got destroyed along with
  * all of its synapses.
@@ -170,6 +197,52 @@ TEST(ConnectionsTest, testDestroySegment) {
   ASSERT_EQ(0ul, numActivePotentialSynapsesForSegment[segment2]);
 }
 
+/**
+ * The relations are recorded only on request, and recording them does not
+ * change the activity.
+ */
+TEST(ConnectionsTest, testRecordRelations) {
+  Connections connections(1024);
+
+  const Segment segment = connections.createSegment(10);
+  connections.createSynapse(segment, 80, 0.85f);
+  connections.createSynapse(segment, 81, 0.15f);
+
+  ASSERT_FALSE(connections.getRecordRelations());
+
+  vector<SynapseIdx> numActivePotentialSynapsesForSegment(
+      connections.segmentFlatListLength(), 0);
+  const vector<SynapseIdx> numActiveConnectedSynapsesForSegment = connections.computeActivity(
+                              numActivePotentialSynapsesForSegment,
+                              {80, 81});
+
+  ASSERT_EQ(0ul, connections.getActiveRelationsForSegments().size());
+  ASSERT_EQ(0ul, connections.getMatchingRelationsForSegments().size());
+  ASSERT_EQ(vector<Segment>({segment}), connections.getActiveSegmentsTouched());
+  ASSERT_EQ(vector<Segment>({segment}), connections.getMatchingSegmentsTouched());
+
+  connections.setRecordRelations(true);
+  ASSERT_TRUE(connections.getRecordRelations());
+
+  vector<SynapseIdx> recordedPotential(connections.segmentFlatListLength(), 0);
+  const vector<SynapseIdx> recordedConnected = connections.computeActivity(
+                              recordedPotential,
+                              {80, 81});
+
+  ASSERT_EQ(numActiveConnectedSynapsesForSegment, recordedConnected);
+  ASSERT_EQ(numActivePotentialSynapsesForSegment, recordedPotential);
+
+  const auto active = connections.getActiveRelationsForSegments().at(segment);
+  const auto matching = connections.getMatchingRelationsForSegments().at(segment);
+  ASSERT_EQ(vector<CellIdx>({80}), vector<CellIdx>(active.begin(), active.end()));
+  // The matching relations add the unconnected synapses to the active ones.
+  ASSERT_EQ(vector<CellIdx>({81}), vector<CellIdx>(matching.begin(), matching.end()));
+
+  connections.setRecordRelations(false);
+  ASSERT_EQ(0ul, connections.getActiveRelationsForSegments().size());
+  ASSERT_EQ(0ul, connections.getMatchingRelationsForSegments().size());
+}
+
 /**
  * Creates a segment, creates a number of synapses on it, destroys a synapse,
  * and makes sure it got destroyed.
@@ -199,6 +272,91 @@ TEST(ConnectionsTest, testDestroySynapse) {
   ASSERT_EQ(2ul, numActivePotentialSynapsesForSegment[segment]);
 }
 
+/**
+ * Destroys a segment and a synapse, and makes sure their slots are reused
+ * only after the next computeActivity.
+ */
+TEST(ConnectionsTest, testReuseDestroyedSlots) {
+  Connections connections(1024);
+
+  Segment segment1 = connections.createSegment(10);
+  Segment segment2 = connections.createSegment(20);
+  Synapse synapse1 = connections.createSynapse(segment1, 80, 0.85f);
+  /*      synapse2*/ connections.createSynapse(segment1, 81, 0.85f);
+
+  connections.destroySegment(segment2);
+  connections.destroySynapse(synapse1);
+
+  // The slots are not reused in the same step.
+  Segment segment3 = connections.createSegment(30);
+  Synapse synapse3 = connections.createSynapse(segment3, 82, 0.85f);
+  ASSERT_NE(segment2, segment3);
+  ASSERT_NE(synapse1, synapse3);
+
+  vector<SynapseIdx> numActivePotentialSynapsesForSegment(
+      connections.segmentFlatListLength(), 0);
+  connections.computeActivity(numActivePotentialSynapsesForSegment, {80, 81, 82});
+
+  Segment segment4 = connections.createSegment(40);
+  Synapse synapse4 = connections.createSynapse(segment4, 83, 0.15f);
+  ASSERT_EQ(segment2, segment4);
+  ASSERT_EQ(synapse1, synapse4);
+  ASSERT_EQ(3u, connections.segmentFlatListLength());
+  ASSERT_EQ(3ul, connections.numSegments());
+  ASSERT_EQ(3ul, connections.numSynapses());
+
+  ASSERT_EQ(40u, connections.cellForSegment(segment4));
+  ASSERT_EQ(segment4, connections.segmentForSynapse(synapse4));
+  ASSERT_NEAR((Permanence)0.15, connections.dataForSynapse(synapse4).permanence, htm::Epsilon);
+}
+
+/**
+ * Destroys segments and synapses, compacts the connections, and makes sure
+ * the remaining ones are renumbered in order with the same activity.
+ */
+TEST(ConnectionsTest, testCompact) {
+  Connections connections(1024);
+
+  Segment segment1 = connections.createSegment(10);
+  Segment segment2 = connections.createSegment(20);
+  Segment segment3 = connections.createSegment(30);
+  connections.createSynapse(segment1, 80, 0.85f);
+  connections.createSynapse(segment2, 81, 0.85f);
+  Synapse synapse3 = connections.createSynapse(segment3, 82, 0.85f);
+  connections.createSynapse(segment3, 83, 0.15f);
+  Synapse synapse5 = connections.createSynapse(segment3, 84, 0.85f);
+
+  connections.destroySegment(segment2);
+  connections.destroySynapse(synapse3);
+
+  const ConnectionsRemap remap = connections.compact();
+
+  ASSERT_EQ(0u, remap.segments[segment1]);
+  ASSERT_EQ(ConnectionsRemap::removed, remap.segments[segment2]);
+  ASSERT_EQ(1u, remap.segments[segment3]);
+  ASSERT_EQ(ConnectionsRemap::removed, remap.synapses[synapse3]);
+  ASSERT_EQ(2u, remap.synapses[synapse5]);
+
+  ASSERT_EQ(2u, connections.segmentFlatListLength());
+  ASSERT_EQ(2ul, connections.numSegments());
+  ASSERT_EQ(3ul, connections.numSynapses());
+  ASSERT_EQ(30u, connections.cellForSegment(remap.segments[segment3]));
+  ASSERT_EQ(remap.segments[segment3],
+            connections.segmentForSynapse(remap.synapses[synapse5]));
+  ASSERT_EQ(vector<Segment>{remap.segments[segment3]},
+            connections.segmentsForCell(30));
+
+  vector<SynapseIdx> numActivePotentialSynapsesForSegment(
+      connections.segmentFlatListLength(), 0);
+  vector<SynapseIdx> numActiveConnectedSynapsesForSegment = connections.computeActivity(
+                              numActivePotentialSynapsesForSegment,
+                              {80, 81, 82, 83, 84});
+
+  ASSERT_EQ(1ul, numActiveConnectedSynapsesForSegment[0]);
+  ASSERT_EQ(1ul, numActiveConnectedSynapsesForSegment[1]);
+  ASSERT_EQ(2ul, numActivePotentialSynapsesForSegment[1]);
+}
+
 /**
  * Creates segments and synapses, then destroys segments and synapses on
  * either side of them and verifies that existing Segment and Synapse
@@ -394,6 +552,7 @@ TEST(ConnectionsTest, testAdaptSynapses) {
         con.createSynapse(seg, inp, permanences[cell][inp]);
     }
   }
+  Connections conBits = con;
 
   input.setDense(SDR_dense_t({ 1, 0, 0, 1, 1, 0, 1, 0 }));
   activeSegments.assign({0, 1, 2});
@@ -401,6 +560,13 @@ TEST(ConnectionsTest, testAdaptSynapses) {
   for(UInt seg : activeSegments)
     con.adaptSegment(seg, input, 0.1f, 0.01f);
 
+  // The Bitset overload learns the same.
+  Bitset inputBits(numInputs);
+  inputBits.assign(input.getSparse());
+  for(UInt seg : activeSegments)
+    conBits.adaptSegment(seg, inputBits, 0.1f, 0.01f);
+  ASSERT_EQ(con, conBits);
+
   for (UInt cell = 0; cell < numCells; cell++) {
     vector<Real> perms( numInputs, 0.0f );
     for( Synapse syn : con.synapsesForSegment(cell) ) {
@@ -742,6 +908,61 @@ TEST(ConnectionsTest, subscribe) {
   connections.unsubscribe(token);
 }
 
+class BatchedTestConnectionsEventHandler : public TestConnectionsEventHandler {
+public:
+  bool isBatched() const override { return true; }
+
+  void onEvents(const vector<ConnectionsEventRecord> &events) override {
+    numBatches++;
+    for( const auto &event : events )
+      types.push_back(event.type);
+    TestConnectionsEventHandler::onEvents(events);
+  }
+
+  UInt numBatches = 0;
+  vector<ConnectionsEventRecord::Type> types;
+};
+
+/**
+ * Make sure a batched event handler gets the events in order, and only
+ * when they are flushed.
+ */
+TEST(ConnectionsTest, subscribeBatched) {
+  using Type = ConnectionsEventRecord::Type;
+  Connections connections(1024, 0.5f);
+
+  auto *handler = new BatchedTestConnectionsEventHandler();
+  auto token = connections.subscribe(handler);
+
+  Segment segment = connections.createSegment(42);
+  Synapse synapse = connections.createSynapse(segment, 41, 0.25f);
+  connections.updateSynapsePermanence(synapse, 0.60f);
+  EXPECT_FALSE(handler->didCreateSegment);
+  EXPECT_EQ(0u, handler->numBatches);
+
+  connections.flushEvents();
+  EXPECT_TRUE(handler->didCreateSegment);
+  EXPECT_TRUE(handler->didCreateSynapse);
+  EXPECT_TRUE(handler->didUpdateSynapsePermanence);
+  EXPECT_EQ(1u, handler->numBatches);
+  const vector<Type> expected = {Type::CREATE_SEGMENT, Type::CREATE_SYNAPSE,
+                                 Type::UPDATE_SYNAPSE_PERMANENCE};
+  EXPECT_EQ(expected, handler->types);
+
+  // Nothing is logged, so nothing is passed.
+  connections.flushEvents();
+  EXPECT_EQ(1u, handler->numBatches);
+
+  // adaptSegment flushes its own events. The synapse is disconnected.
+  SDR inputs({1024});
+  connections.adaptSegment(segment, inputs, 0.1f, 0.2f);
+  EXPECT_EQ(2u, handler->numBatches);
+
+  connections.destroySegment(segment);
+  EXPECT_FALSE(handler->didDestroySegment);
+  connections.unsubscribe(token);
+}
+
 /**
  * Make sure the event handler is destructed on unsubscribe.
  */
@@ -0,0 +1,169 @@
+// AsyncCallbackTest.cpp
+
+/**
+ * @file
+ * Implementation of unit tests for AsyncCallback
+ */
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "cla/model/module/callback/AsyncCallback.hpp"
+#include "cla/model/module/callback/SnapshotCallback.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace cla;
+
+/**
+ * The callback records the steps of the snapshots. It can hold the
+ * background thread in the first snapshot until it is opened, so the
+ * queue fills up, and it can throw at a step.
+ */
+class RecordCallback : public SnapshotCallback {
+public:
+	vector<Step> steps;
+	atomic<bool> opened{true};
+	Step throwStep = static_cast<Step>(-1);
+	bool ended = false;
+
+	const SnapshotFields getSnapshotFields() const override {
+		return SnapshotField::NONE;
+	}
+
+	void doSnapshotProcessing(const StepSnapshot& snapshot) override {
+		while(!opened.load()) this_thread::yield();
+
+		if(snapshot.step == throwStep)
+			throw runtime_error("callback failed");
+
+		steps.push_back(snapshot.step);
+	}
+
+	void doEndProcessing(const CoreCLA*) override {
+		ended = true;
+	}
+};
+
+/**
+ * Run the steps through the AsyncCallback. The snapshots read no layer,
+ * so no model is needed.
+ */
+void runSteps(AsyncCallback& async, const Step nbSteps, RecordCallback& record) {
+	const cla::Values inputs{0.0}, nexts{0.0}, outputs{0.0};
+
+	async.doStartProcessing(nullptr);
+	for(Step step = 0u; step < nbSteps; ++step) {
+		async.doPostProcessing(step, inputs, nexts, outputs, nullptr);
+		if(step == 0u) record.opened.store(true);
+	}
+}
+
+vector<Step> range(const Step begin, const Step end, const Step interval = 1u) {
+	vector<Step> steps;
+	for(Step step = begin; step < end; step += interval) steps.push_back(step);
+	return steps;
+}
+
+/**
+ * The BLOCK policy waits for the free slots, so every step is passed in
+ * order even with a small queue.
+ */
+TEST(AsyncCallbackTest, testBlock) {
+	auto record = make_shared<RecordCallback>();
+	AsyncCallback async({record}, 2u, BackpressurePolicy::BLOCK);
+
+	record->opened.store(false);
+	runSteps(async, 500u, *record);
+	async.doEndProcessing(nullptr);
+
+	ASSERT_EQ(record->steps, range(0u, 500u));
+	ASSERT_EQ(async.getNbDropped(), 0u);
+	ASSERT_TRUE(record->ended);
+}
+
+/**
+ * The DROP policy drops the steps while the queue is full. The first
+ * snapshot holds the background thread, so the queue is full after the
+ * capacity steps and the next ones are dropped until it is opened.
+ */
+TEST(AsyncCallbackTest, testDrop) {
+	const size_t CAPACITY = 4u;
+	auto record = make_shared<RecordCallback>();
+	AsyncCallback async({record}, CAPACITY, BackpressurePolicy::DROP);
+	const cla::Values inputs{0.0}, nexts{0.0}, outputs{0.0};
+
+	record->opened.store(false);
+	async.doStartProcessing(nullptr);
+	for(Step step = 0u; step < 20u; ++step)
+		async.doPostProcessing(step, inputs, nexts, outputs, nullptr);
+
+	record->opened.store(true);
+	async.doEndProcessing(nullptr);
+
+	ASSERT_EQ(record->steps, range(0u, CAPACITY));
+	ASSERT_EQ(async.getNbDropped(), 20u - CAPACITY);
+}
+
+/**
+ * The SAMPLE policy passes only the steps on the interval, and drops
+ * them too when the queue is full.
+ */
+TEST(AsyncCallbackTest, testSample) {
+	auto record = make_shared<RecordCallback>();
+	AsyncCallback async({record}, 64u, BackpressurePolicy::SAMPLE, 3u);
+
+	runSteps(async, 100u, *record);
+	async.doEndProcessing(nullptr);
+
+	ASSERT_EQ(record->steps, range(0u, 100u, 3u));
+	ASSERT_EQ(async.getNbDropped(), 0u);
+
+	const cla::Values inputs{0.0}, nexts{0.0}, outputs{0.0};
+	record->steps.clear();
+	record->opened.store(false);
+	async.initialize({record}, 2u, BackpressurePolicy::SAMPLE, 3u);
+	async.doStartProcessing(nullptr);
+	for(Step step = 0u; step < 30u; ++step)
+		async.doPostProcessing(step, inputs, nexts, outputs, nullptr);
+
+	record->opened.store(true);
+	async.doEndProcessing(nullptr);
+
+	ASSERT_EQ(record->steps, range(0u, 6u, 3u));
+	ASSERT_EQ(async.getNbDropped(), 8u);
+}
+
+/**
+ * The exception of a callback on the background thread is rethrown by
+ * the end of the processing. The compute thread is not blocked by the
+ * full queue after the failure, and the callbacks are ended.
+ */
+TEST(AsyncCallbackTest, testException) {
+	auto record = make_shared<RecordCallback>();
+	record->throwStep = 5u;
+	AsyncCallback async({record}, 1u, BackpressurePolicy::BLOCK);
+
+	runSteps(async, 200u, *record);
+	ASSERT_THROW(async.doEndProcessing(nullptr), runtime_error);
+
+	ASSERT_EQ(record->steps, range(0u, 5u));
+	ASSERT_TRUE(record->ended);
+
+	// The error is reported once, and the callback can be run again.
+	ASSERT_NO_THROW(async.doEndProcessing(nullptr));
+
+	record->steps.clear();
+	record->throwStep = static_cast<Step>(-1);
+	runSteps(async, 10u, *record);
+	ASSERT_NO_THROW(async.doEndProcessing(nullptr));
+	ASSERT_EQ(record->steps, range(0u, 10u));
+}
+
+} // namespace testing
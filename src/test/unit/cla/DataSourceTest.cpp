@@ -0,0 +1,117 @@
+// DataSourceTest.cpp
+
+/**
+ * @file
+ * Implementation of unit tests for CsvSource and EnvSource
+ */
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cla/environment/DataSource.hpp"
+#include "cla/environment/Envs.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace cla;
+
+/**
+ * Read all the rows of the csv text.
+ */
+vector<cla::Values> readAll(const string& text) {
+	istringstream is(text);
+	CsvSource source(is, "csv");
+
+	vector<cla::Values> rows;
+	cla::Values values;
+	while(source.next(values)) rows.push_back(values);
+	return rows;
+}
+
+/**
+ * The header row, the comments and the blank lines are skipped, and the
+ * cells may have spaces around the values.
+ */
+TEST(DataSourceTest, testCsvHeader) {
+	const vector<cla::Values> expected = {{1.0, -2.5}, {0.125, 3e2}};
+
+	ASSERT_EQ(readAll("1,-2.5\n0.125,3e2\n"), expected);
+	ASSERT_EQ(readAll("a,b\n1,-2.5\n0.125,3e2"), expected);
+	ASSERT_EQ(readAll("# comment\n\na,b\n \t\n1 , -2.5\n# comment\n0.125,\t3e2\n"), expected);
+	ASSERT_TRUE(readAll("").empty());
+	ASSERT_TRUE(readAll("a,b\n").empty());
+}
+
+/**
+ * The carriage returns of the CRLF lines are dropped, also on the header
+ * and the blank lines.
+ */
+TEST(DataSourceTest, testCsvCarriageReturn) {
+	const vector<cla::Values> expected = {{1.0, 2.0}, {3.0, 4.0}};
+
+	ASSERT_EQ(readAll("a,b\r\n1,2\r\n\r\n3,4\r\n"), expected);
+	ASSERT_EQ(readAll("1,2\r\n3,4"), expected);
+}
+
+/**
+ * The rows with another number of the values, the cells which are not
+ * numbers after the first values, and a second header are errors.
+ */
+TEST(DataSourceTest, testCsvErrors) {
+	ASSERT_THROW(readAll("1,2\n3\n"), std::runtime_error);
+	ASSERT_THROW(readAll("1\n2,3\n"), std::runtime_error);
+	ASSERT_THROW(readAll("1,2\n3,\n"), std::runtime_error);
+	ASSERT_THROW(readAll("1,2\n3,4x\n"), std::runtime_error);
+	ASSERT_THROW(readAll("a,b\nc,d\n1,2\n"), std::runtime_error);
+	ASSERT_THROW(readAll("1,2\na,b\n"), std::runtime_error);
+
+	// The rows before the error are given.
+	istringstream is("1,2\n3,4\n5\n");
+	CsvSource source(is, "ragged");
+	cla::Values values;
+	ASSERT_TRUE(source.next(values));
+	ASSERT_TRUE(source.next(values));
+	ASSERT_EQ(values, cla::Values({3.0, 4.0}));
+	ASSERT_THROW(source.next(values), std::runtime_error);
+}
+
+/**
+ * The skip stops at the end of the source, and the next values follow
+ * the skipped ones.
+ */
+TEST(DataSourceTest, testSkip) {
+	istringstream is("v\n0\n1\n2\n3\n");
+	CsvSource source(is, "csv");
+	cla::Values values;
+
+	ASSERT_EQ(source.skip(2u), 2u);
+	ASSERT_TRUE(source.next(values));
+	ASSERT_EQ(values, cla::Values({2.0}));
+	ASSERT_EQ(source.skip(5u), 1u);
+	ASSERT_FALSE(source.next(values));
+}
+
+/**
+ * The environment source gives the values of the environment from its
+ * first step, and does not end.
+ */
+TEST(DataSourceTest, testEnvSource) {
+	PEnv env = Env<SawEnv>::make(10u);
+	PEnv expected = Env<SawEnv>::make(10u);
+	EnvSource source(env);
+	cla::Values values;
+
+	for(Step t = 0u; t < 25u; ++t) {
+		ASSERT_TRUE(source.next(values));
+		ASSERT_EQ(values, expected->getValues()) << "step " << t;
+		expected->increment();
+	}
+	ASSERT_EQ(source.skip(100u), 100u);
+}
+
+} // namespace testing
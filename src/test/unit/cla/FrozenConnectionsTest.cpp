@@ -0,0 +1,219 @@
+// FrozenConnectionsTest.cpp
+
+/**
+ * @file
+ * Implementation of unit tests for FrozenConnections
+ */
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <vector>
+
+#include "cla/extension/algorithms/FrozenConnections.hpp"
+#include "htm/types/Types.hpp"
+#include "htm/utils/Log.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+/**
+ * Copy the image into a buffer of words, so the image is aligned like a
+ * mapped file.
+ */
+vector<UInt32> freeze(const Connections& connections) {
+	stringstream ss;
+	const size_t bytes = FrozenConnections::write(ss, connections);
+	const string image = ss.str();
+	EXPECT_EQ(image.size(), bytes);
+
+	vector<UInt32> buffer((bytes + 3u) / 4u);
+	std::copy(image.begin(), image.end(), reinterpret_cast<char*>(buffer.data()));
+	return buffer;
+}
+
+/**
+ * Grow random segments and synapses, including the destroyed ones.
+ */
+void growConnections(Connections& connections, const UInt numInputs, Random& rng) {
+	for(CellIdx cell = 0u; cell < connections.numCells(); ++cell) {
+		const UInt nbSegments = rng.getUInt32(3u);
+		for(UInt i = 0u; i < nbSegments; ++i) {
+			const Segment segment = connections.createSegment(cell);
+			for(UInt j = 0u; j < 12u; ++j) {
+				const CellIdx presyn = rng.getUInt32(numInputs);
+				bool exists = false;
+				for(const Synapse syn : connections.synapsesForSegment(segment))
+					exists |= connections.dataForSynapse(syn).presynapticCell == presyn;
+				if(!exists)
+					connections.createSynapse(segment, presyn, rng.getReal64());
+			}
+		}
+	}
+
+	for(CellIdx cell = 0u; cell < connections.numCells(); cell += 7u) {
+		const auto segments = connections.segmentsForCell(cell);
+		if(!segments.empty()) connections.destroySegment(segments.front());
+	}
+}
+
+/**
+ * Update the checksum in the header after the image is edited, so the
+ * other checks of the validation are reached. The header has 10 words and
+ * the checksum is the last one.
+ */
+void updateChecksum(vector<UInt32>& image) {
+	UInt32 checksum = 2166136261u;
+	for(size_t i = 10u; i < image.size(); ++i) {
+		checksum ^= image[i];
+		checksum *= 16777619u;
+	}
+	image.at(9u) = checksum;
+}
+
+void expectSameRelations(
+	const SegmentRelations& relations,
+	const SegmentRelations& expected
+) {
+	ASSERT_EQ(relations.segments(), expected.segments());
+	for(size_t row = 0u; row < expected.size(); ++row) {
+		const auto cells = relations.cells(row);
+		const auto expectedCells = expected.cells(row);
+		ASSERT_EQ(
+			vector<CellIdx>(cells.begin(), cells.end()),
+			vector<CellIdx>(expectedCells.begin(), expectedCells.end())
+		);
+	}
+}
+
+/**
+ * The frozen view has the same segments and synapses as the connections.
+ */
+TEST(FrozenConnectionsTest, testStructure) {
+	Random rng(3);
+	Connections connections(200u, 0.5f);
+	growConnections(connections, 300u, rng);
+
+	const auto image = freeze(connections);
+	const FrozenConnections frozen(image.data(), image.size() * 4u);
+
+	ASSERT_EQ(frozen.numCells(), connections.numCells());
+	ASSERT_EQ(frozen.segmentFlatListLength(), connections.segmentFlatListLength());
+	ASSERT_EQ(frozen.numSegments(), connections.numSegments());
+	ASSERT_EQ(frozen.numSynapses(), connections.numSynapses());
+	ASSERT_EQ(frozen.getConnectedThreshold(), connections.getConnectedThreshold());
+
+	for(CellIdx cell = 0u; cell < connections.numCells(); ++cell) {
+		const auto& segments = connections.segmentsForCell(cell);
+		const auto frozenSegments = frozen.segmentsForCell(cell);
+		ASSERT_EQ(
+			vector<Segment>(frozenSegments.begin(), frozenSegments.end()), segments
+		);
+
+		for(const Segment segment : segments) {
+			ASSERT_EQ(frozen.cellForSegment(segment), cell);
+
+			const auto& synapses = connections.synapsesForSegment(segment);
+			const auto presyns = frozen.presynapticCellsForSegment(segment);
+			const auto permanences = frozen.permanencesForSegment(segment);
+			ASSERT_EQ(presyns.size(), synapses.size());
+			ASSERT_EQ(permanences.size(), synapses.size());
+
+			for(size_t i = 0u; i < synapses.size(); ++i) {
+				const auto& synData = connections.dataForSynapse(synapses[i]);
+				ASSERT_EQ(presyns[i], synData.presynapticCell);
+				ASSERT_EQ(permanences[i], synData.permanence);
+			}
+		}
+	}
+}
+
+/**
+ * The frozen view computes the same activity as the connections.
+ */
+TEST(FrozenConnectionsTest, testComputeActivity) {
+	Random rng(5);
+	Connections connections(500u, 0.5f);
+	growConnections(connections, 520u, rng);
+
+	const auto image = freeze(connections);
+	const FrozenConnections frozen(image.data(), image.size() * 4u);
+
+	for(UInt step = 0u; step < 20u; ++step) {
+		vector<CellIdx> active;
+		for(CellIdx cell = 0u; cell < 540u; ++cell)
+			if(rng.getReal64() < 0.2) active.push_back(cell);
+
+		vector<SynapseIdx> expectedConnected, expectedPotential;
+		vector<Segment> expectedActive, expectedMatching;
+		SegmentRelations expectedActiveRel, expectedMatchingRel;
+		connections.computeActivity(
+			active, expectedConnected, expectedPotential,
+			expectedActive, expectedMatching,
+			expectedActiveRel, expectedMatchingRel
+		);
+
+		vector<SynapseIdx> numConnected, numPotential;
+		vector<Segment> activeTouched, matchingTouched;
+		SegmentRelations activeRel, matchingRel;
+		frozen.computeActivity(
+			active, numConnected, numPotential,
+			activeTouched, matchingTouched, activeRel, matchingRel
+		);
+
+		ASSERT_EQ(numConnected, expectedConnected);
+		ASSERT_EQ(numPotential, expectedPotential);
+		ASSERT_EQ(activeTouched, expectedActive);
+		ASSERT_EQ(matchingTouched, expectedMatching);
+
+		expectSameRelations(activeRel, expectedActiveRel);
+		expectSameRelations(matchingRel, expectedMatchingRel);
+	}
+}
+
+/**
+ * The validation rejects the images whose checksum, offsets or indices are
+ * broken, and the unchecked attach still reads the trusted image.
+ */
+TEST(FrozenConnectionsTest, testValidation) {
+	Random rng(7);
+	Connections connections(200u, 0.5f);
+	growConnections(connections, 300u, rng);
+
+	const auto image = freeze(connections);
+	ASSERT_NO_THROW(FrozenConnections(image.data(), image.size() * 4u));
+
+	// The words of the header, then the offsets of the cells and the
+	// segments of the cells.
+	const size_t headerWords = 10u;
+	const size_t numCells = connections.numCells();
+
+	// A segment of a cell out of range.
+	auto broken = image;
+	broken.at(headerWords + numCells + 1u) = 0xffffffu;
+	updateChecksum(broken);
+	ASSERT_THROW(FrozenConnections(broken.data(), broken.size() * 4u), htm::Exception);
+
+	// A decreasing offset.
+	broken = image;
+	broken.at(headerWords + 1u) = broken.at(headerWords + 2u) + 1u;
+	updateChecksum(broken);
+	ASSERT_THROW(FrozenConnections(broken.data(), broken.size() * 4u), htm::Exception);
+
+	// A flipped bit of the last segment, caught only by the checksum.
+	broken = image;
+	broken.back() ^= 1u;
+	ASSERT_THROW(FrozenConnections(broken.data(), broken.size() * 4u), htm::Exception);
+	ASSERT_NO_THROW(FrozenConnections(broken.data(), broken.size() * 4u, false));
+
+	// The truncated image is rejected without the validation.
+	ASSERT_THROW(
+		FrozenConnections(image.data(), image.size() * 4u - 4u, false),
+		htm::Exception
+	);
+}
+
+} // namespace testing
@@ -0,0 +1,338 @@
+// HtmLayerTest.cpp
+
+/**
+ * @file
+ * Implementation of unit tests for HtmLayer
+ */
+
+#include "gtest/gtest.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cla/config/ModelConfig.hpp"
+#include "cla/config/builder/module/LayerBuilder.hpp"
+#include "cla/model/core/CoreLayer.hpp"
+#include "htm/types/Sdr.hpp"
+#include "htm/types/Types.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+using namespace cla;
+
+const UInt INPUT_SIZE = 400u;
+const UInt SEQUENCE_LENGTH = 8u;
+
+const json layerConfig = json::parse(R"json({
+	"MLCLA": {
+		"HtmLayer_00": {
+			"columnDimensions": [512],
+			"nbCellsForColumns": 4,
+			"nbRegions": 1,
+			"ActiveColumnSender": {},
+			"ActiveCellReceiver": {},
+			"HtmSpatialPooler": {
+				"potentialRadius": 20,
+				"potentialPct": 0.8,
+				"globalInhibition": true,
+				"localAreaDensity": 0.04,
+				"stimulusThreshold": 0,
+				"synPermInactiveDec": 0.008,
+				"symPermActiveInc": 0.05,
+				"symPermConnected": 0.1,
+				"synInitPermanence": 0.1,
+				"minPctOverlapDutyCycles": 0.0010,
+				"dutyCyclePeriod": 1000,
+				"boostStrength": 0.0,
+				"spVerbosity": 0,
+				"wrapAround": true,
+				"constSynInitPermanence": false
+			},
+			"HtmTemporalMemory": {
+				"activationThreshold" : 10,
+				"initialPermanence" : 0.2100,
+				"connectedPermanence" : 0.3,
+				"minThreshold" : 8,
+				"maxNewSynapseCount" : 20,
+				"permanenceIncrement" : 0.100,
+				"permanenceDecrement" : 0.100,
+				"predictedSegmentDecrement" : 0.005,
+				"maxSegmentsPerCell" : 255,
+				"maxSynapsesPerSegment" : 255,
+				"checkInputs" : true,
+				"exceptionHandling" : false,
+				"externalPredictiveInputs" : 0,
+				"synapseDestinationWeight" : 0.5,
+				"createSynWeight" : 0.0,
+				"destroySynWeight" : 0.0,
+				"activateWeight" : 0.0,
+				"capacityOfNbActiveSegments" : 50,
+				"capacityOfNbMatchingSegments" : 0,
+				"innerSegmentSelectorMode" : "Threshold",
+				"outerSegmentSelectorMode" : "Threshold",
+				"anomalyMode" : 1
+			},
+			"FullAccepter": {},
+			"DirectAdapter": {}
+		},
+		"ScalarIO": {
+			"nbInputs": 1,
+			"dimensions": [400],
+			"nbActiveBits": 21,
+			"mins": [-1.0],
+			"maxs": [1.0]
+		}
+	}
+})json");
+
+/**
+ * Build the single layer of the config with the given regions, threads
+ * and segments per cell, aligned as in the model. The seed is fixed, so
+ * the layers built with the same parameters are the same.
+ */
+PLayer buildLayer(
+	const UInt nbRegions,
+	const UInt nbThreads = 1u,
+	const UInt maxSegmentsPerCell = 255u
+) {
+	json config = layerConfig;
+	config["MLCLA"]["HtmLayer_00"]["nbRegions"] = nbRegions;
+	config["MLCLA"]["HtmLayer_00"]["nbThreads"] = nbThreads;
+	config["MLCLA"]["HtmLayer_00"]["HtmTemporalMemory"]["maxSegmentsPerCell"]
+		= maxSegmentsPerCell;
+
+	JsonConfig aligned(config);
+	aligned.getModel().setSeed(42);
+	aligned.align();
+	return LayerJsonBuilder::buildLayer(
+		"HtmLayer_00", aligned.getConfig().at("MLCLA").at("HtmLayer_00")
+	);
+}
+
+vector<SDR> makeSequence() {
+	Random rng(42);
+	vector<SDR> sequence;
+	for(UInt i = 0u; i < SEQUENCE_LENGTH; ++i) {
+		sequence.emplace_back(vector<UInt>{INPUT_SIZE});
+		sequence.back().randomize(0.05f, rng);
+	}
+	return sequence;
+}
+
+/**
+ * The predictive bits computed as before the connected bits table: the
+ * connected synapses of each predictive column are walked in the spatial
+ * pooler of its region, with the region-local column index and the bits
+ * offset by the region.
+ */
+void predictiveBitsByScan_(
+	const CoreLayer& layer,
+	vector<UInt>& sparse,
+	vector<NumCells>& data
+) {
+	const auto& columns = layer.getLayerProxy()->getPredictiveColumnsWithNbPCells();
+	const auto& columnsData = columns.getExDataDense();
+	const auto& sps = layer.getSPs();
+
+	const UInt nbRegions = static_cast<UInt>(sps.size());
+	const UInt nbColumnsByRegion = columns.size / nbRegions;
+	const UInt nbBitsByRegion = INPUT_SIZE / nbRegions;
+
+	data.assign(INPUT_SIZE, static_cast<NumCells>(0));
+	std::set<UInt> bits;
+
+	for(const auto column : columns.getSparse()) {
+		const UInt regionIdx = column / nbColumnsByRegion;
+		const auto& connections = sps.at(regionIdx)->getConnections();
+		const Segment segment = column - regionIdx * nbColumnsByRegion;
+
+		std::set<UInt> columnBits;
+		for(const Synapse synapse : connections.synapsesForSegment(segment)) {
+			const auto& synData = connections.dataForSynapse(synapse);
+			if(synData.permanence >= connections.getConnectedThreshold()) {
+				columnBits.insert(regionIdx * nbBitsByRegion + synData.presynapticCell);
+			}
+		}
+
+		for(const UInt bit : columnBits) {
+			bits.insert(bit);
+			data[bit] += columnsData[column];
+		}
+	}
+
+	sparse.assign(bits.begin(), bits.end());
+}
+
+/**
+ * The predictive bits looked up in the connected bits tables of the
+ * regions are the same as the scan over the SP synapses, while the SP
+ * and the TM learn.
+ */
+TEST(HtmLayerTest, testPredictiveBits) {
+	const auto sequence = makeSequence();
+
+	for(const UInt nbRegions : {1u, 2u, 4u}) {
+		PLayer layer = buildLayer(nbRegions);
+		SDR active;
+		UInt nbPredictedSteps = 0u;
+
+		for(UInt step = 0u; step < 10u * SEQUENCE_LENGTH; ++step) {
+			layer->forward(sequence[step % SEQUENCE_LENGTH], true, active);
+			const auto& proxy = layer->backward(true);
+
+			vector<UInt> expectedSparse;
+			vector<NumCells> expectedData;
+			predictiveBitsByScan_(*layer, expectedSparse, expectedData);
+
+			const auto& bits = proxy->getPredictiveBitsWithNbPCells();
+			ASSERT_EQ(bits.getSparse(), expectedSparse)
+				<< "regions " << nbRegions << ", step " << step;
+			ASSERT_EQ(bits.getExDataDense(), expectedData)
+				<< "regions " << nbRegions << ", step " << step;
+
+			if(!expectedSparse.empty()) nbPredictedSteps++;
+		}
+
+		ASSERT_GT(nbPredictedSteps, 0u) << "regions " << nbRegions;
+	}
+}
+
+/**
+ * The regions computed on several threads give bit-identical columns,
+ * cells and predictions to the serial regions, while the layer learns.
+ */
+TEST(HtmLayerTest, testThreads) {
+	const auto sequence = makeSequence();
+
+	for(const UInt nbRegions : {2u, 4u}) {
+		for(const UInt nbThreads : {2u, 4u}) {
+			PLayer parallel = buildLayer(nbRegions, nbThreads);
+			PLayer reference = buildLayer(nbRegions, 1u);
+			SDR serialActive, parallelActive;
+
+			for(UInt step = 0u; step < 10u * SEQUENCE_LENGTH; ++step) {
+				const SDR& input = sequence[step % SEQUENCE_LENGTH];
+				const bool learn = step % 5u != 4u;
+
+				reference->forward(input, learn, serialActive);
+				parallel->forward(input, learn, parallelActive);
+				const auto& expected = reference->backward(learn);
+				const auto& proxy = parallel->backward(learn);
+
+				ASSERT_EQ(parallelActive, serialActive)
+					<< "regions " << nbRegions << ", threads " << nbThreads << ", step " << step;
+				ASSERT_EQ(proxy->getActiveColumns(), expected->getActiveColumns())
+					<< "regions " << nbRegions << ", threads " << nbThreads << ", step " << step;
+				ASSERT_EQ(proxy->getActiveCells(), expected->getActiveCells())
+					<< "regions " << nbRegions << ", threads " << nbThreads << ", step " << step;
+				ASSERT_EQ(proxy->getPredictiveCells(), expected->getPredictiveCells())
+					<< "regions " << nbRegions << ", threads " << nbThreads << ", step " << step;
+			}
+
+			for(UInt i = 0u; i < nbRegions; ++i) {
+				ASSERT_EQ(
+					parallel->getSPs().at(i)->getConnections(),
+					reference->getSPs().at(i)->getConnections()
+				) << "regions " << nbRegions << ", threads " << nbThreads << ", region " << i;
+			}
+		}
+	}
+}
+
+/**
+ * The compacted layer and its stream state go on exactly as the layer
+ * and the stream state that are not compacted. The few segments per cell
+ * make the layer destroy segments while it learns random inputs, and the
+ * sequence makes the segments active when the layer is compacted.
+ */
+TEST(HtmLayerTest, testCompact) {
+	PLayer layer = buildLayer(2u, 1u, 2u);
+	PLayer reference = buildLayer(2u, 1u, 2u);
+
+	const auto sequence = makeSequence();
+	Random rng(5);
+	SDR noise({INPUT_SIZE}), active, expectedActive;
+
+	const auto step = [&](const SDR& input, const bool learn) {
+		layer->restate();
+		reference->restate();
+		layer->forward(input, learn, active);
+		reference->forward(input, learn, expectedActive);
+		layer->backward(learn);
+		reference->backward(learn);
+	};
+
+	for(UInt i = 0u; i < 300u; ++i) {
+		noise.randomize(0.05f, rng);
+		step(noise, true);
+	}
+	for(UInt i = 0u; i < 10u * SEQUENCE_LENGTH; ++i)
+		step(sequence[i % SEQUENCE_LENGTH], true);
+
+	PLayerState state = layer->forkState();
+	PLayerState expectedState = reference->forkState();
+
+	ASSERT_FALSE(layer->getLayerProxy()->getActiveSegments().empty());
+	ASSERT_GT(layer->getFragmentation(), 0.0f);
+	layer->compact({state.get()});
+	ASSERT_EQ(layer->getFragmentation(), 0.0f);
+	ASSERT_EQ(
+		layer->getTM()->getConnections().numSegments(),
+		reference->getTM()->getConnections().numSegments()
+	);
+
+	// The renumbered active segments are on the same cells.
+	const auto cellsOfSegments = [](const CoreLayer& l, const SDR_sparse_t& segments) {
+		vector<CellIdx> cells;
+		for(const auto segment : segments) cells.push_back(l.getTM()->cellForSegment(segment));
+		return cells;
+	};
+	ASSERT_EQ(
+		cellsOfSegments(*layer, layer->getLayerProxy()->getActiveSegments()),
+		cellsOfSegments(*reference, reference->getLayerProxy()->getActiveSegments())
+	);
+	ASSERT_EQ(
+		cellsOfSegments(*layer, state->container.activeSegments),
+		cellsOfSegments(*reference, expectedState->container.activeSegments)
+	);
+
+	for(UInt i = 0u; i < 10u * SEQUENCE_LENGTH; ++i) {
+		const SDR& input = sequence[i % SEQUENCE_LENGTH];
+		step(input, i % 4u != 3u);
+
+		const auto& proxy = layer->getLayerProxy();
+		const auto& expected = reference->getLayerProxy();
+		ASSERT_EQ(active, expectedActive) << "step " << i;
+		ASSERT_EQ(proxy->getActiveCells(), expected->getActiveCells()) << "step " << i;
+		ASSERT_EQ(proxy->getPredictiveCells(), expected->getPredictiveCells()) << "step " << i;
+		ASSERT_EQ(
+			layer->getTM()->getConnections().numSynapses(),
+			reference->getTM()->getConnections().numSynapses()
+		) << "step " << i;
+
+		// The stream states continue without learning from the fork.
+		SDR streamActive, expectedStreamActive;
+		layer->restate(*state);
+		reference->restate(*expectedState);
+		layer->forward(input, *state, streamActive);
+		reference->forward(input, *expectedState, expectedStreamActive);
+		layer->backward(*state);
+		reference->backward(*expectedState);
+
+		ASSERT_EQ(streamActive, expectedStreamActive) << "step " << i;
+		ASSERT_EQ(
+			state->proxy->getActiveCells(),
+			expectedState->proxy->getActiveCells()
+		) << "step " << i;
+		ASSERT_EQ(
+			state->proxy->getPredictiveCells(),
+			expectedState->proxy->getPredictiveCells()
+		) << "step " << i;
+	}
+}
+
+} // namespace testing
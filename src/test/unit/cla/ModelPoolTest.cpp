@@ -0,0 +1,155 @@
+// ModelPoolTest.cpp
+
+/**
+ * @file
+ * Implementation of unit tests for ModelPool
+ */
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <vector>
+
+#include "cla/config/ModelConfig.hpp"
+#include "cla/model/ModelPool.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace cla;
+
+const json poolConfig = json::parse(R"json({
+	"MLCLA": {
+		"HtmLayer_00": {
+			"columnDimensions": [256],
+			"nbCellsForColumns": 4,
+			"nbRegions": 1,
+			"ActiveColumnSender": {},
+			"ActiveCellReceiver": {},
+			"HtmSpatialPooler": {
+				"potentialRadius": 20,
+				"potentialPct": 1.0,
+				"globalInhibition": true,
+				"localAreaDensity": 0.04,
+				"stimulusThreshold": 0,
+				"synPermInactiveDec": 0.00025225,
+				"symPermActiveInc": 0.1,
+				"symPermConnected": 0.1,
+				"synInitPermanence": 0.2,
+				"minPctOverlapDutyCycles": 0.0010,
+				"dutyCyclePeriod": 1000,
+				"boostStrength": 0.0,
+				"spVerbosity": 0,
+				"wrapAround": true,
+				"constSynInitPermanence": true
+			},
+			"HtmTemporalMemory": {
+				"activationThreshold" : 10,
+				"initialPermanence" : 0.2100,
+				"connectedPermanence" : 0.3,
+				"minThreshold" : 8,
+				"maxNewSynapseCount" : 20,
+				"permanenceIncrement" : 0.100,
+				"permanenceDecrement" : 0.100,
+				"predictedSegmentDecrement" : 0.005,
+				"maxSegmentsPerCell" : 255,
+				"maxSynapsesPerSegment" : 255,
+				"checkInputs" : true,
+				"exceptionHandling" : false,
+				"externalPredictiveInputs" : 0,
+				"synapseDestinationWeight" : 0.5,
+				"createSynWeight" : 0.0,
+				"destroySynWeight" : 0.0,
+				"activateWeight" : 0.0,
+				"capacityOfNbActiveSegments" : 50,
+				"capacityOfNbMatchingSegments" : 0,
+				"innerSegmentSelectorMode" : "Threshold",
+				"outerSegmentSelectorMode" : "Threshold",
+				"anomalyMode" : 1
+			},
+			"FullAccepter": {},
+			"DirectAdapter": {}
+		},
+		"ScalarIO": {
+			"nbInputs": 1,
+			"dimensions": [201],
+			"nbActiveBits": 21,
+			"mins": [-1.0],
+			"maxs": [1.0]
+		}
+	}
+})json");
+
+const size_t NB_MODELS = 4u;
+
+/**
+ * The config with a fixed seed, so the models built from it are the same.
+ */
+JsonConfig makeConfig() {
+	JsonConfig config(poolConfig);
+	config.getModel().setSeed(42);
+	return config;
+}
+
+/**
+ * A batch with several inputs for some models, in a shuffled model
+ * order. Each model sees its own phase of a sine wave.
+ */
+vector<ModelInput> makeBatch(const size_t step, htm::Random& rng) {
+	vector<ModelInput> batch;
+	for(ModelId id = 0u; id < NB_MODELS; ++id) {
+		const size_t nbInputs = 1u + rng.getUInt32(3u);
+		for(size_t k = 0u; k < nbInputs; ++k) {
+			const double t = static_cast<double>(3u * step + k);
+			batch.push_back({id, {std::sin(0.3 * t + static_cast<double>(id))}});
+		}
+	}
+	rng.shuffle(batch.begin(), batch.end());
+	return batch;
+}
+
+/**
+ * The predictions come back in the order of the batch, and the inputs of
+ * each model are fed in their submission order, so the pool predicts the
+ * same as the models run one by one.
+ */
+TEST(ModelPoolTest, testOrder) {
+	vector<JsonConfig> configs(NB_MODELS, makeConfig());
+	ModelPool pool(configs, 3u);
+	ASSERT_EQ(pool.size(), NB_MODELS);
+	ASSERT_EQ(pool.getNbThreads(), 3u);
+
+	vector<PCLA> references;
+	for(size_t i = 0u; i < NB_MODELS; ++i) {
+		references.emplace_back(makeConfig().buildModel());
+	}
+
+	htm::Random rng(42);
+	for(size_t step = 0u; step < 60u; ++step) {
+		// The reset in the middle restarts every model.
+		if(step == 30u) {
+			pool.reset();
+			for(auto& reference : references) reference->reset();
+		}
+
+		const auto batch = makeBatch(step, rng);
+		const auto predictions = pool.feedforward(batch, true);
+		ASSERT_EQ(predictions.size(), batch.size());
+
+		for(size_t i = 0u; i < batch.size(); ++i) {
+			const auto& input = batch.at(i);
+			ASSERT_EQ(
+				predictions.at(i),
+				references.at(input.modelId)->feedforward(input.values, true)
+			) << "step " << step << ", input " << i;
+		}
+
+		pool.feedback(batch, true);
+		for(const auto& input : batch) {
+			references.at(input.modelId)->feedback(input.values, true);
+		}
+	}
+}
+
+} // namespace testing
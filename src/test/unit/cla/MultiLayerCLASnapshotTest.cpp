@@ -0,0 +1,781 @@
+// MultiLayerCLASnapshotTest.cpp
+
+/**
+ * @file
+ * Implementation of unit tests for the snapshot of MultiLayerCLA
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cla/config/ModelConfig.hpp"
+#include "cla/environment/DataSource.hpp"
+#include "cla/extension/algorithms/TemporalMemoryExtension.hpp"
+#include "cla/model/ModelImage.hpp"
+#include "cla/model/module/callback/CheckpointCallback.hpp"
+#include "cla/model/module/tm/HtmTemporalMemory.hpp"
+#include "htm/types/Types.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace cla;
+
+const json snapshotConfig = json::parse(R"json({
+	"MLCLA": {
+		"HtmLayer_00": {
+			"columnDimensions": [512],
+			"nbCellsForColumns": 4,
+			"nbRegions": 1,
+			"ActiveColumnSender": {},
+			"ActiveCellReceiver": {},
+			"HtmSpatialPooler": {
+				"potentialRadius": 20,
+				"potentialPct": 1.0,
+				"globalInhibition": true,
+				"localAreaDensity": 0.04,
+				"stimulusThreshold": 0,
+				"synPermInactiveDec": 0.00025225,
+				"symPermActiveInc": 0.1,
+				"symPermConnected": 0.1,
+				"synInitPermanence": 0.2,
+				"minPctOverlapDutyCycles": 0.0010,
+				"dutyCyclePeriod": 1000,
+				"boostStrength": 0.0,
+				"spVerbosity": 0,
+				"wrapAround": true,
+				"constSynInitPermanence": true
+			},
+			"HtmTemporalMemory": {
+				"activationThreshold" : 10,
+				"initialPermanence" : 0.2100,
+				"connectedPermanence" : 0.3,
+				"minThreshold" : 8,
+				"maxNewSynapseCount" : 20,
+				"permanenceIncrement" : 0.100,
+				"permanenceDecrement" : 0.100,
+				"predictedSegmentDecrement" : 0.005,
+				"maxSegmentsPerCell" : 255,
+				"maxSynapsesPerSegment" : 255,
+				"checkInputs" : true,
+				"exceptionHandling" : false,
+				"externalPredictiveInputs" : 0,
+				"synapseDestinationWeight" : 0.5,
+				"createSynWeight" : 0.0,
+				"destroySynWeight" : 0.0,
+				"activateWeight" : 0.0,
+				"capacityOfNbActiveSegments" : 50,
+				"capacityOfNbMatchingSegments" : 0,
+				"innerSegmentSelectorMode" : "Threshold",
+				"outerSegmentSelectorMode" : "Threshold",
+				"anomalyMode" : 1
+			},
+			"IntensityAccepter": {
+				"intensityThreshold" : 10
+			},
+			"DirectAdapter": {}
+		},
+		"HtmLayer_01": {
+			"columnDimensions": [512],
+			"nbCellsForColumns": 4,
+			"nbRegions": 1,
+			"BurstColumnSender": {},
+			"VolatileActCellReceiver": {
+				"volatileRate" : 0.75,
+				"volatileThreshold" : 0.1
+			},
+			"HtmSpatialPooler": {
+				"potentialRadius": 20,
+				"potentialPct": 1.0,
+				"globalInhibition": true,
+				"localAreaDensity": 0.04,
+				"stimulusThreshold": 0,
+				"synPermInactiveDec": 0.00025225,
+				"symPermActiveInc": 0.1,
+				"symPermConnected": 0.1,
+				"synInitPermanence": 0.2,
+				"minPctOverlapDutyCycles": 0.0010,
+				"dutyCyclePeriod": 1000,
+				"boostStrength": 0.0,
+				"spVerbosity": 0,
+				"wrapAround": true,
+				"constSynInitPermanence": true
+			},
+			"HtmTemporalMemory": {
+				"activationThreshold" : 10,
+				"initialPermanence" : 0.2100,
+				"connectedPermanence" : 0.3,
+				"minThreshold" : 8,
+				"maxNewSynapseCount" : 20,
+				"permanenceIncrement" : 0.100,
+				"permanenceDecrement" : 0.100,
+				"predictedSegmentDecrement" : 0.005,
+				"maxSegmentsPerCell" : 255,
+				"maxSynapsesPerSegment" : 255,
+				"checkInputs" : true,
+				"exceptionHandling" : false,
+				"externalPredictiveInputs" : 0,
+				"synapseDestinationWeight" : 0.5,
+				"createSynWeight" : 0.0,
+				"destroySynWeight" : 0.0,
+				"activateWeight" : 0.0,
+				"capacityOfNbActiveSegments" : 50,
+				"capacityOfNbMatchingSegments" : 0,
+				"innerSegmentSelectorMode" : "Threshold",
+				"outerSegmentSelectorMode" : "Threshold",
+				"anomalyMode" : 1
+			},
+			"FullAccepter": {},
+			"DirectAdapter": {}
+		},
+		"ScalarIO": {
+			"nbInputs": 1,
+			"dimensions": [201],
+			"nbActiveBits": 21,
+			"mins": [-1.0],
+			"maxs": [1.0]
+		}
+	}
+})json");
+
+cla::Values snapshotInput(const Step t) {
+	return {std::sin(0.3 * static_cast<double>(t))
+		* std::cos(0.05 * static_cast<double>(t))};
+}
+
+void runSteps(PCLA& model, const Step first, const Step last) {
+	for(Step t = first; t < last; ++t) {
+		model->feedforward(snapshotInput(t), true);
+		model->feedback(snapshotInput(t + 1u), true);
+	}
+}
+
+/**
+ * A model loaded from the snapshot continues exactly like the saved model:
+ * the predictions, the cells and the synapses are the same at every step.
+ */
+TEST(MultiLayerCLASnapshotTest, testSaveLoad) {
+	const string path = "MultiLayerCLASnapshotTest.bin";
+
+	JsonConfig config(snapshotConfig);
+	PCLA saved = config.buildModel();
+	runSteps(saved, 0u, 300u);
+	saved->save(path);
+
+	PCLA loaded = config.buildModel();
+	loaded->load(path);
+	std::remove(path.c_str());
+
+	for(Step t = 300u; t < 500u; ++t) {
+		const auto expected = saved->feedforward(snapshotInput(t), true);
+		const auto predictions = loaded->feedforward(snapshotInput(t), true);
+		ASSERT_EQ(predictions, expected) << "step " << t;
+
+		const auto savedLayers = saved->getLayers();
+		const auto loadedLayers = loaded->getLayers();
+		ASSERT_EQ(loadedLayers.size(), savedLayers.size());
+
+		for(size_t i = 0u; i < savedLayers.size(); ++i) {
+			ASSERT_EQ(
+				loadedLayers.at(i)->getActiveCells(),
+				savedLayers.at(i)->getActiveCells()
+			) << "step " << t << ", layer " << i;
+			ASSERT_EQ(
+				loadedLayers.at(i)->getPredictiveCells(),
+				savedLayers.at(i)->getPredictiveCells()
+			) << "step " << t << ", layer " << i;
+			ASSERT_EQ(
+				loadedLayers.at(i)->getNbTmSynapses(),
+				savedLayers.at(i)->getNbTmSynapses()
+			) << "step " << t << ", layer " << i;
+			ASSERT_EQ(
+				loadedLayers.at(i)->getTmAnomaly(),
+				savedLayers.at(i)->getTmAnomaly()
+			) << "step " << t << ", layer " << i;
+		}
+
+		saved->feedback(snapshotInput(t + 1u), true);
+		loaded->feedback(snapshotInput(t + 1u), true);
+	}
+}
+
+void expectSameModels(PCLA& model, PCLA& expected, const Step first, const Step last) {
+	for(Step t = first; t < last; ++t) {
+		ASSERT_EQ(
+			model->feedforward(snapshotInput(t), true),
+			expected->feedforward(snapshotInput(t), true)
+		) << "step " << t;
+
+		const auto layers = model->getLayers();
+		const auto expectedLayers = expected->getLayers();
+		for(size_t i = 0u; i < layers.size(); ++i) {
+			ASSERT_EQ(
+				layers.at(i)->getActiveCells(),
+				expectedLayers.at(i)->getActiveCells()
+			) << "step " << t << ", layer " << i;
+			ASSERT_EQ(
+				layers.at(i)->getNbTmSynapses(),
+				expectedLayers.at(i)->getNbTmSynapses()
+			) << "step " << t << ", layer " << i;
+		}
+
+		model->feedback(snapshotInput(t + 1u), true);
+		expected->feedback(snapshotInput(t + 1u), true);
+	}
+}
+
+/**
+ * A snapshot which does not match the model is rejected, and the model is
+ * left as it was, also when the mismatch is found after some layers.
+ */
+TEST(MultiLayerCLASnapshotTest, testLoadMismatch) {
+	const string path = "MultiLayerCLASnapshotTest_mismatch.bin";
+
+	JsonConfig config(snapshotConfig);
+	PCLA saved = config.buildModel();
+	runSteps(saved, 0u, 300u);
+	saved->save(path);
+
+	// The io is loaded after all layers, and the upper layer after the
+	// lower one.
+	json ioMismatch = snapshotConfig;
+	ioMismatch["MLCLA"]["ScalarIO"]["nbActiveBits"] = 15;
+	json layerMismatch = snapshotConfig;
+	layerMismatch["MLCLA"]["HtmLayer_01"]["nbCellsForColumns"] = 8;
+
+	for(const auto& mismatch : {ioMismatch, layerMismatch}) {
+		JsonConfig mismatchConfig(mismatch);
+		mismatchConfig.getModel().setSeed(42);
+		PCLA model = mismatchConfig.buildModel();
+		PCLA reference = mismatchConfig.buildModel();
+		runSteps(model, 0u, 100u);
+		runSteps(reference, 0u, 100u);
+
+		ASSERT_THROW(model->load(path), std::runtime_error);
+
+		expectSameModels(model, reference, 100u, 200u);
+	}
+
+	std::remove(path.c_str());
+}
+
+/**
+ * A model recovered from the last snapshot and the write-ahead log is the
+ * same as the live model, also when the last record of the log is torn.
+ */
+TEST(MultiLayerCLASnapshotTest, testCheckpointRecover) {
+	const string path = "MultiLayerCLASnapshotTest_checkpoint";
+
+	JsonConfig config(snapshotConfig);
+	PCLA live = config.buildModel();
+
+	// The steps of the fit, which stops without the end of the processing.
+	CheckpointCallback checkpoint(path, 100u);
+	checkpoint.doStartProcessing(live.get());
+	for(Step t = 0u; t < 250u; ++t) {
+		checkpoint.doPreProcessing(t, snapshotInput(t), live.get());
+		const auto outputs = live->feedforward(snapshotInput(t), true);
+		checkpoint.doPostProcessing(
+			t, snapshotInput(t), snapshotInput(t + 1u), outputs, live.get()
+		);
+		live->feedback(snapshotInput(t + 1u), true);
+	}
+	checkpoint.close();
+
+	// Only the last generation is kept.
+	size_t nbFiles = 0u;
+	for(const auto& entry : std::filesystem::directory_iterator(path)) {
+		(void)entry;
+		++nbFiles;
+	}
+	ASSERT_EQ(nbFiles, 2u);
+
+	{
+		std::ofstream wal(path + "/checkpoint_200.wal", std::ios_base::app | std::ios_base::binary);
+		const char torn[5] = {1, 2, 3, 4, 5};
+		wal.write(torn, sizeof(torn));
+	}
+
+	PCLA recovered = config.buildModel();
+	ASSERT_EQ(CheckpointCallback::recover(*recovered, path), 250u);
+
+	expectSameModels(recovered, live, 250u, 350u);
+
+	std::filesystem::remove_all(path);
+}
+
+/**
+ * A processing resumed from the checkpoint counts the steps through, and
+ * replaces the old generation only after its first snapshot.
+ */
+TEST(MultiLayerCLASnapshotTest, testCheckpointResume) {
+	const string path = "MultiLayerCLASnapshotTest_resume";
+	std::filesystem::remove_all(path);
+	ASSERT_FALSE(CheckpointCallback::hasCheckpoint(path));
+
+	JsonConfig config(snapshotConfig);
+	PCLA live = config.buildModel();
+	PCLA resumed;
+
+	const auto run = [](CheckpointCallback& checkpoint, PCLA& model, const Step first, const Step last) {
+		checkpoint.doStartProcessing(model.get());
+		for(Step t = first; t < last; ++t) {
+			checkpoint.doPreProcessing(t, snapshotInput(t), model.get());
+			const auto outputs = model->feedforward(snapshotInput(t), true);
+			checkpoint.doPostProcessing(
+				t, snapshotInput(t), snapshotInput(t + 1u), outputs, model.get()
+			);
+			model->feedback(snapshotInput(t + 1u), true);
+		}
+		checkpoint.close();
+	};
+
+	CheckpointCallback first(path, 100u);
+	run(first, live, 0u, 150u);
+	ASSERT_TRUE(CheckpointCallback::hasCheckpoint(path));
+
+	resumed = config.buildModel();
+	const Step firstStep = CheckpointCallback::recover(*resumed, path);
+	ASSERT_EQ(firstStep, 150u);
+
+	CheckpointCallback second(path, 100u, true, firstStep);
+	run(second, resumed, firstStep, 220u);
+	ASSERT_TRUE(std::filesystem::exists(path + "/checkpoint_150.bin"));
+	ASSERT_FALSE(std::filesystem::exists(path + "/checkpoint_100.bin"));
+	ASSERT_FALSE(std::filesystem::exists(path + "/checkpoint_100.wal"));
+
+	for(Step t = 150u; t < 220u; ++t) {
+		live->feedforward(snapshotInput(t), true);
+		live->feedback(snapshotInput(t + 1u), true);
+	}
+
+	PCLA recovered = config.buildModel();
+	ASSERT_EQ(CheckpointCallback::recover(*recovered, path), 220u);
+
+	expectSameModels(recovered, live, 220u, 300u);
+
+	std::filesystem::remove_all(path);
+}
+
+/**
+ * A processing of a csv source resumed from the checkpoint skips the rows
+ * which the recovered model processed, and continues like the live model.
+ * Without a checkpoint the source is not read, and a source which ends
+ * before the checkpoint is an error.
+ */
+TEST(MultiLayerCLASnapshotTest, testCheckpointResumeSource) {
+	const string path = "MultiLayerCLASnapshotTest_resume_source";
+	std::filesystem::remove_all(path);
+
+	std::ostringstream csv;
+	csv << "value\r\n" << std::setprecision(std::numeric_limits<Value>::max_digits10);
+	for(Step t = 0u; t < 300u; ++t) csv << snapshotInput(t).front() << "\r\n";
+
+	JsonConfig config(snapshotConfig);
+	PCLA live = config.buildModel();
+	PCLA resumed = config.buildModel();
+
+	{
+		std::istringstream is(csv.str());
+		CsvSource source(is, "csv");
+		ASSERT_EQ(CheckpointCallback::resume(*resumed, path, source), 0u);
+
+		cla::Values values;
+		ASSERT_TRUE(source.next(values));
+		ASSERT_EQ(values, snapshotInput(0u));
+	}
+
+	// The processing reads the source one step ahead and stops without
+	// the end of the processing.
+	{
+		std::istringstream is(csv.str());
+		CsvSource source(is, "csv");
+		cla::Values inputs, nexts;
+		ASSERT_TRUE(source.next(inputs));
+
+		CheckpointCallback checkpoint(path, 100u);
+		checkpoint.doStartProcessing(live.get());
+		for(Step t = 0u; t < 150u; ++t) {
+			ASSERT_TRUE(source.next(nexts));
+			checkpoint.doPreProcessing(t, inputs, live.get());
+			const auto outputs = live->feedforward(inputs, true);
+			checkpoint.doPostProcessing(t, inputs, nexts, outputs, live.get());
+			live->feedback(nexts, true);
+			inputs.swap(nexts);
+		}
+		checkpoint.close();
+	}
+
+	{
+		std::istringstream is(csv.str());
+		CsvSource source(is, "csv");
+		ASSERT_EQ(CheckpointCallback::resume(*resumed, path, source), 150u);
+
+		cla::Values values;
+		ASSERT_TRUE(source.next(values));
+		ASSERT_EQ(values, snapshotInput(150u));
+	}
+
+	expectSameModels(resumed, live, 150u, 250u);
+
+	{
+		std::istringstream is("value\n0.5\n0.25\n");
+		CsvSource source(is, "short");
+		PCLA model = config.buildModel();
+		ASSERT_THROW(CheckpointCallback::resume(*model, path, source), std::runtime_error);
+	}
+
+	std::filesystem::remove_all(path);
+}
+
+/**
+ * The rollout feeds the predictions back on a fork, so it gives the same
+ * forecast as a copy of the model without learning, while the model and
+ * the forked stream are not changed.
+ */
+TEST(MultiLayerCLASnapshotTest, testRollout) {
+	const string path = "MultiLayerCLASnapshotTest_rollout.bin";
+	const Step horizon = 24u;
+
+	JsonConfig config(snapshotConfig);
+	PCLA model = config.buildModel();
+	runSteps(model, 0u, 300u);
+	const auto last = model->feedforward(snapshotInput(300u), true);
+	model->save(path);
+
+	PCLA copied = config.buildModel();
+	copied->load(path);
+	PCLA reference = config.buildModel();
+	reference->load(path);
+	std::remove(path.c_str());
+
+	const auto forecasts = model->rollout(horizon);
+	ASSERT_EQ(forecasts.size(), horizon);
+	ASSERT_EQ(forecasts.front(), last);
+
+	for(Step k = 1u; k < horizon; ++k) {
+		ASSERT_EQ(
+			forecasts.at(k), copied->feedforward(forecasts.at(k - 1u), false)
+		) << "step " << k;
+	}
+
+	// The forked stream forecasts the same and is not changed either.
+	const StreamState state = model->fork();
+	ASSERT_EQ(model->rollout(state, horizon), forecasts);
+	ASSERT_EQ(model->rollout(state, horizon), forecasts);
+	ASSERT_TRUE(model->rollout(0u).empty());
+
+	model->feedback(snapshotInput(301u), true);
+	reference->feedback(snapshotInput(301u), true);
+	expectSameModels(model, reference, 301u, 400u);
+}
+
+/**
+ * The stream inference gives the same predictions and cells as the
+ * feedforward without learning, both from a fork of the model and from a
+ * new stream state after a reset.
+ */
+TEST(MultiLayerCLASnapshotTest, testStreamInference) {
+	JsonConfig config(snapshotConfig);
+	PCLA model = config.buildModel();
+	runSteps(model, 0u, 300u);
+
+	const auto expectSameStream = [&](StreamState& state, const Step first, const Step last) {
+		for(Step t = first; t < last; ++t) {
+			const auto expected = model->feedforward(snapshotInput(t), false);
+			ASSERT_EQ(model->feedforward(snapshotInput(t), state), expected) << "step " << t;
+
+			const auto layers = model->getLayers();
+			ASSERT_EQ(state.layers.size(), layers.size());
+			for(size_t i = 0u; i < layers.size(); ++i) {
+				ASSERT_EQ(
+					state.layers.at(i)->proxy->getActiveCells(),
+					layers.at(i)->getActiveCells()
+				) << "step " << t << ", layer " << i;
+				ASSERT_EQ(
+					state.layers.at(i)->proxy->getPredictiveCells(),
+					layers.at(i)->getPredictiveCells()
+				) << "step " << t << ", layer " << i;
+			}
+		}
+	};
+
+	StreamState forked = model->fork();
+	expectSameStream(forked, 300u, 400u);
+
+	model->reset();
+	StreamState fresh = model->makeStreamState();
+	expectSameStream(fresh, 400u, 500u);
+}
+
+/**
+ * The fork carries the anomaly likelihood of the model, so the forked
+ * stream gives the same likelihood as the feedforward without learning.
+ * The likelihood is estimated only at the end of each probationary
+ * period, so the stream runs until some estimated likelihoods are met.
+ */
+TEST(MultiLayerCLASnapshotTest, testForkAnomalyLikelihood) {
+	json likelihoodConfig = snapshotConfig;
+	for(const auto layer : {"HtmLayer_00", "HtmLayer_01"}) {
+		likelihoodConfig["MLCLA"][layer]["HtmTemporalMemory"]["anomalyMode"]
+			= static_cast<int>(htm::TemporalMemoryExtension::ANMode::LIKELIHOOD);
+	}
+
+	JsonConfig config(likelihoodConfig);
+	PCLA model = config.buildModel();
+	runSteps(model, 0u, 600u);
+
+	StreamState forked = model->fork();
+	size_t nbEstimated = 0u;
+
+	for(Step t = 600u; t < 1000u; ++t) {
+		const auto expected = model->feedforward(snapshotInput(t), false);
+		ASSERT_EQ(model->feedforward(snapshotInput(t), forked), expected) << "step " << t;
+
+		const auto layers = model->getLayers();
+		for(size_t i = 0u; i < layers.size(); ++i) {
+			const htm::Real anomaly = layers.at(i)->getTmAnomaly();
+			ASSERT_EQ(forked.layers.at(i)->tm->getAnomaly(), anomaly)
+				<< "step " << t << ", layer " << i;
+			if(anomaly != 0.5f) ++nbEstimated;
+		}
+	}
+	ASSERT_GT(nbEstimated, 0u);
+}
+
+/**
+ * Several streams run on one model from several threads, each with its
+ * own state, and predict the same as the streams run one by one.
+ */
+TEST(MultiLayerCLASnapshotTest, testStreamThreads) {
+	const size_t nbStreams = 4u;
+	const Step nbSteps = 100u;
+
+	JsonConfig config(snapshotConfig);
+	PCLA model = config.buildModel();
+	runSteps(model, 0u, 300u);
+
+	// Each stream starts at another phase of the input.
+	const auto runStream = [&](const size_t stream, vector<cla::Values>& predictions) {
+		StreamState state = model->makeStreamState();
+		for(Step t = 0u; t < nbSteps; ++t) {
+			predictions.push_back(
+				model->feedforward(snapshotInput(300u + 7u * stream + t), state)
+			);
+		}
+	};
+
+	vector<vector<cla::Values>> expected(nbStreams);
+	for(size_t i = 0u; i < nbStreams; ++i) runStream(i, expected.at(i));
+
+	vector<vector<cla::Values>> predictions(nbStreams);
+	vector<std::thread> threads;
+	for(size_t i = 0u; i < nbStreams; ++i) {
+		threads.emplace_back(runStream, i, std::ref(predictions.at(i)));
+	}
+	for(auto& thread : threads) thread.join();
+
+	for(size_t i = 0u; i < nbStreams; ++i) {
+		ASSERT_EQ(predictions.at(i), expected.at(i)) << "stream " << i;
+	}
+}
+
+/**
+ * The read-only image has the encoder parameters and the synapses of the
+ * model, and the overlaps of the mapped spatial poolers select the active
+ * columns of the model.
+ */
+TEST(MultiLayerCLASnapshotTest, testImage) {
+	const string path = "MultiLayerCLASnapshotTest.img";
+
+	JsonConfig config(snapshotConfig);
+	PCLA model = config.buildModel();
+	runSteps(model, 0u, 300u);
+	model->writeImage(path);
+
+	const ModelImage image(path);
+
+	ASSERT_EQ(image.getNbInputs(), 1u);
+	ASSERT_EQ(image.getInputDimensions(), vector<htm::UInt>({201u}));
+	ASSERT_EQ(image.getNbActiveBits(), 21u);
+	ASSERT_EQ(image.getMins(), cla::Values({-1.0}));
+	ASSERT_EQ(image.getMaxs(), cla::Values({1.0}));
+
+	const auto layers = model->getLayers();
+	ASSERT_EQ(image.getLayers().size(), layers.size());
+
+	for(Step t = 300u; t < 320u; ++t) {
+		model->feedforward(snapshotInput(t), false);
+
+		for(size_t i = 0u; i < layers.size(); ++i) {
+			const auto& layer = image.getLayers().at(i);
+			ASSERT_EQ(layer.sps.size(), 1u);
+			ASSERT_EQ(layer.tm.connections.numSynapses(), layers.at(i)->getNbTmSynapses());
+			ASSERT_EQ(layer.tm.connections.numSegments(), layers.at(i)->getNbTmSegments());
+
+			const auto& activeColumns = layers.at(i)->getActiveColumns();
+			if(activeColumns.getSum() == 0u) continue;
+
+			vector<htm::SynapseIdx> overlaps;
+			layer.sps.front().computeOverlaps(
+				layers.at(i)->getActiveBits().getSparse(), overlaps
+			);
+
+			// Without the boosting the active columns have the largest overlaps.
+			const auto& dense = activeColumns.getDense();
+			htm::SynapseIdx minActive = std::numeric_limits<htm::SynapseIdx>::max();
+			htm::SynapseIdx maxInactive = 0u;
+			for(size_t c = 0u; c < overlaps.size(); ++c) {
+				if(dense.at(c)) minActive = std::min(minActive, overlaps.at(c));
+				else maxInactive = std::max(maxInactive, overlaps.at(c));
+			}
+			ASSERT_GE(minActive, maxInactive) << "step " << t << ", layer " << i;
+		}
+
+		model->feedback(snapshotInput(t + 1u), false);
+	}
+
+	std::remove(path.c_str());
+}
+
+/**
+ * The layer views of the image infer the same columns, cells and segments
+ * as the stream of the live model, when they are given the same active
+ * bits and external cells and the same random generator.
+ */
+TEST(MultiLayerCLASnapshotTest, testImageInference) {
+	const string path = "MultiLayerCLASnapshotTest.img";
+
+	JsonConfig config(snapshotConfig);
+	PCLA model = config.buildModel();
+	runSteps(model, 0u, 300u);
+	model->writeImage(path);
+
+	const ModelImage image(path);
+	const auto& layers = image.getLayers();
+
+	StreamState state = model->makeStreamState();
+	vector<ModelImage::LayerState> imageStates(layers.size());
+	for(size_t i = 0u; i < layers.size(); ++i) {
+		imageStates.at(i).tm.rng
+			= static_cast<HtmTemporalMemoryState&>(*state.layers.at(i)->tm).state.rng;
+	}
+
+	for(Step t = 300u; t < 500u; ++t) {
+		model->feedforward(snapshotInput(t), state);
+
+		// The layers run from the bottom until a layer rejects its input,
+		// and the segments are activated from that layer to the bottom.
+		size_t top = layers.size() - 1u;
+		for(size_t i = layers.size(); i-- > 0u;) {
+			top = i;
+			if(state.layers.at(i)->status != Status::RUN) break;
+
+			const auto& container = state.layers.at(i)->container;
+			htm::SDR activeColumns(container.activeColumns.dimensions);
+			htm::SDR activeCells(container.activeCells.dimensions);
+			htm::SDR winnerCells(container.winnerCells.dimensions);
+			layers.at(i).forward(
+				container.activeBits, imageStates.at(i),
+				activeColumns, activeCells, winnerCells
+			);
+
+			ASSERT_EQ(activeColumns.getSparse(), container.activeColumns.getSparse())
+				<< "step " << t << ", layer " << i;
+			ASSERT_EQ(activeCells.getSparse(), container.activeCells.getSparse())
+				<< "step " << t << ", layer " << i;
+			ASSERT_EQ(winnerCells.getSparse(), container.winnerCells.getSparse())
+				<< "step " << t << ", layer " << i;
+		}
+
+		for(size_t i = top; i < layers.size(); ++i) {
+			const auto& container = state.layers.at(i)->container;
+			htm::SDR_sparse_t activeSegments;
+			if(i == 0u) {
+				layers.at(i).backward(imageStates.at(i), activeSegments);
+			} else {
+				layers.at(i).backward(
+					container.externalActiveSDR, container.externalWinnerSDR,
+					imageStates.at(i), activeSegments
+				);
+			}
+			ASSERT_EQ(activeSegments, container.activeSegments)
+				<< "step " << t << ", layer " << i;
+		}
+	}
+
+	std::remove(path.c_str());
+}
+
+/**
+ * The recorded events are set through the model config. The recording
+ * does not change the model, and the events are recorded only when they
+ * are set.
+ */
+TEST(MultiLayerCLASnapshotTest, testRecordedEvents) {
+	const htm::ConnectionsEvents events
+		= htm::ConnectionsEvent::SYNAPSES | htm::ConnectionsEvent::PERMANENCES;
+
+	JsonConfig config(snapshotConfig);
+	config.getModel().setSeed(42u);
+	PCLA model = config.buildModel();
+
+	JsonConfig recordingConfig(snapshotConfig);
+	recordingConfig.getModel().setSeed(42u);
+	recordingConfig.getModel().setRecordedEvents({"synapses", "permanences"});
+	PCLA recording = recordingConfig.buildModel();
+
+	for(const auto& layer : model->getLayers()) {
+		ASSERT_EQ(layer->getTmRecordedEvents(), htm::ConnectionsEvent::NONE);
+	}
+	for(const auto& layer : recording->getLayers()) {
+		ASSERT_EQ(layer->getTmRecordedEvents(), events);
+	}
+
+	size_t nbCreated = 0u;
+	size_t nbUpdated = 0u;
+	for(Step t = 0u; t < 300u; ++t) {
+		ASSERT_EQ(
+			recording->feedforward(snapshotInput(t), true),
+			model->feedforward(snapshotInput(t), true)
+		) << "step " << t;
+
+		const auto layers = model->getLayers();
+		const auto recordingLayers = recording->getLayers();
+		for(size_t i = 0u; i < layers.size(); ++i) {
+			ASSERT_EQ(
+				recordingLayers.at(i)->getActiveCells(),
+				layers.at(i)->getActiveCells()
+			) << "step " << t << ", layer " << i;
+			ASSERT_EQ(
+				recordingLayers.at(i)->getNbTmSynapses(),
+				layers.at(i)->getNbTmSynapses()
+			) << "step " << t << ", layer " << i;
+
+			ASSERT_TRUE(layers.at(i)->getTmCreatedSynapses().empty());
+			ASSERT_TRUE(layers.at(i)->getTmUpdatedSynapses().empty());
+			nbCreated += recordingLayers.at(i)->getTmCreatedSynapses().size();
+			nbUpdated += recordingLayers.at(i)->getTmUpdatedSynapses().size();
+		}
+
+		recording->feedback(snapshotInput(t + 1u), true);
+		model->feedback(snapshotInput(t + 1u), true);
+	}
+
+	ASSERT_GT(nbCreated, 0u);
+	ASSERT_GT(nbUpdated, 0u);
+}
+
+} // namespace testing
@@ -0,0 +1,185 @@
+// PsdrTest.cpp
+
+/**
+ * @file
+ * Implementation of unit tests for PartialSDR and PartialSDR_Extension
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "cla/extension/types/Psdr.hpp"
+#include "cla/extension/types/PSdrExtension.hpp"
+#include "cla/extension/types/SdrExtension.hpp"
+#include "htm/types/Sdr.hpp"
+#include "htm/types/Types.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+/**
+ * The dimensions, the number of splits and the axis of a case. The
+ * dimensions are uneven, so the row of a split is not a power of two and
+ * the axis is not always the first one.
+ */
+struct PartialCase {
+	vector<UInt> dimensions;
+	UInt splitNum;
+	UInt axis;
+};
+
+const vector<PartialCase> partialCases = {
+	{{12u}, 1u, 0u},
+	{{12u}, 3u, 0u},
+	{{120u, 7u}, 4u, 0u},
+	{{5u, 18u}, 6u, 1u},
+	{{6u, 9u, 4u}, 3u, 1u},
+	{{6u, 9u, 4u}, 2u, 2u},
+	{{7u, 5u, 3u}, 7u, 0u},
+};
+
+const vector<Real> sparsities = {0.0f, 0.02f, 0.3f, 1.0f};
+
+/**
+ * The subspace denses split with the dense functions as before the sparse
+ * path.
+ */
+vector<SDR_dense_t> splitByDense_(const SDR& sdr, const PartialCase& c) {
+	vector<SDR_dense_t> denses(c.splitNum, SDR_dense_t(sdr.size / c.splitNum));
+	vector<SDR_dense_t::iterator> begins;
+	for(auto& dense : denses) begins.push_back(dense.begin());
+
+	const auto& dense = sdr.getDense();
+	PartialDenseFuncs::splitDense(
+		dense.begin(), dense.end(), begins, c.dimensions, c.splitNum, c.axis
+	);
+	return denses;
+}
+
+/**
+ * The concatenated dense with the dense functions as before the sparse
+ * path.
+ */
+SDR_dense_t concatenateByDense_(const vector<SDR>& sdrs, const PartialCase& c) {
+	vector<SDR_dense_t::const_iterator> begins;
+	for(const auto& sdr : sdrs) begins.push_back(sdr.getDense().begin());
+
+	SDR_dense_t dense(sdrs.front().size * c.splitNum);
+	PartialDenseFuncs::concatenateDense(
+		dense.begin(), dense.end(), begins, sdrs.front().dimensions, c.axis
+	);
+	return dense;
+}
+
+/**
+ * The sparse split and concatenate give the same SDRs as the dense path,
+ * and the concatenate gives back the split SDR.
+ */
+TEST(PsdrTest, testSplitConcatenate) {
+	Random rng(42);
+
+	for(const auto& c : partialCases) {
+		for(const Real sparsity : sparsities) {
+			PSDR psdr(c.dimensions, c.splitNum, c.axis);
+			psdr.randomize(sparsity, rng);
+
+			const auto sdrs = psdr.split();
+			const auto denses = splitByDense_(psdr, c);
+			ASSERT_EQ(sdrs.size(), static_cast<size_t>(c.splitNum));
+			for(UInt i = 0u; i < c.splitNum; ++i) {
+				ASSERT_EQ(sdrs.at(i).dimensions, psdr.getPartialDimensions());
+				ASSERT_EQ(sdrs.at(i).getDense(), denses.at(i))
+					<< "split " << c.splitNum << ", axis " << c.axis
+					<< ", sparsity " << sparsity << ", subspace " << i;
+			}
+
+			PSDR concatenated(c.dimensions, c.splitNum, c.axis);
+			concatenated.concatenate(sdrs);
+			ASSERT_EQ(concatenated.getDense(), concatenateByDense_(sdrs, c))
+				<< "split " << c.splitNum << ", axis " << c.axis << ", sparsity " << sparsity;
+			ASSERT_EQ(concatenated.getSparse(), psdr.getSparse())
+				<< "split " << c.splitNum << ", axis " << c.axis << ", sparsity " << sparsity;
+		}
+	}
+}
+
+/**
+ * The caller-owned SDRs are refilled by the next split, including an
+ * empty SDR after a full one, and the SDRs with other dimensions are
+ * reinitialized.
+ */
+TEST(PsdrTest, testSplitReuse) {
+	Random rng(7);
+
+	for(const auto& c : partialCases) {
+		PSDR psdr(c.dimensions, c.splitNum, c.axis);
+		vector<SDR> sdrs(c.splitNum, SDR({3u}));
+		SDR concatenated(c.dimensions);
+
+		for(const Real sparsity : {1.0f, 0.0f, 0.1f, 0.0f, 0.5f}) {
+			psdr.randomize(sparsity, rng);
+			psdr.split(sdrs);
+
+			const auto denses = splitByDense_(psdr, c);
+			for(UInt i = 0u; i < c.splitNum; ++i) {
+				ASSERT_EQ(sdrs.at(i).getDense(), denses.at(i))
+					<< "split " << c.splitNum << ", axis " << c.axis
+					<< ", sparsity " << sparsity << ", subspace " << i;
+			}
+
+			PartialSparseFuncs::concatenateSDR(sdrs, concatenated, c.axis);
+			ASSERT_EQ(concatenated.getSparse(), psdr.getSparse())
+				<< "split " << c.splitNum << ", axis " << c.axis << ", sparsity " << sparsity;
+		}
+	}
+}
+
+/**
+ * The extension data follow their indices through the split and the
+ * concatenate.
+ */
+TEST(PsdrTest, testExtensionSplitConcatenate) {
+	Random rng(11);
+
+	for(const auto& c : partialCases) {
+		for(const Real sparsity : sparsities) {
+			PSDRex<UInt> psdrex(c.dimensions, c.splitNum, c.axis);
+			psdrex.randomize(sparsity, rng);
+
+			// The data of each bit is derived from its index, so a bit moved
+			// without its data is caught.
+			vector<UInt> data;
+			for(const auto idx : psdrex.getSparse()) data.push_back(idx * 3u + 1u);
+			psdrex.setExDataSparse(data);
+
+			vector<SDRex<UInt>> sdrexs;
+			psdrex.split(sdrexs);
+
+			const auto denses = splitByDense_(psdrex, c);
+			for(UInt i = 0u; i < c.splitNum; ++i) {
+				ASSERT_EQ(sdrexs.at(i).getDense(), denses.at(i))
+					<< "split " << c.splitNum << ", axis " << c.axis
+					<< ", sparsity " << sparsity << ", subspace " << i;
+				ASSERT_EQ(
+					sdrexs.at(i).getExDataSparse().size(),
+					sdrexs.at(i).getSparse().size()
+				);
+			}
+
+			PSDRex<UInt> concatenated(c.dimensions, c.splitNum, c.axis);
+			concatenated.concatenate(sdrexs);
+			ASSERT_EQ(concatenated.getSparse(), psdrex.getSparse())
+				<< "split " << c.splitNum << ", axis " << c.axis << ", sparsity " << sparsity;
+			ASSERT_EQ(concatenated.getExDataSparse(), data)
+				<< "split " << c.splitNum << ", axis " << c.axis << ", sparsity " << sparsity;
+			ASSERT_EQ(concatenated.getExDataDense(), psdrex.getExDataDense())
+				<< "split " << c.splitNum << ", axis " << c.axis << ", sparsity " << sparsity;
+		}
+	}
+}
+
+} // namespace testing
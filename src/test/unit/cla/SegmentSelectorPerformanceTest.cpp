@@ -0,0 +1,187 @@
+// SegmentSelectorPerformanceTest.cpp
+
+/**
+ * @file
+ * Implementation of performance tests for SegmentSelector
+ */
+
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cla/extension/algorithms/SegmentSelector.hpp"
+#include "cla/extension/algorithms/TemporalMemoryExtension.hpp"
+#include "htm/algorithms/Connections.hpp"
+#include "htm/os/Timer.hpp"
+#include "htm/types/Sdr.hpp"
+#include "htm/types/Types.hpp" // macro "UNUSED"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+#if defined(NDEBUG) && !defined(NTA_OS_WINDOWS)
+	const UInt CELLS 		= 65536u;
+	const UInt POOL 		= 1024u; // cells which can be active
+	const UInt LIVE 		= 2000u; // segments which can be touched
+	const UInt SMALL 		= 10000u;
+	const UInt LARGE 		= 200000u;
+	const UInt STEPS 		= 200u;
+#else
+	const UInt CELLS 		= 4096u;
+	const UInt POOL 		= 256u;
+	const UInt LIVE 		= 200u;
+	const UInt SMALL 		= 1000u;
+	const UInt LARGE 		= 10000u;
+	const UInt STEPS 		= 10u;
+#endif
+
+const UInt SYNAPSES 		= 8u;
+const UInt ACTIVE 			= 40u;
+const SynapseIdx THRESHOLD 	= 2u;
+
+
+/**
+ * Build connections where only the first LIVE segments can be reached by
+ * the active pool, the others synapse on cells which are never active.
+ */
+void buildConnections_(
+	Connections& connections,
+	const UInt numSegments,
+	Random& rng
+) {
+	connections.initialize(CELLS);
+
+	for(UInt i = 0u; i < numSegments; i++) {
+		const Segment segment = connections.createSegment(i % CELLS);
+		const bool live = (i < LIVE);
+
+		for(UInt j = 0u; j < SYNAPSES; j++) {
+			const CellIdx presynapticCell = live
+				? rng.getUInt32(POOL)
+				: POOL + rng.getUInt32(CELLS - POOL);
+			const Permanence permanence = (j % 2u == 0u) ? 0.6f : 0.3f;
+
+			connections.createSynapse(segment, presynapticCell, permanence);
+		}
+	}
+}
+
+/**
+ * Run the full scan and the sparse selector on the same activity, check
+ * that they select the same segments and return the elapsed times.
+ */
+pair<Real64, Real64> runSelectorTest(
+	const UInt numSegments,
+	const string& label
+) {
+	Random rng(42);
+	Connections connections;
+	buildConnections_(connections, numSegments, rng);
+
+	const PSelector full = SegmentSelectors::createSelector(
+		SSMode::THRESHOLD, &connections, CELLS, 1u
+	);
+	const PSelector sparse = SegmentSelectors::createSelector(
+		SSMode::SPARSE_THRESHOLD, &connections, CELLS, 1u
+	);
+
+	SDR pool({POOL});
+	vector<SynapseIdx> numPotential;
+	vector<Segment> fullActive, sparseActive;
+	vector<Segment> fullMatching, sparseMatching;
+	Timer fullTimer, sparseTimer;
+
+	for(UInt step = 0u; step < STEPS; step++) {
+		pool.randomize(static_cast<Real>(ACTIVE) / POOL, rng);
+		const vector<CellIdx> activeCells(
+			pool.getSparse().begin(), pool.getSparse().end()
+		);
+
+		numPotential.assign(connections.segmentFlatListLength(), 0u);
+		const vector<SynapseIdx> numConnected = connections.computeActivity(
+			numPotential, activeCells, false
+		);
+
+		fullTimer.start();
+		full->select(
+			numConnected, connections.getActiveRelationsForSegments(),
+			{0u, THRESHOLD}, fullActive
+		);
+		full->select(
+			numPotential, connections.getMatchingRelationsForSegments(),
+			{0u, THRESHOLD}, fullMatching
+		);
+		fullTimer.stop();
+
+		sparseTimer.start();
+		sparse->select(
+			numConnected, connections.getActiveRelationsForSegments(),
+			{0u, THRESHOLD, connections.getActiveSegmentsTouched()},
+			sparseActive
+		);
+		sparse->select(
+			numPotential, connections.getMatchingRelationsForSegments(),
+			{0u, THRESHOLD, connections.getMatchingSegmentsTouched()},
+			sparseMatching
+		);
+		sparseTimer.stop();
+
+		EXPECT_EQ(fullActive, sparseActive);
+		EXPECT_EQ(fullMatching, sparseMatching);
+	}
+
+	cout << fullTimer.getElapsed() << " in " << label
+		 << ": threshold selector" << endl;
+	cout << sparseTimer.getElapsed() << " in " << label
+		 << ": sparse threshold selector" << endl;
+
+	return {fullTimer.getElapsed(), sparseTimer.getElapsed()};
+}
+
+
+/**
+ * The sparse selector visits only the touched segments, so its latency
+ * must not follow the number of segments on the layer.
+ */
+TEST(SegmentSelectorPerformanceTest, testSparseThreshold) {
+	const auto small = runSelectorTest(SMALL, "selector (small)");
+	const auto large = runSelectorTest(LARGE, "selector (large)");
+
+#ifdef NDEBUG
+	ASSERT_LE(large.second, large.first);
+	ASSERT_LE(large.second, 4.0 * small.second + 0.01);
+#endif
+	UNUSED(small);
+	UNUSED(large);
+}
+
+/**
+ * The temporal memory records the relations only for the selectors which
+ * read them.
+ */
+TEST(SegmentSelectorPerformanceTest, testRecordRelations) {
+	ASSERT_FALSE(SegmentSelectors::createSelector(
+		SSMode::SPARSE_THRESHOLD, nullptr, CELLS, 1u
+	)->usesRelations());
+	ASSERT_TRUE(SegmentSelectors::createSelector(
+		SSMode::INNER_TOGGLE_THRESHOLD, nullptr, CELLS, 1u
+	)->usesRelations());
+
+	TMEParameters params;
+	params.columnDimensions = {64u};
+	params.cellsPerColumn = 4u;
+
+	TemporalMemoryExtension threshold(params);
+	ASSERT_FALSE(threshold.connections.getRecordRelations());
+
+	params.outerSegmentSelectorMode = SSMode::OUTER_TOGGLE_THRESHOLD;
+	TemporalMemoryExtension toggle(params);
+	ASSERT_TRUE(toggle.connections.getRecordRelations());
+}
+
+} // end namespace
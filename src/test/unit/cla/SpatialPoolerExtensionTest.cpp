@@ -0,0 +1,322 @@
+// SpatialPoolerExtensionTest.cpp
+
+/**
+ * @file
+ * Implementation of unit tests for SpatialPoolerExtension
+ */
+
+#include "gtest/gtest.h"
+
+#include <set>
+#include <vector>
+
+#include "cla/extension/algorithms/SpatialPoolerExtension.hpp"
+#include "htm/types/Sdr.hpp"
+#include "htm/types/Types.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+SPEParameters initParameters(const UInt initThreads, const Real potentialPct) {
+	SPEParameters params;
+	params.inputDimensions = {400u};
+	params.columnDimensions = {1000u};
+	params.potentialRadius = 400u;
+	params.potentialPct = potentialPct;
+	params.wrapAround = false;
+	params.seed = 42;
+	params.initThreads = initThreads;
+	return params;
+}
+
+/**
+ * The initial synapses drawn from the random streams of the columns do not
+ * depend on the number of the threads.
+ */
+TEST(SpatialPoolerExtensionTest, testInitThreads) {
+	for(const Real potentialPct : {0.5f, 1.0f}) {
+		const SpatialPoolerExtension serial(initParameters(1u, potentialPct));
+
+		for(const UInt initThreads : {2u, 4u}) {
+			const SpatialPoolerExtension parallel(
+				initParameters(initThreads, potentialPct)
+			);
+			ASSERT_EQ(serial, parallel);
+			ASSERT_EQ(parallel.getInitThreads(), initThreads);
+		}
+
+		const auto& connections = serial.connections;
+		for(CellIdx column = 0u; column < serial.getNumColumns(); ++column) {
+			const auto& synapses = connections.synapsesForSegment(column);
+			const UInt expected = static_cast<UInt>(
+				potentialPct * serial.getNumInputs() + 0.5f
+			);
+			ASSERT_EQ(synapses.size(), expected);
+		}
+	}
+}
+
+/**
+ * By default the initial synapses are drawn from the shared random
+ * generator, the same as htm::SpatialPooler.
+ */
+TEST(SpatialPoolerExtensionTest, testInitLegacy) {
+	for(const bool wrapAround : {false, true}) {
+		auto params = initParameters(0u, 0.5f);
+		params.potentialRadius = 16u;
+		params.wrapAround = wrapAround;
+
+		const SpatialPoolerExtension legacy(params);
+		const SpatialPooler sp(
+			params.inputDimensions, params.columnDimensions,
+			params.potentialRadius, params.potentialPct,
+			params.globalInhibition, params.localAreaDensity,
+			params.stimulusThreshold, params.synPermInactiveDec,
+			params.synPermActiveInc, params.synPermConnected,
+			params.minPctOverlapDutyCycles, params.dutyCyclePeriod,
+			params.boostStrength, params.seed, params.spVerbosity,
+			params.wrapAround
+		);
+		ASSERT_EQ(legacy.connections, sp.connections);
+
+		params.initThreads = 1u;
+		const SpatialPoolerExtension streams(params);
+		ASSERT_NE(legacy.connections, streams.connections);
+	}
+}
+
+/**
+ * The overlaps of the connected bit matrix are the same as the overlaps of
+ * the connections, also after learning changes the synapses.
+ */
+TEST(SpatialPoolerExtensionTest, testConnectedBitMatrix) {
+	auto params = initParameters(0u, 0.5f);
+	params.inputDimensions = {1000u};
+	params.potentialRadius = 16u;
+	params.wrapAround = true;
+	SpatialPoolerExtension sp(params);
+
+	Random rng(7);
+	SDR input({1000u});
+	SDR active({1000u});
+
+	for(UInt step = 0u; step < 20u; ++step) {
+		input.randomize(0.05f, rng);
+
+		std::vector<SynapseIdx> expected;
+		std::vector<Segment> touched;
+		SegmentRelations relations;
+		sp.connections.computeActivity(
+			input.getSparse(), expected, touched, relations
+		);
+
+		sp.infer(input, active);
+		const auto computed = sp.compute(input, false, active);
+		ASSERT_EQ(computed, expected) << ConnectedBitMatrix::kernelName();
+
+		SDR learned({1000u});
+		sp.compute(input, true, learned);
+	}
+}
+
+/**
+ * Without learning, compute and infer give the same active columns as the
+ * overlaps of the connections. The infer with a stream state reuses its
+ * buffers after the first step.
+ */
+TEST(SpatialPoolerExtensionTest, testInferActiveColumns) {
+	auto params = initParameters(0u, 0.5f);
+	params.potentialRadius = 16u;
+	params.wrapAround = true;
+	params.boostStrength = 1.0f;
+	SpatialPoolerExtension sp(params);
+	SpatialPoolerExtension reference(params);
+
+	Random rng(11);
+	SDR input({400u});
+	SDR active({1000u});
+	SDR inferred({1000u});
+	SDR reused({1000u});
+	SDR expected({1000u});
+
+	SPEState state;
+	const UInt64* inputWords = nullptr;
+	const Real* boostedOverlaps = nullptr;
+
+	for(UInt step = 0u; step < 50u; ++step) {
+		input.randomize(0.05f, rng);
+
+		// The learning steps keep the boost factors moving.
+		sp.compute(input, true, active);
+		reference.SpatialPooler::compute(input, true, expected);
+
+		input.randomize(0.05f, rng);
+		sp.compute(input, false, active);
+		sp.infer(input, inferred);
+		sp.infer(input, state, reused);
+		reference.SpatialPooler::compute(input, false, expected);
+
+		ASSERT_EQ(active, expected);
+		ASSERT_EQ(inferred, expected);
+		ASSERT_EQ(reused, expected);
+
+		if(step == 0u) {
+			inputWords = state.inputWords.data();
+			boostedOverlaps = state.boostedOverlaps.data();
+		}
+		ASSERT_EQ(state.inputWords.data(), inputWords) << "step " << step;
+		ASSERT_EQ(state.boostedOverlaps.data(), boostedOverlaps) << "step " << step;
+	}
+}
+
+/**
+ * The connected bits of a column as the predictive bits used to scan
+ * them, walking all the synapses of the column. The threshold is the
+ * connections' one, inclusive like the overlap of the SP.
+ */
+vector<CellIdx> connectedBitsByScan_(
+	const Connections& connections,
+	const CellIdx column
+) {
+	std::set<CellIdx> bits;
+	for(const Synapse synapse : connections.synapsesForSegment(column)) {
+		const auto& synData = connections.dataForSynapse(synapse);
+		if(synData.permanence >= connections.getConnectedThreshold()) {
+			bits.insert(synData.presynapticCell);
+		}
+	}
+	return vector<CellIdx>(bits.begin(), bits.end());
+}
+
+/**
+ * One segment for each column, with some synapses exactly on the
+ * connected threshold.
+ */
+void growColumns(
+	Connections& connections,
+	const UInt numColumns,
+	const UInt numInputs,
+	Random& rng
+) {
+	connections.initialize(numInputs, 0.5f);
+	for(CellIdx column = 0u; column < numColumns; ++column) {
+		const Segment segment = connections.createSegment(column);
+		for(UInt i = 0u; i < 20u; ++i) {
+			const Permanence permanence = rng.getReal64() < 0.2
+				? 0.5f : static_cast<Permanence>(rng.getReal64());
+			connections.createSynapse(segment, rng.getUInt32(numInputs), permanence);
+		}
+	}
+}
+
+/**
+ * The table follows the synapse events of the connections: the created,
+ * destroyed and updated synapses invalidate their column.
+ */
+TEST(SpatialPoolerExtensionTest, testConnectedBitsTable) {
+	const UInt numColumns = 100u;
+	const UInt numInputs = 200u;
+
+	Random rng(5);
+	Connections connections;
+	growColumns(connections, numColumns, numInputs, rng);
+
+	ConnectedBitsTable table;
+	table.initialize(&connections, numColumns);
+	connections.subscribe(&table);
+
+	for(UInt round = 0u; round < 50u; ++round) {
+		for(CellIdx column = 0u; column < numColumns; ++column) {
+			ASSERT_EQ(
+				table.bitsForColumn(column),
+				connectedBitsByScan_(connections, column)
+			) << "round " << round << ", column " << column;
+		}
+
+		for(UInt i = 0u; i < 30u; ++i) {
+			const Segment segment = rng.getUInt32(numColumns);
+			const auto synapses = connections.synapsesForSegment(segment);
+			const UInt action = rng.getUInt32(3u);
+
+			if(action == 0u || synapses.empty()) {
+				connections.createSynapse(segment, rng.getUInt32(numInputs), 0.5f);
+			} else if(action == 1u) {
+				connections.destroySynapse(synapses[rng.getUInt32(static_cast<UInt>(synapses.size()))]);
+			} else {
+				connections.updateSynapsePermanence(
+					synapses[rng.getUInt32(static_cast<UInt>(synapses.size()))],
+					rng.getReal64() < 0.3 ? 0.5f : static_cast<Permanence>(rng.getReal64())
+				);
+			}
+		}
+	}
+}
+
+/**
+ * A synapse exactly on the connected threshold is connected, as in the
+ * overlap of the SP.
+ */
+TEST(SpatialPoolerExtensionTest, testConnectedBitsThreshold) {
+	Connections connections(10u, 0.5f);
+	const Segment segment = connections.createSegment(0u);
+	connections.createSynapse(segment, 3u, 0.5f);
+	connections.createSynapse(segment, 5u, 0.5f - 1.0e-3f);
+	connections.createSynapse(segment, 7u, 0.6f);
+
+	ConnectedBitsTable table;
+	table.initialize(&connections, 1u);
+	ASSERT_EQ(table.bitsForColumn(0u), vector<CellIdx>({3u, 7u}));
+}
+
+/**
+ * Without the events, the table is refreshed after the refresh period of
+ * inference steps. The learning steps do not count.
+ */
+TEST(SpatialPoolerExtensionTest, testConnectedBitsRefreshPeriod) {
+	const UInt numColumns = 20u;
+	const UInt numInputs = 50u;
+	const UInt period = 3u;
+
+	Random rng(9);
+	Connections connections;
+	growColumns(connections, numColumns, numInputs, rng);
+
+	// Not subscribed, so only the refresh invalidates the table.
+	ConnectedBitsTable table;
+	table.initialize(&connections, numColumns);
+	table.setRefreshPeriod(period);
+	ASSERT_EQ(table.getRefreshPeriod(), period);
+
+	vector<vector<CellIdx>> cached;
+	for(CellIdx column = 0u; column < numColumns; ++column) {
+		cached.push_back(table.bitsForColumn(column));
+	}
+
+	for(CellIdx column = 0u; column < numColumns; ++column) {
+		for(const Synapse synapse : connections.synapsesForSegment(column)) {
+			const Permanence permanence = connections.dataForSynapse(synapse).permanence;
+			connections.updateSynapsePermanence(synapse, permanence >= 0.5f ? 0.1f : 0.9f);
+		}
+	}
+
+	for(UInt step = 0u; step < 2u * period; ++step) {
+		table.step(true);
+		if(step < period - 1u) table.step(false);
+
+		for(CellIdx column = 0u; column < numColumns; ++column) {
+			ASSERT_EQ(table.bitsForColumn(column), cached[column]) << "step " << step;
+		}
+	}
+
+	table.step(false);
+	for(CellIdx column = 0u; column < numColumns; ++column) {
+		const auto expected = connectedBitsByScan_(connections, column);
+		ASSERT_NE(expected, cached[column]);
+		ASSERT_EQ(table.bitsForColumn(column), expected);
+	}
+}
+
+} // namespace testing
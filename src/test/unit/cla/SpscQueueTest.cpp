@@ -0,0 +1,112 @@
+// SpscQueueTest.cpp
+
+/**
+ * @file
+ * Implementation of unit tests for SpscQueue
+ */
+
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "cla/utils/SpscQueue.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace cla;
+
+/**
+ * The empty queue has no front, and the full queue has no back until a
+ * slot is released.
+ */
+TEST(SpscQueueTest, testEmptyFull) {
+	SpscQueue<size_t> queue(3u);
+	ASSERT_EQ(queue.capacity(), 3u);
+	ASSERT_EQ(queue.front(), nullptr);
+
+	for(size_t i = 0u; i < 3u; ++i) {
+		size_t* slot = queue.back();
+		ASSERT_NE(slot, nullptr) << "push " << i;
+		*slot = i;
+		queue.push();
+	}
+	ASSERT_EQ(queue.back(), nullptr);
+
+	ASSERT_NE(queue.front(), nullptr);
+	ASSERT_EQ(*queue.front(), 0u);
+	queue.pop();
+	ASSERT_NE(queue.back(), nullptr);
+
+	for(size_t i = 1u; i < 3u; ++i) {
+		ASSERT_EQ(*queue.front(), i);
+		queue.pop();
+	}
+	ASSERT_EQ(queue.front(), nullptr);
+}
+
+/**
+ * The counters go around the slots many times, and each slot is reused
+ * in place with its previous value.
+ */
+TEST(SpscQueueTest, testWraparound) {
+	SpscQueue<vector<size_t>> queue(3u);
+	vector<const vector<size_t>*> slots;
+
+	for(size_t i = 0u; i < 100u; ++i) {
+		vector<size_t>* slot = queue.back();
+		ASSERT_NE(slot, nullptr);
+		if(i >= 3u) {
+			ASSERT_EQ(slot, slots.at(i % 3u)) << "push " << i;
+			ASSERT_EQ(slot->back(), i - 3u) << "push " << i;
+		} else {
+			slots.push_back(slot);
+		}
+		slot->push_back(i);
+		queue.push();
+
+		// Keep one or two values in the queue, so the head and the tail
+		// are not on the same slot.
+		if(i % 2u == 1u) {
+			ASSERT_EQ(queue.front()->back(), i - 1u);
+			queue.pop();
+			ASSERT_EQ(queue.front()->back(), i);
+			queue.pop();
+			ASSERT_EQ(queue.front(), nullptr);
+		}
+	}
+}
+
+/**
+ * A producer and a consumer thread on a small queue pass all the values
+ * in order.
+ */
+TEST(SpscQueueTest, testOrdering) {
+	const size_t NB_VALUES = 200000u;
+	SpscQueue<size_t> queue(7u);
+
+	thread producer([&]() {
+		for(size_t i = 0u; i < NB_VALUES; ++i) {
+			size_t* slot;
+			while(!(slot = queue.back())) this_thread::yield();
+			*slot = i;
+			queue.push();
+		}
+	});
+
+	size_t nbOutOfOrder = 0u;
+	for(size_t i = 0u; i < NB_VALUES; ++i) {
+		const size_t* slot;
+		while(!(slot = queue.front())) this_thread::yield();
+		if(*slot != i) nbOutOfOrder++;
+		queue.pop();
+	}
+	producer.join();
+
+	ASSERT_EQ(nbOutOfOrder, 0u);
+	ASSERT_EQ(queue.front(), nullptr);
+}
+
+} // namespace testing
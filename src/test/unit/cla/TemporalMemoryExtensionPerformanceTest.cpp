@@ -0,0 +1,338 @@
+// TemporalMemoryExtensionPerformanceTest.cpp
+
+/**
+ * @file
+ * Implementation of performance tests for TemporalMemoryExtension
+ */
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cla/extension/algorithms/TemporalMemoryExtension.hpp"
+#include "cla/extension/algorithms/SegmentSelector.hpp"
+#include "htm/os/Timer.hpp"
+#include "htm/types/Sdr.hpp"
+#include "htm/types/Types.hpp" // macro "UNUSED"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+#if defined(NDEBUG) && !defined(NTA_OS_WINDOWS)
+	const UInt COLS 		= 2048u;
+	const UInt W 			= 40u;
+	const UInt STEPS 		= 1000u;
+	const UInt QUERIES 		= 200000u;
+#else
+	const UInt COLS 		= 128u;
+	const UInt W 			= 6u;
+	const UInt STEPS 		= 50u;
+	const UInt QUERIES 		= 2000u;
+#endif
+
+const UInt CELLS_PER_COLUMN = 32u;
+
+
+/**
+ * Run the TM on inputs which never repeat, so that most of the active
+ * columns burst and call the least used cell search.
+ */
+Real64 runBurstingTest(TemporalMemoryExtension& tm, const string& label) {
+	Random rng(42);
+	SDR columns({COLS});
+	Timer timer;
+
+	for(UInt step = 0u; step < STEPS; step++) {
+		columns.randomize(static_cast<Real>(W) / COLS, rng);
+
+		timer.start();
+		tm.compute(columns, true);
+		timer.stop();
+	}
+
+	cout << timer.getElapsed() << " in " << label << ": "
+		 << STEPS << " bursting steps, "
+		 << tm.connections.numSegments() << " segments" << endl;
+
+	return timer.getElapsed();
+}
+
+/**
+ * The least used cell search as it was done before the tracker.
+ */
+CellIdx leastUsedCellByScan_(
+	const Connections& connections,
+	const CellIdx column,
+	Random& rng
+) {
+	vector<CellIdx> cells(CELLS_PER_COLUMN);
+	for(CellIdx i = 0u; i < CELLS_PER_COLUMN; i++) {
+		cells[i] = column * CELLS_PER_COLUMN + i;
+	}
+	rng.shuffle(cells.begin(), cells.end());
+
+	const auto compareByNumSegments 
+		= [&](const CellIdx a, const CellIdx b) {
+			if(connections.numSegments(a) == connections.numSegments(b))
+				return a < b;
+			else return connections.numSegments(a) < connections.numSegments(b);
+		};
+
+	return *std::min_element(cells.begin(), cells.end(), compareByNumSegments);
+}
+
+
+/**
+ * Bursting heavy input on the TM, the least used cell is searched for
+ * nearly every active column.
+ */
+TEST(TemporalMemoryExtensionPerformanceTest, testBursting) {
+	TemporalMemoryExtension tm;
+	tm.initialize(1u, {COLS}, CELLS_PER_COLUMN);
+
+	auto tim = runBurstingTest(tm, "temporal memory extension (bursting)");
+
+#ifdef NDEBUG
+	ASSERT_LE(tim, 5.0f * Timer::getSpeed());
+#endif
+	UNUSED(tim);
+}
+
+/**
+ * Compare the tracker which is kept by the TM's own segment events with
+ * the scan over the cells of the column, after the segments have been
+ * created and destroyed. Both must return a cell with the minimum number
+ * of segments, and the tracker must choose the same cell as a tracker
+ * freshly built from the same segments.
+ */
+TEST(TemporalMemoryExtensionPerformanceTest, testLeastUsedCell) {
+	const CellIdx CELLS = 4u;
+	const SegmentIdx MAX_SEGMENTS = 2u;
+
+	TemporalMemoryExtension tm;
+	tm.initialize(1u, {COLS}, CELLS, 13u, 0.21f, 0.5f, 10u, 20u,
+		0.1f, 0.1f, 0.1f, 42, MAX_SEGMENTS);
+
+	tm.setRecordedEvents(ConnectionsEvent::SEGMENTS);
+	size_t destroyed = 0u;
+
+	// Dense non repeating input, every column bursts often enough to fill
+	// its cells, so the oldest segments are destroyed.
+	Random inputRng(42);
+	SDR columns({COLS});
+	for(UInt step = 0u; step < STEPS; step++) {
+		columns.randomize(0.25f, inputRng);
+		tm.compute(columns, true);
+		destroyed += tm.getSynapseHandler().getDestroyedSegments().size();
+	}
+	ASSERT_GT(destroyed, 0u);
+
+	const Connections& connections = tm.connections;
+	const LeastUsedCellTracker& tracker = tm.getLeastUsedCellTracker();
+
+	LeastUsedCellTracker fresh;
+	fresh.initialize(&connections, COLS, CELLS);
+
+	for(CellIdx column = 0u; column < COLS; column++) {
+		size_t minSegments = MAX_SEGMENTS;
+		for(CellIdx i = 0u; i < CELLS; i++) {
+			minSegments = std::min(minSegments, connections.numSegments(column * CELLS + i));
+		}
+
+		Random rng(column + 1), freshRng(column + 1);
+		for(UInt i = 0u; i < 2u * CELLS; i++) {
+			const CellIdx cell = tracker.getLeastUsedCell(column, rng);
+			ASSERT_EQ(cell / CELLS, column);
+			ASSERT_EQ(connections.numSegments(cell), minSegments);
+			ASSERT_EQ(cell, fresh.getLeastUsedCell(column, freshRng));
+		}
+	}
+}
+
+/**
+ * The batched duty cycle update of the TM gives bit-identical duty cycles
+ * to a reference updated segment by segment, over a learning run where
+ * the segments are created, destroyed and reused. The reference follows
+ * the segments by the recorded events.
+ */
+TEST(TemporalMemoryExtensionPerformanceTest, testSegmentDutyCycle) {
+	const CellIdx CELLS = 4u;
+	const UInt SEQUENCE = 10u;
+
+	TemporalMemoryExtension tm;
+	tm.initialize(1u, {COLS}, CELLS, 8u, 0.21f, 0.3f, 6u, 20u,
+		0.1f, 0.1f, 0.01f, 42, 2u);
+	tm.setRecordedEvents(ConnectionsEvent::SEGMENTS);
+
+	const SegmentDutyCycle& dutyCycle = tm.getSegmentDutyCycle();
+	SegmentDutyCycle reference(dutyCycle.getCycle());
+
+	// A repeating sequence makes the segments active and correct, and
+	// some noise makes them wrong and destroys them.
+	Random rng(42);
+	vector<SDR> sequence(SEQUENCE, SDR({COLS}));
+	for(auto& columns : sequence) columns.randomize(static_cast<Real>(W) / COLS, rng);
+
+	SDR columns({COLS});
+	size_t nbUpdates = 0u, nbDestroyed = 0u;
+
+	for(UInt step = 0u; step < 600u; step++) {
+		if(step % 3u == 2u) columns.randomize(static_cast<Real>(W) / COLS, rng);
+		else columns = sequence[step % SEQUENCE];
+		const bool learn = step % 11u != 10u;
+
+		tm.activateDendrites(learn);
+		const vector<Segment> actives = tm.getActiveSegments();
+		tm.activateCells(columns, learn);
+
+		if(learn) {
+			const auto& dense = columns.getDense();
+			for(const Segment segment : actives) {
+				if(!reference.isExistSegment(segment)) continue;
+				const CellIdx column = tm.connections.cellForSegment(segment) / CELLS;
+				reference.updateDutyCycle(segment, dense[column] != 0u);
+				nbUpdates++;
+			}
+		}
+
+		// The segments are created and destroyed after the update.
+		const auto& handler = tm.getSynapseHandler();
+		for(const Segment segment : handler.getCreatedSegments())
+			reference.onCreateSegment(segment);
+		for(const Segment segment : handler.getDestroyedSegments())
+			reference.onDestroySegment(segment);
+		nbDestroyed += handler.getDestroyedSegments().size();
+
+		const Segment nbSlots = static_cast<Segment>(tm.connections.segmentFlatListLength());
+		for(Segment segment = 0u; segment < nbSlots; segment++) {
+			ASSERT_EQ(dutyCycle.isExistSegment(segment), reference.isExistSegment(segment))
+				<< "step " << step << ", segment " << segment;
+			if(!reference.isExistSegment(segment)) continue;
+
+			const auto value = dutyCycle.getDutyCycle(segment);
+			const auto expected = reference.getDutyCycle(segment);
+			ASSERT_EQ(value.first, expected.first)
+				<< "step " << step << ", segment " << segment;
+			ASSERT_EQ(value.second, expected.second)
+				<< "step " << step << ", segment " << segment;
+		}
+	}
+
+	ASSERT_GT(nbUpdates, 0u);
+	ASSERT_GT(nbDestroyed, 0u);
+}
+
+/**
+ * Compare the speed of the tracker with the scan over the cells of the
+ * column.
+ */
+TEST(TemporalMemoryExtensionPerformanceTest, testLeastUsedCellSpeed) {
+	TemporalMemoryExtension tm;
+	tm.initialize(1u, {COLS}, CELLS_PER_COLUMN);
+	runBurstingTest(tm, "temporal memory extension (warm up)");
+
+	const Connections& connections = tm.connections;
+	const LeastUsedCellTracker& tracker = tm.getLeastUsedCellTracker();
+
+	Random rng(7);
+	vector<CellIdx> columns(QUERIES);
+	for(auto& column : columns) column = rng.getUInt32(COLS);
+
+	Timer scanTimer, trackerTimer;
+	vector<CellIdx> scanned(QUERIES), tracked(QUERIES);
+
+	scanTimer.start();
+	for(UInt i = 0u; i < QUERIES; i++) {
+		scanned[i] = leastUsedCellByScan_(connections, columns[i], rng);
+	}
+	scanTimer.stop();
+
+	trackerTimer.start();
+	for(UInt i = 0u; i < QUERIES; i++) {
+		tracked[i] = tracker.getLeastUsedCell(columns[i], rng);
+	}
+	trackerTimer.stop();
+
+	for(UInt i = 0u; i < QUERIES; i++) {
+		ASSERT_EQ(tm.columnForCell(tracked[i]), columns[i]);
+		ASSERT_EQ(
+			connections.numSegments(tracked[i]),
+			connections.numSegments(scanned[i])
+		);
+	}
+
+	cout << scanTimer.getElapsed() << " in least used cell: scan" << endl;
+	cout << trackerTimer.getElapsed() << " in least used cell: tracker" << endl;
+
+#ifdef NDEBUG
+	ASSERT_LE(trackerTimer.getElapsed(), scanTimer.getElapsed());
+#endif
+}
+
+/**
+ * Run the TM on a repeated sequence with the external predictive inputs,
+ * so that the segments grow synapses to both the cells and the external
+ * inputs in most of the steps.
+ */
+Real64 runLearningTest(TemporalMemoryExtension& tm, const string& label) {
+	const UInt SEQUENCE_LENGTH = 20u;
+	const UInt EXTERNAL = COLS * 4u;
+
+	Random rng(42);
+	vector<SDR> sequence, externals;
+	for(UInt i = 0u; i < SEQUENCE_LENGTH; i++) {
+		sequence.emplace_back(vector<UInt>{COLS});
+		sequence.back().randomize(static_cast<Real>(W) / COLS, rng);
+		externals.emplace_back(vector<UInt>{EXTERNAL});
+		externals.back().randomize(static_cast<Real>(W) / COLS, rng);
+	}
+
+	Timer timer;
+	for(UInt step = 0u; step < STEPS; step++) {
+		const UInt i = step % SEQUENCE_LENGTH;
+
+		timer.start();
+		tm.compute(sequence[i], true, externals[i], externals[i]);
+		timer.stop();
+	}
+
+	cout << timer.getElapsed() << " in " << label << ": "
+		 << STEPS << " learning steps, "
+		 << tm.connections.numSynapses() << " synapses" << endl;
+
+	return timer.getElapsed();
+}
+
+/**
+ * Learning heavy input on the TM, the synapses are grown on the bursting
+ * and on the predicted columns. The result must be the same for the same
+ * seed.
+ */
+TEST(TemporalMemoryExtensionPerformanceTest, testLearning) {
+	const auto& makeTM = [](TemporalMemoryExtension& tm) {
+		tm.initialize(1u, {COLS}, CELLS_PER_COLUMN, 13u, 0.21f, 0.5f, 10u, 20u,
+			0.1f, 0.1f, 0.0f, 42, 255u, 255u, true, false, COLS * 4u);
+	};
+
+	TemporalMemoryExtension tm, other;
+	makeTM(tm);
+	makeTM(other);
+
+	auto tim = runLearningTest(tm, "temporal memory extension (learning)");
+	runLearningTest(other, "temporal memory extension (learning, same seed)");
+
+	ASSERT_EQ(tm, other);
+
+#ifdef NDEBUG
+	ASSERT_LE(tim, 5.0f * Timer::getSpeed());
+#endif
+	UNUSED(tim);
+}
+
+} // end namespace
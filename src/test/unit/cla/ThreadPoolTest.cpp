@@ -0,0 +1,115 @@
+// ThreadPoolTest.cpp
+
+/**
+ * @file
+ * Implementation of unit tests for ThreadPool
+ */
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "cla/utils/ThreadPool.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace cla;
+
+/**
+ * Every index is called exactly once, for any number of the tasks and
+ * the workers.
+ */
+TEST(ThreadPoolTest, testParallelFor) {
+	for(const size_t nbThreads : {1u, 2u, 4u}) {
+		ThreadPool pool(nbThreads);
+		ASSERT_EQ(pool.size(), nbThreads);
+
+		for(const size_t nbTasks : {0u, 1u, 7u, 1000u}) {
+			vector<atomic<size_t>> calls(nbTasks);
+			pool.parallelFor(nbTasks, [&](const size_t i) { calls.at(i)++; });
+
+			for(size_t i = 0u; i < nbTasks; ++i) {
+				ASSERT_EQ(calls.at(i).load(), 1u)
+					<< "threads " << nbThreads << ", tasks " << nbTasks << ", index " << i;
+			}
+		}
+	}
+
+	ThreadPool pool;
+	ASSERT_EQ(pool.size(), max(1u, thread::hardware_concurrency()));
+}
+
+/**
+ * A task can run a parallelFor on its own pool. The waiting caller runs
+ * the queued tasks, so even a single worker does not deadlock.
+ */
+TEST(ThreadPoolTest, testNestedParallelFor) {
+	const size_t nbOuters = 8u;
+	const size_t nbInners = 100u;
+
+	for(const size_t nbThreads : {1u, 2u, 4u}) {
+		ThreadPool pool(nbThreads);
+		vector<atomic<size_t>> calls(nbOuters * nbInners);
+
+		pool.parallelFor(nbOuters, [&](const size_t i) {
+			pool.parallelFor(nbInners, [&](const size_t j) {
+				calls.at(i * nbInners + j)++;
+			});
+		});
+
+		for(size_t i = 0u; i < calls.size(); ++i) {
+			ASSERT_EQ(calls.at(i).load(), 1u) << "threads " << nbThreads << ", index " << i;
+		}
+	}
+}
+
+/**
+ * The exception of a call is rethrown after all the other calls have
+ * finished, and the pool can be used again.
+ */
+TEST(ThreadPoolTest, testException) {
+	ThreadPool pool(4u);
+	atomic<size_t> nbCalls(0u);
+
+	ASSERT_THROW(
+		pool.parallelFor(100u, [&](const size_t i) {
+			if(i == 3u) throw runtime_error("task 3");
+			nbCalls++;
+		}),
+		runtime_error
+	);
+	ASSERT_EQ(nbCalls.load(), 99u);
+
+	nbCalls = 0u;
+	pool.parallelFor(10u, [&](const size_t i) { nbCalls++; });
+	ASSERT_EQ(nbCalls.load(), 10u);
+}
+
+/**
+ * The destructor stops the idle workers, also the pinned ones and those
+ * of a pool which was never used.
+ */
+TEST(ThreadPoolTest, testShutdown) {
+	for(size_t round = 0u; round < 20u; ++round) {
+		ThreadPool unused(4u);
+	}
+
+	for(const bool pinThreads : {false, true}) {
+		atomic<size_t> nbCalls(0u);
+		{
+			ThreadPool pool(4u, pinThreads);
+			pool.parallelFor(50u, [&](const size_t i) {
+				this_thread::sleep_for(chrono::microseconds(100));
+				nbCalls++;
+			});
+		}
+		ASSERT_EQ(nbCalls.load(), 50u);
+	}
+}
+
+} // namespace testing
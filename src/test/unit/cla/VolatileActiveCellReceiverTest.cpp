@@ -0,0 +1,112 @@
+// VolatileActiveCellReceiverTest.cpp
+
+/**
+ * @file
+ * Implementation of unit tests for VolatileActiveCellReceiver
+ */
+
+#include "gtest/gtest.h"
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "cla/model/module/helper/LayerProxy.hpp"
+#include "cla/model/module/helper/SDRContainer.hpp"
+#include "cla/model/module/receiver/VolatileActiveCellReceiver.hpp"
+#include "htm/types/Sdr.hpp"
+#include "htm/types/Types.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+using namespace cla;
+
+const UInt NUM_CELLS = 64u;
+const UInt STEPS = 200u;
+
+/**
+ * The step by step float decay as it was done before the receiver kept
+ * the last active step of each cell.
+ */
+class DenseVolatileCells {
+public:
+	Real rate;
+	Real threshold;
+	vector<Real> dense;
+
+	DenseVolatileCells(const Real rate, const Real threshold)
+		: rate(rate), threshold(threshold), dense(NUM_CELLS, 0.0f) {}
+
+	SDR_sparse_t receive(const SDR& cells, const bool run) {
+		for(auto& value : dense) value *= rate;
+		if(run) {
+			for(const auto idx : cells.getSparse()) dense[idx] = 1.0f;
+		}
+
+		SDR_sparse_t sparse;
+		for(UInt i = 0u; i < NUM_CELLS; i++) {
+			if(dense[i] >= threshold) sparse.push_back(i);
+		}
+		return sparse;
+	}
+};
+
+/**
+ * Feed the same random cells to the receiver and to the dense decay,
+ * with some sleeping steps, and compare the volatile cells.
+ */
+void compareWithDenseDecay(const Real rate, const Real threshold) {
+	SDRContainer container({NUM_CELLS}, {NUM_CELLS}, {NUM_CELLS});
+	const vector<PSpatialPooler> sps;
+	const PTemporalMemory tm;
+	auto upperLayer = make_shared<LayerProxy>(container, sps, tm);
+
+	VolatileActiveCellReceiver receiver(NUM_CELLS, rate, threshold);
+	DenseVolatileCells active(rate, threshold), winner(rate, threshold);
+
+	Random rng(42);
+	SDR activeSDR, winnerSDR;
+	for(UInt step = 0u; step < STEPS; step++) {
+		const bool run = rng.getReal64() < 0.8;
+		upperLayer->setStatus(run ? Status::RUN : Status::SLEEP);
+		container.activeCells.randomize(0.1f, rng);
+		container.winnerCells.randomize(0.05f, rng);
+
+		receiver.receive(upperLayer, activeSDR, winnerSDR);
+
+		ASSERT_EQ(activeSDR.getSparse(), active.receive(container.activeCells, run))
+			<< "rate " << rate << ", threshold " << threshold << ", step " << step;
+		ASSERT_EQ(winnerSDR.getSparse(), winner.receive(container.winnerCells, run))
+			<< "rate " << rate << ", threshold " << threshold << ", step " << step;
+	}
+}
+
+TEST(VolatileActiveCellReceiverTest, testDenseDecay) {
+	compareWithDenseDecay(0.5f, 0.2f);
+	compareWithDenseDecay(0.9f, 0.01f);
+	compareWithDenseDecay(0.5f, 1.0f);
+	compareWithDenseDecay(1.0f, 0.5f);
+}
+
+/**
+ * The zero rate and the zero threshold must not hang the receiver and
+ * must behave like the dense decay.
+ */
+TEST(VolatileActiveCellReceiverTest, testZeroRateAndThreshold) {
+	compareWithDenseDecay(0.0f, 0.2f);
+	compareWithDenseDecay(0.5f, 0.0f);
+	compareWithDenseDecay(0.0f, 0.0f);
+	compareWithDenseDecay(1.0f, 0.0f);
+}
+
+/**
+ * A tiny threshold is reached only by the underflow of the value.
+ */
+TEST(VolatileActiveCellReceiverTest, testUnderflow) {
+	compareWithDenseDecay(0.5f, std::numeric_limits<Real>::denorm_min());
+}
+
+} // end namespace
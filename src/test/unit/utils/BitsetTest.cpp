@@ -0,0 +1,60 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2016, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+
+#include "gtest/gtest.h"
+
+#include "htm/types/Types.hpp"
+#include "htm/utils/Bitset.hpp"
+
+namespace testing { 
+    
+using namespace htm;
+
+TEST(Bitset, SetAndContains) {
+  Bitset bits(130);
+  ASSERT_EQ(130u, bits.size());
+
+  bits.set(0);
+  bits.set(63);
+  bits.set(64);
+  bits.set(129);
+
+  for(UInt i = 0; i < bits.size(); i++) {
+    const bool expected = (i == 0 || i == 63 || i == 64 || i == 129);
+    ASSERT_EQ(expected, bits.contains(i)) << i;
+  }
+}
+
+TEST(Bitset, AssignReplaces) {
+  Bitset bits(200);
+  bits.assign(std::vector<UInt32>{1, 70, 199});
+  ASSERT_TRUE(bits.contains(70));
+
+  bits.assign(std::vector<UInt32>{2, 150});
+  ASSERT_FALSE(bits.contains(1));
+  ASSERT_FALSE(bits.contains(70));
+  ASSERT_FALSE(bits.contains(199));
+  ASSERT_TRUE(bits.contains(2));
+  ASSERT_TRUE(bits.contains(150));
+
+  bits.clear();
+  for(UInt i = 0; i < bits.size(); i++) {
+    ASSERT_FALSE(bits.contains(i));
+  }
+}
+}